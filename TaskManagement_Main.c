@@ -0,0 +1,758 @@
+#include "TaskManagement_Stacks.h"
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+
+/* scanf field widths for the description-sized line buffers. */
+#define QUOTE_WIDTH(width) #width
+#define SCAN_WIDTH(width) QUOTE_WIDTH(width)
+#define SCAN_DESCRIPTION_LINE " %" SCAN_WIDTH(MAX_DESCRIPTION_LENGTH) "[^\n]"
+
+ 
+static TaskServer* activeServer;
+
+ 
+static void stopActiveServer(int signalNumber) {
+    (void)signalNumber;
+    stopTaskServer(activeServer);
+}
+
+ 
+int main(int argc, char* argv[]) {
+    TaskStack taskStack;
+    UndoStack undoStack;
+    KeywordIndex keywordIndex;
+    TaskColumns taskColumns;
+    TaskHeap taskHeap;
+    DueIndex dueIndex;
+    SortedView dateView;
+    SortedView importanceView;
+    TaskSortKey dateKey = { SORT_BY_DUE_DATE, false };
+    TaskSortKey importanceKeys[] = { { SORT_BY_IMPORTANCE, true }, { SORT_BY_DUE_DATE, false } };
+    WriteAheadLog writeAheadLog;
+    TaskNamespace taskNamespace;
+    NamedStack* namedStack = NULL;
+    Task newTask;
+    char description[MAX_DESCRIPTION];
+    char searchKeyword[MAX_DESCRIPTION];
+    int taskIndex, taskNumber;
+    int year, month, day;
+    bool batch = argc > 1;
+    bool named = argc > 1 && (strcmp(argv[1], "--stack") == 0 || strcmp(argv[1], "--search-all") == 0);
+    int first = argc > 3 && strcmp(argv[1], "--stack") == 0 ? 3 : 1;
+    
+    /* Batch mode: "-f FILE" (or "-f -" for stdin) runs a command script,
+       "--serve ADDRESS" takes the same commands over a socket until
+       SIGINT or SIGTERM, anything else is a single command taken from the
+       arguments. "--stack NAME" in front of any of these works on the
+       named stack in stacks/ instead of tasks.dat, and "--search-all
+       QUERY" searches every named stack. */
+    if (batch) {
+        setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+    }
+    initializeStack(&taskStack);
+    initializeUndoStack(&undoStack, UNDO_BUDGET);
+    initializeKeywordIndex(&keywordIndex);
+    attachKeywordIndex(&taskStack, &keywordIndex);
+    initializeTaskColumns(&taskColumns);
+    attachTaskColumns(&taskStack, &taskColumns);
+    initializeTaskHeap(&taskHeap);
+    attachTaskHeap(&taskStack, &taskHeap);
+    initializeDueIndex(&dueIndex);
+    attachDueIndex(&taskStack, &dueIndex);
+    
+     
+    /* The log only continues the snapshot it was checkpointed against, so
+       it is replayed over tasks.dat or, when there is none yet, over the
+       empty stack, never over a stack that failed to load. */
+    initializeWriteAheadLog(&writeAheadLog);
+    bool loaded = !named && loadStackFromFile(&taskStack);
+    bool missing = !loaded && errno == ENOENT;
+    if (loaded && !batch) {
+        printf("Tasks loaded successfully from file.\n");
+    }
+    if (!named && openWriteAheadLog(&writeAheadLog, WAL_FILENAME)) {
+        int recovered = loaded || missing ? replayWriteAheadLog(&taskStack, &writeAheadLog) :
+                        writeAheadLog.fileSize > 0 ? -1 : 0;
+        if (recovered < 0) {
+            fprintf(stderr, "Cannot apply %s to %s; both files were left untouched.\n", WAL_FILENAME, FILENAME);
+            return 1;
+        }
+        if (recovered > 0 && !batch) {
+            printf("Recovered %d change(s) made since the last save.\n", recovered);
+        }
+        attachWriteAheadLog(&taskStack, &writeAheadLog);
+    }
+    attachUndoStack(&taskStack, &undoStack);
+    
+    if (batch) {
+        TaskStack* stack = &taskStack;
+        int failed = 0;
+        if (named && !initializeTaskNamespace(&taskNamespace, NAMESPACE_DIRECTORY)) {
+            fprintf(stderr, "Cannot open %s/\n", NAMESPACE_DIRECTORY);
+            return 1;
+        }
+        if (first == 3 && (namedStack = lockNamedStack(&taskNamespace, argv[2], true)) != NULL) {
+            stack = &namedStack->stack;
+        }
+        
+        if (named && first == 1 && strcmp(argv[1], "--stack") == 0) {
+            fprintf(stderr, "Usage: %s --stack NAME COMMAND...\n", argv[0]);
+            failed = 1;
+        } else if (first == 3 && namedStack == NULL) {
+            fprintf(stderr, "Cannot open stack '%s'\n", argv[2]);
+            failed = 1;
+        } else if (strcmp(argv[1], "--search-all") == 0 && argc == 3) {
+            NamespaceMatch* matches;
+            loadTaskNamespace(&taskNamespace);
+            int count = searchTaskNamespace(&taskNamespace, argv[2], &matches);
+            for (int i = 0; i < count; i++) {
+                if (i == 0 || strcmp(matches[i].stackName, matches[i - 1].stackName) != 0) {
+                    printf("[%s]\n", matches[i].stackName);
+                }
+                displayTask(&matches[i].task, matches[i].index);
+            }
+            failed = count < 0;
+            if (count >= 0) {
+                freeNamespaceMatches(matches, count);
+            }
+        } else if (strcmp(argv[first], "-f") == 0 && argc == first + 2) {
+            FILE* script = strcmp(argv[first + 1], "-") == 0 ? stdin : fopen(argv[first + 1], "r");
+            if (script == NULL) {
+                fprintf(stderr, "Cannot open %s\n", argv[first + 1]);
+                failed = 1;
+            } else {
+                failed = runBatchFile(stack, script);
+                if (script != stdin) {
+                    fclose(script);
+                }
+            }
+        } else if (strcmp(argv[first], "--serve") == 0 && argc == first + 2) {
+            TaskServer server;
+            if (!openTaskServer(&server, argv[first + 1])) {
+                fprintf(stderr, "Cannot listen on %s\n", argv[first + 1]);
+                failed = 1;
+            } else {
+                struct sigaction action = { .sa_handler = stopActiveServer };
+                activeServer = &server;
+                sigaction(SIGINT, &action, NULL);
+                sigaction(SIGTERM, &action, NULL);
+                if (server.port > 0) {
+                    fprintf(stderr, "Listening on port %d\n", server.port);
+                }
+                setStatsFile(STATS_FILENAME, STATS_FILE_INTERVAL_MS);
+                int served = runTaskServer(&server, stack);
+                failed = served < 0;
+                fprintf(stderr, "Served %d request(s) in %llu round(s)\n", served,
+                        (unsigned long long)server.rounds);
+                closeTaskServer(&server);
+                finishBackgroundSave(true);
+                failed += !saveStackToFile(stack);
+                refreshStatsFile(stack, true);
+            }
+        } else {
+            char line[4 * MAX_DESCRIPTION] = "";
+            for (int i = first; i < argc; i++) {
+                strncat(line, argv[i], sizeof(line) - strlen(line) - 2);
+                strcat(line, " ");
+            }
+            if (!runBatchCommand(stack, line)) {
+                fprintf(stderr, "Cannot run command; try '%s help'\n", argv[0]);
+                failed = 1;
+            }
+        }
+        /* Changes the log could not take are kept by saving the stack. */
+        if (stack->wal != NULL && stack->wal->fd >= 0 && !syncWriteAheadLog(stack->wal)) {
+            fprintf(stderr, "Cannot write the log; saving the stack instead\n");
+            failed += !saveStackToFile(stack);
+        }
+        if (named) {
+            if (namedStack != NULL) {
+                unlockNamedStack(&taskNamespace, namedStack);
+            }
+            freeTaskNamespace(&taskNamespace);
+        }
+        closeWriteAheadLog(&writeAheadLog);
+        taskStack.undo = NULL;
+        freeUndoStack(&undoStack);
+        resetStack(&taskStack);
+        freeKeywordIndex(&keywordIndex);
+        freeTaskColumns(&taskColumns);
+        freeTaskHeap(&taskHeap);
+        freeDueIndex(&dueIndex);
+        return failed > 0 ? 1 : 0;
+    }
+    
+    /* The sorted listings are views kept beside the stack, so showing them
+       leaves the stack's order alone; they are built on first use. */
+    initializeSortedView(&dateView, &dateKey, 1);
+    attachSortedView(&taskStack, &dateView);
+    initializeSortedView(&importanceView, importanceKeys, 2);
+    attachSortedView(&taskStack, &importanceView);
+    
+    setStatsFile(STATS_FILENAME, STATS_FILE_INTERVAL_MS);
+    while (1) {
+        /* The previous action becomes durable before the menu comes back. */
+        syncWriteAheadLog(&writeAheadLog);
+        checkpointWriteAheadLog(&taskStack);
+        finishBackgroundSave(false);
+        refreshStatsFile(&taskStack, false);
+        drawUIHeader();
+        if (writeAheadLog.failed) {
+            printf("| Changes can no longer be written to tasks.wal; save (10) to keep them.       |\n");
+        }
+        printf("| Main Menu:                                                                   |\n");
+        printf("| 1. Push Task (Add)                                                           |\n");
+        printf("| 2. Pop Task (Remove Last)                                                    |\n");
+        printf("| 3. View All Tasks                                                            |\n");
+        printf("| 4. Edit Task                                                                 |\n");
+        printf("| 5. Remove Specific Task                                                      |\n");
+        printf("| 6. Search Tasks                                                              |\n");
+        printf("| 7. View by Date                                                              |\n");
+        printf("| 8. View by Importance                                                        |\n");
+        printf("| 9. Undo Last Operation                                                       |\n");
+        printf("| 10. Save Tasks                                                               |\n");
+        printf("| 11. View by Custom Keys                                                      |\n");
+        printf("| 12. Tasks Due Before a Date                                                  |\n");
+        printf("| 13. Filter Tasks                                                             |\n");
+        printf("| 14. Redo Last Undo                                                           |\n");
+        printf("| 15. Import Tasks (CSV/JSONL)                                                 |\n");
+        printf("| 16. Export Tasks (CSV/JSONL)                                                 |\n");
+        printf("| 17. Next Most Important Task                                                 |\n");
+        printf("| 18. Due Date Calendar                                                        |\n");
+        printf("| 19. Show Stats                                                               |\n");
+        printf("| 20. Top Tasks                                                                |\n");
+        printf("| 21. Exit                                                                     |\n");
+        drawLine(80);
+        printf("| Enter your choice: ");
+        
+        int choice;
+        scanf("%d", &choice);
+        clearInputBuffer();
+        
+        switch (choice) {
+            case 1:  
+                drawUIHeader();
+                printf("| Push New Task                                                             |\n");
+                drawLine(80);
+                
+                printf("| Enter Task Description: ");
+                description[0] = '\0';
+                scanf(SCAN_DESCRIPTION_LINE, description);
+                clearInputBuffer();
+                memset(&newTask, 0, sizeof(newTask));
+                if (!setTaskDescription(&newTask, description)) {
+                    printf("| Cannot store the description; the task was not pushed.\n");
+                    drawUIFooter();
+                    continue;
+                }
+                
+                printf("| Enter Task Due Date (YYYY MM DD): ");
+                if (scanf("%d %d %d", &year, &month, &day) != 3 || 
+                    !setTaskDueDate(&newTask, year, month, day)) {
+                    printf("| Invalid date format. Please enter a valid date.\n");
+                    drawUIFooter();
+                    continue;
+                }
+                clearInputBuffer();
+                
+                printf("| Enter Task Importance (1-10): ");
+                scanf("%d", &newTask.importance);
+                clearInputBuffer();
+                
+                printf("| Task Status (0-Pending, 1-In Progress, 2-Completed): ");
+                int status;
+                scanf("%d", &status);
+                if (status >= PENDING && status <= COMPLETED) {
+                    newTask.status = (TaskStatus)status;
+                } else {
+                    newTask.status = PENDING;
+                }
+                clearInputBuffer();
+                
+                 
+                newTask.createdAt = time(NULL);
+                
+                if (pushTask(&taskStack, newTask)) {
+                    printf("| Task pushed successfully!\n");
+                } else {
+                    printf("| Task stack is full. Cannot push more tasks.\n");
+                }
+                
+                drawUIFooter();
+                break;
+                
+            case 2:  
+                drawUIHeader();
+                printf("| Pop Task                                                                  |\n");
+                drawLine(80);
+                
+                Task poppedTask;
+                if (popTask(&taskStack, &poppedTask)) {
+                    printf("| Popped Task: %s\n", getTaskDescription(&poppedTask));
+                } else {
+                    printf("| Task stack is empty. Nothing to pop.\n");
+                }
+                
+                drawUIFooter();
+                break;
+                
+            case 3:  
+                browseTasks(&taskStack, "Current Tasks");
+                break;
+                
+            case 4:  
+                drawUIHeader();
+                printf("| Edit Task                                                                 |\n");
+                drawLine(80);
+                
+                if (isEmptyStack(&taskStack)) {
+                    printf("| Task stack is empty. Nothing to edit.\n");
+                    drawUIFooter();
+                    continue;
+                }
+                
+                displayTaskPage(&taskStack, getStackSize(&taskStack) - visibleTaskRows(), visibleTaskRows());
+                
+                printf("| Enter Task ID to edit: ");
+                scanf("%d", &taskNumber);
+                clearInputBuffer();
+                
+                taskIndex = taskNumber - 1;
+                Task* taskToEdit = getTaskAtIndex(&taskStack, taskIndex);
+                
+                if (taskToEdit == NULL) {
+                    printf("| Invalid Task ID. Please try again.\n");
+                    drawUIFooter();
+                    continue;
+                }
+                
+                 
+                Task editedTask = *taskToEdit;
+                
+                printf("| Current description: %s\n", getTaskDescription(&editedTask));
+                printf("| Enter new description (or press Enter to keep current): ");
+                char newDesc[MAX_DESCRIPTION];
+                if (fgets(newDesc, MAX_DESCRIPTION, stdin) != NULL && newDesc[0] != '\n') {
+                    newDesc[strcspn(newDesc, "\n")] = 0;  
+                    if (!setTaskDescription(&editedTask, newDesc)) {
+                        printf("| Cannot store the new description; keeping the current one.\n");
+                    }
+                }
+                
+                printf("| Current date: %s\n", editedTask.dueLabel);
+                printf("| Enter new date (YYYY MM DD) or 0 to keep current: ");
+                if (scanf("%d", &year) == 1 && year != 0) {
+                    scanf("%d %d", &month, &day);
+                    if (!setTaskDueDate(&editedTask, year, month, day)) {
+                        printf("| Invalid date. Keeping current date.\n");
+                    }
+                }
+                clearInputBuffer();
+                
+                printf("| Current importance: %d\n", editedTask.importance);
+                printf("| Enter new importance (1-10) or 0 to keep current: ");
+                int importance;
+                if (scanf("%d", &importance) == 1 && importance > 0) {
+                    editedTask.importance = importance;
+                }
+                clearInputBuffer();
+                
+                printf("| Current status: %s\n", statusNames[editedTask.status]);
+                printf("| Enter new status (0-Pending, 1-In Progress, 2-Completed) or -1 to keep current: ");
+                if (scanf("%d", &status) == 1 && status >= 0) {
+                    if (status >= PENDING && status <= COMPLETED) {
+                        editedTask.status = (TaskStatus)status;
+                    }
+                }
+                clearInputBuffer();
+                
+                if (editTaskAtIndex(&taskStack, taskIndex, editedTask)) {
+                    printf("| Task updated successfully!\n");
+                } else {
+                    printf("| Error updating task.\n");
+                }
+                
+                drawUIFooter();
+                break;
+                
+            case 5:  
+                drawUIHeader();
+                printf("| Remove Specific Task                                                      |\n");
+                drawLine(80);
+                
+                if (isEmptyStack(&taskStack)) {
+                    printf("| Task stack is empty. Nothing to remove.\n");
+                    drawUIFooter();
+                    continue;
+                }
+                
+                displayTaskPage(&taskStack, getStackSize(&taskStack) - visibleTaskRows(), visibleTaskRows());
+                
+                printf("| Enter Task ID to remove: ");
+                scanf("%d", &taskNumber);
+                clearInputBuffer();
+                
+                taskIndex = taskNumber - 1;
+                
+                if (removeTaskAtIndex(&taskStack, taskIndex)) {
+                    printf("| Task removed successfully!\n");
+                } else {
+                    printf("| Invalid Task ID or error removing task.\n");
+                }
+                
+                drawUIFooter();
+                break;
+                
+            case 6:  
+                drawUIHeader();
+                printf("| Search Tasks                                                              |\n");
+                drawLine(80);
+                
+                printf("| Search mode (1-Keywords, 2-Substring, 3-Substring ignoring case): ");
+                int searchMode;
+                if (scanf("%d", &searchMode) != 1 || searchMode < 1 || searchMode > 3) {
+                    searchMode = 1;
+                }
+                clearInputBuffer();
+                
+                printf("| Keywords are ANDed; use OR or | for alternatives and word* for prefixes.\n");
+                printf("| Enter search query: ");
+                scanf(SCAN_DESCRIPTION_LINE, searchKeyword);
+                clearInputBuffer();
+                
+                searchTasks(&taskStack, searchKeyword, (SearchMode)(searchMode - 1));
+                break;
+                
+            case 7:  
+                browseSortedView(&taskStack, &dateView, "Tasks by due date; the stack order is unchanged.");
+                break;
+                
+            case 8:  
+                browseSortedView(&taskStack, &importanceView, "Tasks by importance; the stack order is unchanged.");
+                break;
+                
+            case 9:  
+                drawUIHeader();
+                printf("| Undo Last Operation                                                       |\n");
+                drawLine(80);
+                
+                if (undoLastOperation(&taskStack, &undoStack)) {
+                    printf("| Last operation undone successfully!\n");
+                } else {
+                    printf("| Nothing to undo or error occurred.\n");
+                }
+                
+                drawUIFooter();
+                break;
+                
+            case 10:  
+                drawUIHeader();
+                if (saveStackInBackground(&taskStack)) {
+                    printf("| Saving tasks in the background.                                           |\n");
+                } else {
+                    printf("| Error saving tasks.                                                       |\n");
+                }
+                drawUIFooter();
+                break;
+                
+            case 11:  
+                drawUIHeader();
+                printf("| View by Custom Keys                                                       |\n");
+                drawLine(80);
+                
+                printf("| Keys: importance, date, created (prefix '-' for descending)\n");
+                printf("| Enter sort keys (e.g. -importance date created): ");
+                char sortSpec[MAX_DESCRIPTION];
+                TaskSortKey sortKeys[MAX_SORT_KEYS];
+                scanf(SCAN_DESCRIPTION_LINE, sortSpec);
+                clearInputBuffer();
+                
+                int keyCount = parseSortKeys(sortSpec, sortKeys);
+                if (keyCount < 0) {
+                    printf("| Invalid sort keys.\n");
+                    drawUIFooter();
+                    continue;
+                }
+                
+                SortedView customView;
+                initializeSortedView(&customView, sortKeys, keyCount);
+                browseSortedView(&taskStack, &customView, "Tasks in key order; the stack order is unchanged.");
+                freeSortedView(&customView);
+                break;
+                
+            case 12:  
+                drawUIHeader();
+                printf("| Tasks Due Before a Date                                                   |\n");
+                drawLine(80);
+                
+                printf("| Enter date (YYYY MM DD): ");
+                if (scanf("%d %d %d", &year, &month, &day) != 3 || !isValidDate(year, month, day)) {
+                    clearInputBuffer();
+                    printf("| Invalid date format. Please enter a valid date.\n");
+                    drawUIFooter();
+                    continue;
+                }
+                clearInputBuffer();
+                
+                printf("| %2s | %-30s | %-17s | %10s | %-11s |\n", 
+                       "ID", "Description", "Due Date", "Importance", "Status");
+                drawLine(80);
+                if (displayTasksDueBetween(&taskStack, 0, DUE_KEY(year, month, day) - 1) == 0) {
+                    printf("| No tasks due before that date.\n");
+                }
+                drawUIFooter();
+                break;
+                
+            case 13:  
+                drawUIHeader();
+                printf("| Filter Tasks                                                              |\n");
+                drawLine(80);
+                
+                TaskFilter filter;
+                initializeTaskFilter(&filter);
+                printf("| Minimum importance (0 for any): ");
+                if (scanf("%d", &filter.minImportance) != 1 || filter.minImportance <= 0) {
+                    filter.minImportance = INT_MIN;
+                }
+                clearInputBuffer();
+                
+                printf("| Status (0-Pending, 1-In Progress, 2-Completed, -1 for any): ");
+                if (scanf("%d", &status) == 1 && status >= PENDING && status <= COMPLETED) {
+                    filter.statusMask = 1u << status;
+                }
+                clearInputBuffer();
+                
+                printf("| %2s | %-30s | %-17s | %10s | %-11s |\n", 
+                       "ID", "Description", "Due Date", "Importance", "Status");
+                drawLine(80);
+                int filtered = displayFilteredTasks(&taskStack, &filter);
+                if (filtered == 0) {
+                    printf("| No tasks match that filter.\n");
+                } else {
+                    printf("| %d matching task(s).\n", filtered);
+                }
+                drawUIFooter();
+                break;
+                
+            case 14:  
+                drawUIHeader();
+                printf("| Redo Last Undo                                                            |\n");
+                drawLine(80);
+                
+                if (redoLastOperation(&taskStack, &undoStack)) {
+                    printf("| Last undone operation redone successfully!\n");
+                } else {
+                    printf("| Nothing to redo.\n");
+                }
+                
+                drawUIFooter();
+                break;
+                
+            case 15:  
+            case 16:  
+                drawUIHeader();
+                printf(choice == 15 ? "| Import Tasks                                                              |\n"
+                                    : "| Export Tasks                                                              |\n");
+                drawLine(80);
+                
+                char path[256];
+                printf("| File path (.csv, or .jsonl for JSON Lines): ");
+                if (scanf(" %255[^\n]", path) != 1) {
+                    clearInputBuffer();
+                    drawUIFooter();
+                    continue;
+                }
+                clearInputBuffer();
+                
+                if (choice == 15) {
+                    int rejected;
+                    int imported = importTasksFromFile(&taskStack, path, taskFileFormatForPath(path), &rejected);
+                    if (imported < 0) {
+                        printf("| Cannot read %s.\n", path);
+                    } else {
+                        printf("| Imported %d task(s); skipped %d invalid record(s).\n", imported, rejected);
+                    }
+                } else {
+                    int exported = exportTasksToFile(&taskStack, path, taskFileFormatForPath(path));
+                    if (exported < 0) {
+                        printf("| Error writing %s.\n", path);
+                    } else {
+                        printf("| Exported %d task(s).\n", exported);
+                    }
+                }
+                
+                drawUIFooter();
+                break;
+                
+            case 17:  
+                drawUIHeader();
+                printf("| Next Most Important Task                                                  |\n");
+                drawLine(80);
+                
+                Task nextTask;
+                int nextIndex;
+                if (!peekPriorityTask(&taskStack, &nextTask, &nextIndex)) {
+                    printf("| No unfinished tasks.\n");
+                    drawUIFooter();
+                    break;
+                }
+                printf("| %2s | %-30s | %-17s | %10s | %-11s |\n", 
+                       "ID", "Description", "Due Date", "Importance", "Status");
+                drawLine(80);
+                displayTask(&nextTask, nextIndex);
+                drawLine(80);
+                
+                char answer;
+                printf("| Remove it from the stack? (y/n): ");
+                if (scanf(" %c", &answer) == 1 && (answer == 'y' || answer == 'Y')) {
+                    if (popPriorityTask(&taskStack, &nextTask)) {
+                        printf("| Removed: %s\n", getTaskDescription(&nextTask));
+                    }
+                }
+                clearInputBuffer();
+                
+                drawUIFooter();
+                break;
+                
+            case 18:  
+                drawUIHeader();
+                printf("| Due Date Calendar                                                         |\n");
+                drawLine(80);
+                
+                int view;
+                printf("| 1-Due This Week, 2-Overdue, 3-Due Between Dates, 4-Tasks per Month: ");
+                if (scanf("%d", &view) != 1 || view < 1 || view > 4) {
+                    clearInputBuffer();
+                    printf("| Invalid choice.\n");
+                    drawUIFooter();
+                    continue;
+                }
+                clearInputBuffer();
+                
+                int fromKey = 0, toKey = 0, listed;
+                time_t now = time(NULL);
+                if (view == 3) {
+                    printf("| From (YYYY MM DD): ");
+                    if (scanf("%d %d %d", &year, &month, &day) != 3) {
+                        clearInputBuffer();
+                        drawUIFooter();
+                        continue;
+                    }
+                    fromKey = DUE_KEY(year, month, day);
+                    printf("| To (YYYY MM DD): ");
+                    if (scanf("%d %d %d", &year, &month, &day) != 3) {
+                        clearInputBuffer();
+                        drawUIFooter();
+                        continue;
+                    }
+                    toKey = DUE_KEY(year, month, day);
+                    clearInputBuffer();
+                } else if (view == 1) {
+                    fromKey = dueKeyForDay(now, 0);
+                    toKey = dueKeyForDay(now, 6);
+                }
+                
+                if (view == 4) {
+                    listed = displayDueCalendar(&taskStack);
+                } else {
+                    printf("| %2s | %-30s | %-17s | %10s | %-11s |\n", 
+                           "ID", "Description", "Due Date", "Importance", "Status");
+                    drawLine(80);
+                    listed = view == 2 ? displayOverdueTasks(&taskStack, dueKeyForDay(now, 0))
+                                       : displayTasksDueBetween(&taskStack, fromKey, toKey);
+                }
+                if (listed == 0) {
+                    printf("| No tasks found.\n");
+                }
+                drawUIFooter();
+                break;
+                
+            case 19:  
+                drawUIHeader();
+                printf("| Operation Stats                                                           |\n");
+                drawLine(80);
+                if (displayStats(&taskStack) < 0) {
+                    printf("| Not enough memory to collect the stats.\n");
+                }
+                drawUIFooter();
+                break;
+                
+            case 20:  
+                drawUIHeader();
+                printf("| Top Tasks                                                                 |\n");
+                drawLine(80);
+                
+                int topCount;
+                printf("| How many tasks: ");
+                if (scanf("%d", &topCount) != 1 || topCount <= 0) {
+                    clearInputBuffer();
+                    printf("| Invalid number.\n");
+                    drawUIFooter();
+                    continue;
+                }
+                clearInputBuffer();
+                
+                TaskFilter topFilter;
+                initializeTaskFilter(&topFilter);
+                printf("| Status (0-Pending, 1-In Progress, 2-Completed, -1 for any): ");
+                if (scanf("%d", &status) == 1 && status >= PENDING && status <= COMPLETED) {
+                    topFilter.statusMask = 1u << status;
+                }
+                clearInputBuffer();
+                
+                TaskSortKey topKeys[MAX_SORT_KEYS] = { { SORT_BY_IMPORTANCE, true }, { SORT_BY_DUE_DATE, false } };
+                int topKeyCount = 2;
+                printf("| Sort keys (Enter for -importance date): ");
+                if (fgets(sortSpec, sizeof(sortSpec), stdin) != NULL && sortSpec[strspn(sortSpec, " \t\r\n")] != '\0') {
+                    sortSpec[strcspn(sortSpec, "\r\n")] = '\0';
+                    topKeyCount = parseSortKeys(sortSpec, topKeys);
+                }
+                if (topKeyCount < 0) {
+                    printf("| Invalid sort keys.\n");
+                    drawUIFooter();
+                    continue;
+                }
+                
+                printf("| %2s | %-30s | %-17s | %10s | %-11s |\n", 
+                       "ID", "Description", "Due Date", "Importance", "Status");
+                drawLine(80);
+                int topShown = displayTopTasks(&taskStack, topKeys, topKeyCount, &topFilter, topCount);
+                if (topShown == 0) {
+                    printf("| No tasks match.\n");
+                } else if (topShown < 0) {
+                    printf("| Not enough memory to select the tasks.\n");
+                }
+                drawUIFooter();
+                break;
+                
+            case 21:  
+                drawUIHeader();
+                printf("| Saving tasks before exit...                                               |\n");
+                saveStackToFile(&taskStack);
+                finishBackgroundSave(true);
+                refreshStatsFile(&taskStack, true);
+                resetStack(&taskStack);
+                freeKeywordIndex(&keywordIndex);
+                freeTaskColumns(&taskColumns);
+                freeTaskHeap(&taskHeap);
+                freeDueIndex(&dueIndex);
+                detachSortedView(&taskStack, &dateView);
+                freeSortedView(&dateView);
+                detachSortedView(&taskStack, &importanceView);
+                freeSortedView(&importanceView);
+                closeWriteAheadLog(&writeAheadLog);
+                freeUndoStack(&undoStack);
+                printf("| Thank you for using the Stack-Based Task Management System!               |\n");
+                drawUIFooter();
+                exit(0);
+                
+            default:
+                drawUIHeader();
+                printf("| Invalid choice. Please try again.                                           |\n");
+                drawUIFooter();
+        }
+    }
+    
+    return 0;
+}
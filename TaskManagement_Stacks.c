@@ -1,42 +1,103 @@
-#include <stdio.h>
-#include <stdlib.h>
+#include "TaskManagement_Stacks.h"
 #include <string.h>
-#include <stdbool.h>
-#include <time.h>
+#include <ctype.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <sys/ioctl.h>
 
-#define MAX_TASKS 100
-#define MAX_DESCRIPTION 100
-#define FILENAME "tasks.dat"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
 
  
+/* Handles of pool slots, one list per slot size or of retired strings. */
+typedef struct {
+    uint32_t* handles;
+    uint32_t count;
+    uint32_t capacity;
+} StringSlots;
+
+ 
+/* Every description is stored NUL-terminated in 1 MB blocks that never
+   move, and a handle packs its block number and offset into 32 bits;
+   handle 0 is the empty string. An 8-byte header in front of the text
+   counts the stack slots and queued tasks holding it, so tasks can be
+   copied freely and read on any thread without a lock. The last release
+   retires the string; it stays readable for two more reclaim passes, one
+   per STRING_RECLAIM_BYTES retired, which covers a task just popped or a
+   handle just looked up, and then its slot is reused for text of the same
+   size. With interning on, equal descriptions share a handle. */
+typedef struct {
+    char* blocks[STRING_MAX_BLOCKS];
+    uint32_t blockCount;
+    uint32_t used;
+    uint32_t* internHandles;
+    uint32_t* internHashes;
+    uint32_t internCount;
+    uint32_t internCapacity;
+    StringSlots freeSlots[STRING_SLOT_CLASSES];
+    StringSlots retired;
+    uint64_t retiredBytes;
+    uint32_t epoch;
+    uint64_t bytes;
+    uint64_t freeBytes;
+    bool interning;
+    pthread_mutex_t lock;
+} StringPool;
+
+ 
+/* Low two bits of the word after a string's reference count; the rest is
+   the reclaim epoch it was stored, looked up or retired in. */
 typedef enum {
-    PENDING = 0,
-    IN_PROGRESS = 1,
-    COMPLETED = 2
-} TaskStatus;
+    STRING_LIVE = 0,
+    STRING_RETIRED = 1,
+    STRING_FREE = 2
+} StringState;
 
  
+/* Task layout of the interim raw tasks.dat, kept for migrating old files. */
 typedef struct {
-    char description[MAX_DESCRIPTION];
-    int year;
-    int month;
-    int day;
+    char description[LEGACY_DESCRIPTION];
+    int dueKey;
+    char dueLabel[DUE_LABEL_SIZE];
     int importance;
     TaskStatus status;
+    uint32_t id;
     time_t createdAt;
-} Task;
+} RawTask;
 
  
+/* Task layout of the original raw tasks.dat, kept for migrating old files. */
 typedef struct {
-    Task tasks[MAX_TASKS];
-    int top;   
-} TaskStack;
+    char description[LEGACY_DESCRIPTION];
+    int year;
+    int month;
+    int day;
+    int importance;
+    int status;
+    time_t createdAt;
+} LegacyTask;
 
  
+/* Sorting moves these small records instead of whole Tasks; descending keys
+   are stored bit-inverted so every comparison is ascending. */
 typedef struct {
-    Task tasks[MAX_TASKS];
-    int top;
-} UndoStack;
+    int64_t key[MAX_SORT_KEYS];
+    int slot;
+} TaskSortRecord;
 
  
 const char* monthNames[] = {
@@ -49,724 +110,8122 @@ const char* statusNames[] = {
 };
 
  
-void initializeStack(TaskStack* stack);
-void initializeUndoStack(UndoStack* stack);
-bool pushTask(TaskStack* stack, Task task);
-bool popTask(TaskStack* stack, Task* task);
-bool peekTask(TaskStack* stack, Task* task);
-bool isEmptyStack(TaskStack* stack);
-bool isFullStack(TaskStack* stack);
-bool isValidDate(int year, int month, int day);
-void clearInputBuffer();
-void saveStackToFile(TaskStack stack);
-bool loadStackFromFile(TaskStack* stack);
-void displayTask(Task task, int index);
-void displayAllTasks(TaskStack stack);
-void searchTasks(TaskStack stack, const char* keyword);
-void drawUIHeader();
-void drawUIFooter();
-void drawLine(int width);
-Task* getTaskAtIndex(TaskStack* stack, int index);
-int getStackSize(TaskStack stack);
-bool removeTaskAtIndex(TaskStack* stack, int index, UndoStack* undoStack);
-bool editTaskAtIndex(TaskStack* stack, int index, Task newTask, UndoStack* undoStack);
-void sortStackByDate(TaskStack* stack);
-void sortStackByImportance(TaskStack* stack);
-bool undoLastOperation(TaskStack* stack, UndoStack* undoStack);
+/* Status spellings in import/export files and batch commands. */
+const char* statusTokens[] = {
+    "pending", "in-progress", "completed"
+};
+
+ 
+/* Import/export columns in CSV order; created_at is optional on import. */
+const char* importFieldNames[IMPORT_FIELDS] = {
+    "description", "due", "importance", "status", "created_at"
+};
 
  
-void initializeStack(TaskStack* stack) {
-    stack->top = -1;
-}
+/* Operation names in the stats, as in the Prometheus op label. */
+const char* statOperationNames[STAT_OPERATIONS] = {
+    "push", "pop", "peek", "edit", "insert", "remove", "request", "push_bulk", "sort", "reorder", "undo",
+    "redo", "search_index", "search_scan", "save", "load", "import", "export", "wal_sync"
+};
 
  
-void initializeUndoStack(UndoStack* stack) {
-    stack->top = -1;
-}
+/* Block 0 starts with the empty string behind handle 0. */
+static char firstStringBlock[STRING_BLOCK_SIZE] __attribute__((aligned(16)));
+static StringPool stringPool = {
+    .blocks = { firstStringBlock },
+    .blockCount = 1,
+    .used = STRING_HEADER_SIZE,
+    .interning = true,
+    .lock = PTHREAD_MUTEX_INITIALIZER
+};
 
  
-bool pushTask(TaskStack* stack, Task task) {
-    if (!isFullStack(stack)) {
-        stack->top++;
-        stack->tasks[stack->top] = task;
-        return true;
-    }
-    return false;
+const char* getTaskDescription(const Task* task) {
+    return stringPool.blocks[task->description >> STRING_BLOCK_SHIFT] + (task->description & (STRING_BLOCK_SIZE - 1));
 }
 
  
-bool popTask(TaskStack* stack, Task* task) {
-    if (!isEmptyStack(stack)) {
-        *task = stack->tasks[stack->top];
-        stack->top--;
-        return true;
-    }
-    return false;
+/* Bytes the substring scanners may load from the start of the description:
+   the rest of its block, which is allocated and zeroed in full. */
+static size_t descriptionReadable(const Task* task) {
+    return STRING_BLOCK_SIZE - (task->description & (STRING_BLOCK_SIZE - 1));
 }
 
  
-bool peekTask(TaskStack* stack, Task* task) {
-    if (!isEmptyStack(stack)) {
-        *task = stack->tasks[stack->top];
-        return true;
+static uint32_t hashText(const char* text, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
     }
-    return false;
+    return hash;
 }
 
  
-bool isEmptyStack(TaskStack* stack) {
-    return stack->top == -1;
+static bool growInternTable(StringPool* pool) {
+    uint32_t capacity = pool->internCapacity ? pool->internCapacity * 2 : 4096;
+    uint32_t* handles = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    uint32_t* hashes = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    if (handles == NULL || hashes == NULL) {
+        free(handles);
+        free(hashes);
+        return false;
+    }
+    
+    for (uint32_t i = 0; i < pool->internCapacity; i++) {
+        if (pool->internHandles[i] != 0) {
+            uint32_t slot = pool->internHashes[i] & (capacity - 1);
+            while (handles[slot] != 0) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            handles[slot] = pool->internHandles[i];
+            hashes[slot] = pool->internHashes[i];
+        }
+    }
+    free(pool->internHandles);
+    free(pool->internHashes);
+    pool->internHandles = handles;
+    pool->internHashes = hashes;
+    pool->internCapacity = capacity;
+    return true;
 }
 
  
-bool isFullStack(TaskStack* stack) {
-    return stack->top == MAX_TASKS - 1;
+static inline char* poolText(const StringPool* pool, uint32_t handle) {
+    return pool->blocks[handle >> STRING_BLOCK_SHIFT] + (handle & (STRING_BLOCK_SIZE - 1));
 }
 
  
-int getStackSize(TaskStack stack) {
-    return stack.top + 1;
+static inline atomic_uint* poolStringRefs(const StringPool* pool, uint32_t handle) {
+    return (atomic_uint*)(poolText(pool, handle) - STRING_HEADER_SIZE);
 }
 
  
-bool pushToUndoStack(UndoStack* stack, Task task) {
-    if (stack->top < MAX_TASKS - 1) {
-        stack->top++;
-        stack->tasks[stack->top] = task;
-        return true;
-    }
-    return false;
+static inline uint32_t* poolStringState(const StringPool* pool, uint32_t handle) {
+    return (uint32_t*)(poolText(pool, handle) - 4);
 }
 
  
-bool popFromUndoStack(UndoStack* stack, Task* task) {
-    if (stack->top >= 0) {
-        *task = stack->tasks[stack->top];
-        stack->top--;
-        return true;
-    }
-    return false;
+/* Header, text and terminator, rounded up to 8 bytes. */
+static inline size_t stringSlotSize(size_t length) {
+    return (STRING_HEADER_SIZE + length + 1 + 7) & ~(size_t)7;
 }
 
  
-bool undoLastOperation(TaskStack* stack, UndoStack* undoStack) {
-    Task undoTask;
-    if (popFromUndoStack(undoStack, &undoTask)) {
-         
-        pushTask(stack, undoTask);
-        return true;
+static bool addStringSlot(StringSlots* slots, uint32_t handle) {
+    if (slots->count == slots->capacity) {
+        uint32_t capacity = slots->capacity ? slots->capacity * 2 : 256;
+        uint32_t* handles = (uint32_t*)realloc(slots->handles, capacity * sizeof(uint32_t));
+        if (handles == NULL) {
+            return false;
+        }
+        slots->handles = handles;
+        slots->capacity = capacity;
     }
-    return false;
+    slots->handles[slots->count++] = handle;
+    return true;
 }
 
  
-bool isValidDate(int year, int month, int day) {
-    if (year < 1000 || year > 9999 || month < 1 || month > 12 || day < 1 || day > 31) {
-        return false;
+/* Takes the string out of the intern table, shifting later entries of its
+   probe run back so lookups still find them. */
+static void forgetInternedString(StringPool* pool, uint32_t handle) {
+    if (pool->internCapacity == 0) {
+        return;
     }
     
-     
-    if ((month == 4 || month == 6 || month == 9 || month == 11) && day > 30) {
-        return false;
+    const char* text = poolText(pool, handle);
+    uint32_t mask = pool->internCapacity - 1;
+    uint32_t hole = hashText(text, strlen(text)) & mask;
+    while (pool->internHandles[hole] != handle) {
+        if (pool->internHandles[hole] == 0) {
+            return;
+        }
+        hole = (hole + 1) & mask;
     }
-    
-     
-    if (month == 2) {
-        bool isLeapYear = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
-        if (isLeapYear && day > 29) {
-            return false;
-        } else if (!isLeapYear && day > 28) {
-            return false;
+    for (uint32_t next = (hole + 1) & mask; pool->internHandles[next] != 0; next = (next + 1) & mask) {
+        uint32_t home = pool->internHashes[next] & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            pool->internHandles[hole] = pool->internHandles[next];
+            pool->internHashes[hole] = pool->internHashes[next];
+            hole = next;
         }
     }
-    
-    return true;
+    pool->internHandles[hole] = 0;
+    pool->internCount--;
 }
 
  
-Task* getTaskAtIndex(TaskStack* stack, int index) {
-    if (index >= 0 && index <= stack->top) {
-        return &(stack->tasks[index]);
+/* Starts a new reclaim epoch and frees the strings retired two or more
+   epochs ago that nothing has taken back since. */
+static void reclaimPoolStrings(StringPool* pool) {
+    uint32_t kept = 0;
+    
+    pool->epoch++;
+    pool->retiredBytes = 0;
+    for (uint32_t i = 0; i < pool->retired.count; i++) {
+        uint32_t handle = pool->retired.handles[i];
+        uint32_t state = *poolStringState(pool, handle);
+        if ((state & 3) != STRING_RETIRED || atomic_load_explicit(poolStringRefs(pool, handle), memory_order_acquire) != 0) {
+            continue;
+        }
+        
+        char* text = poolText(pool, handle);
+        size_t size = stringSlotSize(strlen(text));
+        if (((pool->epoch - (state >> 2)) & (UINT32_MAX >> 2)) < 2) {
+            pool->retired.handles[kept++] = handle;
+            continue;
+        }
+        forgetInternedString(pool, handle);
+        if (!addStringSlot(&pool->freeSlots[size / 8], handle)) {
+            pool->retired.handles[kept++] = handle;
+            continue;
+        }
+        *poolStringState(pool, handle) = STRING_FREE;
+        text[0] = '\0';
+        pool->bytes -= size;
+        pool->freeBytes += size;
     }
-    return NULL;
+    pool->retired.count = kept;
 }
 
  
-bool removeTaskAtIndex(TaskStack* stack, int index, UndoStack* undoStack) {
-    if (index < 0 || index > stack->top) {
-        return false;
-    }
-    
-     
-    pushToUndoStack(undoStack, stack->tasks[index]);
-    
-     
-    TaskStack tempStack;
-    initializeStack(&tempStack);
+/* Stores the text in a free slot of its size, or else at the end of the
+   last block, starting a new one when it does not fit. The string starts
+   live with no references. Returns 0 when the pool is full or out of
+   memory. */
+static uint32_t appendPoolString(StringPool* pool, const char* text, size_t length) {
+    size_t size = stringSlotSize(length);
+    StringSlots* slots = &pool->freeSlots[size / 8];
+    uint32_t handle;
     
-     
-    Task task;
-    for (int i = stack->top; i > index; i--) {
-        popTask(stack, &task);
-        pushTask(&tempStack, task);
+    if (slots->count > 0) {
+        handle = slots->handles[--slots->count];
+        pool->freeBytes -= size;
+    } else {
+        if (pool->used + size > STRING_BLOCK_SIZE) {
+            char* block = pool->blockCount < STRING_MAX_BLOCKS ? (char*)calloc(1, STRING_BLOCK_SIZE) : NULL;
+            if (block == NULL) {
+                return 0;
+            }
+            pool->blocks[pool->blockCount++] = block;
+            pool->used = 0;
+        }
+        handle = ((pool->blockCount - 1) << STRING_BLOCK_SHIFT) | (pool->used + STRING_HEADER_SIZE);
+        pool->used += (uint32_t)size;
     }
     
-     
-    popTask(stack, &task);
-    
-     
-    while (!isEmptyStack(&tempStack)) {
-        popTask(&tempStack, &task);
-        pushTask(stack, task);
+    char* stored = poolText(pool, handle);
+    atomic_init(poolStringRefs(pool, handle), 0);
+    *poolStringState(pool, handle) = STRING_LIVE | pool->epoch << 2;
+    memcpy(stored, text, length);
+    stored[length] = '\0';
+    pool->bytes += size;
+    return handle;
+}
+
+ 
+/* Returns the handle of length bytes of text, reusing an equal string
+   when interning is on; 0 stands for the empty string and for failure. */
+static uint32_t storePoolString(const char* text, size_t length) {
+    StringPool* pool = &stringPool;
+    uint32_t handle = 0;
+    if (length == 0) {
+        return 0;
     }
     
-    return true;
+    pthread_mutex_lock(&pool->lock);
+    if (!pool->interning) {
+        handle = appendPoolString(pool, text, length);
+    } else if (pool->internCount * 2 < pool->internCapacity || growInternTable(pool)) {
+        uint32_t hash = hashText(text, length);
+        uint32_t slot = hash & (pool->internCapacity - 1);
+        while ((handle = pool->internHandles[slot]) != 0) {
+            const char* stored = poolText(pool, handle);
+            if (pool->internHashes[slot] == hash && memcmp(stored, text, length) == 0 && stored[length] == '\0') {
+                uint32_t* state = poolStringState(pool, handle);
+                *state = (*state & 3) | pool->epoch << 2;
+                break;
+            }
+            slot = (slot + 1) & (pool->internCapacity - 1);
+        }
+        if (handle == 0 && (handle = appendPoolString(pool, text, length)) != 0) {
+            pool->internHandles[slot] = handle;
+            pool->internHashes[slot] = hash;
+            pool->internCount++;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return handle;
 }
 
  
-bool editTaskAtIndex(TaskStack* stack, int index, Task newTask, UndoStack* undoStack) {
-    if (index < 0 || index > stack->top) {
-        return false;
+/* Stack slots and queued tasks each hold a reference on their text. Taking
+   one on a retired string brings it back: reclaim passes only free strings
+   nothing holds, and drop the others from the retired list. */
+static void retainTaskDescription(const Task* task) {
+    if (task->description != 0) {
+        atomic_fetch_add_explicit(poolStringRefs(&stringPool, task->description), 1, memory_order_relaxed);
     }
-    
-     
-    pushToUndoStack(undoStack, stack->tasks[index]);
-    
-     
-    TaskStack tempStack;
-    initializeStack(&tempStack);
-    
-     
-    Task task;
-    for (int i = stack->top; i > index; i--) {
-        popTask(stack, &task);
-        pushTask(&tempStack, task);
+}
+
+ 
+static void retirePoolString(StringPool* pool, uint32_t handle, size_t length) {
+    *poolStringState(pool, handle) = STRING_RETIRED | pool->epoch << 2;
+    if (addStringSlot(&pool->retired, handle)) {
+        pool->retiredBytes += stringSlotSize(length);
     }
-    
-     
-    popTask(stack, &task);
-    
-     
-    newTask.createdAt = task.createdAt;
-    
-     
-    pushTask(stack, newTask);
-    
-     
-    while (!isEmptyStack(&tempStack)) {
-        popTask(&tempStack, &task);
-        pushTask(stack, task);
+    if (pool->retiredBytes >= STRING_RECLAIM_BYTES) {
+        reclaimPoolStrings(pool);
     }
-    
-    return true;
 }
 
  
-void sortStackByDate(TaskStack* stack) {
-     
-    int size = getStackSize(*stack);
-    Task* tasks = (Task*)malloc(size * sizeof(Task));
-    
-     
-    TaskStack tempStack;
-    initializeStack(&tempStack);
-    
-     
-    for (int i = 0; i < size; i++) {
-        popTask(stack, &tasks[i]);
+static void releaseTaskDescription(const Task* task) {
+    StringPool* pool = &stringPool;
+    if (task->description == 0) {
+        return;
     }
     
-     
-    for (int i = 0; i < size - 1; i++) {
-        for (int j = 0; j < size - i - 1; j++) {
-            if (tasks[j].year > tasks[j + 1].year || 
-                (tasks[j].year == tasks[j + 1].year && tasks[j].month > tasks[j + 1].month) ||
-                (tasks[j].year == tasks[j + 1].year && tasks[j].month == tasks[j + 1].month && tasks[j].day > tasks[j + 1].day)) {
-                Task temp = tasks[j];
-                tasks[j] = tasks[j + 1];
-                tasks[j + 1] = temp;
-            }
+    atomic_uint* refs = poolStringRefs(pool, task->description);
+    unsigned count = atomic_load_explicit(refs, memory_order_relaxed);
+    while (count > 1) {
+        if (atomic_compare_exchange_weak_explicit(refs, &count, count - 1, memory_order_release,
+                                                  memory_order_relaxed)) {
+            return;
         }
     }
-    
-     
-    for (int i = size - 1; i >= 0; i--) {
-        pushTask(stack, tasks[i]);
+    pthread_mutex_lock(&pool->lock);
+    if (atomic_fetch_sub_explicit(refs, 1, memory_order_acq_rel) == 1) {
+        retirePoolString(pool, task->description, task->descriptionLength);
     }
-    
-    free(tasks);
+    pthread_mutex_unlock(&pool->lock);
 }
 
  
-void sortStackByImportance(TaskStack* stack) {
-     
-    int size = getStackSize(*stack);
-    Task* tasks = (Task*)malloc(size * sizeof(Task));
-    
-     
-    TaskStack tempStack;
-    initializeStack(&tempStack);
-    
-     
-    for (int i = 0; i < size; i++) {
-        popTask(stack, &tasks[i]);
+/* Releases the text of every live task in a chunk that is being freed,
+   under one lock. */
+static void releaseChunkDescriptions(const TaskChunk* chunk) {
+    StringPool* pool = &stringPool;
+    if (chunk->liveCount == 0) {
+        return;
     }
     
-     
-    for (int i = 0; i < size - 1; i++) {
-        for (int j = 0; j < size - i - 1; j++) {
-            if (tasks[j].importance < tasks[j + 1].importance) {
-                Task temp = tasks[j];
-                tasks[j] = tasks[j + 1];
-                tasks[j + 1] = temp;
+    pthread_mutex_lock(&pool->lock);
+    for (int w = 0; w < TASK_CHUNK_WORDS; w++) {
+        for (uint64_t bits = chunk->live[w]; bits != 0; bits &= bits - 1) {
+            const Task* task = &chunk->tasks[w * 64 + __builtin_ctzll(bits)];
+            if (task->description != 0 &&
+                atomic_fetch_sub_explicit(poolStringRefs(pool, task->description), 1, memory_order_acq_rel) == 1) {
+                retirePoolString(pool, task->description, task->descriptionLength);
             }
         }
     }
-    
-     
-    for (int i = size - 1; i >= 0; i--) {
-        pushTask(stack, tasks[i]);
-    }
-    
-    free(tasks);
+    pthread_mutex_unlock(&pool->lock);
 }
 
  
-void saveStackToFile(TaskStack stack) {
-    FILE* file = fopen(FILENAME, "wb");
-    if (file != NULL) {
-        int count = getStackSize(stack);
-        fwrite(&count, sizeof(int), 1, file);
-        fwrite(stack.tasks, sizeof(Task), count, file);
-        fclose(file);
+static void retainChunkDescriptions(const TaskChunk* chunk) {
+    for (int w = 0; w < TASK_CHUNK_WORDS; w++) {
+        for (uint64_t bits = chunk->live[w]; bits != 0; bits &= bits - 1) {
+            retainTaskDescription(&chunk->tasks[w * 64 + __builtin_ctzll(bits)]);
+        }
     }
 }
 
  
-bool loadStackFromFile(TaskStack* stack) {
-    FILE* file = fopen(FILENAME, "rb");
-    if (file != NULL) {
-        int count;
-        fread(&count, sizeof(int), 1, file);
-        
-         
-        initializeStack(stack);
-        
-         
-        Task* tasks = (Task*)malloc(count * sizeof(Task));
-        fread(tasks, sizeof(Task), count, file);
-        
-         
-        for (int i = count - 1; i >= 0; i--) {
-            pushTask(stack, tasks[i]);
-        }
-        
-        free(tasks);
-        fclose(file);
-        return true;
+static bool setTaskDescriptionText(Task* task, const char* text, size_t length) {
+    uint32_t handle = length < MAX_DESCRIPTION ? storePoolString(text, length) : 0;
+    if (handle == 0 && length > 0) {
+        return false;
     }
-    return false;
+    task->description = handle;
+    task->descriptionLength = (uint16_t)length;
+    return true;
 }
 
  
-void clearInputBuffer() {
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF);
+/* Stores the description in the string pool; fails, leaving the task as it
+   was, if it is MAX_DESCRIPTION bytes or longer or the pool is full. The
+   text stays readable while a stack or queue holds the task, and for two
+   reclaim passes after that. */
+bool setTaskDescription(Task* task, const char* text) {
+    return setTaskDescriptionText(task, text, strlen(text));
 }
 
  
-void displayTask(Task task, int index) {
-    char dateStr[20];
-    sprintf(dateStr, "%s %02d, %04d", monthNames[task.month - 1], task.day, task.year);
-    
-    printf("| %2d | %-30s | %-17s | %10d | %-11s |\n", 
-           index + 1, 
-           task.description, 
-           dateStr, 
-           task.importance, 
-           statusNames[task.status]);
+/* Turns deduplication of new descriptions on or off; strings already in
+   the pool keep their handles either way. */
+void setStringInterning(bool enabled) {
+    pthread_mutex_lock(&stringPool.lock);
+    stringPool.interning = enabled;
+    pthread_mutex_unlock(&stringPool.lock);
 }
 
  
-void displayAllTasks(TaskStack stack) {
-    int size = getStackSize(stack);
-    
-    if (size == 0) {
-        printf("| No tasks available.                                                         |\n");
+static bool sameDescription(const Task* a, const Task* b) {
+    return a->description == b->description ||
+           (a->descriptionLength == b->descriptionLength &&
+            memcmp(getTaskDescription(a), getTaskDescription(b), a->descriptionLength) == 0);
+}
+
+ 
+void initializeStack(TaskStack* stack) {
+    stack->table = NULL;
+    stack->chunks = NULL;
+    stack->liveTree = NULL;
+    stack->chunkCount = 0;
+    stack->chunkCapacity = 0;
+    stack->top = -1;
+    stack->size = 0;
+    stack->tombstones = 0;
+    stack->idSlots = NULL;
+    stack->nextId = 0;
+    stack->idCapacity = 0;
+    stack->keywordIndex = NULL;
+    stack->columns = NULL;
+    stack->heap = NULL;
+    stack->dueIndex = NULL;
+    stack->sortedViews = NULL;
+    stack->wal = NULL;
+    stack->undo = NULL;
+    stack->path = NULL;
+    stack->lsn = 0;
+    stack->generation = 0;
+}
+
+ 
+static void releaseTaskChunk(TaskChunk* chunk) {
+    if (atomic_fetch_sub_explicit(&chunk->refs, 1, memory_order_acq_rel) == 1) {
+        releaseChunkDescriptions(chunk);
+        free(chunk);
+    }
+}
+
+ 
+/* Drops one reference to the table; the last one frees it and releases
+   its chunks. Safe from any thread. */
+static void releaseChunkTable(ChunkTable* table) {
+    if (table == NULL || atomic_fetch_sub_explicit(&table->refs, 1, memory_order_acq_rel) != 1) {
         return;
     }
-    
-    drawLine(80);
-    printf("| %2s | %-30s | %-17s | %10s | %-11s |\n", 
-           "ID", "Description", "Due Date", "Importance", "Status");
-    drawLine(80);
-    
-    TaskStack tempStack;
-    initializeStack(&tempStack);
-    Task task;
-    
-     
-    TaskStack copyStack = stack;
-    
-     
-    Task* tasks = (Task*)malloc(size * sizeof(Task));
-    
-     
-    for (int i = 0; i < size; i++) {
-        popTask(&copyStack, &task);
-        tasks[i] = task;
+    for (int c = 0; c < table->count; c++) {
+        releaseTaskChunk(table->chunks[c]);
     }
-    
-     
-    for (int i = size - 1; i >= 0; i--) {
-        displayTask(tasks[i], size - 1 - i);
+    free(table);
+}
+
+ 
+/* Forgets the changes a sorted view has noted, once they are merged or
+   about to be rebuilt over. */
+static void clearSortedChanges(SortedView* view) {
+    for (int i = 0; i < view->changedCount; i++) {
+        view->marks[view->changed[i]] = 0;
     }
-    
-    free(tasks);
-    drawLine(80);
+    view->changedCount = 0;
 }
 
  
-void searchTasks(TaskStack stack, const char* keyword) {
-    bool found = false;
-    drawUIHeader();
-    printf("| Search Results for '%s':                                                |\n", keyword);
-    drawLine(80);
+static void markSortedViewStale(SortedView* view) {
+    clearSortedChanges(view);
+    view->stale = true;
+}
+
+ 
+void resetStack(TaskStack* stack) {
+    KeywordIndex* index = stack->keywordIndex;
+    TaskColumns* columns = stack->columns;
+    TaskHeap* heap = stack->heap;
+    DueIndex* dueIndex = stack->dueIndex;
+    SortedView* sortedViews = stack->sortedViews;
+    WriteAheadLog* wal = stack->wal;
+    UndoStack* undo = stack->undo;
+    const char* path = stack->path;
+    uint64_t lsn = stack->lsn;
     
-    int size = getStackSize(stack);
-    Task* tasks = (Task*)malloc(size * sizeof(Task));
-    TaskStack copyStack = stack;
-    Task task;
+    releaseChunkTable(stack->table);
+    free(stack->idSlots);
+    initializeStack(stack);
     
-     
-    for (int i = 0; i < size; i++) {
-        popTask(&copyStack, &task);
-        tasks[i] = task;
+    if (index != NULL) {
+        clearKeywordIndex(index);
+        stack->keywordIndex = index;
     }
-    
-     
-    printf("| %2s | %-30s | %-17s | %10s | %-11s |\n", 
-           "ID", "Description", "Due Date", "Importance", "Status");
-    drawLine(80);
-    
-    for (int i = size - 1; i >= 0; i--) {
-        if (strstr(tasks[i].description, keyword) != NULL) {
-            displayTask(tasks[i], size - 1 - i);
-            found = true;
-        }
+    if (columns != NULL) {
+        columns->poolUsed = 0;
+        columns->poolGarbage = 0;
+        stack->columns = columns;
     }
-    
-    free(tasks);
-    
-    if (!found) {
-        printf("| No tasks matching '%s' found.                                            |\n", keyword);
+    if (heap != NULL) {
+        clearTaskHeap(heap);
+        stack->heap = heap;
+    }
+    if (dueIndex != NULL) {
+        clearDueIndex(dueIndex);
+        stack->dueIndex = dueIndex;
+    }
+    for (SortedView* view = sortedViews; view != NULL; view = view->next) {
+        clearSortedChanges(view);
+        view->count = 0;
+        view->stale = false;
+    }
+    stack->sortedViews = sortedViews;
+    stack->wal = wal;
+    stack->undo = undo;
+    stack->path = path;
+    stack->lsn = lsn;
+    if (undo != NULL) {
+        clearUndoStack(undo);
     }
-    
-    drawUIFooter();
 }
 
  
-void drawUIHeader() {
-    system("clear || cls");  
-    drawLine(80);
-    printf("|                       TASK MANAGEMENT SYSTEM (STACK-BASED)                    |\n");
-    drawLine(80);
+static void rebuildLiveTree(TaskStack* stack) {
+    int n = stack->chunkCapacity;
+    for (int i = 1; i <= n; i++) {
+        stack->liveTree[i] = i - 1 < stack->chunkCount ? stack->chunks[i - 1]->liveCount : 0;
+    }
+    for (int i = 1; i <= n; i++) {
+        int parent = i + (i & -i);
+        if (parent <= n) {
+            stack->liveTree[parent] += stack->liveTree[i];
+        }
+    }
 }
 
-void drawUIFooter() {
-    drawLine(80);
-    printf("| Press Enter to continue...                                                    |\n");
-    drawLine(80);
-    clearInputBuffer();
+ 
+static void updateLiveTree(TaskStack* stack, int chunk, int delta) {
+    for (int i = chunk + 1; i <= stack->chunkCapacity; i += i & -i) {
+        stack->liveTree[i] += delta;
+    }
 }
 
-void drawLine(int width) {
-    printf("+");
-    for (int i = 0; i < width - 2; i++) {
-        printf("-");
+ 
+/* Makes the chunk table private to the stack, with room for capacity
+   chunks. A table a view still holds is copied, taking a reference on
+   each chunk; a private one is grown in place. */
+static bool ownChunkTable(TaskStack* stack, int capacity) {
+    ChunkTable* table = stack->table;
+    bool shared = table != NULL && atomic_load_explicit(&table->refs, memory_order_acquire) > 1;
+    if (table != NULL && !shared && capacity <= stack->chunkCapacity) {
+        return true;
     }
-    printf("+\n");
+    
+    size_t bytes = sizeof(ChunkTable) + capacity * sizeof(TaskChunk*) + (capacity + 1) * sizeof(int);
+    ChunkTable* owned = (ChunkTable*)(shared ? malloc(bytes) : realloc(table, bytes));
+    if (owned == NULL) {
+        return false;
+    }
+    if (shared) {
+        for (int c = 0; c < stack->chunkCount; c++) {
+            owned->chunks[c] = table->chunks[c];
+            atomic_fetch_add_explicit(&table->chunks[c]->refs, 1, memory_order_relaxed);
+        }
+        releaseChunkTable(table);
+    }
+    atomic_init(&owned->refs, 1);
+    owned->count = stack->chunkCount;
+    owned->liveTree = (int*)(owned->chunks + capacity);
+    stack->table = owned;
+    stack->chunks = owned->chunks;
+    stack->liveTree = owned->liveTree;
+    stack->chunkCapacity = capacity;
+    rebuildLiveTree(stack);
+    return true;
 }
 
  
-int main() {
-    TaskStack taskStack;
-    UndoStack undoStack;
-    Task newTask;
-    char searchKeyword[MAX_DESCRIPTION];
-    int taskIndex, taskNumber;
-    
-    initializeStack(&taskStack);
-    initializeUndoStack(&undoStack);
-    
+/* Gives the stack its own copy of chunks first..last before they are
+   written, where a view opened since they were last copied may hold
+   them. Returns false when out of memory; the tasks are unchanged. */
+static bool unshareChunks(TaskStack* stack, int first, int last) {
+    for (int c = first; c <= last; c++) {
+        if (stack->chunks[c]->generation == stack->generation) {
+            continue;
+        }
+        if (!ownChunkTable(stack, stack->chunkCapacity)) {
+            return false;
+        }
+        
+        TaskChunk* chunk = stack->chunks[c];
+        if (atomic_load_explicit(&chunk->refs, memory_order_acquire) > 1) {
+            TaskChunk* copy = (TaskChunk*)malloc(sizeof(TaskChunk));
+            if (copy == NULL) {
+                return false;
+            }
+            memcpy(copy->tasks, chunk->tasks, sizeof(chunk->tasks));
+            memcpy(copy->live, chunk->live, sizeof(chunk->live));
+            copy->liveCount = chunk->liveCount;
+            retainChunkDescriptions(copy);
+            atomic_init(&copy->refs, 1);
+            stack->chunks[c] = copy;
+            releaseTaskChunk(chunk);
+        }
+        stack->chunks[c]->generation = stack->generation;
+    }
+    return true;
+}
+
+ 
+/* Opens a read-only view of the stack as it is now, in O(1): the view
+   shares the chunk table, and the stack copies a chunk, or the table, the
+   first time it writes one an open view can see. The view has none of the
+   stack's attachments, so displays, searches, filters and snapshots taken
+   from it scan the tasks. Open views on the thread that writes the stack;
+   a view may be read and closed on any thread. */
+void openStackView(TaskStack* stack, TaskStack* view) {
+    initializeStack(view);
+    if (stack->table == NULL) {
+        return;
+    }
+    
+    atomic_fetch_add_explicit(&stack->table->refs, 1, memory_order_relaxed);
+    stack->generation++;
+    view->table = stack->table;
+    view->chunks = stack->chunks;
+    view->liveTree = stack->liveTree;
+    view->chunkCount = stack->chunkCount;
+    view->chunkCapacity = stack->chunkCapacity;
+    view->top = stack->top;
+    view->size = stack->size;
+    view->tombstones = stack->tombstones;
+    view->path = stack->path;
+    view->lsn = stack->lsn;
+    view->generation = stack->generation;
+}
+
+ 
+/* Releases the view; chunks no longer held by the stack or another view
+   are freed. */
+void closeStackView(TaskStack* view) {
+    releaseChunkTable(view->table);
+    initializeStack(view);
+}
+
+ 
+static bool reserveTaskSlot(TaskStack* stack, int slot) {
+    int chunk = slot >> TASK_CHUNK_SHIFT;
+    if (chunk < stack->chunkCount) {
+        return true;
+    }
+    
+    int capacity = stack->chunkCapacity;
+    if (stack->chunkCount == capacity) {
+        capacity = capacity ? capacity * 2 : 16;
+    }
+    if (!ownChunkTable(stack, capacity)) {
+        return false;
+    }
+    
+    TaskChunk* chunkTasks = (TaskChunk*)malloc(sizeof(TaskChunk));
+    if (chunkTasks == NULL) {
+        return false;
+    }
+    memset(chunkTasks->live, 0, sizeof(chunkTasks->live));
+    chunkTasks->liveCount = 0;
+    atomic_init(&chunkTasks->refs, 1);
+    chunkTasks->generation = stack->generation;
+    stack->chunks[stack->chunkCount++] = chunkTasks;
+    stack->table->count = stack->chunkCount;
+    return true;
+}
+
+ 
+static inline Task* taskSlot(const TaskStack* stack, int slot) {
+    return &stack->chunks[slot >> TASK_CHUNK_SHIFT]->tasks[slot & TASK_CHUNK_MASK];
+}
+
+ 
+static inline bool isSlotLive(const TaskStack* stack, int slot) {
+    const TaskChunk* chunk = stack->chunks[slot >> TASK_CHUNK_SHIFT];
+    return (chunk->live[(slot & TASK_CHUNK_MASK) >> 6] >> (slot & 63)) & 1;
+}
+
+ 
+static void markSlot(TaskStack* stack, int slot, bool live) {
+    TaskChunk* chunk = stack->chunks[slot >> TASK_CHUNK_SHIFT];
+    uint64_t bit = (uint64_t)1 << (slot & 63);
+    uint64_t* word = &chunk->live[(slot & TASK_CHUNK_MASK) >> 6];
+    
+    if (live) {
+        *word |= bit;
+        chunk->liveCount++;
+        stack->size++;
+    } else {
+        *word &= ~bit;
+        chunk->liveCount--;
+        stack->size--;
+    }
+    updateLiveTree(stack, slot >> TASK_CHUNK_SHIFT, live ? 1 : -1);
+}
+
+ 
+/* Maps a bottom-based stack index to its physical slot in O(log n). */
+static int slotForIndex(const TaskStack* stack, int index) {
+    if (stack->tombstones == 0) {
+        return index;
+    }
+    
+    int chunk = 0;
+    int remaining = index;
+    int step = 1;
+    while (step * 2 <= stack->chunkCapacity) {
+        step *= 2;
+    }
+    for (; step > 0; step /= 2) {
+        int next = chunk + step;
+        if (next <= stack->chunkCapacity && stack->liveTree[next] <= remaining) {
+            chunk = next;
+            remaining -= stack->liveTree[next];
+        }
+    }
+    
+    const TaskChunk* tasks = stack->chunks[chunk];
+    for (int w = 0; w < TASK_CHUNK_WORDS; w++) {
+        int count = __builtin_popcountll(tasks->live[w]);
+        if (remaining < count) {
+            uint64_t bits = tasks->live[w];
+            while (remaining-- > 0) {
+                bits &= bits - 1;
+            }
+            return (chunk << TASK_CHUNK_SHIFT) + w * 64 + __builtin_ctzll(bits);
+        }
+        remaining -= count;
+    }
+    return -1;
+}
+
+ 
+ 
+void initializeTaskColumns(TaskColumns* columns) {
+    memset(columns, 0, sizeof(*columns));
+}
+
+ 
+void freeTaskColumns(TaskColumns* columns) {
+    free(columns->importance);
+    free(columns->status);
+    free(columns->dueKey);
+    free(columns->createdAt);
+    free(columns->descriptionOffset);
+    free(columns->pool);
+    initializeTaskColumns(columns);
+}
+
+ 
+static void* growColumn(void* column, size_t width, int used, int capacity) {
+    char* grown = (char*)realloc(column, (size_t)capacity * width);
+    if (grown != NULL) {
+        memset(grown + (size_t)used * width, 0, (size_t)(capacity - used) * width);
+    }
+    return grown;
+}
+
+ 
+/* Grows every column to cover whole chunks up to slot; the new rows are
+   zeroed so filters can read full 64-slot words. */
+static bool reserveColumnRows(TaskColumns* columns, int slot) {
+    if (slot < columns->capacity) {
+        return true;
+    }
+    
+    int capacity = columns->capacity ? columns->capacity : TASK_CHUNK_SIZE;
+    while (capacity <= slot) {
+        capacity = capacity > INT_MAX / 2 ? MAX_TASKS + TASK_CHUNK_SIZE : capacity * 2;
+    }
+    
+    void* grown;
+    if ((grown = growColumn(columns->importance, sizeof(int32_t), columns->capacity, capacity)) == NULL) {
+        return false;
+    }
+    columns->importance = (int32_t*)grown;
+    if ((grown = growColumn(columns->status, sizeof(uint8_t), columns->capacity, capacity)) == NULL) {
+        return false;
+    }
+    columns->status = (uint8_t*)grown;
+    if ((grown = growColumn(columns->dueKey, sizeof(int32_t), columns->capacity, capacity)) == NULL) {
+        return false;
+    }
+    columns->dueKey = (int32_t*)grown;
+    if ((grown = growColumn(columns->createdAt, sizeof(int64_t), columns->capacity, capacity)) == NULL) {
+        return false;
+    }
+    columns->createdAt = (int64_t*)grown;
+    if ((grown = growColumn(columns->descriptionOffset, sizeof(uint32_t), columns->capacity, capacity)) == NULL) {
+        return false;
+    }
+    columns->descriptionOffset = (uint32_t*)grown;
+    
+    columns->capacity = capacity;
+    return true;
+}
+
+ 
+static bool reservePoolBytes(TaskColumns* columns, size_t length) {
+    size_t needed = columns->poolUsed + length + STRING_POOL_PADDING;
+    if (needed <= columns->poolCapacity) {
+        return true;
+    }
+    if (needed > UINT32_MAX) {
+        return false;
+    }
+    
+    size_t capacity = columns->poolCapacity ? columns->poolCapacity : 64 * 1024;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    char* pool = (char*)realloc(columns->pool, capacity);
+    if (pool == NULL) {
+        return false;
+    }
+    columns->pool = pool;
+    columns->poolCapacity = capacity;
+    return true;
+}
+
+ 
+static bool writeColumnRow(TaskColumns* columns, int slot, const Task* task) {
+    size_t length = task->descriptionLength + 1;
+    if (!reserveColumnRows(columns, slot) || !reservePoolBytes(columns, length)) {
+        return false;
+    }
+    
+    columns->importance[slot] = task->importance;
+    columns->status[slot] = (uint8_t)task->status;
+    columns->dueKey[slot] = task->dueKey;
+    columns->createdAt[slot] = (int64_t)task->createdAt;
+    columns->descriptionOffset[slot] = (uint32_t)columns->poolUsed;
+    memcpy(columns->pool + columns->poolUsed, getTaskDescription(task), length - 1);
+    columns->pool[columns->poolUsed + length - 1] = '\0';
+    columns->poolUsed += length;
+    return true;
+}
+
+ 
+/* Rewrites the columns from the live tasks in slot order, which also repacks
+   the description pool. Columns that cannot be rebuilt are detached. */
+static void rebuildTaskColumns(TaskStack* stack) {
+    TaskColumns* columns = stack->columns;
+    TaskCursor cursor;
+    const Task* task;
+    
+    columns->poolUsed = 0;
+    columns->poolGarbage = 0;
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        if (!writeColumnRow(columns, cursor.slot, task)) {
+            stack->columns = NULL;
+            return;
+        }
+    }
+}
+
+ 
+/* Appends the row for a task just written to slot; once the pool is mostly
+   garbage the whole store is rebuilt instead, which picks the task up too. */
+static void storeTaskColumns(TaskStack* stack, int slot) {
+    TaskColumns* columns = stack->columns;
+    if (columns->poolGarbage > 64 * 1024 && columns->poolGarbage > columns->poolUsed / 2) {
+        rebuildTaskColumns(stack);
+    } else if (!writeColumnRow(stack->columns, slot, taskSlot(stack, slot))) {
+        stack->columns = NULL;
+    }
+}
+
+ 
+static void releaseTaskColumns(TaskStack* stack, int slot) {
+    TaskColumns* columns = stack->columns;
+    columns->poolGarbage += strlen(columns->pool + columns->descriptionOffset[slot]) + 1;
+}
+
+ 
+void attachTaskColumns(TaskStack* stack, TaskColumns* columns) {
+    stack->columns = columns;
+    rebuildTaskColumns(stack);
+}
+
+ 
+void detachTaskColumns(TaskStack* stack) {
+    stack->columns = NULL;
+}
+
+ 
+static void trimTombstones(TaskStack* stack) {
+    while (stack->top >= 0 && !isSlotLive(stack, stack->top)) {
+        stack->top--;
+        stack->tombstones--;
+    }
+}
+
+ 
+void compactStack(TaskStack* stack) {
+    int write = 0;
+    if (!unshareChunks(stack, 0, stack->chunkCount - 1)) {
+        return;
+    }
+    for (int slot = 0; slot <= stack->top; slot++) {
+        if (isSlotLive(stack, slot)) {
+            if (write != slot) {
+                *taskSlot(stack, write) = *taskSlot(stack, slot);
+                stack->idSlots[taskSlot(stack, write)->id] = write;
+            }
+            write++;
+        }
+    }
+    
+    for (int c = 0; c < stack->chunkCount; c++) {
+        TaskChunk* chunk = stack->chunks[c];
+        int first = c << TASK_CHUNK_SHIFT;
+        int used = write - first;
+        used = used < 0 ? 0 : (used > TASK_CHUNK_SIZE ? TASK_CHUNK_SIZE : used);
+        
+        memset(chunk->live, 0, sizeof(chunk->live));
+        for (int w = 0; w < used / 64; w++) {
+            chunk->live[w] = ~(uint64_t)0;
+        }
+        if (used % 64) {
+            chunk->live[used / 64] = ((uint64_t)1 << (used % 64)) - 1;
+        }
+        chunk->liveCount = used;
+    }
+    
+    stack->top = write - 1;
+    stack->tombstones = 0;
+    rebuildLiveTree(stack);
+    
+    if (stack->columns != NULL) {
+        rebuildTaskColumns(stack);
+    }
+}
+
+ 
+/* Maps a physical slot back to its bottom-based stack index in O(log n). */
+static int indexForSlot(const TaskStack* stack, int slot) {
+    if (stack->tombstones == 0) {
+        return slot;
+    }
+    
+    int chunk = slot >> TASK_CHUNK_SHIFT;
+    int index = 0;
+    for (int i = chunk; i > 0; i -= i & -i) {
+        index += stack->liveTree[i];
+    }
+    
+    const TaskChunk* tasks = stack->chunks[chunk];
+    int offset = slot & TASK_CHUNK_MASK;
+    for (int w = 0; w < offset >> 6; w++) {
+        index += __builtin_popcountll(tasks->live[w]);
+    }
+    if (offset & 63) {
+        index += __builtin_popcountll(tasks->live[offset >> 6] & (((uint64_t)1 << (offset & 63)) - 1));
+    }
+    return index;
+}
+
+ 
+static void initializePostingList(PostingList* list) {
+    list->ids = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+ 
+static int postingLowerBound(const PostingList* list, uint32_t id) {
+    int low = 0, high = list->count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (list->ids[mid] < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+ 
+static bool insertPosting(PostingList* list, uint32_t id) {
+    int position = list->count;
+    if (list->count > 0 && list->ids[list->count - 1] >= id) {
+        position = postingLowerBound(list, id);
+        if (list->ids[position] == id) {
+            return true;
+        }
+    }
+    
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 4;
+        uint32_t* ids = (uint32_t*)realloc(list->ids, capacity * sizeof(uint32_t));
+        if (ids == NULL) {
+            return false;
+        }
+        list->ids = ids;
+        list->capacity = capacity;
+    }
+    
+    memmove(list->ids + position + 1, list->ids + position, (list->count - position) * sizeof(uint32_t));
+    list->ids[position] = id;
+    list->count++;
+    return true;
+}
+
+ 
+static void erasePosting(PostingList* list, uint32_t id) {
+    int position = postingLowerBound(list, id);
+    if (position < list->count && list->ids[position] == id) {
+        memmove(list->ids + position, list->ids + position + 1, (list->count - position - 1) * sizeof(uint32_t));
+        list->count--;
+    }
+}
+
+ 
+/* Copies the next lowercase alphanumeric token out of *text; bytes of UTF-8
+   sequences count as token characters. Returns the token length, 0 at end. */
+static int nextToken(const char** text, char* token) {
+    const unsigned char* p = (const unsigned char*)*text;
+    
+    while (*p && !(isalnum(*p) || *p >= 0x80)) {
+        p++;
+    }
+    int length = 0;
+    while (*p && (isalnum(*p) || *p >= 0x80)) {
+        if (length < MAX_TOKEN_LENGTH - 1) {
+            token[length++] = (char)tolower(*p);
+        }
+        p++;
+    }
+    token[length] = '\0';
+    *text = (const char*)p;
+    return length;
+}
+
+ 
+static uint32_t hashToken(const char* token) {
+    uint32_t hash = 2166136261u;
+    while (*token) {
+        hash = (hash ^ (unsigned char)*token++) * 16777619u;
+    }
+    return hash;
+}
+
+ 
+void initializeKeywordIndex(KeywordIndex* index) {
+    index->entries = NULL;
+    index->capacity = 0;
+    index->used = 0;
+    index->sortedEntries = NULL;
+    index->sortedCount = 0;
+    index->sortedDirty = false;
+}
+
+ 
+void freeKeywordIndex(KeywordIndex* index) {
+    for (int i = 0; i < index->capacity; i++) {
+        free(index->entries[i].token);
+        free(index->entries[i].postings.ids);
+    }
+    free(index->entries);
+    free(index->sortedEntries);
+    initializeKeywordIndex(index);
+}
+
+ 
+void clearKeywordIndex(KeywordIndex* index) {
+    for (int i = 0; i < index->capacity; i++) {
+        index->entries[i].postings.count = 0;
+    }
+}
+
+ 
+static bool growKeywordIndex(KeywordIndex* index) {
+    int capacity = index->capacity ? index->capacity * 2 : 1024;
+    IndexEntry* entries = (IndexEntry*)calloc(capacity, sizeof(IndexEntry));
+    if (entries == NULL) {
+        return false;
+    }
+    
+    for (int i = 0; i < index->capacity; i++) {
+        IndexEntry* entry = &index->entries[i];
+        if (entry->token != NULL) {
+            int slot = entry->hash & (capacity - 1);
+            while (entries[slot].token != NULL) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            entries[slot] = *entry;
+        }
+    }
+    
+    free(index->entries);
+    index->entries = entries;
+    index->capacity = capacity;
+    index->sortedDirty = true;
+    return true;
+}
+
+ 
+static IndexEntry* findIndexEntry(KeywordIndex* index, const char* token, bool create) {
+    if (create && (index->used + 1) * 10 > index->capacity * 7 && !growKeywordIndex(index)) {
+        return NULL;
+    }
+    if (index->capacity == 0) {
+        return NULL;
+    }
+    
+    uint32_t hash = hashToken(token);
+    int slot = hash & (index->capacity - 1);
+    while (index->entries[slot].token != NULL) {
+        IndexEntry* entry = &index->entries[slot];
+        if (entry->hash == hash && strcmp(entry->token, token) == 0) {
+            return entry;
+        }
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+    if (!create) {
+        return NULL;
+    }
+    
+    IndexEntry* entry = &index->entries[slot];
+    entry->token = strdup(token);
+    if (entry->token == NULL) {
+        return NULL;
+    }
+    entry->hash = hash;
+    initializePostingList(&entry->postings);
+    index->used++;
+    index->sortedDirty = true;
+    return entry;
+}
+
+ 
+static void indexTask(KeywordIndex* index, const Task* task, bool add) {
+    const char* text = getTaskDescription(task);
+    char token[MAX_TOKEN_LENGTH];
+    
+    while (nextToken(&text, token) > 0) {
+        IndexEntry* entry = findIndexEntry(index, token, add);
+        if (entry == NULL) {
+            continue;
+        }
+        if (add) {
+            insertPosting(&entry->postings, task->id);
+        } else {
+            erasePosting(&entry->postings, task->id);
+        }
+    }
+}
+
+ 
+void attachKeywordIndex(TaskStack* stack, KeywordIndex* index) {
+    TaskCursor cursor;
+    const Task* task;
+    
+    clearKeywordIndex(index);
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        indexTask(index, task, true);
+    }
+    stack->keywordIndex = index;
+}
+
+ 
+void initializeTaskHeap(TaskHeap* heap) {
+    heap->entries = NULL;
+    heap->count = 0;
+    heap->capacity = 0;
+    heap->positions = NULL;
+    heap->positionCapacity = 0;
+}
+
+ 
+void freeTaskHeap(TaskHeap* heap) {
+    free(heap->entries);
+    free(heap->positions);
+    initializeTaskHeap(heap);
+}
+
+ 
+void clearTaskHeap(TaskHeap* heap) {
+    heap->count = 0;
+    for (uint32_t i = 0; i < heap->positionCapacity; i++) {
+        heap->positions[i] = -1;
+    }
+}
+
+ 
+static inline bool isHeapTask(const Task* task) {
+    return task->status != COMPLETED;
+}
+
+ 
+/* Higher importance first, then the earlier due date, then the older task;
+   the id breaks exact ties so the order is deterministic. */
+static inline bool heapEntryBefore(const HeapEntry* a, const HeapEntry* b) {
+    if (a->importance != b->importance) {
+        return a->importance > b->importance;
+    }
+    if (a->dueKey != b->dueKey) {
+        return a->dueKey < b->dueKey;
+    }
+    if (a->createdAt != b->createdAt) {
+        return a->createdAt < b->createdAt;
+    }
+    return a->id < b->id;
+}
+
+ 
+static void siftHeapUp(TaskHeap* heap, int position) {
+    HeapEntry entry = heap->entries[position];
+    while (position > 0) {
+        int parent = (position - 1) / HEAP_ARITY;
+        if (!heapEntryBefore(&entry, &heap->entries[parent])) {
+            break;
+        }
+        heap->entries[position] = heap->entries[parent];
+        heap->positions[heap->entries[position].id] = position;
+        position = parent;
+    }
+    heap->entries[position] = entry;
+    heap->positions[entry.id] = position;
+}
+
+ 
+static void siftHeapDown(TaskHeap* heap, int position) {
+    HeapEntry entry = heap->entries[position];
+    for (;;) {
+        int first = position * HEAP_ARITY + 1;
+        if (first >= heap->count) {
+            break;
+        }
+        int last = first + HEAP_ARITY < heap->count ? first + HEAP_ARITY : heap->count;
+        int best = first;
+        for (int child = first + 1; child < last; child++) {
+            if (heapEntryBefore(&heap->entries[child], &heap->entries[best])) {
+                best = child;
+            }
+        }
+        if (!heapEntryBefore(&heap->entries[best], &entry)) {
+            break;
+        }
+        heap->entries[position] = heap->entries[best];
+        heap->positions[heap->entries[position].id] = position;
+        position = best;
+    }
+    heap->entries[position] = entry;
+    heap->positions[entry.id] = position;
+}
+
+ 
+static bool reserveHeapPositions(TaskHeap* heap, uint32_t id) {
+    if (id < heap->positionCapacity) {
+        return true;
+    }
+    uint32_t capacity = heap->positionCapacity ? heap->positionCapacity : 1024;
+    while (capacity <= id) {
+        capacity *= 2;
+    }
+    int* positions = (int*)realloc(heap->positions, capacity * sizeof(int));
+    if (positions == NULL) {
+        return false;
+    }
+    for (uint32_t i = heap->positionCapacity; i < capacity; i++) {
+        positions[i] = -1;
+    }
+    heap->positions = positions;
+    heap->positionCapacity = capacity;
+    return true;
+}
+
+ 
+/* Adds an unfinished task; completed tasks are left out. Returns false only
+   when memory runs out. */
+static bool addHeapTask(TaskHeap* heap, const Task* task) {
+    if (!isHeapTask(task)) {
+        return true;
+    }
+    if (!reserveHeapPositions(heap, task->id)) {
+        return false;
+    }
+    if (heap->count == heap->capacity) {
+        int capacity = heap->capacity ? heap->capacity * 2 : 1024;
+        HeapEntry* entries = (HeapEntry*)realloc(heap->entries, capacity * sizeof(HeapEntry));
+        if (entries == NULL) {
+            return false;
+        }
+        heap->entries = entries;
+        heap->capacity = capacity;
+    }
+    
+    HeapEntry* entry = &heap->entries[heap->count++];
+    entry->importance = task->importance;
+    entry->dueKey = task->dueKey;
+    entry->createdAt = (int64_t)task->createdAt;
+    entry->id = task->id;
+    siftHeapUp(heap, heap->count - 1);
+    return true;
+}
+
+ 
+static void eraseHeapTask(TaskHeap* heap, uint32_t id) {
+    int position = id < heap->positionCapacity ? heap->positions[id] : -1;
+    if (position < 0) {
+        return;
+    }
+    heap->positions[id] = -1;
+    if (position < --heap->count) {
+        HeapEntry moved = heap->entries[heap->count];
+        heap->entries[position] = moved;
+        siftHeapDown(heap, position);
+        siftHeapUp(heap, heap->positions[moved.id]);
+    }
+}
+
+ 
+/* The stack's hooks call this with the task as it is before (`removed`)
+   and after (`added`) a change; either may be NULL. A heap that cannot grow
+   is detached rather than left inconsistent. */
+static void updateTaskHeap(TaskStack* stack, const Task* removed, const Task* added) {
+    if (removed != NULL) {
+        eraseHeapTask(stack->heap, removed->id);
+    }
+    if (added != NULL && !addHeapTask(stack->heap, added)) {
+        stack->heap = NULL;
+    }
+}
+
+ 
+/* Rebuilds the heap from the stack in O(n) and attaches it. */
+void attachTaskHeap(TaskStack* stack, TaskHeap* heap) {
+    TaskCursor cursor;
+    const Task* task;
+    
+    clearTaskHeap(heap);
+    stack->heap = NULL;
+    if (stack->nextId > 0 && !reserveHeapPositions(heap, stack->nextId - 1)) {
+        return;
+    }
+    if (heap->capacity < stack->size) {
+        HeapEntry* entries = (HeapEntry*)realloc(heap->entries, stack->size * sizeof(HeapEntry));
+        if (entries == NULL) {
+            return;
+        }
+        heap->entries = entries;
+        heap->capacity = stack->size;
+    }
+    
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        if (isHeapTask(task)) {
+            HeapEntry* entry = &heap->entries[heap->count];
+            entry->importance = task->importance;
+            entry->dueKey = task->dueKey;
+            entry->createdAt = (int64_t)task->createdAt;
+            entry->id = task->id;
+            heap->positions[task->id] = heap->count++;
+        }
+    }
+    for (int position = heap->count / HEAP_ARITY; position >= 0; position--) {
+        if (position < heap->count) {
+            siftHeapDown(heap, position);
+        }
+    }
+    stack->heap = heap;
+}
+
+ 
+void detachTaskHeap(TaskStack* stack) {
+    stack->heap = NULL;
+}
+
+ 
+/* Copies out the most important unfinished task in O(1), with its stack
+   index if `index` is not NULL. The stack order is not touched. */
+bool peekPriorityTask(const TaskStack* stack, Task* task, int* index) {
+    const TaskHeap* heap = stack->heap;
+    if (heap == NULL || heap->count == 0) {
+        return false;
+    }
+    int slot = stack->idSlots[heap->entries[0].id];
+    *task = *taskSlot(stack, slot);
+    if (index != NULL) {
+        *index = indexForSlot(stack, slot);
+    }
+    return true;
+}
+
+ 
+/* Removes the most important unfinished task from wherever it sits in the
+   stack, in O(log n). Goes through removeTaskAtIndex, so the change is
+   logged and can be undone like any other removal. */
+bool popPriorityTask(TaskStack* stack, Task* task) {
+    int index;
+    return peekPriorityTask(stack, task, &index) && removeTaskAtIndex(stack, index);
+}
+
+ 
+void initializeDueIndex(DueIndex* index) {
+    memset(index, 0, sizeof(*index));
+}
+
+ 
+void clearDueIndex(DueIndex* index) {
+    for (int i = 0; i < index->leafCount; i++) {
+        free(index->leaves[i]);
+    }
+    index->leafCount = 0;
+    index->count = 0;
+    index->monthCount = 0;
+}
+
+ 
+void freeDueIndex(DueIndex* index) {
+    clearDueIndex(index);
+    free(index->leaves);
+    free(index->lows);
+    free(index->months);
+    initializeDueIndex(index);
+}
+
+ 
+static inline bool dueEntryBefore(DueEntry a, DueEntry b) {
+    return a.dueKey != b.dueKey ? a.dueKey < b.dueKey : a.id < b.id;
+}
+
+ 
+/* The last leaf whose first entry does not come after `entry`, or 0. */
+static int findDueLeaf(const DueIndex* index, DueEntry entry) {
+    int low = 0;
+    int high = index->leafCount - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (dueEntryBefore(entry, index->lows[middle])) {
+            high = middle - 1;
+        } else {
+            low = middle;
+        }
+    }
+    return low;
+}
+
+ 
+/* The first position in the leaf whose entry does not come before `entry`. */
+static int findDuePosition(const DueLeaf* leaf, DueEntry entry) {
+    int low = 0;
+    int high = leaf->count;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (dueEntryBefore(leaf->entries[middle], entry)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+ 
+static DueLeaf* insertDueLeaf(DueIndex* index, int position) {
+    if (index->leafCount == index->leafCapacity) {
+        int capacity = index->leafCapacity ? index->leafCapacity * 2 : 64;
+        DueLeaf** leaves = (DueLeaf**)realloc(index->leaves, capacity * sizeof(DueLeaf*));
+        if (leaves == NULL) {
+            return NULL;
+        }
+        index->leaves = leaves;
+        DueEntry* lows = (DueEntry*)realloc(index->lows, capacity * sizeof(DueEntry));
+        if (lows == NULL) {
+            return NULL;
+        }
+        index->lows = lows;
+        index->leafCapacity = capacity;
+    }
+    DueLeaf* leaf = (DueLeaf*)malloc(sizeof(DueLeaf));
+    if (leaf == NULL) {
+        return NULL;
+    }
+    leaf->count = 0;
+    memmove(&index->leaves[position + 1], &index->leaves[position],
+            (index->leafCount - position) * sizeof(DueLeaf*));
+    memmove(&index->lows[position + 1], &index->lows[position], (index->leafCount - position) * sizeof(DueEntry));
+    index->leaves[position] = leaf;
+    index->leafCount++;
+    return leaf;
+}
+
+ 
+static void removeDueLeaf(DueIndex* index, int position) {
+    free(index->leaves[position]);
+    memmove(&index->leaves[position], &index->leaves[position + 1],
+            (index->leafCount - position - 1) * sizeof(DueLeaf*));
+    memmove(&index->lows[position], &index->lows[position + 1],
+            (index->leafCount - position - 1) * sizeof(DueEntry));
+    index->leafCount--;
+}
+
+ 
+/* Adjusts the number of tasks due in the month of dueKey; months with no
+   tasks left are dropped. */
+static bool countDueMonth(DueIndex* index, int32_t dueKey, int delta) {
+    int32_t monthKey = dueKey / 100;
+    int low = 0;
+    int high = index->monthCount;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (index->months[middle].monthKey < monthKey) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    if (low < index->monthCount && index->months[low].monthKey == monthKey) {
+        index->months[low].count += delta;
+        if (index->months[low].count == 0) {
+            memmove(&index->months[low], &index->months[low + 1],
+                    (index->monthCount - low - 1) * sizeof(DueMonth));
+            index->monthCount--;
+        }
+        return true;
+    }
+    if (index->monthCount == index->monthCapacity) {
+        int capacity = index->monthCapacity ? index->monthCapacity * 2 : 32;
+        DueMonth* months = (DueMonth*)realloc(index->months, capacity * sizeof(DueMonth));
+        if (months == NULL) {
+            return false;
+        }
+        index->months = months;
+        index->monthCapacity = capacity;
+    }
+    memmove(&index->months[low + 1], &index->months[low], (index->monthCount - low) * sizeof(DueMonth));
+    index->months[low].monthKey = monthKey;
+    index->months[low].count = delta;
+    index->monthCount++;
+    return true;
+}
+
+ 
+/* A full leaf is split in half, except at the very end of the index where
+   appends in date order would otherwise leave every leaf half empty. */
+static bool addDueEntry(DueIndex* index, int32_t dueKey, uint32_t id) {
+    DueEntry entry = { dueKey, id };
+    if (index->leafCount == 0 && insertDueLeaf(index, 0) == NULL) {
+        return false;
+    }
+    
+    int l = findDueLeaf(index, entry);
+    DueLeaf* leaf = index->leaves[l];
+    if (leaf->count == DUE_LEAF_SIZE) {
+        bool append = l == index->leafCount - 1 && dueEntryBefore(leaf->entries[DUE_LEAF_SIZE - 1], entry);
+        int keep = append ? DUE_LEAF_SIZE : DUE_LEAF_SIZE / 2;
+        DueLeaf* sibling = insertDueLeaf(index, l + 1);
+        if (sibling == NULL) {
+            return false;
+        }
+        sibling->count = DUE_LEAF_SIZE - keep;
+        memcpy(sibling->entries, leaf->entries + keep, sibling->count * sizeof(DueEntry));
+        leaf->count = keep;
+        index->lows[l + 1] = append ? entry : sibling->entries[0];
+        if (append || !dueEntryBefore(entry, sibling->entries[0])) {
+            leaf = sibling;
+            l++;
+        }
+    }
+    
+    int position = findDuePosition(leaf, entry);
+    memmove(leaf->entries + position + 1, leaf->entries + position, (leaf->count - position) * sizeof(DueEntry));
+    leaf->entries[position] = entry;
+    leaf->count++;
+    if (position == 0) {
+        index->lows[l] = entry;
+    }
+    index->count++;
+    return countDueMonth(index, dueKey, 1);
+}
+
+ 
+/* Removes an entry; a leaf that runs empty is freed, and one that fits
+   into half a leaf together with its right neighbour absorbs it. */
+static void eraseDueEntry(DueIndex* index, int32_t dueKey, uint32_t id) {
+    DueEntry entry = { dueKey, id };
+    if (index->leafCount == 0) {
+        return;
+    }
+    int l = findDueLeaf(index, entry);
+    DueLeaf* leaf = index->leaves[l];
+    int position = findDuePosition(leaf, entry);
+    if (position == leaf->count || leaf->entries[position].dueKey != dueKey || leaf->entries[position].id != id) {
+        return;
+    }
+    
+    memmove(leaf->entries + position, leaf->entries + position + 1, (leaf->count - position - 1) * sizeof(DueEntry));
+    leaf->count--;
+    index->count--;
+    countDueMonth(index, dueKey, -1);
+    
+    if (leaf->count == 0) {
+        removeDueLeaf(index, l);
+        return;
+    }
+    index->lows[l] = leaf->entries[0];
+    if (l + 1 < index->leafCount && leaf->count + index->leaves[l + 1]->count <= DUE_LEAF_SIZE / 2) {
+        DueLeaf* next = index->leaves[l + 1];
+        memcpy(leaf->entries + leaf->count, next->entries, next->count * sizeof(DueEntry));
+        leaf->count += next->count;
+        removeDueLeaf(index, l + 1);
+    }
+}
+
+ 
+/* Same contract as updateTaskHeap. */
+static void updateDueIndex(TaskStack* stack, const Task* removed, const Task* added) {
+    if (removed != NULL) {
+        eraseDueEntry(stack->dueIndex, removed->dueKey, removed->id);
+    }
+    if (added != NULL && !addDueEntry(stack->dueIndex, added->dueKey, added->id)) {
+        stack->dueIndex = NULL;
+    }
+}
+
+ 
+/* Stable LSD radix sort on the due-date key, a byte per pass; passes where
+   every key has the same byte are skipped. */
+static bool radixSortDueEntries(DueEntry* entries, int count) {
+    DueEntry* buffer = (DueEntry*)malloc((count + 1) * sizeof(DueEntry));
+    DueEntry* from = entries;
+    DueEntry* to = buffer;
+    if (buffer == NULL) {
+        return false;
+    }
+    
+    for (int shift = 0; shift < 32 && count > 0; shift += 8) {
+        int offsets[256] = { 0 };
+        for (int i = 0; i < count; i++) {
+            offsets[(((uint32_t)from[i].dueKey ^ 0x80000000u) >> shift) & 255]++;
+        }
+        if (offsets[(((uint32_t)from[0].dueKey ^ 0x80000000u) >> shift) & 255] == count) {
+            continue;
+        }
+        for (int b = 0, total = 0; b < 256; b++) {
+            int n = offsets[b];
+            offsets[b] = total;
+            total += n;
+        }
+        for (int i = 0; i < count; i++) {
+            to[offsets[(((uint32_t)from[i].dueKey ^ 0x80000000u) >> shift) & 255]++] = from[i];
+        }
+        DueEntry* swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != entries) {
+        memcpy(entries, from, count * sizeof(DueEntry));
+    }
+    free(buffer);
+    return true;
+}
+
+ 
+/* Builds the index from the stack and attaches it. Collecting the entries
+   in id order and sorting them stably by due date gives (due date, id)
+   order in linear time. Leaves are filled to three quarters so later
+   inserts rarely split them. */
+void attachDueIndex(TaskStack* stack, DueIndex* index) {
+    const int fill = DUE_LEAF_SIZE * 3 / 4;
+    DueEntry* entries = (DueEntry*)malloc((stack->size + 1) * sizeof(DueEntry));
+    int count = 0;
+    
+    clearDueIndex(index);
+    stack->dueIndex = NULL;
+    if (entries == NULL) {
+        return;
+    }
+    for (uint32_t id = 0; id < stack->nextId; id++) {
+        if (stack->idSlots[id] >= 0) {
+            entries[count].dueKey = taskSlot(stack, stack->idSlots[id])->dueKey;
+            entries[count++].id = id;
+        }
+    }
+    if (!radixSortDueEntries(entries, count)) {
+        free(entries);
+        return;
+    }
+    
+    for (int i = 0; i < count; i += fill) {
+        DueLeaf* leaf = insertDueLeaf(index, index->leafCount);
+        if (leaf == NULL) {
+            clearDueIndex(index);
+            free(entries);
+            return;
+        }
+        leaf->count = count - i < fill ? count - i : fill;
+        memcpy(leaf->entries, entries + i, leaf->count * sizeof(DueEntry));
+        index->lows[index->leafCount - 1] = entries[i];
+    }
+    for (int i = 0; i < count; i++) {
+        if (!countDueMonth(index, entries[i].dueKey, 1)) {
+            clearDueIndex(index);
+            free(entries);
+            return;
+        }
+    }
+    index->count = count;
+    free(entries);
+    stack->dueIndex = index;
+}
+
+ 
+void detachDueIndex(TaskStack* stack) {
+    stack->dueIndex = NULL;
+}
+
+ 
+static void openDueCursor(DueCursor* cursor, const DueIndex* index, int fromKey, int toKey) {
+    DueEntry first = { fromKey, 0 };
+    cursor->index = index;
+    cursor->leaf = index->leafCount > 0 ? findDueLeaf(index, first) : 0;
+    cursor->position = index->leafCount > 0 ? findDuePosition(index->leaves[cursor->leaf], first) : 0;
+    cursor->toKey = toKey;
+}
+
+ 
+static bool nextDueEntry(DueCursor* cursor, uint32_t* id) {
+    const DueIndex* index = cursor->index;
+    while (cursor->leaf < index->leafCount) {
+        const DueLeaf* leaf = index->leaves[cursor->leaf];
+        if (cursor->position < leaf->count) {
+            const DueEntry* entry = &leaf->entries[cursor->position++];
+            if (entry->dueKey > cursor->toKey) {
+                cursor->leaf = index->leafCount;
+                return false;
+            }
+            *id = entry->id;
+            return true;
+        }
+        cursor->leaf++;
+        cursor->position = 0;
+    }
+    return false;
+}
+
+ 
+/* Makes room in the view's change list for one more id and in its marks
+   for this one. */
+static bool reserveSortedChange(SortedView* view, uint32_t id) {
+    if (id >= view->markCapacity) {
+        uint32_t capacity = view->markCapacity ? view->markCapacity : 1024;
+        while (capacity <= id) {
+            capacity *= 2;
+        }
+        uint8_t* marks = (uint8_t*)realloc(view->marks, capacity);
+        if (marks == NULL) {
+            return false;
+        }
+        memset(marks + view->markCapacity, 0, capacity - view->markCapacity);
+        view->marks = marks;
+        view->markCapacity = capacity;
+    }
+    if (view->changedCount == view->changedCapacity) {
+        int capacity = view->changedCapacity ? view->changedCapacity * 2 : 64;
+        uint32_t* changed = (uint32_t*)realloc(view->changed, capacity * sizeof(uint32_t));
+        if (changed == NULL) {
+            return false;
+        }
+        view->changed = changed;
+        view->changedCapacity = capacity;
+    }
+    return true;
+}
+
+ 
+/* Notes in every attached view that the task with this id was pushed,
+   removed or given new keys. A view with too many changes to merge is
+   marked stale rather than tracked further. */
+static void noteSortedChange(TaskStack* stack, uint32_t id) {
+    for (SortedView* view = stack->sortedViews; view != NULL; view = view->next) {
+        if (view->stale || (id < view->markCapacity && view->marks[id])) {
+            continue;
+        }
+        if (view->changedCount >= view->count / SORTED_VIEW_REBUILD_RATIO || !reserveSortedChange(view, id)) {
+            markSortedViewStale(view);
+            continue;
+        }
+        view->marks[id] = 1;
+        view->changed[view->changedCount++] = id;
+    }
+}
+
+ 
+/* Gives the live tasks consecutive ids in their current id order, so every
+   posting list stays sorted after its ids are rewritten. */
+static void renumberTaskIds(TaskStack* stack) {
+    uint32_t* remap = (uint32_t*)malloc((stack->nextId + 1) * sizeof(uint32_t));
+    uint32_t next = 0;
+    if (remap == NULL || !unshareChunks(stack, 0, stack->chunkCount - 1)) {
+        free(remap);
+        return;
+    }
+    
+    for (uint32_t id = 0; id < stack->nextId; id++) {
+        int slot = stack->idSlots[id];
+        if (slot >= 0) {
+            remap[id] = next;
+            taskSlot(stack, slot)->id = next;
+            stack->idSlots[next++] = slot;
+        }
+    }
+    for (uint32_t id = next; id < stack->nextId; id++) {
+        stack->idSlots[id] = -1;
+    }
+    
+    KeywordIndex* index = stack->keywordIndex;
+    for (int i = 0; index != NULL && i < index->capacity; i++) {
+        PostingList* list = &index->entries[i].postings;
+        for (int j = 0; j < list->count; j++) {
+            list->ids[j] = remap[list->ids[j]];
+        }
+    }
+    TaskHeap* heap = stack->heap;
+    if (heap != NULL) {
+        for (uint32_t i = 0; i < heap->positionCapacity; i++) {
+            heap->positions[i] = -1;
+        }
+        for (int i = 0; i < heap->count; i++) {
+            heap->entries[i].id = remap[heap->entries[i].id];
+            heap->positions[heap->entries[i].id] = i;
+        }
+    }
+    DueIndex* dueIndex = stack->dueIndex;
+    for (int l = 0; dueIndex != NULL && l < dueIndex->leafCount; l++) {
+        DueLeaf* leaf = dueIndex->leaves[l];
+        for (int i = 0; i < leaf->count; i++) {
+            leaf->entries[i].id = remap[leaf->entries[i].id];
+        }
+        dueIndex->lows[l] = leaf->entries[0];
+    }
+    for (SortedView* view = stack->sortedViews; view != NULL; view = view->next) {
+        markSortedViewStale(view);
+    }
+    
+    stack->nextId = next;
+    free(remap);
+}
+
+ 
+static bool reserveTaskIds(TaskStack* stack, int count) {
+    if (stack->nextId + (uint32_t)count <= stack->idCapacity) {
+        return true;
+    }
+    if ((uint32_t)stack->size * 2 < stack->idCapacity) {
+        renumberTaskIds(stack);
+        if (stack->nextId + (uint32_t)count <= stack->idCapacity) {
+            return true;
+        }
+    }
+    
+    uint32_t capacity = stack->idCapacity ? stack->idCapacity * 2 : 1024;
+    while (capacity < stack->nextId + (uint32_t)count) {
+        capacity *= 2;
+    }
+    int* idSlots = (int*)realloc(stack->idSlots, capacity * sizeof(int));
+    if (idSlots == NULL) {
+        return false;
+    }
+    stack->idSlots = idSlots;
+    stack->idCapacity = capacity;
+    return true;
+}
+
+ 
+static void onTaskRemoved(TaskStack* stack, const Task* task) {
+    if (stack->columns != NULL) {
+        releaseTaskColumns(stack, stack->idSlots[task->id]);
+    }
+    if (stack->heap != NULL) {
+        updateTaskHeap(stack, task, NULL);
+    }
+    if (stack->dueIndex != NULL) {
+        updateDueIndex(stack, task, NULL);
+    }
+    if (stack->sortedViews != NULL) {
+        noteSortedChange(stack, task->id);
+    }
+    stack->idSlots[task->id] = -1;
+    if (stack->keywordIndex != NULL) {
+        indexTask(stack->keywordIndex, task, false);
+    }
+    releaseTaskDescription(task);
+}
+
+ 
+/* Stats are kept per thread, so counting a call is a plain load, add and
+   store to memory no other thread writes. collectStats adds up the blocks
+   on a list; the block of a thread that has exited goes to the next new
+   thread, and none is ever freed, so every total only grows. */
+typedef struct ThreadStats {
+    _Atomic uint64_t calls[STAT_OPERATIONS];
+    _Atomic uint64_t failures[STAT_OPERATIONS];
+    _Atomic uint64_t timedNanos[STAT_OPERATIONS];
+    _Atomic uint64_t histogram[STAT_OPERATIONS][STAT_BUCKETS];
+    bool inUse;
+    struct ThreadStats* next;
+} ThreadStats;
+
+static ThreadStats* statsBlocks = NULL;
+static pthread_mutex_t statsLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t statsKey;
+static pthread_once_t statsKeyOnce = PTHREAD_ONCE_INIT;
+static _Thread_local ThreadStats* threadStats = NULL;
+static atomic_bool statsEnabled = true;
+
+ 
+static int64_t monotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+ 
+static void releaseThreadStats(void* block) {
+    pthread_mutex_lock(&statsLock);
+    ((ThreadStats*)block)->inUse = false;
+    pthread_mutex_unlock(&statsLock);
+}
+
+ 
+static void createStatsKey() {
+    pthread_key_create(&statsKey, releaseThreadStats);
+}
+
+ 
+/* Gives the calling thread a stats block, reusing one whose thread has
+   exited; the key's destructor hands it back. */
+static ThreadStats* registerThreadStats() {
+    ThreadStats* stats;
+    pthread_once(&statsKeyOnce, createStatsKey);
+    pthread_mutex_lock(&statsLock);
+    for (stats = statsBlocks; stats != NULL && stats->inUse; stats = stats->next);
+    if (stats == NULL && (stats = (ThreadStats*)calloc(1, sizeof(ThreadStats))) != NULL) {
+        stats->next = statsBlocks;
+        statsBlocks = stats;
+    }
+    if (stats != NULL) {
+        stats->inUse = true;
+    }
+    pthread_mutex_unlock(&statsLock);
+    if (stats != NULL) {
+        pthread_setspecific(statsKey, stats);
+    }
+    threadStats = stats;
+    return stats;
+}
+
+ 
+static inline void addStat(_Atomic uint64_t* counter, uint64_t amount) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+ 
+static inline int latencyBucket(uint64_t nanos) {
+    if (nanos < 16) {
+        return (int)nanos;
+    }
+    int exponent = 63 - __builtin_clzll(nanos);
+    int bucket = 16 + (exponent - 4) * 8 + (int)((nanos >> (exponent - 3)) & 7);
+    return bucket < STAT_BUCKETS ? bucket : STAT_BUCKETS - 1;
+}
+
+ 
+/* The largest latency that falls in the bucket. */
+static uint64_t bucketLimit(int bucket) {
+    if (bucket < 16) {
+        return (uint64_t)bucket;
+    }
+    int exponent = 4 + (bucket - 16) / 8;
+    return ((uint64_t)(9 + (bucket - 16) % 8) << (exponent - 3)) - 1;
+}
+
+ 
+/* Counts a call as it starts. Returns the time to hand to endStat when
+   this call is one to time, otherwise 0, so that a call that succeeds
+   untimed costs endStat nothing but a test. */
+static inline int64_t beginStat(StatOperation operation) {
+    ThreadStats* stats = threadStats;
+    if (!atomic_load_explicit(&statsEnabled, memory_order_relaxed) ||
+        (stats == NULL && (stats = registerThreadStats()) == NULL)) {
+        return 0;
+    }
+    uint64_t calls = atomic_load_explicit(&stats->calls[operation], memory_order_relaxed) + 1;
+    atomic_store_explicit(&stats->calls[operation], calls, memory_order_relaxed);
+    if (operation < STAT_PUSH_BULK && calls % STAT_SAMPLE_EVERY != 0) {
+        return 0;
+    }
+    return monotonicNanos();
+}
+
+ 
+static inline void endStat(StatOperation operation, int64_t started, bool ok) {
+    ThreadStats* stats = threadStats;
+    if ((ok && started == 0) || stats == NULL || !atomic_load_explicit(&statsEnabled, memory_order_relaxed)) {
+        return;
+    }
+    if (!ok) {
+        addStat(&stats->failures[operation], 1);
+    }
+    if (started != 0) {
+        uint64_t nanos = (uint64_t)(monotonicNanos() - started);
+        addStat(&stats->timedNanos[operation], nanos);
+        addStat(&stats->histogram[operation][latencyBucket(nanos)], 1);
+    }
+}
+
+ 
+/* Turns counting and timing on or off for every thread; on by default. */
+void setStatsEnabled(bool enabled) {
+    atomic_store(&statsEnabled, enabled);
+}
+
+ 
+/* Adds up the stats of every thread that has made a measured call. The
+   threads may be counting meanwhile, so the totals are a moment's view
+   rather than one instant's. */
+void collectStats(TaskStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    pthread_mutex_lock(&statsLock);
+    for (const ThreadStats* block = statsBlocks; block != NULL; block = block->next) {
+        for (int op = 0; op < STAT_OPERATIONS; op++) {
+            stats->calls[op] += atomic_load_explicit(&block->calls[op], memory_order_relaxed);
+            stats->failures[op] += atomic_load_explicit(&block->failures[op], memory_order_relaxed);
+            stats->timedNanos[op] += atomic_load_explicit(&block->timedNanos[op], memory_order_relaxed);
+            for (int b = 0; b < STAT_BUCKETS; b++) {
+                uint64_t count = atomic_load_explicit(&block->histogram[op][b], memory_order_relaxed);
+                stats->histogram[op][b] += count;
+                stats->timed[op] += count;
+            }
+        }
+        stats->threads += block->inUse;
+    }
+    pthread_mutex_unlock(&statsLock);
+}
+
+ 
+/* The latency in nanoseconds that `percentile` percent of the timed calls
+   did not exceed, rounded up to the edge of its bucket; 0 when no call was
+   timed. */
+uint64_t statPercentile(const TaskStats* stats, StatOperation operation, double percentile) {
+    uint64_t total = stats->timed[operation];
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(total * percentile / 100.0 + 0.999999);
+    uint64_t seen = 0;
+    rank = rank < 1 ? 1 : rank > total ? total : rank;
+    for (int b = 0; b < STAT_BUCKETS; b++) {
+        seen += stats->histogram[operation][b];
+        if (seen >= rank) {
+            return bucketLimit(b);
+        }
+    }
+    return bucketLimit(STAT_BUCKETS - 1);
+}
+
+ 
+static inline void putLE16(unsigned char* p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+ 
+static inline void putLE32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+ 
+static inline void putLE64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+ 
+static inline uint16_t getLE16(const unsigned char* p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+ 
+static inline uint32_t getLE32(const unsigned char* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+ 
+static inline uint64_t getLE64(const unsigned char* p) {
+    return (uint64_t)getLE32(p) | (uint64_t)getLE32(p + 4) << 32;
+}
+
+ 
+static uint32_t crcTable[8][256];
+static pthread_once_t crcTableOnce = PTHREAD_ONCE_INIT;
+
+ 
+static void buildCrcTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crcTable[0][i] = c;
+    }
+    for (int t = 1; t < 8; t++) {
+        for (int i = 0; i < 256; i++) {
+            crcTable[t][i] = (crcTable[t - 1][i] >> 8) ^ crcTable[0][crcTable[t - 1][i] & 0xFF];
+        }
+    }
+}
+
+ 
+/* CRC-32 (IEEE 802.3), eight bytes per step with slice-by-8 tables. The
+   save thread and the log writers may be first to ask at the same time,
+   so the tables are built once under pthread_once. */
+static uint32_t updateCrc32(uint32_t crc, const void* data, size_t length) {
+    const unsigned char* p = (const unsigned char*)data;
+    
+    pthread_once(&crcTableOnce, buildCrcTable);
+    crc = ~crc;
+    for (; length >= 8; length -= 8, p += 8) {
+        uint32_t low = getLE32(p) ^ crc;
+        uint32_t high = getLE32(p + 4);
+        crc = crcTable[7][low & 0xFF] ^ crcTable[6][(low >> 8) & 0xFF] ^
+              crcTable[5][(low >> 16) & 0xFF] ^ crcTable[4][low >> 24] ^
+              crcTable[3][high & 0xFF] ^ crcTable[2][(high >> 8) & 0xFF] ^
+              crcTable[1][(high >> 16) & 0xFF] ^ crcTable[0][high >> 24];
+    }
+    while (length-- > 0) {
+        crc = crcTable[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+ 
+void initializeWriteAheadLog(WriteAheadLog* wal) {
+    wal->fd = -1;
+    wal->used = 0;
+    wal->pendingRecords = 0;
+    wal->pendingSince = 0;
+    wal->fileSize = 0;
+    wal->syncedSize = 0;
+    wal->groupRecords = WAL_GROUP_RECORDS;
+    wal->groupWindowNanos = WAL_GROUP_WINDOW_MS * 1000000LL;
+    wal->checkpointBytes = WAL_CHECKPOINT_BYTES;
+    wal->checkpointDue = false;
+    wal->checkpointRetryAt = 0;
+    wal->checkpointRetryNanos = WAL_CHECKPOINT_RETRY_MS * 1000000LL;
+    wal->syncs = 0;
+    wal->failed = false;
+}
+
+ 
+bool openWriteAheadLog(WriteAheadLog* wal, const char* path) {
+    initializeWriteAheadLog(wal);
+    wal->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (wal->fd < 0) {
+        return false;
+    }
+    off_t end = lseek(wal->fd, 0, SEEK_END);
+    wal->fileSize = end > 0 ? end : 0;
+    wal->syncedSize = wal->fileSize;
+    return true;
+}
+
+ 
+static bool writeAll(int fd, const unsigned char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+ 
+/* Marks the log failed and drops the batch written since the last good
+   sync: it is cut off the file, whether a write stopped part of the way
+   or the sync itself failed, so the log holds only records known durable
+   and no torn one sits in front of whatever a later checkpoint appends.
+   The checkpoint that keeps the stack's changes becomes due at once. */
+static void failWriteAheadLog(WriteAheadLog* wal) {
+    if (ftruncate(wal->fd, wal->syncedSize) == 0) {
+        fdatasync(wal->fd);
+    }
+    wal->fileSize = wal->syncedSize;
+    lseek(wal->fd, wal->fileSize, SEEK_SET);
+    wal->used = 0;
+    wal->pendingRecords = 0;
+    wal->failed = true;
+    wal->checkpointDue = true;
+}
+
+ 
+static bool flushWalBuffer(WriteAheadLog* wal) {
+    if (!writeAll(wal->fd, wal->buffer, wal->used)) {
+        failWriteAheadLog(wal);
+        return false;
+    }
+    wal->fileSize += (off_t)wal->used;
+    wal->used = 0;
+    return true;
+}
+
+ 
+/* Writes out the buffered records and makes them durable with one fsync,
+   however many operations the batch holds. */
+bool syncWriteAheadLog(WriteAheadLog* wal) {
+    if (wal->fd < 0 || wal->failed) {
+        return false;
+    }
+    if (wal->used == 0 && wal->pendingRecords == 0) {
+        return true;
+    }
+    int64_t started = beginStat(STAT_WAL_SYNC);
+    bool ok = flushWalBuffer(wal) && fdatasync(wal->fd) == 0;
+    if (ok) {
+        wal->syncedSize = wal->fileSize;
+    } else if (!wal->failed) {
+        failWriteAheadLog(wal);
+    }
+    endStat(STAT_WAL_SYNC, started, ok);
+    wal->pendingRecords = 0;
+    wal->syncs++;
+    return ok;
+}
+
+ 
+void closeWriteAheadLog(WriteAheadLog* wal) {
+    if (wal->fd >= 0) {
+        syncWriteAheadLog(wal);
+        close(wal->fd);
+    }
+    wal->fd = -1;
+}
+
+ 
+void attachWriteAheadLog(TaskStack* stack, WriteAheadLog* wal) {
+    stack->wal = wal;
+}
+
+ 
+/* Appends one record: payload length, CRC-32 over the rest, LSN, type and
+   payload. The batch is synced once it holds groupRecords records, or when
+   a record arrives after the oldest one has waited groupWindowNanos; the
+   window is only checked here, so callers that go idle (the menu prompt,
+   the server between rounds) sync themselves. A log that has grown past
+   checkpointBytes is only marked due, since folding it into the snapshot
+   takes O(n); the idle points run checkpointWriteAheadLog. The operation
+   has already been applied, so a record that cannot be written only marks
+   the log failed; the stack goes on and the caller checks wal->failed. */
+static void appendWalRecord(TaskStack* stack, WalRecordType type, const unsigned char* payload, size_t length) {
+    WriteAheadLog* wal = stack->wal;
+    unsigned char header[WAL_RECORD_HEADER];
+    
+    if (wal->failed || (wal->used + WAL_RECORD_HEADER + length > WAL_BUFFER_SIZE && !flushWalBuffer(wal))) {
+        return;
+    }
+    
+    stack->lsn++;
+    putLE32(header, (uint32_t)length);
+    putLE64(header + 8, stack->lsn);
+    header[16] = (unsigned char)type;
+    uint32_t crc = updateCrc32(0, header + 8, WAL_RECORD_HEADER - 8);
+    putLE32(header + 4, updateCrc32(crc, payload, length));
+    
+    if (WAL_RECORD_HEADER + length > WAL_BUFFER_SIZE) {
+        if (!writeAll(wal->fd, header, WAL_RECORD_HEADER) || !writeAll(wal->fd, payload, length)) {
+            failWriteAheadLog(wal);
+            return;
+        }
+        wal->fileSize += (off_t)(WAL_RECORD_HEADER + length);
+    } else {
+        memcpy(wal->buffer + wal->used, header, WAL_RECORD_HEADER);
+        memcpy(wal->buffer + wal->used + WAL_RECORD_HEADER, payload, length);
+        wal->used += WAL_RECORD_HEADER + length;
+    }
+    
+    int64_t now = monotonicNanos();
+    if (wal->pendingRecords++ == 0) {
+        wal->pendingSince = now;
+    }
+    if (wal->pendingRecords >= wal->groupRecords || now - wal->pendingSince >= wal->groupWindowNanos) {
+        syncWriteAheadLog(wal);
+    }
+    if (wal->fileSize + (off_t)wal->used >= wal->checkpointBytes) {
+        wal->checkpointDue = true;
+    }
+}
+
+ 
+static size_t encodeTaskPayload(unsigned char* out, const Task* task) {
+    size_t length = task->descriptionLength;
+    putLE32(out, (uint32_t)task->dueKey);
+    putLE32(out + 4, (uint32_t)task->importance);
+    putLE32(out + 8, (uint32_t)task->status);
+    putLE64(out + 12, (uint64_t)(int64_t)task->createdAt);
+    putLE16(out + 20, (uint16_t)length);
+    memcpy(out + 22, getTaskDescription(task), length);
+    return 22 + length;
+}
+
+ 
+static bool decodeTaskPayload(const unsigned char* in, size_t length, Task* task) {
+    if (length < 22 || getLE16(in + 20) != length - 22 || length - 22 >= MAX_DESCRIPTION) {
+        return false;
+    }
+    memset(task, 0, sizeof(*task));
+    task->dueKey = (int32_t)getLE32(in);
+    task->importance = (int32_t)getLE32(in + 4);
+    task->status = (TaskStatus)getLE32(in + 8);
+    task->createdAt = (time_t)(int64_t)getLE64(in + 12);
+    if (!setTaskDescriptionText(task, (const char*)in + 22, length - 22)) {
+        return false;
+    }
+    if ((unsigned)task->status > COMPLETED) {
+        task->status = PENDING;
+    }
+    if (!setTaskDueDate(task, DUE_YEAR(task->dueKey), DUE_MONTH(task->dueKey), DUE_DAY(task->dueKey))) {
+        task->dueLabel[0] = '\0';
+    }
+    return true;
+}
+
+ 
+static void logTaskOperation(TaskStack* stack, WalRecordType type, int index, const Task* task) {
+    unsigned char payload[4 + 22 + MAX_DESCRIPTION];
+    size_t length = 0;
+    
+    if (type == WAL_EDIT || type == WAL_REMOVE || type == WAL_INSERT) {
+        putLE32(payload, (uint32_t)index);
+        length = 4;
+    }
+    if (task != NULL) {
+        length += encodeTaskPayload(payload + length, task);
+    }
+    appendWalRecord(stack, type, payload, length);
+}
+
+ 
+static void logSortOperation(TaskStack* stack, const TaskSortKey* keys, int keyCount) {
+    unsigned char payload[1 + 2 * MAX_SORT_KEYS];
+    payload[0] = (unsigned char)keyCount;
+    for (int k = 0; k < keyCount; k++) {
+        payload[1 + 2 * k] = (unsigned char)keys[k].field;
+        payload[2 + 2 * k] = keys[k].descending;
+    }
+    appendWalRecord(stack, WAL_SORT, payload, 1 + 2 * keyCount);
+}
+
+ 
+/* A record that cannot be built is as lost as one that cannot be written,
+   so running out of memory for the payload fails the log too. */
+static void logReorderOperation(TaskStack* stack, const int* order, int size) {
+    unsigned char* payload = (unsigned char*)malloc(4 + (size_t)size * 4);
+    if (payload == NULL) {
+        failWriteAheadLog(stack->wal);
+        return;
+    }
+    putLE32(payload, (uint32_t)size);
+    for (int i = 0; i < size; i++) {
+        putLE32(payload + 4 + 4 * (size_t)i, (uint32_t)order[i]);
+    }
+    appendWalRecord(stack, WAL_REORDER, payload, 4 + (size_t)size * 4);
+    free(payload);
+}
+
+ 
+static void logPushBatch(TaskStack* stack, const Task* tasks, int count) {
+    size_t length = 4;
+    for (int i = 0; i < count; i++) {
+        length += 22 + tasks[i].descriptionLength;
+    }
+    unsigned char* payload = (unsigned char*)malloc(length);
+    length = 4;
+    if (payload == NULL) {
+        failWriteAheadLog(stack->wal);
+        return;
+    }
+    putLE32(payload, (uint32_t)count);
+    for (int i = 0; i < count; i++) {
+        length += encodeTaskPayload(payload + length, &tasks[i]);
+    }
+    appendWalRecord(stack, WAL_PUSH_BATCH, payload, length);
+    free(payload);
+}
+
+ 
+static bool applyWalRecord(TaskStack* stack, WalRecordType type, const unsigned char* payload, size_t length) {
+    Task task;
+    
+    switch (type) {
+        case WAL_PUSH:
+            return decodeTaskPayload(payload, length, &task) && pushTask(stack, task);
+        case WAL_POP:
+            return length == 0 && popTask(stack, &task);
+        case WAL_PUSH_BATCH: {
+            int count = length >= 4 ? (int)getLE32(payload) : -1;
+            if (count < 0 || (size_t)count > (length - 4) / 22) {
+                return false;
+            }
+            Task* tasks = (Task*)malloc((size_t)count * sizeof(Task) + 1);
+            size_t offset = 4;
+            bool ok = tasks != NULL;
+            for (int i = 0; ok && i < count; i++) {
+                size_t taskLength = offset + 22 <= length ? 22 + (size_t)getLE16(payload + offset + 20) : 0;
+                ok = taskLength > 0 && offset + taskLength <= length &&
+                     decodeTaskPayload(payload + offset, taskLength, &tasks[i]);
+                offset += taskLength;
+            }
+            ok = ok && offset == length && pushTasks(stack, tasks, count);
+            free(tasks);
+            return ok;
+        }
+        case WAL_EDIT:
+            return length >= 4 && decodeTaskPayload(payload + 4, length - 4, &task) &&
+                   editTaskAtIndex(stack, (int)getLE32(payload), task);
+        case WAL_INSERT:
+            return length >= 4 && decodeTaskPayload(payload + 4, length - 4, &task) &&
+                   insertTaskAtIndex(stack, (int)getLE32(payload), task);
+        case WAL_REMOVE:
+            return length == 4 && removeTaskAtIndex(stack, (int)getLE32(payload));
+        case WAL_REORDER: {
+            int size = length >= 4 ? (int)getLE32(payload) : -1;
+            if (size != getStackSize(stack) || length != 4 + (size_t)size * 4) {
+                return false;
+            }
+            int* order = (int*)malloc((size_t)size * sizeof(int) + 1);
+            if (order == NULL) {
+                return false;
+            }
+            for (int i = 0; i < size; i++) {
+                order[i] = (int)getLE32(payload + 4 + 4 * (size_t)i);
+            }
+            bool ok = reorderStack(stack, order);
+            free(order);
+            return ok;
+        }
+        case WAL_SORT: {
+            TaskSortKey keys[MAX_SORT_KEYS];
+            int keyCount = length > 0 ? payload[0] : 0;
+            if (keyCount < 1 || keyCount > MAX_SORT_KEYS || length != 1 + 2 * (size_t)keyCount) {
+                return false;
+            }
+            for (int k = 0; k < keyCount; k++) {
+                if (payload[1 + 2 * k] > SORT_BY_CREATED_AT) {
+                    return false;
+                }
+                keys[k].field = (TaskSortField)payload[1 + 2 * k];
+                keys[k].descending = payload[2 + 2 * k] != 0;
+            }
+            return sortStack(stack, keys, keyCount);
+        }
+    }
+    return false;
+}
+
+ 
+/* Re-applies the logged operations newer than the stack's LSN, which is the
+   one stored in the snapshot it was loaded from. Replay stops at the first
+   torn or corrupt record and the log is cut back to the last good one, so
+   later appends follow valid history. A record that is out of sequence or
+   cannot be applied means the log does not continue this snapshot; the log
+   is then left untouched and -1 returned, and the caller must not go on
+   with the stack. Otherwise returns the number of operations replayed. */
+int replayWriteAheadLog(TaskStack* stack, WriteAheadLog* wal) {
+    WriteAheadLog* attached = stack->wal;
+    size_t size = (size_t)wal->fileSize;
+    size_t offset = 0;
+    int replayed = 0;
+    
+    if (wal->fd < 0 || size == 0) {
+        return 0;
+    }
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, wal->fd, 0);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    
+    const unsigned char* log = (const unsigned char*)map;
+    UndoStack* undo = stack->undo;
+    stack->wal = NULL;
+    stack->undo = NULL;
+    while (size - offset >= WAL_RECORD_HEADER) {
+        const unsigned char* record = log + offset;
+        size_t length = getLE32(record);
+        uint64_t lsn = getLE64(record + 8);
+        
+        if (length > size - offset - WAL_RECORD_HEADER ||
+            updateCrc32(updateCrc32(0, record + 8, WAL_RECORD_HEADER - 8), record + WAL_RECORD_HEADER, length) != getLE32(record + 4)) {
+            break;
+        }
+        if (lsn > stack->lsn) {
+            if (lsn != stack->lsn + 1 ||
+                !applyWalRecord(stack, (WalRecordType)record[16], record + WAL_RECORD_HEADER, length)) {
+                replayed = -1;
+                break;
+            }
+            stack->lsn = lsn;
+            replayed++;
+        }
+        offset += WAL_RECORD_HEADER + length;
+    }
+    stack->wal = attached;
+    stack->undo = undo;
+    munmap(map, size);
+    
+    if (replayed < 0) {
+        return -1;
+    }
+    if (offset < size && ftruncate(wal->fd, (off_t)offset) == 0) {
+        fdatasync(wal->fd);
+    }
+    wal->fileSize = (off_t)offset;
+    wal->syncedSize = wal->fileSize;
+    lseek(wal->fd, wal->fileSize, SEEK_SET);
+    return replayed;
+}
+
+ 
+void initializeUndoStack(UndoStack* journal, size_t budget) {
+    journal->ring = NULL;
+    journal->capacity = budget;
+    journal->start = 0;
+    journal->cursor = 0;
+    journal->end = 0;
+    journal->undoCount = 0;
+    journal->redoCount = 0;
+}
+
+ 
+void freeUndoStack(UndoStack* journal) {
+    free(journal->ring);
+    initializeUndoStack(journal, journal->capacity);
+}
+
+ 
+void clearUndoStack(UndoStack* journal) {
+    journal->start = journal->cursor = journal->end = 0;
+    journal->undoCount = 0;
+    journal->redoCount = 0;
+}
+
+ 
+void attachUndoStack(TaskStack* stack, UndoStack* journal) {
+    stack->undo = journal;
+}
+
+ 
+static void ringWrite(UndoStack* journal, uint64_t position, const void* data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    size_t offset = (size_t)(position % journal->capacity);
+    size_t first = journal->capacity - offset < length ? journal->capacity - offset : length;
+    memcpy(journal->ring + offset, data, first);
+    memcpy(journal->ring, (const unsigned char*)data + first, length - first);
+}
+
+ 
+static void ringRead(const UndoStack* journal, uint64_t position, void* data, size_t length) {
+    size_t offset = (size_t)(position % journal->capacity);
+    size_t first = journal->capacity - offset < length ? journal->capacity - offset : length;
+    memcpy(data, journal->ring + offset, first);
+    memcpy((unsigned char*)data + first, journal->ring, length - first);
+}
+
+ 
+/* Appends an entry framed by its total length at both ends, so the ring can
+   be walked in either direction. Recording drops whatever could still be
+   redone and evicts the oldest entries to stay within the budget; an entry
+   larger than the whole budget clears the history, since the older entries
+   could no longer be undone in order. */
+static void recordUndo(TaskStack* stack, UndoKind kind, const unsigned char* head, size_t headLength,
+                       const unsigned char* tail, size_t tailLength) {
+    UndoStack* journal = stack->undo;
+    unsigned char frame[5];
+    size_t total = 4 + 1 + headLength + tailLength + 4;
+    
+    journal->end = journal->cursor;
+    journal->redoCount = 0;
+    if (total > journal->capacity || total > UINT32_MAX) {
+        clearUndoStack(journal);
+        return;
+    }
+    if (journal->ring == NULL && (journal->ring = (unsigned char*)malloc(journal->capacity)) == NULL) {
+        clearUndoStack(journal);
+        return;
+    }
+    
+    while (journal->end - journal->start + total > journal->capacity) {
+        unsigned char length[4];
+        ringRead(journal, journal->start, length, 4);
+        journal->start += getLE32(length);
+        journal->undoCount--;
+    }
+    
+    putLE32(frame, (uint32_t)total);
+    frame[4] = (unsigned char)kind;
+    uint64_t position = journal->end;
+    ringWrite(journal, position, frame, 5);
+    ringWrite(journal, position + 5, head, headLength);
+    ringWrite(journal, position + 5 + headLength, tail, tailLength);
+    ringWrite(journal, position + total - 4, frame, 4);
+    
+    journal->end += total;
+    journal->cursor = journal->end;
+    journal->undoCount++;
+}
+
+ 
+static void recordTaskUndo(TaskStack* stack, UndoKind kind, int index, const Task* task) {
+    unsigned char payload[4 + 22 + MAX_DESCRIPTION];
+    putLE32(payload, (uint32_t)index);
+    recordUndo(stack, kind, payload, 4 + encodeTaskPayload(payload + 4, task), NULL, 0);
+}
+
+ 
+/* Stores only the fields an edit changed, each as an old/new pair. */
+static void recordEditUndo(TaskStack* stack, int index, const Task* before, const Task* after) {
+    unsigned char payload[5 + 2 * 4 + 2 * 4 + 2 + 2 * (2 + MAX_DESCRIPTION)];
+    size_t length = 5;
+    unsigned char mask = 0;
+    
+    putLE32(payload, (uint32_t)index);
+    if (before->dueKey != after->dueKey) {
+        mask |= EDIT_DUE_DATE;
+        putLE32(payload + length, (uint32_t)before->dueKey);
+        putLE32(payload + length + 4, (uint32_t)after->dueKey);
+        length += 8;
+    }
+    if (before->importance != after->importance) {
+        mask |= EDIT_IMPORTANCE;
+        putLE32(payload + length, (uint32_t)before->importance);
+        putLE32(payload + length + 4, (uint32_t)after->importance);
+        length += 8;
+    }
+    if (before->status != after->status) {
+        mask |= EDIT_STATUS;
+        payload[length++] = (unsigned char)before->status;
+        payload[length++] = (unsigned char)after->status;
+    }
+    if (!sameDescription(before, after)) {
+        mask |= EDIT_DESCRIPTION;
+        for (int side = 0; side < 2; side++) {
+            const Task* task = side ? after : before;
+            const char* text = getTaskDescription(task);
+            size_t textLength = task->descriptionLength;
+            putLE16(payload + length, (uint16_t)textLength);
+            memcpy(payload + length + 2, text, textLength);
+            length += 2 + textLength;
+        }
+    }
+    payload[4] = mask;
+    recordUndo(stack, UNDO_EDIT, payload, length, NULL, 0);
+}
+
+ 
+/* Records a reordering as the permutation itself: 4 bytes per task. */
+static void recordPermutationUndo(TaskStack* stack, const int* order, int size) {
+    unsigned char count[4];
+    unsigned char* encoded = (unsigned char*)malloc((size_t)size * 4);
+    if (encoded == NULL) {
+        clearUndoStack(stack->undo);
+        return;
+    }
+    putLE32(count, (uint32_t)size);
+    for (int i = 0; i < size; i++) {
+        putLE32(encoded + 4 * (size_t)i, (uint32_t)order[i]);
+    }
+    recordUndo(stack, UNDO_PERMUTE, count, 4, encoded, (size_t)size * 4);
+    free(encoded);
+}
+
+ 
+static bool applyEditUndo(TaskStack* stack, const unsigned char* payload, size_t length, bool undo) {
+    Task* current = getTaskAtIndex(stack, (int)getLE32(payload));
+    unsigned char mask = payload[4];
+    size_t offset = 5;
+    if (current == NULL) {
+        return false;
+    }
+    
+    Task task = *current;
+    if (mask & EDIT_DUE_DATE) {
+        int key = (int32_t)getLE32(payload + offset + (undo ? 0 : 4));
+        setTaskDueDate(&task, DUE_YEAR(key), DUE_MONTH(key), DUE_DAY(key));
+        offset += 8;
+    }
+    if (mask & EDIT_IMPORTANCE) {
+        task.importance = (int32_t)getLE32(payload + offset + (undo ? 0 : 4));
+        offset += 8;
+    }
+    if (mask & EDIT_STATUS) {
+        task.status = (TaskStatus)payload[offset + (undo ? 0 : 1)];
+        offset += 2;
+    }
+    if (mask & EDIT_DESCRIPTION) {
+        size_t oldLength = getLE16(payload + offset);
+        const unsigned char* text = payload + offset + 2;
+        size_t textLength = oldLength;
+        if (!undo) {
+            text += oldLength + 2;
+            textLength = getLE16(payload + offset + 2 + oldLength);
+        }
+        if (!setTaskDescriptionText(&task, (const char*)text, textLength)) {
+            return false;
+        }
+        offset += 4 + oldLength + getLE16(payload + offset + 2 + oldLength);
+    }
+    return offset == length && editTaskAtIndex(stack, (int)getLE32(payload), task);
+}
+
+ 
+static bool applyPermutationUndo(TaskStack* stack, const unsigned char* payload, size_t length, bool undo) {
+    int size = (int)getLE32(payload);
+    if (size != getStackSize(stack) || length != 4 + (size_t)size * 4) {
+        return false;
+    }
+    
+    int* order = (int*)malloc((size_t)size * sizeof(int));
+    if (order == NULL) {
+        return false;
+    }
+    for (int i = 0; i < size; i++) {
+        int from = (int)getLE32(payload + 4 + 4 * (size_t)i);
+        if (from < 0 || from >= size) {
+            free(order);
+            return false;
+        }
+        if (undo) {
+            order[from] = i;
+        } else {
+            order[i] = from;
+        }
+    }
+    bool ok = reorderStack(stack, order);
+    free(order);
+    return ok;
+}
+
+ 
+static bool applyUndoEntry(TaskStack* stack, UndoKind kind, const unsigned char* payload, size_t length, bool undo) {
+    Task task;
+    int index = length >= 4 ? (int)getLE32(payload) : -1;
+    bool withTask = kind == UNDO_PUSH || kind == UNDO_POP || kind == UNDO_REMOVE || kind == UNDO_INSERT;
+    
+    if (withTask && (length < 4 || !decodeTaskPayload(payload + 4, length - 4, &task))) {
+        return false;
+    }
+    switch (kind) {
+        case UNDO_PUSH:
+            return undo ? popTask(stack, &task) : pushTask(stack, task);
+        case UNDO_POP:
+            return undo ? pushTask(stack, task) : popTask(stack, &task);
+        case UNDO_REMOVE:
+            return undo ? insertTaskAtIndex(stack, index, task) : removeTaskAtIndex(stack, index);
+        case UNDO_INSERT:
+            return undo ? removeTaskAtIndex(stack, index) : insertTaskAtIndex(stack, index, task);
+        case UNDO_EDIT:
+            return length >= 5 && applyEditUndo(stack, payload, length, undo);
+        case UNDO_PERMUTE:
+            return length >= 4 && applyPermutationUndo(stack, payload, length, undo);
+    }
+    return false;
+}
+
+ 
+/* Steps the journal one entry back (undo) or forward (redo) and applies it
+   with the journal detached, so the step is not itself recorded. If the
+   stack no longer matches the entry the history is discarded. */
+static bool stepUndoStack(TaskStack* stack, UndoStack* journal, bool undo) {
+    unsigned char length[4];
+    if (undo ? journal->cursor == journal->start : journal->cursor == journal->end) {
+        return false;
+    }
+    
+    ringRead(journal, undo ? journal->cursor - 4 : journal->cursor, length, 4);
+    uint32_t total = getLE32(length);
+    uint64_t position = undo ? journal->cursor - total : journal->cursor;
+    unsigned char* entry = (unsigned char*)malloc(total);
+    if (entry == NULL) {
+        return false;
+    }
+    ringRead(journal, position, entry, total);
+    
+    UndoStack* attached = stack->undo;
+    stack->undo = NULL;
+    bool ok = applyUndoEntry(stack, (UndoKind)entry[4], entry + 5, total - 9, undo);
+    stack->undo = attached;
+    free(entry);
+    
+    if (!ok) {
+        clearUndoStack(journal);
+    } else if (undo) {
+        journal->cursor -= total;
+        journal->undoCount--;
+        journal->redoCount++;
+    } else {
+        journal->cursor += total;
+        journal->undoCount++;
+        journal->redoCount--;
+    }
+    return ok;
+}
+
+ 
+bool undoLastOperation(TaskStack* stack, UndoStack* journal) {
+    int64_t started = beginStat(STAT_UNDO);
+    bool ok = stepUndoStack(stack, journal, true);
+    endStat(STAT_UNDO, started, ok);
+    return ok;
+}
+
+ 
+bool redoLastOperation(TaskStack* stack, UndoStack* journal) {
+    int64_t started = beginStat(STAT_REDO);
+    bool ok = stepUndoStack(stack, journal, false);
+    endStat(STAT_REDO, started, ok);
+    return ok;
+}
+
+ 
+bool pushTask(TaskStack* stack, Task task) {
+    int64_t started = beginStat(STAT_PUSH);
+    bool ok = !isFullStack(stack) && reserveTaskSlot(stack, stack->top + 1) && reserveTaskIds(stack, 1) &&
+              unshareChunks(stack, (stack->top + 1) >> TASK_CHUNK_SHIFT, (stack->top + 1) >> TASK_CHUNK_SHIFT);
+    if (ok) {
+        stack->top++;
+        task.id = stack->nextId++;
+        stack->idSlots[task.id] = stack->top;
+        *taskSlot(stack, stack->top) = task;
+        markSlot(stack, stack->top, true);
+        retainTaskDescription(&task);
+        
+        if (stack->keywordIndex != NULL) {
+            indexTask(stack->keywordIndex, &task, true);
+        }
+        if (stack->columns != NULL) {
+            storeTaskColumns(stack, stack->top);
+        }
+        if (stack->heap != NULL) {
+            updateTaskHeap(stack, NULL, &task);
+        }
+        if (stack->dueIndex != NULL) {
+            updateDueIndex(stack, NULL, &task);
+        }
+        if (stack->sortedViews != NULL) {
+            noteSortedChange(stack, task.id);
+        }
+        if (stack->wal != NULL) {
+            logTaskOperation(stack, WAL_PUSH, 0, &task);
+        }
+        if (stack->undo != NULL) {
+            recordTaskUndo(stack, UNDO_PUSH, stack->size - 1, &task);
+        }
+    }
+    endStat(STAT_PUSH, started, ok);
+    return ok;
+}
+
+ 
+/* Appends tasks[0..count) in order, exactly as that many pushTask calls
+   would, but reserves slots and ids once, sets live bits a word at a time
+   and writes a single log record. A bulk append is not undoable, so it
+   clears the undo history. */
+static bool pushTasksUnmeasured(TaskStack* stack, const Task* tasks, int count) {
+    int first = stack->top + 1;
+    int last = stack->top + count;
+    if (count <= 0) {
+        return count == 0;
+    }
+    if (count > MAX_TASKS - first || !reserveTaskIds(stack, count)) {
+        return false;
+    }
+    for (int chunk = first >> TASK_CHUNK_SHIFT; chunk <= last >> TASK_CHUNK_SHIFT; chunk++) {
+        if (!reserveTaskSlot(stack, chunk << TASK_CHUNK_SHIFT)) {
+            return false;
+        }
+    }
+    if (!unshareChunks(stack, first >> TASK_CHUNK_SHIFT, last >> TASK_CHUNK_SHIFT)) {
+        return false;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        Task* task = taskSlot(stack, first + i);
+        *task = tasks[i];
+        retainTaskDescription(task);
+        task->id = stack->nextId++;
+        stack->idSlots[task->id] = first + i;
+    }
+    for (int slot = first; slot <= last; ) {
+        int chunkEnd = (slot | TASK_CHUNK_MASK) < last ? (slot | TASK_CHUNK_MASK) : last;
+        TaskChunk* chunk = stack->chunks[slot >> TASK_CHUNK_SHIFT];
+        for (int bit = slot & TASK_CHUNK_MASK; bit <= (chunkEnd & TASK_CHUNK_MASK); ) {
+            int wordEnd = (bit | 63) < (chunkEnd & TASK_CHUNK_MASK) ? (bit | 63) : (chunkEnd & TASK_CHUNK_MASK);
+            int width = wordEnd - bit + 1;
+            chunk->live[bit >> 6] |= (width == 64 ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1) << (bit & 63);
+            bit = wordEnd + 1;
+        }
+        chunk->liveCount += chunkEnd - slot + 1;
+        updateLiveTree(stack, slot >> TASK_CHUNK_SHIFT, chunkEnd - slot + 1);
+        slot = chunkEnd + 1;
+    }
+    stack->top = last;
+    stack->size += count;
+    
+    for (int slot = first; slot <= last; slot++) {
+        if (stack->keywordIndex != NULL) {
+            indexTask(stack->keywordIndex, taskSlot(stack, slot), true);
+        }
+        if (stack->columns != NULL) {
+            storeTaskColumns(stack, slot);
+        }
+        if (stack->heap != NULL) {
+            updateTaskHeap(stack, NULL, taskSlot(stack, slot));
+        }
+        if (stack->dueIndex != NULL) {
+            updateDueIndex(stack, NULL, taskSlot(stack, slot));
+        }
+        if (stack->sortedViews != NULL) {
+            noteSortedChange(stack, taskSlot(stack, slot)->id);
+        }
+    }
+    if (stack->undo != NULL) {
+        clearUndoStack(stack->undo);
+    }
+    if (stack->wal != NULL) {
+        logPushBatch(stack, tasks, count);
+    }
+    return true;
+}
+
+ 
+bool pushTasks(TaskStack* stack, const Task* tasks, int count) {
+    int64_t started = beginStat(STAT_PUSH_BULK);
+    bool ok = pushTasksUnmeasured(stack, tasks, count);
+    endStat(STAT_PUSH_BULK, started, ok);
+    return ok;
+}
+
+ 
+bool popTask(TaskStack* stack, Task* task) {
+    int64_t started = beginStat(STAT_POP);
+    bool ok = !isEmptyStack(stack) && unshareChunks(stack, stack->top >> TASK_CHUNK_SHIFT, stack->top >> TASK_CHUNK_SHIFT);
+    if (ok) {
+        *task = *taskSlot(stack, stack->top);
+        onTaskRemoved(stack, task);
+        markSlot(stack, stack->top, false);
+        stack->top--;
+        trimTombstones(stack);
+        
+        if (stack->wal != NULL) {
+            logTaskOperation(stack, WAL_POP, 0, NULL);
+        }
+        if (stack->undo != NULL) {
+            recordTaskUndo(stack, UNDO_POP, stack->size, task);
+        }
+    }
+    endStat(STAT_POP, started, ok);
+    return ok;
+}
+
+ 
+bool peekTask(TaskStack* stack, Task* task) {
+    int64_t started = beginStat(STAT_PEEK);
+    bool ok = !isEmptyStack(stack);
+    if (ok) {
+        *task = *taskSlot(stack, stack->top);
+    }
+    endStat(STAT_PEEK, started, ok);
+    return ok;
+}
+
+ 
+bool isEmptyStack(const TaskStack* stack) {
+    return stack->size == 0;
+}
+
+ 
+bool isFullStack(const TaskStack* stack) {
+    return stack->top == MAX_TASKS - 1;
+}
+
+ 
+int getStackSize(const TaskStack* stack) {
+    return stack->size;
+}
+
+ 
+void initializeConcurrentStack(ConcurrentTaskStack* stack) {
+    atomic_init(&stack->head, 0);
+    atomic_init(&stack->freeNodes, 0);
+    atomic_init(&stack->allocated, 0);
+    atomic_init(&stack->size, 0);
+    for (int i = 0; i < CONCURRENT_MAX_BLOCKS; i++) {
+        atomic_init(&stack->blocks[i], NULL);
+    }
+    pthread_mutex_init(&stack->growLock, NULL);
+}
+
+ 
+static inline TaskNode* concurrentNode(const ConcurrentTaskStack* stack, uint32_t ref) {
+    uint32_t index = ref - 1;
+    TaskNode* block = atomic_load_explicit(&stack->blocks[index >> CONCURRENT_BLOCK_SHIFT],
+                                           memory_order_acquire);
+    return &block[index & (CONCURRENT_BLOCK_SIZE - 1)];
+}
+
+ 
+/* Only safe once no other thread uses the stack. */
+void freeConcurrentStack(ConcurrentTaskStack* stack) {
+    uint32_t ref = (uint32_t)atomic_load_explicit(&stack->head, memory_order_relaxed);
+    while (ref != 0) {
+        TaskNode* node = concurrentNode(stack, ref);
+        releaseTaskDescription(&node->task);
+        ref = atomic_load_explicit(&node->next, memory_order_relaxed);
+    }
+    for (int i = 0; i < CONCURRENT_MAX_BLOCKS; i++) {
+        free(atomic_load_explicit(&stack->blocks[i], memory_order_relaxed));
+    }
+    pthread_mutex_destroy(&stack->growLock);
+}
+
+ 
+/* A list head packs the 1-based node reference (0 for an empty list) in the
+   low half and a tag in the high half. Every successful exchange bumps the
+   tag, so a head that was popped and pushed back between a thread's load
+   and its compare-and-swap no longer matches (the ABA problem). */
+static inline uint64_t tagListHead(uint64_t head, uint32_t ref) {
+    return ((head >> 32) + 1) << 32 | ref;
+}
+
+ 
+static void pushNodeList(ConcurrentTaskStack* stack, _Atomic uint64_t* list, uint32_t ref) {
+    TaskNode* node = concurrentNode(stack, ref);
+    uint64_t head = atomic_load_explicit(list, memory_order_relaxed);
+    do {
+        atomic_store_explicit(&node->next, (uint32_t)head, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(list, &head, tagListHead(head, ref),
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+ 
+/* Nodes are never returned to the allocator, so reading `next` from a node
+   another thread has just popped is harmless: the tag makes the exchange
+   fail and the loop retries. */
+static uint32_t popNodeList(ConcurrentTaskStack* stack, _Atomic uint64_t* list) {
+    uint64_t head = atomic_load_explicit(list, memory_order_acquire);
+    for (;;) {
+        uint32_t ref = (uint32_t)head;
+        if (ref == 0) {
+            return 0;
+        }
+        uint32_t next = atomic_load_explicit(&concurrentNode(stack, ref)->next, memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(list, &head, tagListHead(head, next),
+                                                  memory_order_acquire, memory_order_acquire)) {
+            return ref;
+        }
+    }
+}
+
+ 
+/* Reuses a free node, or carves a new one from the current block. Only
+   allocating a new block takes the lock. */
+static uint32_t allocateConcurrentNode(ConcurrentTaskStack* stack) {
+    uint32_t ref = popNodeList(stack, &stack->freeNodes);
+    if (ref != 0) {
+        return ref;
+    }
+    
+    uint32_t index = atomic_fetch_add_explicit(&stack->allocated, 1, memory_order_relaxed);
+    if (index >= (uint32_t)CONCURRENT_MAX_BLOCKS * CONCURRENT_BLOCK_SIZE) {
+        atomic_fetch_sub_explicit(&stack->allocated, 1, memory_order_relaxed);
+        return 0;
+    }
+    _Atomic(TaskNode*)* block = &stack->blocks[index >> CONCURRENT_BLOCK_SHIFT];
+    if (atomic_load_explicit(block, memory_order_acquire) == NULL) {
+        pthread_mutex_lock(&stack->growLock);
+        if (atomic_load_explicit(block, memory_order_relaxed) == NULL) {
+            TaskNode* nodes = (TaskNode*)malloc(CONCURRENT_BLOCK_SIZE * sizeof(TaskNode));
+            atomic_store_explicit(block, nodes, memory_order_release);
+        }
+        pthread_mutex_unlock(&stack->growLock);
+        if (atomic_load_explicit(block, memory_order_acquire) == NULL) {
+            return 0;
+        }
+    }
+    return index + 1;
+}
+
+ 
+/* Same semantics as pushTask, callable from any number of threads at once.
+   Returns false only when no node can be allocated. */
+bool pushConcurrentTask(ConcurrentTaskStack* stack, Task task) {
+    uint32_t ref = allocateConcurrentNode(stack);
+    if (ref == 0) {
+        return false;
+    }
+    concurrentNode(stack, ref)->task = task;
+    retainTaskDescription(&task);
+    pushNodeList(stack, &stack->head, ref);
+    atomic_fetch_add_explicit(&stack->size, 1, memory_order_relaxed);
+    return true;
+}
+
+ 
+bool popConcurrentTask(ConcurrentTaskStack* stack, Task* task) {
+    uint32_t ref = popNodeList(stack, &stack->head);
+    if (ref == 0) {
+        return false;
+    }
+    *task = concurrentNode(stack, ref)->task;
+    releaseTaskDescription(task);
+    pushNodeList(stack, &stack->freeNodes, ref);
+    atomic_fetch_sub_explicit(&stack->size, 1, memory_order_relaxed);
+    return true;
+}
+
+ 
+/* Copies the top task. The copy is retried until the head, tag included,
+   is unchanged afterwards, so it never mixes two tasks. */
+bool peekConcurrentTask(ConcurrentTaskStack* stack, Task* task) {
+    for (;;) {
+        uint64_t head = atomic_load_explicit(&stack->head, memory_order_acquire);
+        if ((uint32_t)head == 0) {
+            return false;
+        }
+        *task = concurrentNode(stack, (uint32_t)head)->task;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&stack->head, memory_order_relaxed) == head) {
+            return true;
+        }
+    }
+}
+
+ 
+/* Exact only while no other thread is pushing or popping. */
+int getConcurrentStackSize(const ConcurrentTaskStack* stack) {
+    return atomic_load_explicit(&stack->size, memory_order_relaxed);
+}
+
+ 
+/* Moves every queued task onto a regular stack, oldest first, so the most
+   recently pushed ends up on top. The whole list is detached with one
+   exchange; producers may keep pushing meanwhile. Returns the number of
+   tasks moved, or -1 if the stack ran out of memory; the tasks that did
+   not fit are pushed back. */
+int drainConcurrentStack(ConcurrentTaskStack* source, TaskStack* stack) {
+    uint64_t head = atomic_load_explicit(&source->head, memory_order_acquire);
+    while (!atomic_compare_exchange_weak_explicit(&source->head, &head, tagListHead(head, 0),
+                                                  memory_order_acquire, memory_order_acquire)) {
+    }
+    
+    uint32_t oldest = 0;
+    for (uint32_t ref = (uint32_t)head; ref != 0;) {
+        TaskNode* node = concurrentNode(source, ref);
+        uint32_t next = atomic_load_explicit(&node->next, memory_order_relaxed);
+        atomic_store_explicit(&node->next, oldest, memory_order_relaxed);
+        oldest = ref;
+        ref = next;
+    }
+    
+    int moved = 0;
+    while (oldest != 0) {
+        TaskNode* node = concurrentNode(source, oldest);
+        uint32_t next = atomic_load_explicit(&node->next, memory_order_relaxed);
+        if (!pushTask(stack, node->task)) {
+            break;
+        }
+        releaseTaskDescription(&node->task);
+        pushNodeList(source, &source->freeNodes, oldest);
+        atomic_fetch_sub_explicit(&source->size, 1, memory_order_relaxed);
+        oldest = next;
+        moved++;
+    }
+    if (oldest == 0) {
+        return moved;
+    }
+    
+    /* What did not fit goes back, oldest first. */
+    while (oldest != 0) {
+        uint32_t next = atomic_load_explicit(&concurrentNode(source, oldest)->next, memory_order_relaxed);
+        pushNodeList(source, &source->head, oldest);
+        oldest = next;
+    }
+    return -1;
+}
+
+ 
+void initializeTaskExecutor(TaskExecutor* executor, int workerCount) {
+    memset(executor, 0, sizeof(*executor));
+    executor->workerCount = workerCount < 1 ? 1 : workerCount > MAX_EXECUTOR_WORKERS ? MAX_EXECUTOR_WORKERS : workerCount;
+    executor->stealing = true;
+}
+
+ 
+/* Handlers are tried in registration order; the first whose keyword occurs
+   in the description runs the task, and a NULL keyword matches any task. */
+bool registerTaskHandler(TaskExecutor* executor, const char* keyword, TaskHandler handler, void* context) {
+    if (executor->handlerCount == MAX_TASK_HANDLERS || handler == NULL) {
+        return false;
+    }
+    TaskHandlerEntry* entry = &executor->handlers[executor->handlerCount++];
+    entry->keyword = keyword;
+    entry->handler = handler;
+    entry->context = context;
+    return true;
+}
+
+ 
+typedef enum {
+    STEAL_EMPTY,
+    STEAL_ABORT,
+    STEAL_SUCCESS
+} StealResult;
+
+ 
+/* Chase-Lev deque of stack slots, after the C11 formulation by Le, Pop,
+   Cohen and Zappa Nardelli. The owner pushes and pops at the bottom and
+   thieves take from the top. The buffer is sized for every slot seeded
+   into it, and tasks never spawn tasks, so it never has to grow. */
+typedef struct {
+    _Alignas(64) _Atomic int64_t top;
+    _Alignas(64) _Atomic int64_t bottom;
+    atomic_int* buffer;
+    int64_t mask;
+} WorkDeque;
+
+ 
+typedef struct {
+    TaskStack* stack;
+    const TaskExecutor* executor;
+    WorkDeque* deques;
+    int index;
+    ExecutorStats stats;
+} ExecutorWorker;
+
+ 
+static void pushWorkDeque(WorkDeque* deque, int slot) {
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    atomic_store_explicit(&deque->buffer[bottom & deque->mask], slot, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+}
+
+ 
+static bool popWorkDeque(WorkDeque* deque, int* slot) {
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return false;
+    }
+    *slot = atomic_load_explicit(&deque->buffer[bottom & deque->mask], memory_order_relaxed);
+    if (top < bottom) {
+        return true;
+    }
+    /* Last task: race the thieves for it. */
+    bool won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                       memory_order_seq_cst, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return won;
+}
+
+ 
+static StealResult stealWorkDeque(WorkDeque* deque, int* slot) {
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    
+    if (top >= bottom) {
+        return STEAL_EMPTY;
+    }
+    *slot = atomic_load_explicit(&deque->buffer[top & deque->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return STEAL_ABORT;
+    }
+    return STEAL_SUCCESS;
+}
+
+ 
+/* Sweeps the other workers' deques, starting after this worker's own, and
+   gives up once a sweep finds all of them empty; as nothing is pushed
+   after seeding, empty stays empty. */
+static bool stealWork(ExecutorWorker* worker, int* slot) {
+    int count = worker->executor->workerCount;
+    bool contended = true;
+    
+    while (contended) {
+        contended = false;
+        for (int i = 1; i < count; i++) {
+            int victim = (worker->index + i) % count;
+            worker->stats.stealAttempts++;
+            StealResult result = stealWorkDeque(&worker->deques[victim], slot);
+            if (result == STEAL_SUCCESS) {
+                worker->stats.steals++;
+                return true;
+            }
+            contended |= result == STEAL_ABORT;
+        }
+    }
+    return false;
+}
+
+ 
+/* Claims the task by moving it from PENDING to IN_PROGRESS with a
+   compare-and-swap, runs its handler, and stores the outcome: COMPLETED,
+   or PENDING again if the handler failed or none matched. */
+static void executeTask(ExecutorWorker* worker, int slot) {
+    const TaskExecutor* executor = worker->executor;
+    Task* task = taskSlot(worker->stack, slot);
+    TaskStatus expected = PENDING;
+    
+    if (!__atomic_compare_exchange_n(&task->status, &expected, IN_PROGRESS, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;
+    }
+    for (int h = 0; h < executor->handlerCount; h++) {
+        const TaskHandlerEntry* entry = &executor->handlers[h];
+        if (entry->keyword == NULL || strstr(getTaskDescription(task), entry->keyword) != NULL) {
+            bool done = entry->handler(task, entry->context);
+            __atomic_store_n(&task->status, done ? COMPLETED : PENDING, __ATOMIC_RELEASE);
+            worker->stats.executed++;
+            worker->stats.completed += done;
+            worker->stats.failed += !done;
+            return;
+        }
+    }
+    __atomic_store_n(&task->status, PENDING, __ATOMIC_RELEASE);
+    worker->stats.unhandled++;
+}
+
+ 
+static void* runExecutorWorker(void* argument) {
+    ExecutorWorker* worker = (ExecutorWorker*)argument;
+    WorkDeque* own = &worker->deques[worker->index];
+    int slot;
+    
+    for (;;) {
+        if (!popWorkDeque(own, &slot) && (!worker->executor->stealing || !stealWork(worker, &slot))) {
+            return NULL;
+        }
+        executeTask(worker, slot);
+    }
+}
+
+ 
+/* Runs every PENDING task of the stack through the registered handlers and
+   returns the number completed, or -1 if memory runs out. The pending tasks
+   are dealt to the workers in contiguous runs of the stack, each worker
+   starting from the top of its run, and idle workers steal from the
+   bottom of the others' runs. Workers only touch each task's status; once
+   they have finished, every completed task goes through editTaskAtIndex,
+   so the indexes, the log and the undo journal see an ordinary edit; a
+   task whose edit fails stays PENDING, is left out of the count and is
+   counted in stats.uncommitted instead. The stack must not be used by
+   anything else during the run. */
+int runTaskExecutor(TaskExecutor* executor, TaskStack* stack) {
+    int workerCount = executor->workerCount;
+    int* pending = (int*)malloc((stack->size + 1) * sizeof(int));
+    WorkDeque* deques = (WorkDeque*)aligned_alloc(64, workerCount * sizeof(WorkDeque));
+    ExecutorWorker workers[MAX_EXECUTOR_WORKERS];
+    pthread_t threads[MAX_EXECUTOR_WORKERS];
+    int count = 0;
+    int completed = 0;
+    
+    memset(&executor->stats, 0, sizeof(executor->stats));
+    if (pending == NULL || deques == NULL || !unshareChunks(stack, 0, stack->chunkCount - 1)) {
+        free(pending);
+        free(deques);
+        return -1;
+    }
+    for (int slot = 0; slot <= stack->top; slot++) {
+        if (isSlotLive(stack, slot) && taskSlot(stack, slot)->status == PENDING) {
+            pending[count++] = slot;
+        }
+    }
+    
+    int seeded = 0;
+    bool ready = true;
+    for (int w = 0; w < workerCount; w++) {
+        int end = (int)((int64_t)count * (w + 1) / workerCount);
+        int64_t capacity = 1;
+        while (capacity < end - seeded) {
+            capacity *= 2;
+        }
+        atomic_init(&deques[w].top, 0);
+        atomic_init(&deques[w].bottom, 0);
+        deques[w].mask = capacity - 1;
+        deques[w].buffer = (atomic_int*)malloc(capacity * sizeof(atomic_int));
+        ready = ready && deques[w].buffer != NULL;
+        for (; seeded < end && deques[w].buffer != NULL; seeded++) {
+            pushWorkDeque(&deques[w], pending[seeded]);
+        }
+        seeded = end;
+        
+        memset(&workers[w], 0, sizeof(workers[w]));
+        workers[w].stack = stack;
+        workers[w].executor = executor;
+        workers[w].deques = deques;
+        workers[w].index = w;
+    }
+    
+    if (!ready) {
+        for (int w = 0; w < workerCount; w++) {
+            free(deques[w].buffer);
+        }
+        free(deques);
+        free(pending);
+        return -1;
+    }
+    
+    /* Workers whose thread cannot be started run on this one afterwards. */
+    int64_t start = monotonicNanos();
+    int started = 0;
+    while (started < workerCount &&
+           pthread_create(&threads[started], NULL, runExecutorWorker, &workers[started]) == 0) {
+        started++;
+    }
+    for (int w = started; w < workerCount; w++) {
+        runExecutorWorker(&workers[w]);
+    }
+    for (int w = 0; w < started; w++) {
+        pthread_join(threads[w], NULL);
+    }
+    executor->stats.seconds = (monotonicNanos() - start) / 1e9;
+    
+    for (int w = 0; w < workerCount; w++) {
+        const ExecutorStats* stats = &workers[w].stats;
+        executor->workerStats[w] = *stats;
+        executor->stats.executed += stats->executed;
+        executor->stats.completed += stats->completed;
+        executor->stats.failed += stats->failed;
+        executor->stats.unhandled += stats->unhandled;
+        executor->stats.steals += stats->steals;
+        executor->stats.stealAttempts += stats->stealAttempts;
+        free(deques[w].buffer);
+    }
+    free(deques);
+    
+    for (int i = 0; i < count; i++) {
+        Task* task = taskSlot(stack, pending[i]);
+        if (task->status == COMPLETED) {
+            Task updated = *task;
+            task->status = PENDING;
+            if (editTaskAtIndex(stack, indexForSlot(stack, pending[i]), updated)) {
+                completed++;
+            } else {
+                executor->stats.uncommitted++;
+            }
+        }
+    }
+    free(pending);
+    return completed;
+}
+
+ 
+void openTaskCursor(TaskCursor* cursor, const TaskStack* stack) {
+    cursor->stack = stack;
+    cursor->slot = -1;
+    cursor->index = -1;
+}
+
+ 
+/* Walks the live stack from bottom to top without copying; cursor->index is
+   the stack index of the task just returned. */
+const Task* nextTaskFromCursor(TaskCursor* cursor) {
+    const TaskStack* stack = cursor->stack;
+    int slot = cursor->slot + 1;
+    
+    while (slot <= stack->top) {
+        const TaskChunk* chunk = stack->chunks[slot >> TASK_CHUNK_SHIFT];
+        uint64_t bits = chunk->live[(slot & TASK_CHUNK_MASK) >> 6] >> (slot & 63);
+        if (bits & 1) {
+            cursor->slot = slot;
+            cursor->index++;
+            return &chunk->tasks[slot & TASK_CHUNK_MASK];
+        }
+        slot += bits ? __builtin_ctzll(bits) : 64 - (slot & 63);
+    }
+    return NULL;
+}
+
+ 
+/* Positions the cursor so the next task it returns is the one at `index`,
+   in O(log n); past the end, the cursor is exhausted. */
+void seekTaskCursor(TaskCursor* cursor, int index) {
+    const TaskStack* stack = cursor->stack;
+    if (index >= stack->size) {
+        cursor->slot = stack->top;
+        cursor->index = stack->size - 1;
+        return;
+    }
+    index = index < 0 ? 0 : index;
+    cursor->slot = slotForIndex(stack, index) - 1;
+    cursor->index = index - 1;
+}
+
+
+ 
+bool isValidDate(int year, int month, int day) {
+    if (year < 1000 || year > 9999 || month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    
+     
+    if ((month == 4 || month == 6 || month == 9 || month == 11) && day > 30) {
+        return false;
+    }
+    
      
-    if (loadStackFromFile(&taskStack)) {
-        printf("Tasks loaded successfully from file.\n");
-    }
-    
-    while (1) {
-        drawUIHeader();
-        printf("| Main Menu:                                                                   |\n");
-        printf("| 1. Push Task (Add)                                                           |\n");
-        printf("| 2. Pop Task (Remove Last)                                                    |\n");
-        printf("| 3. View All Tasks                                                            |\n");
-        printf("| 4. Edit Task                                                                 |\n");
-        printf("| 5. Remove Specific Task                                                      |\n");
-        printf("| 6. Search Tasks                                                              |\n");
-        printf("| 7. Sort by Date                                                              |\n");
-        printf("| 8. Sort by Importance                                                        |\n");
-        printf("| 9. Undo Last Operation                                                       |\n");
-        printf("| 10. Save Tasks                                                               |\n");
-        printf("| 11. Exit                                                                     |\n");
-        drawLine(80);
-        printf("| Enter your choice: ");
+    if (month == 2) {
+        bool isLeapYear = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+        if (isLeapYear && day > 29) {
+            return false;
+        } else if (!isLeapYear && day > 28) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+ 
+/* Validates the date once and caches both the packed YYYYMMDD key used for
+   sorting and range filters and the label used when the task is displayed. */
+bool setTaskDueDate(Task* task, int year, int month, int day) {
+    if (!isValidDate(year, month, day)) {
+        return false;
+    }
+    task->dueKey = DUE_KEY(year, month, day);
+    
+    /* Same text as "%s %02d, %04d", without going through snprintf. */
+    char* label = task->dueLabel;
+    size_t nameLength = strlen(monthNames[month - 1]);
+    memcpy(label, monthNames[month - 1], nameLength);
+    label += nameLength;
+    *label++ = ' ';
+    *label++ = (char)('0' + day / 10);
+    *label++ = (char)('0' + day % 10);
+    *label++ = ',';
+    *label++ = ' ';
+    *label++ = (char)('0' + year / 1000);
+    *label++ = (char)('0' + year / 100 % 10);
+    *label++ = (char)('0' + year / 10 % 10);
+    *label++ = (char)('0' + year % 10);
+    *label = '\0';
+    return true;
+}
+
+ 
+Task* getTaskAtIndex(TaskStack* stack, int index) {
+    if (index >= 0 && index < stack->size) {
+        return taskSlot(stack, slotForIndex(stack, index));
+    }
+    return NULL;
+}
+
+ 
+static bool removeTaskAtIndexUnmeasured(TaskStack* stack, int index) {
+    if (index < 0 || index >= stack->size) {
+        return false;
+    }
+    
+    int slot = slotForIndex(stack, index);
+    if (!unshareChunks(stack, slot >> TASK_CHUNK_SHIFT, slot >> TASK_CHUNK_SHIFT)) {
+        return false;
+    }
+    if (stack->undo != NULL) {
+        recordTaskUndo(stack, UNDO_REMOVE, index, taskSlot(stack, slot));
+    }
+    
+    onTaskRemoved(stack, taskSlot(stack, slot));
+    markSlot(stack, slot, false);
+    stack->tombstones++;
+    trimTombstones(stack);
+    
+    if (stack->tombstones >= TASK_CHUNK_SIZE && stack->tombstones > stack->size) {
+        compactStack(stack);
+    }
+    if (stack->wal != NULL) {
+        logTaskOperation(stack, WAL_REMOVE, index, NULL);
+    }
+    return true;
+}
+
+ 
+bool removeTaskAtIndex(TaskStack* stack, int index) {
+    int64_t started = beginStat(STAT_REMOVE);
+    bool ok = removeTaskAtIndexUnmeasured(stack, index);
+    endStat(STAT_REMOVE, started, ok);
+    return ok;
+}
+
+ 
+static bool editTaskAtIndexUnmeasured(TaskStack* stack, int index, Task newTask) {
+    if (index < 0 || index >= stack->size) {
+        return false;
+    }
+    
+    int slot = slotForIndex(stack, index);
+    if (!unshareChunks(stack, slot >> TASK_CHUNK_SHIFT, slot >> TASK_CHUNK_SHIFT)) {
+        return false;
+    }
+    Task* task = taskSlot(stack, slot);
+    
+    newTask.createdAt = task->createdAt;
+    newTask.id = task->id;
+    if (stack->undo != NULL) {
+        recordEditUndo(stack, index, task, &newTask);
+    }
+    if (stack->keywordIndex != NULL && !sameDescription(&newTask, task)) {
+        indexTask(stack->keywordIndex, task, false);
+        indexTask(stack->keywordIndex, &newTask, true);
+    }
+    if (stack->heap != NULL) {
+        updateTaskHeap(stack, task, &newTask);
+    }
+    if (stack->dueIndex != NULL && newTask.dueKey != task->dueKey) {
+        updateDueIndex(stack, task, &newTask);
+    }
+    if (stack->sortedViews != NULL && (newTask.importance != task->importance || newTask.dueKey != task->dueKey)) {
+        noteSortedChange(stack, task->id);
+    }
+    retainTaskDescription(&newTask);
+    releaseTaskDescription(task);
+    *task = newTask;
+    
+    if (stack->columns != NULL) {
+        releaseTaskColumns(stack, slot);
+        storeTaskColumns(stack, slot);
+    }
+    if (stack->wal != NULL) {
+        logTaskOperation(stack, WAL_EDIT, index, &newTask);
+    }
+    return true;
+}
+
+ 
+bool editTaskAtIndex(TaskStack* stack, int index, Task newTask) {
+    int64_t started = beginStat(STAT_EDIT);
+    bool ok = editTaskAtIndexUnmeasured(stack, index, newTask);
+    endStat(STAT_EDIT, started, ok);
+    return ok;
+}
+
+ 
+/* Inserts task so that it becomes stack index `index`; index == size is a
+   push. When the slot just below the task now at that index is dead, as it
+   is right after that position was removed, the task is written back into
+   it in O(log n). Otherwise the stack is compacted and the tasks above are
+   shifted up one slot. */
+static bool insertTaskAtIndexUnmeasured(TaskStack* stack, int index, Task task) {
+    if (index < 0 || index > stack->size) {
+        return false;
+    }
+    if (index == stack->size) {
+        return pushTask(stack, task);
+    }
+    if (isFullStack(stack) || !reserveTaskSlot(stack, stack->top + 1) || !reserveTaskIds(stack, 1)) {
+        return false;
+    }
+    
+    int slot = slotForIndex(stack, index);
+    bool shifted = slot == 0 || isSlotLive(stack, slot - 1);
+    int written = shifted ? (stack->tombstones > 0 ? 0 : slot) : slot - 1;
+    if (!unshareChunks(stack, written >> TASK_CHUNK_SHIFT, shifted ? stack->chunkCount - 1 : written >> TASK_CHUNK_SHIFT)) {
+        return false;
+    }
+    if (shifted) {
+        if (stack->tombstones > 0) {
+            compactStack(stack);
+            slot = index;
+        }
+        for (int s = stack->top; s >= slot; s--) {
+            *taskSlot(stack, s + 1) = *taskSlot(stack, s);
+            stack->idSlots[taskSlot(stack, s + 1)->id] = s + 1;
+        }
+        stack->top++;
+        markSlot(stack, stack->top, true);
+    } else {
+        slot--;
+        markSlot(stack, slot, true);
+        stack->tombstones--;
+    }
+    
+    task.id = stack->nextId++;
+    stack->idSlots[task.id] = slot;
+    *taskSlot(stack, slot) = task;
+    retainTaskDescription(&task);
+    
+    if (stack->keywordIndex != NULL) {
+        indexTask(stack->keywordIndex, &task, true);
+    }
+    if (stack->columns != NULL) {
+        if (shifted) {
+            rebuildTaskColumns(stack);
+        } else {
+            storeTaskColumns(stack, slot);
+        }
+    }
+    if (stack->heap != NULL) {
+        updateTaskHeap(stack, NULL, &task);
+    }
+    if (stack->dueIndex != NULL) {
+        updateDueIndex(stack, NULL, &task);
+    }
+    if (stack->sortedViews != NULL) {
+        noteSortedChange(stack, task.id);
+    }
+    if (stack->undo != NULL) {
+        recordTaskUndo(stack, UNDO_INSERT, index, &task);
+    }
+    if (stack->wal != NULL) {
+        logTaskOperation(stack, WAL_INSERT, index, &task);
+    }
+    return true;
+}
+
+ 
+bool insertTaskAtIndex(TaskStack* stack, int index, Task task) {
+    int64_t started = beginStat(STAT_INSERT);
+    bool ok = insertTaskAtIndexUnmeasured(stack, index, task);
+    endStat(STAT_INSERT, started, ok);
+    return ok;
+}
+
+ 
+static int64_t taskSortValue(const Task* task, TaskSortField field) {
+    switch (field) {
+        case SORT_BY_IMPORTANCE:
+            return task->importance;
+        case SORT_BY_DUE_DATE:
+            return task->dueKey;
+        case SORT_BY_CREATED_AT:
+            return (int64_t)task->createdAt;
+    }
+    return 0;
+}
+
+ 
+/* Fills the sort records one key column at a time, reading only the columns
+   named by the keys; record i describes slot size - 1 - i. */
+static void extractColumnSortKeys(const TaskColumns* columns, TaskSortRecord* records, int size,
+                                  const TaskSortKey* keys, int keyCount) {
+    for (int i = 0; i < size; i++) {
+        records[i].slot = size - 1 - i;
+    }
+    for (int k = 0; k < keyCount; k++) {
+        int64_t flip = keys[k].descending ? -1 : 0;
+        switch (keys[k].field) {
+            case SORT_BY_IMPORTANCE:
+                for (int i = 0; i < size; i++) {
+                    records[i].key[k] = columns->importance[size - 1 - i] ^ flip;
+                }
+                break;
+            case SORT_BY_DUE_DATE:
+                for (int i = 0; i < size; i++) {
+                    records[i].key[k] = columns->dueKey[size - 1 - i] ^ flip;
+                }
+                break;
+            case SORT_BY_CREATED_AT:
+                for (int i = 0; i < size; i++) {
+                    records[i].key[k] = columns->createdAt[size - 1 - i] ^ flip;
+                }
+                break;
+        }
+    }
+}
+
+ 
+static inline bool sortRecordLess(const TaskSortRecord* a, const TaskSortRecord* b, int keyCount) {
+    for (int k = 0; k < keyCount; k++) {
+        if (a->key[k] != b->key[k]) {
+            return a->key[k] < b->key[k];
+        }
+    }
+    return false;
+}
+
+ 
+static void mergeSortRecords(const TaskSortRecord* left, int leftCount,
+                             const TaskSortRecord* right, int rightCount,
+                             TaskSortRecord* out, int keyCount) {
+    int i = 0, j = 0, k = 0;
+    while (i < leftCount && j < rightCount) {
+        if (sortRecordLess(&right[j], &left[i], keyCount)) {
+            out[k++] = right[j++];
+        } else {
+            out[k++] = left[i++];
+        }
+    }
+    memcpy(out + k, left + i, (leftCount - i) * sizeof(TaskSortRecord));
+    k += leftCount - i;
+    memcpy(out + k, right + j, (rightCount - j) * sizeof(TaskSortRecord));
+}
+
+ 
+/* Stable bottom-up merge sort: insertion-sorted runs of 16, then merge
+   passes that ping-pong between records and scratch. */
+static void sortRecordRun(TaskSortRecord* records, TaskSortRecord* scratch, int count, int keyCount) {
+    const int run = 16;
+    for (int start = 0; start < count; start += run) {
+        int end = start + run < count ? start + run : count;
+        for (int i = start + 1; i < end; i++) {
+            TaskSortRecord record = records[i];
+            int j = i - 1;
+            while (j >= start && sortRecordLess(&record, &records[j], keyCount)) {
+                records[j + 1] = records[j];
+                j--;
+            }
+            records[j + 1] = record;
+        }
+    }
+    
+    TaskSortRecord* from = records;
+    TaskSortRecord* to = scratch;
+    for (int width = run; width < count; width *= 2) {
+        for (int start = 0; start < count; start += 2 * width) {
+            int mid = start + width < count ? start + width : count;
+            int end = start + 2 * width < count ? start + 2 * width : count;
+            mergeSortRecords(from + start, mid - start, from + mid, end - mid, to + start, keyCount);
+        }
+        TaskSortRecord* swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != records) {
+        memcpy(records, from, count * sizeof(TaskSortRecord));
+    }
+}
+
+ 
+typedef struct {
+    TaskSortRecord* records;
+    TaskSortRecord* scratch;
+    int start;
+    int mid;
+    int end;
+    int keyCount;
+} SortJob;
+
+ 
+static void* sortRunWorker(void* arg) {
+    SortJob* job = (SortJob*)arg;
+    sortRecordRun(job->records + job->start, job->scratch + job->start,
+                  job->end - job->start, job->keyCount);
+    return NULL;
+}
+
+ 
+static void* mergeRunWorker(void* arg) {
+    SortJob* job = (SortJob*)arg;
+    mergeSortRecords(job->records + job->start, job->mid - job->start,
+                     job->records + job->mid, job->end - job->mid,
+                     job->scratch + job->start, job->keyCount);
+    return NULL;
+}
+
+ 
+static int sortThreadCount(int count) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = 1;
+    if (count < PARALLEL_SORT_THRESHOLD || cores < 2) {
+        return 1;
+    }
+    while (threads * 2 <= cores && threads * 2 <= MAX_SORT_THREADS) {
+        threads *= 2;
+    }
+    return threads;
+}
+
+ 
+/* Sorts each of the thread runs concurrently, then merges neighbouring
+   runs pairwise, one thread per merge, until a single run remains. */
+static void parallelSortRecords(TaskSortRecord* records, TaskSortRecord* scratch,
+                                int count, int keyCount, int threads) {
+    pthread_t workers[MAX_SORT_THREADS];
+    SortJob jobs[MAX_SORT_THREADS];
+    int bounds[MAX_SORT_THREADS + 1];
+    TaskSortRecord* sorted = records;
+    
+    for (int t = 0; t <= threads; t++) {
+        bounds[t] = (int)((int64_t)count * t / threads);
+    }
+    
+    for (int t = 0; t < threads; t++) {
+        jobs[t] = (SortJob){ records, scratch, bounds[t], bounds[t], bounds[t + 1], keyCount };
+        if (pthread_create(&workers[t], NULL, sortRunWorker, &jobs[t]) != 0) {
+            sortRunWorker(&jobs[t]);
+            workers[t] = 0;
+        }
+    }
+    for (int t = 0; t < threads; t++) {
+        if (workers[t]) {
+            pthread_join(workers[t], NULL);
+        }
+    }
+    
+    for (int runs = threads; runs > 1; runs /= 2) {
+        int merges = runs / 2;
+        for (int m = 0; m < merges; m++) {
+            jobs[m] = (SortJob){ records, scratch, bounds[2 * m], bounds[2 * m + 1], bounds[2 * m + 2], keyCount };
+            if (pthread_create(&workers[m], NULL, mergeRunWorker, &jobs[m]) != 0) {
+                mergeRunWorker(&jobs[m]);
+                workers[m] = 0;
+            }
+        }
+        for (int m = 0; m < merges; m++) {
+            if (workers[m]) {
+                pthread_join(workers[m], NULL);
+            }
+            bounds[m] = bounds[2 * m];
+        }
+        bounds[merges] = count;
+        
+        TaskSortRecord* swap = records;
+        records = scratch;
+        scratch = swap;
+    }
+    
+    if (records != sorted) {
+        memcpy(sorted, records, count * sizeof(TaskSortRecord));
+    }
+}
+
+ 
+/* Moves the task in slot source[j] to slot j on a compacted stack, following
+   each cycle of the permutation so every Task is moved once. Consumes
+   source. */
+static void permuteSlots(TaskStack* stack, int* source, int size) {
+    for (int start = 0; start < size; start++) {
+        if (source[start] == start) {
+            continue;
+        }
+        Task saved = *taskSlot(stack, start);
+        int current = start;
+        while (source[current] != start) {
+            int next = source[current];
+            *taskSlot(stack, current) = *taskSlot(stack, next);
+            source[current] = current;
+            current = next;
+        }
+        *taskSlot(stack, current) = saved;
+        source[current] = current;
+    }
+    for (int slot = 0; slot < size; slot++) {
+        stack->idSlots[taskSlot(stack, slot)->id] = slot;
+    }
+    if (stack->columns != NULL) {
+        rebuildTaskColumns(stack);
+    }
+}
+
+ 
+/* Reorders the stack so the first task in key order ends up on top; tasks
+   with equal keys keep their previous order. Each Task is moved once.
+   Returns false if memory ran out or the sort did not reach the log. */
+static bool sortStackUnmeasured(TaskStack* stack, const TaskSortKey* keys, int keyCount) {
+    int size = getStackSize(stack);
+    if (size < 2 || keyCount <= 0) {
+        return true;
+    }
+    if (keyCount > MAX_SORT_KEYS) {
+        keyCount = MAX_SORT_KEYS;
+    }
+    if (!unshareChunks(stack, 0, stack->chunkCount - 1)) {
+        return false;
+    }
+    if (stack->tombstones > 0) {
+        compactStack(stack);
+    }
+    
+    TaskSortRecord* records = (TaskSortRecord*)malloc(size * sizeof(TaskSortRecord));
+    TaskSortRecord* scratch = (TaskSortRecord*)malloc(size * sizeof(TaskSortRecord));
+    if (records == NULL || scratch == NULL) {
+        free(records);
+        free(scratch);
+        return false;
+    }
+    
+    if (stack->columns != NULL) {
+        extractColumnSortKeys(stack->columns, records, size, keys, keyCount);
+    } else {
+        for (int i = 0; i < size; i++) {
+            const Task* task = taskSlot(stack, size - 1 - i);
+            for (int k = 0; k < keyCount; k++) {
+                int64_t value = taskSortValue(task, keys[k].field);
+                records[i].key[k] = keys[k].descending ? ~value : value;
+            }
+            records[i].slot = size - 1 - i;
+        }
+    }
+    
+    int threads = sortThreadCount(size);
+    if (threads > 1) {
+        parallelSortRecords(records, scratch, size, keyCount, threads);
+    } else {
+        sortRecordRun(records, scratch, size, keyCount);
+    }
+    
+    int* source = (int*)scratch;
+    for (int i = 0; i < size; i++) {
+        source[size - 1 - i] = records[i].slot;
+    }
+    if (stack->undo != NULL) {
+        recordPermutationUndo(stack, source, size);
+    }
+    permuteSlots(stack, source, size);
+    free(records);
+    free(scratch);
+    if (stack->wal != NULL) {
+        logSortOperation(stack, keys, keyCount);
+    }
+    return true;
+}
+
+ 
+bool sortStack(TaskStack* stack, const TaskSortKey* keys, int keyCount) {
+    int64_t started = beginStat(STAT_SORT);
+    bool ok = sortStackUnmeasured(stack, keys, keyCount);
+    endStat(STAT_SORT, started, ok);
+    return ok;
+}
+
+ 
+/* Rearranges the stack so the task at index order[j] ends up at index j.
+   Returns false unless order is a permutation of 0..size-1. */
+static bool reorderStackUnmeasured(TaskStack* stack, const int* order) {
+    int size = getStackSize(stack);
+    int* source = (int*)malloc((size_t)size * sizeof(int) + 1);
+    bool* seen = (bool*)calloc((size_t)size + 1, sizeof(bool));
+    bool valid = source != NULL && seen != NULL;
+    
+    for (int i = 0; valid && i < size; i++) {
+        valid = order[i] >= 0 && order[i] < size && !seen[order[i]];
+        if (valid) {
+            seen[order[i]] = true;
+            source[i] = order[i];
+        }
+    }
+    free(seen);
+    if (!valid || !unshareChunks(stack, 0, stack->chunkCount - 1)) {
+        free(source);
+        return false;
+    }
+    
+    if (stack->tombstones > 0) {
+        compactStack(stack);
+    }
+    if (stack->undo != NULL) {
+        recordPermutationUndo(stack, order, size);
+    }
+    permuteSlots(stack, source, size);
+    free(source);
+    if (stack->wal != NULL) {
+        logReorderOperation(stack, order, size);
+    }
+    return true;
+}
+
+ 
+bool reorderStack(TaskStack* stack, const int* order) {
+    int64_t started = beginStat(STAT_REORDER);
+    bool ok = reorderStackUnmeasured(stack, order);
+    endStat(STAT_REORDER, started, ok);
+    return ok;
+}
+
+ 
+void sortStackByDate(TaskStack* stack) {
+    TaskSortKey key = { SORT_BY_DUE_DATE, false };
+    sortStack(stack, &key, 1);
+}
+
+ 
+void sortStackByImportance(TaskStack* stack) {
+    TaskSortKey key = { SORT_BY_IMPORTANCE, true };
+    sortStack(stack, &key, 1);
+}
+
+ 
+/* Parses a key list such as "-importance date created" (or "-i d c"); a
+   leading '-' sorts that key descending. Returns the key count, or -1. */
+int parseSortKeys(const char* spec, TaskSortKey* keys) {
+    const char* names[] = { "importance", "date", "created" };
+    int count = 0;
+    
+    while (*spec) {
+        while (*spec == ' ' || *spec == ',' || *spec == '\t') {
+            spec++;
+        }
+        if (*spec == '\0') {
+            break;
+        }
+        
+        bool descending = false;
+        if (*spec == '-' || *spec == '+') {
+            descending = *spec == '-';
+            spec++;
+        }
+        
+        size_t length = strcspn(spec, " ,\t");
+        int field = -1;
+        for (int i = 0; i < 3 && length > 0; i++) {
+            if (strncmp(spec, names[i], length) == 0 && length <= strlen(names[i])) {
+                field = i;
+            }
+        }
+        if (field < 0 || count == MAX_SORT_KEYS) {
+            return -1;
+        }
+        
+        keys[count].field = (TaskSortField)field;
+        keys[count].descending = descending;
+        count++;
+        spec += length;
+    }
+    return count > 0 ? count : -1;
+}
+
+ 
+static void fillSortedEntry(SortedEntry* entry, const Task* task, const TaskSortKey* keys, int keyCount) {
+    for (int k = 0; k < MAX_SORT_KEYS; k++) {
+        int64_t value = k < keyCount ? taskSortValue(task, keys[k].field) : 0;
+        entry->key[k] = k < keyCount && keys[k].descending ? ~value : value;
+    }
+    entry->id = task->id;
+}
+
+ 
+static int compareSortedEntries(const void* a, const void* b) {
+    const SortedEntry* x = (const SortedEntry*)a;
+    const SortedEntry* y = (const SortedEntry*)b;
+    for (int k = 0; k < MAX_SORT_KEYS; k++) {
+        if (x->key[k] != y->key[k]) {
+            return x->key[k] < y->key[k] ? -1 : 1;
+        }
+    }
+    return x->id < y->id ? -1 : x->id > y->id;
+}
+
+ 
+/* The view starts out stale, so it is built on its first read. */
+void initializeSortedView(SortedView* view, const TaskSortKey* keys, int keyCount) {
+    keyCount = keyCount < 0 ? 0 : keyCount > MAX_SORT_KEYS ? MAX_SORT_KEYS : keyCount;
+    memmove(view->keys, keys, keyCount * sizeof(TaskSortKey));
+    view->keyCount = keyCount;
+    view->entries = NULL;
+    view->count = 0;
+    view->capacity = 0;
+    view->changed = NULL;
+    view->changedCount = 0;
+    view->changedCapacity = 0;
+    view->marks = NULL;
+    view->markCapacity = 0;
+    view->stale = true;
+    view->merges = 0;
+    view->rebuilds = 0;
+    view->next = NULL;
+}
+
+ 
+/* Frees the view's memory; it must be detached first. The keys are kept. */
+void freeSortedView(SortedView* view) {
+    free(view->entries);
+    free(view->changed);
+    free(view->marks);
+    initializeSortedView(view, view->keys, view->keyCount);
+}
+
+ 
+void attachSortedView(TaskStack* stack, SortedView* view) {
+    markSortedViewStale(view);
+    view->next = stack->sortedViews;
+    stack->sortedViews = view;
+}
+
+ 
+void detachSortedView(TaskStack* stack, SortedView* view) {
+    for (SortedView** link = &stack->sortedViews; *link != NULL; link = &(*link)->next) {
+        if (*link == view) {
+            *link = view->next;
+            view->next = NULL;
+            markSortedViewStale(view);
+            return;
+        }
+    }
+}
+
+ 
+static bool reserveSortedEntries(SortedView* view, int count) {
+    if (count <= view->capacity) {
+        return true;
+    }
+    int capacity = view->capacity ? view->capacity : 1024;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    SortedEntry* entries = (SortedEntry*)realloc(view->entries, capacity * sizeof(SortedEntry));
+    if (entries == NULL) {
+        return false;
+    }
+    view->entries = entries;
+    view->capacity = capacity;
+    return true;
+}
+
+ 
+/* Sorts the live tasks' keys with sortStack's merge sort, collected in id
+   order so the stable sort leaves ties in id order; each record's slot
+   carries its task id. */
+static bool rebuildSortedView(const TaskStack* stack, SortedView* view) {
+    TaskSortRecord* records = (TaskSortRecord*)malloc(((size_t)stack->size + 1) * sizeof(TaskSortRecord));
+    TaskSortRecord* scratch = (TaskSortRecord*)malloc(((size_t)stack->size + 1) * sizeof(TaskSortRecord));
+    int count = 0;
+    if (records == NULL || scratch == NULL || !reserveSortedEntries(view, stack->size)) {
+        free(records);
+        free(scratch);
+        markSortedViewStale(view);
+        return false;
+    }
+    
+    for (uint32_t id = 0; id < stack->nextId; id++) {
+        if (stack->idSlots[id] >= 0) {
+            SortedEntry entry;
+            fillSortedEntry(&entry, taskSlot(stack, stack->idSlots[id]), view->keys, view->keyCount);
+            memcpy(records[count].key, entry.key, sizeof(entry.key));
+            records[count++].slot = (int)id;
+        }
+    }
+    int threads = sortThreadCount(count);
+    if (threads > 1) {
+        parallelSortRecords(records, scratch, count, view->keyCount, threads);
+    } else {
+        sortRecordRun(records, scratch, count, view->keyCount);
+    }
+    for (int i = 0; i < count; i++) {
+        memcpy(view->entries[i].key, records[i].key, sizeof(records[i].key));
+        view->entries[i].id = (uint32_t)records[i].slot;
+    }
+    free(records);
+    free(scratch);
+    
+    view->count = count;
+    clearSortedChanges(view);
+    view->stale = false;
+    view->rebuilds++;
+    return true;
+}
+
+ 
+/* Brings the view up to date with the stack. The k noted changes are
+   applied by dropping their old entries, sorting their new ones and
+   merging the two runs from the back, in place: O(n + k log k). A view
+   that is stale, or not attached to this stack and so never told of
+   changes, is rebuilt instead. Returns false when memory runs out. */
+bool refreshSortedView(const TaskStack* stack, SortedView* view) {
+    bool attached = false;
+    for (const SortedView* other = stack->sortedViews; other != NULL; other = other->next) {
+        attached = attached || other == view;
+    }
+    if (!attached || view->stale) {
+        return rebuildSortedView(stack, view);
+    }
+    if (view->changedCount == 0) {
+        return true;
+    }
+    
+    SortedEntry* fresh = (SortedEntry*)malloc(view->changedCount * sizeof(SortedEntry));
+    if (fresh == NULL || !reserveSortedEntries(view, view->count + view->changedCount)) {
+        free(fresh);
+        markSortedViewStale(view);
+        return false;
+    }
+    int added = 0;
+    for (int i = 0; i < view->changedCount; i++) {
+        uint32_t id = view->changed[i];
+        if (id < stack->nextId && stack->idSlots[id] >= 0) {
+            fillSortedEntry(&fresh[added++], taskSlot(stack, stack->idSlots[id]), view->keys, view->keyCount);
+        }
+    }
+    qsort(fresh, added, sizeof(SortedEntry), compareSortedEntries);
+    
+    int kept = 0;
+    for (int i = 0; i < view->count; i++) {
+        uint32_t id = view->entries[i].id;
+        if (id >= view->markCapacity || !view->marks[id]) {
+            view->entries[kept++] = view->entries[i];
+        }
+    }
+    int from = kept - 1;
+    int out = kept + added - 1;
+    for (int j = added - 1; j >= 0; out--) {
+        if (from >= 0 && compareSortedEntries(&view->entries[from], &fresh[j]) > 0) {
+            view->entries[out] = view->entries[from--];
+        } else {
+            view->entries[out] = fresh[j--];
+        }
+    }
+    view->count = kept + added;
+    clearSortedChanges(view);
+    view->merges++;
+    free(fresh);
+    return true;
+}
+
+ 
+/* The task at `rank` in a refreshed view, and its stack index in *index. */
+const Task* getSortedTask(const TaskStack* stack, const SortedView* view, int rank, int* index) {
+    if (rank < 0 || rank >= view->count) {
+        return NULL;
+    }
+    int slot = stack->idSlots[view->entries[rank].id];
+    if (index != NULL) {
+        *index = indexForSlot(stack, slot);
+    }
+    return taskSlot(stack, slot);
+}
+
+ 
+/* Where the task at stack index `index` sits in a refreshed view, found by
+   binary search on its keys. */
+static int findSortedRank(const TaskStack* stack, const SortedView* view, int index) {
+    SortedEntry entry;
+    int low = 0;
+    int high = view->count;
+    fillSortedEntry(&entry, taskSlot(stack, slotForIndex(stack, index)), view->keys, view->keyCount);
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (compareSortedEntries(&view->entries[mid], &entry) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+ 
+/* Prints every task in the view's order. Returns the count, or -1 when
+   the view cannot be brought up to date. */
+int displaySortedView(const TaskStack* stack, SortedView* view) {
+    if (!refreshSortedView(stack, view)) {
+        return -1;
+    }
+    for (int rank = 0; rank < view->count; rank++) {
+        int index;
+        const Task* task = getSortedTask(stack, view, rank, &index);
+        displayTask(task, index);
+    }
+    return view->count;
+}
+
+ 
+static bool writeSnapshotBytes(FILE* file, const void* data, size_t length, uint32_t* crc) {
+    *crc = updateCrc32(*crc, data, length);
+    return fwrite(data, 1, length, file) == length;
+}
+
+ 
+/* Writes the stack bottom to top: a header, one fixed-width record per task
+   and then the descriptions, each NUL-terminated and addressed by the
+   offset in its record. The header goes in last, once the CRC is known. */
+bool writeTaskSnapshot(const TaskStack* stack, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    
+    unsigned char header[SNAPSHOT_HEADER_SIZE] = { 0 };
+    unsigned char buffer[256 * SNAPSHOT_RECORD_SIZE];
+    size_t used = 0;
+    uint64_t stringOffset = 0;
+    uint32_t crc = 0;
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    TaskCursor cursor;
+    const Task* task;
+    
+    openTaskCursor(&cursor, stack);
+    while (ok && (task = nextTaskFromCursor(&cursor)) != NULL) {
+        unsigned char* record = buffer + used;
+        size_t length = task->descriptionLength;
+        
+        memset(record, 0, SNAPSHOT_RECORD_SIZE);
+        putLE64(record, stringOffset);
+        putLE16(record + 8, (uint16_t)length);
+        putLE32(record + 12, (uint32_t)task->dueKey);
+        putLE32(record + 16, (uint32_t)task->importance);
+        putLE32(record + 20, (uint32_t)task->status);
+        putLE64(record + 24, (uint64_t)(int64_t)task->createdAt);
+        stringOffset += length + 1;
+        used += SNAPSHOT_RECORD_SIZE;
+        
+        if (used == sizeof(buffer)) {
+            ok = writeSnapshotBytes(file, buffer, used, &crc);
+            used = 0;
+        }
+    }
+    ok = ok && writeSnapshotBytes(file, buffer, used, &crc);
+    used = 0;
+    
+    openTaskCursor(&cursor, stack);
+    while (ok && (task = nextTaskFromCursor(&cursor)) != NULL) {
+        size_t length = task->descriptionLength;
+        if (used + length + 1 > sizeof(buffer)) {
+            ok = writeSnapshotBytes(file, buffer, used, &crc);
+            used = 0;
+        }
+        memcpy(buffer + used, getTaskDescription(task), length);
+        buffer[used + length] = '\0';
+        used += length + 1;
+    }
+    ok = ok && writeSnapshotBytes(file, buffer, used, &crc);
+    
+    uint64_t count = (uint64_t)getStackSize(stack);
+    memcpy(header, SNAPSHOT_MAGIC, 8);
+    putLE32(header + 8, SNAPSHOT_VERSION);
+    putLE32(header + 12, SNAPSHOT_HEADER_SIZE);
+    putLE32(header + 16, SNAPSHOT_RECORD_SIZE);
+    putLE32(header + 20, crc);
+    putLE64(header + 24, count);
+    putLE64(header + 32, SNAPSHOT_HEADER_SIZE + count * SNAPSHOT_RECORD_SIZE);
+    putLE64(header + 40, stringOffset);
+    putLE64(header + 48, stack->lsn);
+    
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    return fclose(file) == 0 && ok;
+}
+
+ 
+/* The snapshot of a stack's file being written from a view on another
+   thread, to the same path with ".bg" appended. */
+typedef struct {
+    TaskStack view;
+    char path[MAX_NAMESPACE_PATH];
+    char temporary[MAX_NAMESPACE_PATH + 8];
+    pthread_t thread;
+    atomic_bool done;
+    bool running;
+    bool written;
+    bool superseded;
+} BackgroundSave;
+
+static BackgroundSave backgroundSave;
+
+ 
+/* Makes a rename within the directory holding `path` durable. */
+static void syncParentDirectory(const char* path) {
+    char parent[MAX_NAMESPACE_PATH];
+    const char* slash = strrchr(path, '/');
+    snprintf(parent, sizeof(parent), "%.*s", slash != NULL ? (int)(slash - path + 1) : 1,
+             slash != NULL ? path : ".");
+    int directory = open(parent, O_RDONLY);
+    if (directory >= 0) {
+        fsync(directory);
+        close(directory);
+    }
+}
+
+ 
+/* Checkpoints the stack: the snapshot is written beside `path` and renamed
+   over it, so a crash leaves either the old file or the new one. Every
+   logged operation is then part of the file and the log restarts. */
+static bool saveStackToPathUnmeasured(const TaskStack* stack, const char* path) {
+    char temporary[MAX_NAMESPACE_PATH + 8];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    if (!writeTaskSnapshot(stack, temporary) || rename(temporary, path) != 0) {
+        remove(temporary);
+        return false;
+    }
+    syncParentDirectory(path);
+    if (backgroundSave.running && strcmp(path, backgroundSave.path) == 0) {
+        backgroundSave.superseded = true;
+    }
+    
+    WriteAheadLog* wal = stack->wal;
+    if (wal != NULL && wal->fd >= 0 && ftruncate(wal->fd, 0) == 0) {
+        wal->used = 0;
+        wal->pendingRecords = 0;
+        wal->fileSize = 0;
+        wal->syncedSize = 0;
+        wal->failed = false;
+        wal->checkpointDue = false;
+        wal->checkpointRetryNanos = WAL_CHECKPOINT_RETRY_MS * 1000000LL;
+        lseek(wal->fd, 0, SEEK_SET);
+    }
+    return true;
+}
+
+ 
+bool saveStackToPath(const TaskStack* stack, const char* path) {
+    int64_t started = beginStat(STAT_SAVE);
+    bool ok = saveStackToPathUnmeasured(stack, path);
+    endStat(STAT_SAVE, started, ok);
+    return ok;
+}
+
+ 
+/* Saves to tasks.dat, or to the stack's own file if it has one. */
+bool saveStackToFile(const TaskStack* stack) {
+    return saveStackToPath(stack, stack->path != NULL ? stack->path : FILENAME);
+}
+
+ 
+/* Runs the checkpoint the log has marked due, for callers at an idle point:
+   the menu prompt, a server round, a script line, unlocking a named stack.
+   After a failed save the next try waits WAL_CHECKPOINT_RETRY_MS, doubling
+   up to WAL_CHECKPOINT_RETRY_MAX_MS. Returns false only when a checkpoint
+   was due and did not happen. */
+bool checkpointWriteAheadLog(TaskStack* stack) {
+    WriteAheadLog* wal = stack->wal;
+    if (wal == NULL || wal->fd < 0 || !wal->checkpointDue) {
+        return true;
+    }
+    int64_t now = monotonicNanos();
+    if (now < wal->checkpointRetryAt) {
+        return false;
+    }
+    if (saveStackToFile(stack) && !wal->checkpointDue) {
+        return true;
+    }
+    wal->checkpointRetryAt = now + wal->checkpointRetryNanos;
+    if (wal->checkpointRetryNanos < WAL_CHECKPOINT_RETRY_MAX_MS * 1000000LL / 2) {
+        wal->checkpointRetryNanos *= 2;
+    } else {
+        wal->checkpointRetryNanos = WAL_CHECKPOINT_RETRY_MAX_MS * 1000000LL;
+    }
+    return false;
+}
+
+ 
+static void* runBackgroundSave(void* argument) {
+    BackgroundSave* save = (BackgroundSave*)argument;
+    int64_t started = beginStat(STAT_SAVE);
+    save->written = writeTaskSnapshot(&save->view, save->temporary);
+    endStat(STAT_SAVE, started, save->written);
+    atomic_store_explicit(&save->done, true, memory_order_release);
+    return NULL;
+}
+
+ 
+/* Starts writing the stack as it is now to its file from a view on another
+   thread and returns at once; mutations go on meanwhile, copying the chunks
+   they touch. The log is left alone, since replay skips the records the
+   snapshot holds, and restarts at the next saveStackToFile. A save still
+   running is finished first. Without a thread, or when the log has failed
+   and only a checkpoint can restart it, this is saveStackToFile. */
+bool saveStackInBackground(TaskStack* stack) {
+    finishBackgroundSave(true);
+    if (stack->wal != NULL && stack->wal->failed) {
+        return saveStackToFile(stack);
+    }
+    openStackView(stack, &backgroundSave.view);
+    snprintf(backgroundSave.path, sizeof(backgroundSave.path), "%s", stack->path != NULL ? stack->path : FILENAME);
+    snprintf(backgroundSave.temporary, sizeof(backgroundSave.temporary), "%s.bg", backgroundSave.path);
+    atomic_store_explicit(&backgroundSave.done, false, memory_order_relaxed);
+    backgroundSave.superseded = false;
+    if (pthread_create(&backgroundSave.thread, NULL, runBackgroundSave, &backgroundSave) != 0) {
+        closeStackView(&backgroundSave.view);
+        return saveStackToFile(stack);
+    }
+    backgroundSave.running = true;
+    return true;
+}
+
+ 
+/* Collects the background save once its thread is done, or waits for it,
+   and renames its snapshot over the stack's file unless saveStackToFile
+   has written a newer one since. Returns true when a save was collected
+   and the file now holds it. */
+bool finishBackgroundSave(bool wait) {
+    BackgroundSave* save = &backgroundSave;
+    if (!save->running || (!wait && !atomic_load_explicit(&save->done, memory_order_acquire))) {
+        return false;
+    }
+    pthread_join(save->thread, NULL);
+    closeStackView(&save->view);
+    save->running = false;
+    
+    if (!save->written || save->superseded || rename(save->temporary, save->path) != 0) {
+        remove(save->temporary);
+        return false;
+    }
+    syncParentDirectory(save->path);
+    return true;
+}
+
+ 
+/* Maps a snapshot and checks its header, in time independent of the task
+   count; the CRC is left to verifyTaskSnapshot. Files from before the
+   versioned format (a task count followed by raw Task structs, in either
+   the original or the interim layout) are recognised by their size. */
+bool openTaskSnapshot(TaskSnapshot* snapshot, const char* path) {
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+    
+    memset(snapshot, 0, sizeof(*snapshot));
+    if (fd < 0) {
+        return false;
+    }
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(int)) {
+        close(fd);
+        errno = EINVAL;
+        return false;
+    }
+    
+    void* map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    snapshot->map = (const unsigned char*)map;
+    snapshot->mapSize = (size_t)info.st_size;
+    
+    const unsigned char* p = snapshot->map;
+    size_t size = snapshot->mapSize;
+    
+    if (size >= SNAPSHOT_HEADER_SIZE && memcmp(p, SNAPSHOT_MAGIC, 8) == 0) {
+        uint64_t count = getLE64(p + 24);
+        uint64_t stringsOffset = getLE64(p + 32);
+        uint64_t stringsSize = getLE64(p + 40);
+        
+        if (getLE32(p + 8) == SNAPSHOT_VERSION && getLE32(p + 12) == SNAPSHOT_HEADER_SIZE &&
+            getLE32(p + 16) == SNAPSHOT_RECORD_SIZE && count <= MAX_TASKS &&
+            stringsOffset == SNAPSHOT_HEADER_SIZE + count * SNAPSHOT_RECORD_SIZE &&
+            stringsOffset <= size && stringsSize == size - stringsOffset) {
+            snapshot->format = SNAPSHOT_VERSIONED;
+            snapshot->count = (int)count;
+            snapshot->crc = getLE32(p + 20);
+            snapshot->lsn = getLE64(p + 48);
+            snapshot->records = p + SNAPSHOT_HEADER_SIZE;
+            snapshot->strings = p + stringsOffset;
+            snapshot->stringsSize = stringsSize;
+            return true;
+        }
+    } else {
+        int count;
+        memcpy(&count, p, sizeof(int));
+        if (count >= 0 && size - sizeof(int) == (size_t)count * sizeof(LegacyTask)) {
+            snapshot->format = SNAPSHOT_LEGACY_BASELINE;
+        } else if (count >= 0 && size - sizeof(int) == (size_t)count * sizeof(RawTask)) {
+            snapshot->format = SNAPSHOT_LEGACY_RAW;
+        }
+        if (snapshot->format != SNAPSHOT_INVALID) {
+            snapshot->count = count;
+            snapshot->records = p + sizeof(int);
+            return true;
+        }
+    }
+    
+    closeTaskSnapshot(snapshot);
+    errno = EINVAL;
+    return false;
+}
+
+ 
+void closeTaskSnapshot(TaskSnapshot* snapshot) {
+    if (snapshot->map != NULL) {
+        munmap((void*)snapshot->map, snapshot->mapSize);
+    }
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+ 
+/* Checks the CRC over the records and descriptions. Legacy files carry no
+   checksum and always pass. */
+bool verifyTaskSnapshot(const TaskSnapshot* snapshot) {
+    if (snapshot->format != SNAPSHOT_VERSIONED) {
+        return snapshot->format != SNAPSHOT_INVALID;
+    }
+    size_t length = snapshot->mapSize - SNAPSHOT_HEADER_SIZE;
+    return updateCrc32(0, snapshot->records, length) == snapshot->crc;
+}
+
+ 
+/* Returns the description of task index in place, without copying. For
+   versioned files the text is NUL-terminated whenever the record is valid;
+   NULL means the record points outside the string section. */
+const char* getSnapshotDescription(const TaskSnapshot* snapshot, int index, size_t* length) {
+    if (index < 0 || index >= snapshot->count) {
+        return NULL;
+    }
+    if (snapshot->format == SNAPSHOT_VERSIONED) {
+        const unsigned char* record = snapshot->records + (size_t)index * SNAPSHOT_RECORD_SIZE;
+        uint64_t offset = getLE64(record);
+        size_t textLength = getLE16(record + 8);
+        if (textLength >= MAX_DESCRIPTION || offset >= snapshot->stringsSize ||
+            snapshot->stringsSize - offset <= textLength || snapshot->strings[offset + textLength] != '\0') {
+            return NULL;
+        }
+        *length = textLength;
+        return (const char*)snapshot->strings + offset;
+    }
+    
+    size_t width = snapshot->format == SNAPSHOT_LEGACY_BASELINE ? sizeof(LegacyTask) : sizeof(RawTask);
+    const char* text = (const char*)snapshot->records + (size_t)index * width;
+    *length = strnlen(text, LEGACY_DESCRIPTION - 1);
+    return text;
+}
+
+ 
+/* Decodes task index (0 is the bottom of the stack) from the mapping. */
+bool readSnapshotTask(const TaskSnapshot* snapshot, int index, Task* task) {
+    size_t length;
+    const char* text = getSnapshotDescription(snapshot, index, &length);
+    if (text == NULL) {
+        return false;
+    }
+    
+    memset(task, 0, sizeof(*task));
+    if (!setTaskDescriptionText(task, text, length)) {
+        return false;
+    }
+    
+    if (snapshot->format == SNAPSHOT_VERSIONED) {
+        const unsigned char* record = snapshot->records + (size_t)index * SNAPSHOT_RECORD_SIZE;
+        task->dueKey = (int32_t)getLE32(record + 12);
+        task->importance = (int32_t)getLE32(record + 16);
+        task->status = (TaskStatus)getLE32(record + 20);
+        task->createdAt = (time_t)(int64_t)getLE64(record + 24);
+    } else if (snapshot->format == SNAPSHOT_LEGACY_BASELINE) {
+        LegacyTask legacy;
+        memcpy(&legacy, snapshot->records + (size_t)index * sizeof(LegacyTask), sizeof(legacy));
+        task->dueKey = DUE_KEY(legacy.year, legacy.month, legacy.day);
+        task->importance = legacy.importance;
+        task->status = (TaskStatus)legacy.status;
+        task->createdAt = legacy.createdAt;
+    } else {
+        RawTask raw;
+        memcpy(&raw, snapshot->records + (size_t)index * sizeof(RawTask), sizeof(raw));
+        task->dueKey = raw.dueKey;
+        task->importance = raw.importance;
+        task->status = raw.status;
+        task->createdAt = raw.createdAt;
+    }
+    
+    if ((unsigned)task->status > COMPLETED) {
+        task->status = PENDING;
+    }
+    if (!setTaskDueDate(task, DUE_YEAR(task->dueKey), DUE_MONTH(task->dueKey), DUE_DAY(task->dueKey))) {
+        task->dueLabel[0] = '\0';
+    }
+    return true;
+}
+
+ 
+/* Replaces the stack's tasks with the snapshot's, decoded and appended
+   IMPORT_BATCH_SIZE at a time. A file that fails to open or verify
+   leaves the stack as it was; one that fails to decode part of the way
+   leaves it empty at LSN 0, never holding part of the file. */
+bool loadStackFromPath(TaskStack* stack, const char* path) {
+    TaskSnapshot snapshot;
+    Task* batch = NULL;
+    int64_t started = beginStat(STAT_LOAD);
+    
+    if (!openTaskSnapshot(&snapshot, path)) {
+        endStat(STAT_LOAD, started, false);
+        return false;
+    }
+    bool ok = verifyTaskSnapshot(&snapshot) && (batch = (Task*)malloc(IMPORT_BATCH_SIZE * sizeof(Task))) != NULL;
+    if (ok) {
+        WriteAheadLog* wal = stack->wal;
+        UndoStack* undo = stack->undo;
+        madvise((void*)snapshot.map, snapshot.mapSize, MADV_SEQUENTIAL);
+        resetStack(stack);
+        stack->wal = NULL;
+        stack->undo = NULL;
+        for (int first = 0; ok && first < snapshot.count; first += IMPORT_BATCH_SIZE) {
+            int count = snapshot.count - first < IMPORT_BATCH_SIZE ? snapshot.count - first : IMPORT_BATCH_SIZE;
+            for (int i = 0; ok && i < count; i++) {
+                ok = readSnapshotTask(&snapshot, first + i, &batch[i]);
+            }
+            ok = ok && pushTasks(stack, batch, count);
+        }
+        if (!ok) {
+            resetStack(stack);
+        }
+        stack->wal = wal;
+        stack->undo = undo;
+        stack->lsn = ok ? snapshot.lsn : 0;
+    }
+    free(batch);
+    closeTaskSnapshot(&snapshot);
+    endStat(STAT_LOAD, started, ok);
+    if (!ok) {
+        errno = EINVAL;
+    }
+    return ok;
+}
+
+ 
+bool loadStackFromFile(TaskStack* stack) {
+    return loadStackFromPath(stack, stack->path != NULL ? stack->path : FILENAME);
+}
+
+ 
+TaskFileFormat taskFileFormatForPath(const char* path) {
+    const char* extension = strrchr(path, '.');
+    if (extension != NULL && (strcasecmp(extension, ".jsonl") == 0 || strcasecmp(extension, ".ndjson") == 0 ||
+                              strcasecmp(extension, ".json") == 0)) {
+        return TASK_FILE_JSONL;
+    }
+    return TASK_FILE_CSV;
+}
+
+ 
+/* Accepts the status tokens used by import, export and batch commands, or
+   the digits 0-2. */
+static bool parseStatusToken(const char* text, size_t length, TaskStatus* status) {
+    for (int s = PENDING; s <= COMPLETED; s++) {
+        if ((length == 1 && text[0] == '0' + s) ||
+            (length == strlen(statusTokens[s]) && strncasecmp(text, statusTokens[s], length) == 0)) {
+            *status = (TaskStatus)s;
+            return true;
+        }
+    }
+    return false;
+}
+
+ 
+static bool parseFieldInteger(const ImportField* field, int64_t low, int64_t high, int64_t* value) {
+    const char* text = field->text;
+    size_t i = field->length > 0 && text[0] == '-';
+    int64_t parsed = 0;
+    
+    if (i == field->length || field->length - i > 18) {
+        return false;
+    }
+    for (; i < field->length; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        parsed = parsed * 10 + (text[i] - '0');
+    }
+    parsed = text[0] == '-' ? -parsed : parsed;
+    if (parsed < low || parsed > high) {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+ 
+/* YYYY-MM-DD to a due-date key. Only the shape is checked here; the date
+   itself is validated later, a batch at a time. */
+static bool parseFieldDate(const ImportField* field, int* key) {
+    const char* text = field->text;
+    int value = 0;
+    if (field->length != 10) {
+        return false;
+    }
+    for (int i = 0; i < 10; i++) {
+        if (i == 4 || i == 7) {
+            if (text[i] != '-') {
+                return false;
+            }
+        } else if (text[i] < '0' || text[i] > '9') {
+            return false;
+        } else {
+            value = value * 10 + (text[i] - '0');
+        }
+    }
+    *key = value;
+    return true;
+}
+
+ 
+static int parseHexDigits(const char* text) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = isdigit((unsigned char)text[i]) ? text[i] - '0' :
+                    isxdigit((unsigned char)text[i]) ? (tolower((unsigned char)text[i]) - 'a' + 10) : -1;
+        if (digit < 0) {
+            return -1;
+        }
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+ 
+/* Copies a field into a NUL-terminated description, undoing CSV doubled
+   quotes or JSON escapes. Fails if the result does not fit. */
+static bool copyFieldText(const ImportField* field, TaskFileFormat format, char* out) {
+    const char* text = field->text;
+    size_t used = 0;
+    
+    if (!field->escaped) {
+        if (field->length >= MAX_DESCRIPTION) {
+            return false;
+        }
+        memcpy(out, text, field->length);
+        out[field->length] = '\0';
+        return true;
+    }
+    
+    for (size_t i = 0; i < field->length; i++) {
+        unsigned char utf8[4];
+        int bytes = 1;
+        utf8[0] = (unsigned char)text[i];
+        if (format == TASK_FILE_CSV) {
+            i += text[i] == '"';
+        } else if (text[i] == '\\') {
+            const char* escapes = "\"\"\\\\//b\bf\fn\nr\rt\t";
+            const char* found = strchr(escapes, text[++i]);
+            if (text[i] != 'u' && (text[i] == '\0' || found == NULL || (found - escapes) % 2 != 0)) {
+                return false;
+            }
+            if (text[i] != 'u') {
+                utf8[0] = (unsigned char)found[1];
+            } else {
+                int code = i + 4 < field->length ? parseHexDigits(text + i + 1) : -1;
+                i += 4;
+                if (code >= 0xD800 && code < 0xDC00) {
+                    int low = i + 6 < field->length && text[i + 1] == '\\' && text[i + 2] == 'u' ?
+                              parseHexDigits(text + i + 3) : -1;
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        return false;
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                } else if (code < 0 || (code >= 0xDC00 && code <= 0xDFFF)) {
+                    return false;
+                }
+                if (code < 0x80) {
+                    utf8[0] = (unsigned char)code;
+                } else if (code < 0x800) {
+                    utf8[0] = (unsigned char)(0xC0 | code >> 6);
+                    utf8[1] = (unsigned char)(0x80 | (code & 0x3F));
+                    bytes = 2;
+                } else if (code < 0x10000) {
+                    utf8[0] = (unsigned char)(0xE0 | code >> 12);
+                    utf8[1] = (unsigned char)(0x80 | ((code >> 6) & 0x3F));
+                    utf8[2] = (unsigned char)(0x80 | (code & 0x3F));
+                    bytes = 3;
+                } else {
+                    utf8[0] = (unsigned char)(0xF0 | code >> 18);
+                    utf8[1] = (unsigned char)(0x80 | ((code >> 12) & 0x3F));
+                    utf8[2] = (unsigned char)(0x80 | ((code >> 6) & 0x3F));
+                    utf8[3] = (unsigned char)(0x80 | (code & 0x3F));
+                    bytes = 4;
+                }
+            }
+        }
+        if (used + bytes >= MAX_DESCRIPTION || (bytes == 1 && utf8[0] == '\0')) {
+            return false;
+        }
+        memcpy(out + used, utf8, bytes);
+        used += bytes;
+    }
+    out[used] = '\0';
+    return true;
+}
+
+ 
+static const char* skipLine(const char* cursor, const char* end) {
+    const char* newline = (const char*)memchr(cursor, '\n', end - cursor);
+    return newline != NULL ? newline + 1 : end;
+}
+
+ 
+/* Reads one CSV field in place. Returns 1 if a comma follows, 0 at the end
+   of the record and -1 if the field is malformed. Quoted fields may hold
+   commas, doubled quotes and newlines. */
+static int nextCsvField(const char** cursor, const char* end, ImportField* field) {
+    const char* p = *cursor;
+    
+    field->escaped = false;
+    if (p < end && *p == '"') {
+        field->text = ++p;
+        while ((p = (const char*)memchr(p, '"', end - p)) != NULL && p + 1 < end && p[1] == '"') {
+            field->escaped = true;
+            p += 2;
+        }
+        if (p == NULL) {
+            return -1;
+        }
+        field->length = p++ - field->text;
+    } else {
+        field->text = p;
+        while (p < end && *p != ',' && *p != '\n' && *p != '\r') {
+            p++;
+        }
+        field->length = p - field->text;
+    }
+    
+    if (p < end && *p == ',') {
+        *cursor = p + 1;
+        return 1;
+    }
+    if (p < end && *p == '\r') {
+        p++;
+    }
+    if (p < end && *p != '\n') {
+        return -1;
+    }
+    *cursor = p < end ? p + 1 : end;
+    return 0;
+}
+
+ 
+/* Returns the number of fields in the record (only the first IMPORT_FIELDS
+   are kept) or -1 if it is malformed, in which case the rest of its line is
+   skipped. */
+static int readCsvRecord(const char** cursor, const char* end, ImportField* fields) {
+    ImportField field;
+    int count = 0;
+    int more = 1;
+    
+    while (more > 0) {
+        more = nextCsvField(cursor, end, &field);
+        if (more < 0) {
+            *cursor = skipLine(*cursor, end);
+            return -1;
+        }
+        if (count < IMPORT_FIELDS) {
+            fields[count] = field;
+        }
+        count++;
+    }
+    return count;
+}
+
+ 
+static const char* skipJsonSpace(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+ 
+static bool readJsonString(const char** cursor, const char* end, ImportField* field) {
+    const char* p = *cursor + 1;
+    
+    field->text = p;
+    field->escaped = false;
+    while (p < end && *p != '"') {
+        if (*p == '\\') {
+            if (p + 1 >= end) {
+                return false;
+            }
+            field->escaped = true;
+            p++;
+        } else if ((unsigned char)*p < 0x20) {
+            return false;
+        }
+        p++;
+    }
+    if (p >= end) {
+        return false;
+    }
+    field->length = p - field->text;
+    *cursor = p + 1;
+    return true;
+}
+
+ 
+/* Parses one line of JSON Lines: a flat object whose values are strings,
+   numbers, booleans or null. The known keys fill `fields`, with a bit per
+   key set in `present`, and other keys are ignored. Returns 1 for an
+   object, 0 for a blank line and -1 if the line is malformed. */
+static int readJsonRecord(const char** cursor, const char* end, ImportField* fields, unsigned* present) {
+    const char* lineEnd = (const char*)memchr(*cursor, '\n', end - *cursor);
+    lineEnd = lineEnd != NULL ? lineEnd : end;
+    const char* p = skipJsonSpace(*cursor, lineEnd);
+    
+    *cursor = lineEnd < end ? lineEnd + 1 : end;
+    *present = 0;
+    if (p == lineEnd) {
+        return 0;
+    }
+    if (*p != '{') {
+        return -1;
+    }
+    p = skipJsonSpace(p + 1, lineEnd);
+    
+    while (p < lineEnd && *p != '}') {
+        ImportField key, value;
+        if (*p != '"' || !readJsonString(&p, lineEnd, &key)) {
+            return -1;
+        }
+        p = skipJsonSpace(p, lineEnd);
+        if (p == lineEnd || *p != ':') {
+            return -1;
+        }
+        p = skipJsonSpace(p + 1, lineEnd);
+        if (p < lineEnd && *p == '"') {
+            if (!readJsonString(&p, lineEnd, &value)) {
+                return -1;
+            }
+        } else {
+            value.text = p;
+            value.escaped = false;
+            while (p < lineEnd && (isalnum((unsigned char)*p) || *p == '-' || *p == '+' || *p == '.')) {
+                p++;
+            }
+            value.length = p - value.text;
+            if (value.length == 0) {
+                return -1;
+            }
+        }
+        
+        for (int f = 0; f < IMPORT_FIELDS; f++) {
+            if (!key.escaped && key.length == strlen(importFieldNames[f]) &&
+                memcmp(key.text, importFieldNames[f], key.length) == 0) {
+                fields[f] = value;
+                *present |= 1u << f;
+            }
+        }
+        p = skipJsonSpace(p, lineEnd);
+        if (p < lineEnd && *p == ',') {
+            p = skipJsonSpace(p + 1, lineEnd);
+            if (p < lineEnd && *p == '}') {
+                return -1;
+            }
+        } else if (p == lineEnd || *p != '}') {
+            return -1;
+        }
+    }
+    if (p == lineEnd) {
+        return -1;
+    }
+    return skipJsonSpace(p + 1, lineEnd) == lineEnd ? 1 : -1;
+}
+
+ 
+/* Fills a task from the import fields. created_at may be missing or empty,
+   in which case the import time is used. The due date is only parsed here
+   and is validated with the rest of its batch. */
+static bool taskFromImportFields(const ImportField* fields, unsigned present, TaskFileFormat format, time_t now,
+                                 Task* task) {
+    const unsigned required = (1u << IMPORT_REQUIRED_FIELDS) - 1;
+    int64_t importance;
+    int64_t createdAt = (int64_t)now;
+    char description[MAX_DESCRIPTION];
+    
+    memset(task, 0, sizeof(*task));
+    if ((present & required) != required ||
+        !copyFieldText(&fields[0], format, description) ||
+        !setTaskDescription(task, description) ||
+        !parseFieldDate(&fields[1], &task->dueKey) ||
+        !parseFieldInteger(&fields[2], INT_MIN, INT_MAX, &importance) ||
+        !parseStatusToken(fields[3].text, fields[3].length, &task->status)) {
+        return false;
+    }
+    if ((present >> IMPORT_REQUIRED_FIELDS) & 1 && fields[4].length > 0 &&
+        !parseFieldInteger(&fields[4], -999999999999999999LL, 999999999999999999LL, &createdAt)) {
+        return false;
+    }
+    task->importance = (int)importance;
+    task->createdAt = (time_t)createdAt;
+    return true;
+}
+
+ 
+/* Validates the batch's due dates in one pass, drops the invalid records
+   and appends the rest with a single pushTasks. Returns the number pushed,
+   or -1 if the stack could not grow. */
+static int flushImportBatch(TaskStack* stack, Task* batch, int count, int* rejected) {
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        int key = batch[i].dueKey;
+        if (setTaskDueDate(&batch[i], DUE_YEAR(key), DUE_MONTH(key), DUE_DAY(key))) {
+            if (kept != i) {
+                batch[kept] = batch[i];
+            }
+            kept++;
+        }
+    }
+    *rejected += count - kept;
+    return pushTasks(stack, batch, kept) ? kept : -1;
+}
+
+ 
+/* Streams a CSV or JSON Lines file onto the stack, bottom task first.
+   The file is mapped, and fields are tokenized in place; only the final
+   Task is written. Records are appended IMPORT_BATCH_SIZE at a time.
+   Malformed or invalid records are skipped and counted in `rejected`.
+   Returns the number of tasks imported, or -1 if the file cannot be read. */
+static int importTasksFromFileUnmeasured(TaskStack* stack, const char* path, TaskFileFormat format, int* rejected) {
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+    
+    *rejected = 0;
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (info.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    size_t size = (size_t)info.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    Task* batch = (Task*)malloc(IMPORT_BATCH_SIZE * sizeof(Task));
+    if (map == MAP_FAILED || batch == NULL) {
+        if (map != MAP_FAILED) {
+            munmap(map, size);
+        }
+        free(batch);
+        return -1;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    
+    const char* cursor = (const char*)map;
+    const char* end = cursor + size;
+    time_t now = time(NULL);
+    int imported = 0;
+    int pending = 0;
+    bool header = format == TASK_FILE_CSV;
+    bool full = false;
+    
+    while (cursor < end && !full) {
+        ImportField fields[IMPORT_FIELDS];
+        unsigned present = 0;
+        int result;
+        
+        if (format == TASK_FILE_CSV) {
+            int count = readCsvRecord(&cursor, end, fields);
+            if (count == 1 && fields[0].length == 0) {
+                continue;
+            }
+            if (header && count > 0 && fields[0].length == strlen(importFieldNames[0]) &&
+                strncasecmp(fields[0].text, importFieldNames[0], fields[0].length) == 0) {
+                header = false;
+                continue;
+            }
+            present = count == IMPORT_REQUIRED_FIELDS || count == IMPORT_FIELDS ? (1u << count) - 1 : 0;
+            result = count < 0 ? -1 : 1;
+        } else {
+            result = readJsonRecord(&cursor, end, fields, &present);
+        }
+        header = false;
+        if (result == 0) {
+            continue;
+        }
+        if (result < 0 || !taskFromImportFields(fields, present, format, now, &batch[pending])) {
+            (*rejected)++;
+            continue;
+        }
+        
+        if (++pending == IMPORT_BATCH_SIZE) {
+            int pushed = flushImportBatch(stack, batch, pending, rejected);
+            full = pushed < 0;
+            imported += full ? 0 : pushed;
+            pending = 0;
+        }
+    }
+    if (pending > 0 && !full) {
+        int pushed = flushImportBatch(stack, batch, pending, rejected);
+        imported += pushed < 0 ? 0 : pushed;
+    }
+    
+    free(batch);
+    munmap(map, size);
+    return imported;
+}
+
+ 
+int importTasksFromFile(TaskStack* stack, const char* path, TaskFileFormat format, int* rejected) {
+    int64_t started = beginStat(STAT_IMPORT);
+    int imported = importTasksFromFileUnmeasured(stack, path, format, rejected);
+    endStat(STAT_IMPORT, started, imported >= 0);
+    return imported;
+}
+
+ 
+static char* appendDecimal(char* out, int64_t value) {
+    char digits[20];
+    int count = 0;
+    uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+    
+    if (value < 0) {
+        *out++ = '-';
+    }
+    do {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    while (count > 0) {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+ 
+static char* appendDueDate(char* out, int key) {
+    int parts[3] = { DUE_YEAR(key), DUE_MONTH(key), DUE_DAY(key) };
+    int widths[3] = { 4, 2, 2 };
+    for (int p = 0; p < 3; p++) {
+        for (int d = widths[p] - 1, value = parts[p]; d >= 0; d--, value /= 10) {
+            out[d] = (char)('0' + value % 10);
+        }
+        out += widths[p];
+        *out++ = '-';
+    }
+    return out - 1;
+}
+
+ 
+static char* appendCsvText(char* out, const char* text) {
+    size_t length = strlen(text);
+    if (strpbrk(text, ",\"\r\n") == NULL) {
+        memcpy(out, text, length);
+        return out + length;
+    }
+    *out++ = '"';
+    for (; *text != '\0'; text++) {
+        if (*text == '"') {
+            *out++ = '"';
+        }
+        *out++ = *text;
+    }
+    *out++ = '"';
+    return out;
+}
+
+ 
+static char* appendJsonText(char* out, const char* text) {
+    const char* hex = "0123456789abcdef";
+    *out++ = '"';
+    for (; *text != '\0'; text++) {
+        unsigned char c = (unsigned char)*text;
+        if (c == '"' || c == '\\') {
+            *out++ = '\\';
+            *out++ = (char)c;
+        } else if (c < 0x20) {
+            memcpy(out, "\\u00", 4);
+            out[4] = hex[c >> 4];
+            out[5] = hex[c & 15];
+            out += 6;
+        } else {
+            *out++ = (char)c;
+        }
+    }
+    *out++ = '"';
+    return out;
+}
+
+ 
+/* One task as a CSV row in the export column order, without the newline;
+   writes at most EXPORT_ROW_LIMIT bytes. */
+static char* appendCsvTask(char* out, const Task* task) {
+    out = appendCsvText(out, getTaskDescription(task));
+    *out++ = ',';
+    out = appendDueDate(out, task->dueKey);
+    *out++ = ',';
+    out = appendDecimal(out, task->importance);
+    *out++ = ',';
+    out = stpcpy(out, statusTokens[task->status]);
+    *out++ = ',';
+    return appendDecimal(out, (int64_t)task->createdAt);
+}
+
+ 
+/* Writes the stack, bottom task first, as CSV (with a header line) or JSON
+   Lines. Rows are formatted straight from the stack into one output buffer.
+   Returns the number of tasks written, or -1 on an I/O error. */
+int exportTasksToFile(const TaskStack* stack, const char* path, TaskFileFormat format) {
+    int64_t started = beginStat(STAT_EXPORT);
+    FILE* file = fopen(path, "wb");
+    char* buffer = (char*)malloc(EXPORT_BUFFER_SIZE);
+    TaskCursor cursor;
+    const Task* task;
+    int count = 0;
+    bool ok = file != NULL && buffer != NULL;
+    
+    char* out = buffer;
+    if (ok && format == TASK_FILE_CSV) {
+        for (int f = 0; f < IMPORT_FIELDS; f++) {
+            out += sprintf(out, f ? ",%s" : "%s", importFieldNames[f]);
+        }
+        *out++ = '\n';
+    }
+    
+    openTaskCursor(&cursor, stack);
+    while (ok && (task = nextTaskFromCursor(&cursor)) != NULL) {
+        if (out - buffer > EXPORT_BUFFER_SIZE - EXPORT_ROW_LIMIT) {
+            ok = fwrite(buffer, 1, out - buffer, file) == (size_t)(out - buffer);
+            out = buffer;
+        }
+        if (format == TASK_FILE_CSV) {
+            out = appendCsvTask(out, task);
+        } else {
+            out = stpcpy(out, "{\"description\":");
+            out = appendJsonText(out, getTaskDescription(task));
+            out = stpcpy(out, ",\"due\":\"");
+            out = appendDueDate(out, task->dueKey);
+            out = stpcpy(out, "\",\"importance\":");
+            out = appendDecimal(out, task->importance);
+            out = stpcpy(out, ",\"status\":\"");
+            out = stpcpy(out, statusTokens[task->status]);
+            out = stpcpy(out, "\",\"created_at\":");
+            out = appendDecimal(out, (int64_t)task->createdAt);
+            *out++ = '}';
+        }
+        *out++ = '\n';
+        count++;
+    }
+    
+    if (ok && out > buffer) {
+        ok = fwrite(buffer, 1, out - buffer, file) == (size_t)(out - buffer);
+    }
+    if (file != NULL && fclose(file) != 0) {
+        ok = false;
+    }
+    free(buffer);
+    endStat(STAT_EXPORT, started, ok);
+    return ok ? count : -1;
+}
+ 
+void clearInputBuffer() {
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF);
+}
+
+ 
+void displayTask(const Task* task, int index) {
+    printf(TASK_ROW_FORMAT, 
+           index + 1, 
+           getTaskDescription(task), 
+           task->dueLabel, 
+           task->importance, 
+           statusNames[task->status]);
+}
+
+ 
+/* Builds the table in a frame and writes it FRAME_FLUSH_BYTES at a time,
+   rather than one stdio call per row and per border character. */
+void displayAllTasks(const TaskStack* stack) {
+    TerminalFrame frame;
+    TaskCursor cursor;
+    const Task* task;
+    
+    if (isEmptyStack(stack)) {
+        printf("| No tasks available.                                                         |\n");
+        return;
+    }
+    
+    initializeTerminalFrame(&frame, STDOUT_FILENO);
+    appendFrameLine(&frame, 80);
+    appendFrameFormat(&frame, "| %2s | %-30s | %-17s | %10s | %-11s |\n", 
+                      "ID", "Description", "Due Date", "Importance", "Status");
+    appendFrameLine(&frame, 80);
+    
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        appendFrameTask(&frame, task, cursor.index);
+        if (frame.length >= FRAME_FLUSH_BYTES) {
+            flushTerminalFrame(&frame);
+        }
+    }
+    
+    appendFrameLine(&frame, 80);
+    flushTerminalFrame(&frame);
+    freeTerminalFrame(&frame);
+}
+
+ 
+void prepareSubstringMatcher(SubstringMatcher* matcher, const char* needle, bool ignoreCase) {
+    snprintf(matcher->needle, MAX_DESCRIPTION, "%s", needle);
+    matcher->length = strlen(matcher->needle);
+    matcher->ignoreCase = ignoreCase;
+    
+    if (ignoreCase) {
+        for (size_t i = 0; i < matcher->length; i++) {
+            matcher->needle[i] = (char)tolower((unsigned char)matcher->needle[i]);
+        }
+    }
+    
+    char first = matcher->length ? matcher->needle[0] : 0;
+    char last = matcher->length ? matcher->needle[matcher->length - 1] : 0;
+    matcher->firstLower = first;
+    matcher->lastLower = last;
+    matcher->firstUpper = ignoreCase ? (char)toupper((unsigned char)first) : first;
+    matcher->lastUpper = ignoreCase ? (char)toupper((unsigned char)last) : last;
+}
+
+ 
+static inline bool matchesAt(const SubstringMatcher* matcher, const char* text) {
+    if (!matcher->ignoreCase) {
+        return memcmp(text + 1, matcher->needle + 1, matcher->length - 1) == 0;
+    }
+    for (size_t i = 1; i < matcher->length; i++) {
+        if (tolower((unsigned char)text[i]) != (unsigned char)matcher->needle[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ 
+/* Byte-at-a-time scan from text[start]; stops at the terminating NUL and
+   never compares past it, so it is safe right up to the readable limit. */
+static bool scanScalar(const SubstringMatcher* matcher, const char* text, size_t start) {
+    for (size_t i = start; text[i] != '\0'; i++) {
+        if (text[i] != matcher->firstLower && text[i] != matcher->firstUpper) {
+            continue;
+        }
+        size_t j = 1;
+        while (j < matcher->length) {
+            unsigned char c = (unsigned char)text[i + j];
+            if ((matcher->ignoreCase ? tolower(c) : c) != (unsigned char)matcher->needle[j]) {
+                break;
+            }
+            j++;
+        }
+        if (j == matcher->length) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ 
+static bool scanPortable(const SubstringMatcher* matcher, const char* text, size_t readable) {
+    (void)readable;
+    return scanScalar(matcher, text, 0);
+}
+
+#ifdef HAVE_X86_SIMD
+ 
+/* Compares 16 candidate start positions at once against the needle's first
+   and last bytes and only verifies the positions where both agree. The
+   terminating NUL is found in the same pass, so no strlen is needed; blocks
+   are used while the loads stay within the caller's readable bytes. */
+__attribute__((target("sse2")))
+static bool scanSse2(const SubstringMatcher* matcher, const char* text, size_t readable) {
+    size_t n = matcher->length;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i firstLower = _mm_set1_epi8(matcher->firstLower);
+    const __m128i firstUpper = _mm_set1_epi8(matcher->firstUpper);
+    const __m128i lastLower = _mm_set1_epi8(matcher->lastLower);
+    const __m128i lastUpper = _mm_set1_epi8(matcher->lastUpper);
+    size_t i = 0;
+    
+    for (; i + n - 1 + 16 <= readable; i += 16) {
+        __m128i head = _mm_loadu_si128((const __m128i*)(text + i));
+        __m128i tail = _mm_loadu_si128((const __m128i*)(text + i + n - 1));
+        __m128i headHit = _mm_or_si128(_mm_cmpeq_epi8(head, firstLower), _mm_cmpeq_epi8(head, firstUpper));
+        __m128i tailHit = _mm_or_si128(_mm_cmpeq_epi8(tail, lastLower), _mm_cmpeq_epi8(tail, lastUpper));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(headHit, tailHit));
+        unsigned end = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(head, zero));
+        
+        if (end) {
+            mask &= (1u << __builtin_ctz(end)) - 1;
+        }
+        while (mask) {
+            if (matchesAt(matcher, text + i + __builtin_ctz(mask))) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+        if (end) {
+            return false;
+        }
+    }
+    return scanScalar(matcher, text, i);
+}
+
+ 
+__attribute__((target("avx2")))
+static bool scanAvx2(const SubstringMatcher* matcher, const char* text, size_t readable) {
+    size_t n = matcher->length;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i firstLower = _mm256_set1_epi8(matcher->firstLower);
+    const __m256i firstUpper = _mm256_set1_epi8(matcher->firstUpper);
+    const __m256i lastLower = _mm256_set1_epi8(matcher->lastLower);
+    const __m256i lastUpper = _mm256_set1_epi8(matcher->lastUpper);
+    size_t i = 0;
+    
+    for (; i + n - 1 + 32 <= readable; i += 32) {
+        __m256i head = _mm256_loadu_si256((const __m256i*)(text + i));
+        __m256i tail = _mm256_loadu_si256((const __m256i*)(text + i + n - 1));
+        __m256i headHit = _mm256_or_si256(_mm256_cmpeq_epi8(head, firstLower), _mm256_cmpeq_epi8(head, firstUpper));
+        __m256i tailHit = _mm256_or_si256(_mm256_cmpeq_epi8(tail, lastLower), _mm256_cmpeq_epi8(tail, lastUpper));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(headHit, tailHit));
+        unsigned end = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(head, zero));
+        
+        if (end) {
+            mask &= (1u << __builtin_ctz(end)) - 1;
+        }
+        while (mask) {
+            if (matchesAt(matcher, text + i + __builtin_ctz(mask))) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+        if (end) {
+            return false;
+        }
+    }
+    return scanSse2(matcher, text + i, readable - i);
+}
+#endif
+
+ 
+typedef bool (*SubstringScanFunction)(const SubstringMatcher*, const char*, size_t);
+
+static SubstringScanFunction substringScanner = NULL;
+static pthread_once_t substringScannerOnce = PTHREAD_ONCE_INIT;
+
+ 
+SubstringScanLevel detectSubstringScanLevel() {
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SCAN_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SCAN_SSE2;
+    }
+#endif
+    return SCAN_SCALAR;
+}
+
+ 
+static SubstringScanFunction substringScannerFor(SubstringScanLevel level) {
+#ifdef HAVE_X86_SIMD
+    if (level == SCAN_AVX2) {
+        return scanAvx2;
+    }
+    if (level == SCAN_SSE2) {
+        return scanSse2;
+    }
+#endif
+    (void)level;
+    return scanPortable;
+}
+
+ 
+static void selectSubstringScanner() {
+    substringScanner = substringScannerFor(detectSubstringScanLevel());
+}
+
+ 
+/* Picks the scanner matchSubstring uses, capped at what the CPU supports.
+   Searches pick the best one once, on first use; call this before starting
+   any that should use another. */
+void setSubstringScanLevel(SubstringScanLevel level) {
+    pthread_once(&substringScannerOnce, selectSubstringScanner);
+    if (level > detectSubstringScanLevel()) {
+        level = detectSubstringScanLevel();
+    }
+    substringScanner = substringScannerFor(level);
+}
+
+ 
+/* Returns true if the needle occurs in the NUL-terminated text. The SIMD
+   scanners may load any of the first `readable` bytes of text, which must
+   all be addressable and include the terminator. */
+bool matchSubstring(const SubstringMatcher* matcher, const char* text, size_t readable) {
+    if (matcher->length == 0) {
+        return true;
+    }
+    pthread_once(&substringScannerOnce, selectSubstringScanner);
+    return substringScanner(matcher, text, readable);
+}
+
+ 
+int displayMatchingTasks(const TaskStack* stack, const char* keyword, bool ignoreCase) {
+    int matches = 0;
+    TaskCursor cursor;
+    const Task* task;
+    SubstringMatcher matcher;
+    int64_t started = beginStat(STAT_SEARCH_SCAN);
+    
+    const TaskColumns* columns = stack->columns;
+    
+    prepareSubstringMatcher(&matcher, keyword, ignoreCase);
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        if (columns != NULL) {
+            size_t offset = columns->descriptionOffset[cursor.slot];
+            if (matchSubstring(&matcher, columns->pool + offset, columns->poolUsed + STRING_POOL_PADDING - offset)) {
+                displayTask(task, cursor.index);
+                matches++;
+            }
+        } else if (matchSubstring(&matcher, getTaskDescription(task), descriptionReadable(task))) {
+            displayTask(task, cursor.index);
+            matches++;
+        }
+    }
+    endStat(STAT_SEARCH_SCAN, started, true);
+    return matches;
+}
+
+ 
+void initializeTaskFilter(TaskFilter* filter) {
+    filter->minImportance = INT_MIN;
+    filter->maxImportance = INT_MAX;
+    filter->statusMask = ALL_STATUSES;
+    filter->fromDueKey = INT_MIN;
+    filter->toDueKey = INT_MAX;
+}
+
+ 
+bool taskMatchesFilter(const Task* task, const TaskFilter* filter) {
+    return task->importance >= filter->minImportance && task->importance <= filter->maxImportance &&
+           ((filter->statusMask >> task->status) & 1) &&
+           task->dueKey >= filter->fromDueKey && task->dueKey <= filter->toDueKey;
+}
+
+ 
+static inline uint64_t columnRangeMask(const int32_t* values, int32_t low, int32_t high) {
+    uint64_t mask = 0;
+    for (int j = 0; j < 64; j++) {
+        mask |= (uint64_t)((values[j] >= low) & (values[j] <= high)) << j;
+    }
+    return mask;
+}
+
+ 
+static inline uint64_t columnStatusMask(const uint8_t* values, unsigned statusMask) {
+    uint64_t mask = 0;
+    for (int j = 0; j < 64; j++) {
+        mask |= (uint64_t)((statusMask >> values[j]) & 1) << j;
+    }
+    return mask;
+}
+
+ 
+/* Returns the live slots among the 64 starting at base that pass the filter,
+   as a bitmask. With columns attached only the constrained columns are
+   read; otherwise each live Task is tested in place. */
+static uint64_t matchFilterWord(const TaskStack* stack, const TaskFilter* filter, int base, uint64_t live) {
+    const TaskColumns* columns = stack->columns;
+    uint64_t mask = live;
+    
+    if (columns == NULL) {
+        for (uint64_t bits = live; bits; bits &= bits - 1) {
+            int j = __builtin_ctzll(bits);
+            if (!taskMatchesFilter(taskSlot(stack, base + j), filter)) {
+                mask &= ~((uint64_t)1 << j);
+            }
+        }
+        return mask;
+    }
+    
+    if (mask && (filter->minImportance != INT_MIN || filter->maxImportance != INT_MAX)) {
+        mask &= columnRangeMask(columns->importance + base, filter->minImportance, filter->maxImportance);
+    }
+    if (mask && (filter->statusMask & ALL_STATUSES) != ALL_STATUSES) {
+        mask &= columnStatusMask(columns->status + base, filter->statusMask);
+    }
+    if (mask && (filter->fromDueKey != INT_MIN || filter->toDueKey != INT_MAX)) {
+        mask &= columnRangeMask(columns->dueKey + base, filter->fromDueKey, filter->toDueKey);
+    }
+    return mask;
+}
+
+ 
+int countMatchingTasks(const TaskStack* stack, const TaskFilter* filter) {
+    int matches = 0;
+    for (int c = 0; c < stack->chunkCount; c++) {
+        const TaskChunk* chunk = stack->chunks[c];
+        for (int w = 0; w < TASK_CHUNK_WORDS; w++) {
+            if (chunk->live[w]) {
+                int base = (c << TASK_CHUNK_SHIFT) + w * 64;
+                matches += __builtin_popcountll(matchFilterWord(stack, filter, base, chunk->live[w]));
+            }
+        }
+    }
+    return matches;
+}
+
+ 
+int displayFilteredTasks(const TaskStack* stack, const TaskFilter* filter) {
+    int matches = 0;
+    int index = 0;
+    for (int c = 0; c < stack->chunkCount; c++) {
+        const TaskChunk* chunk = stack->chunks[c];
+        for (int w = 0; w < TASK_CHUNK_WORDS; w++) {
+            uint64_t live = chunk->live[w];
+            if (live == 0) {
+                continue;
+            }
+            int base = (c << TASK_CHUNK_SHIFT) + w * 64;
+            for (uint64_t mask = matchFilterWord(stack, filter, base, live); mask; mask &= mask - 1) {
+                int j = __builtin_ctzll(mask);
+                displayTask(taskSlot(stack, base + j), index + __builtin_popcountll(live & (((uint64_t)1 << j) - 1)));
+                matches++;
+            }
+            index += __builtin_popcountll(live);
+        }
+    }
+    return matches;
+}
+
+ 
+/* A sort key read from the columns when they are attached. */
+static int64_t slotSortValue(const TaskStack* stack, int slot, TaskSortField field) {
+    const TaskColumns* columns = stack->columns;
+    if (columns == NULL) {
+        return taskSortValue(taskSlot(stack, slot), field);
+    }
+    switch (field) {
+        case SORT_BY_IMPORTANCE:
+            return columns->importance[slot];
+        case SORT_BY_DUE_DATE:
+            return columns->dueKey[slot];
+        case SORT_BY_CREATED_AT:
+            return columns->createdAt[slot];
+    }
+    return 0;
+}
+
+ 
+/* Key order, then slot order, so ties go to the task lower in the stack. */
+static int compareSortRecords(const void* a, const void* b) {
+    const TaskSortRecord* x = (const TaskSortRecord*)a;
+    const TaskSortRecord* y = (const TaskSortRecord*)b;
+    for (int k = 0; k < MAX_SORT_KEYS; k++) {
+        if (x->key[k] != y->key[k]) {
+            return x->key[k] < y->key[k] ? -1 : 1;
+        }
+    }
+    return (x->slot > y->slot) - (x->slot < y->slot);
+}
+
+ 
+static void swapSortRecords(TaskSortRecord* a, TaskSortRecord* b) {
+    TaskSortRecord saved = *a;
+    *a = *b;
+    *b = saved;
+}
+
+ 
+/* Moves the k first records in key order to the front, in no particular
+   order: quickselect with a median-of-three pivot, O(n) expected. Records
+   never compare equal, since their slots differ. */
+static void selectSortRecords(TaskSortRecord* records, int count, int k) {
+    int low = 0;
+    int high = count - 1;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (compareSortRecords(&records[mid], &records[low]) < 0) {
+            swapSortRecords(&records[mid], &records[low]);
+        }
+        if (compareSortRecords(&records[high], &records[low]) < 0) {
+            swapSortRecords(&records[high], &records[low]);
+        }
+        if (compareSortRecords(&records[high], &records[mid]) < 0) {
+            swapSortRecords(&records[high], &records[mid]);
+        }
+        
+        TaskSortRecord pivot = records[mid];
+        int i = low;
+        int j = high;
+        while (i <= j) {
+            while (compareSortRecords(&records[i], &pivot) < 0) {
+                i++;
+            }
+            while (compareSortRecords(&records[j], &pivot) > 0) {
+                j--;
+            }
+            if (i <= j) {
+                swapSortRecords(&records[i], &records[j]);
+                i++;
+                j--;
+            }
+        }
+        if (k - 1 <= j) {
+            high = j;
+        } else if (k - 1 >= i) {
+            low = i;
+        } else {
+            break;
+        }
+    }
+}
+
+ 
+/* Writes the stack indices of the first k tasks in key order that pass
+   the filter (NULL for every task) to indices and returns how many there
+   are, or -1 when memory runs out. The matching tasks' keys are gathered
+   in one pass, quickselect moves the first k to the front and only those
+   are sorted: O(n + k log k), and the stack is left as it is. */
+int selectTopTasks(const TaskStack* stack, const TaskSortKey* keys, int keyCount, const TaskFilter* filter, int k,
+                   int* indices) {
+    keyCount = keyCount < 0 ? 0 : keyCount > MAX_SORT_KEYS ? MAX_SORT_KEYS : keyCount;
+    if (k <= 0) {
+        return 0;
+    }
+    TaskSortRecord* records = (TaskSortRecord*)malloc(((size_t)stack->size + 1) * sizeof(TaskSortRecord));
+    int count = 0;
+    if (records == NULL) {
+        return -1;
+    }
+    
+    for (int c = 0; c < stack->chunkCount; c++) {
+        const TaskChunk* chunk = stack->chunks[c];
+        for (int w = 0; w < TASK_CHUNK_WORDS; w++) {
+            uint64_t live = chunk->live[w];
+            if (live == 0) {
+                continue;
+            }
+            int base = (c << TASK_CHUNK_SHIFT) + w * 64;
+            uint64_t mask = filter != NULL ? matchFilterWord(stack, filter, base, live) : live;
+            for (; mask; mask &= mask - 1) {
+                TaskSortRecord* record = &records[count++];
+                record->slot = base + __builtin_ctzll(mask);
+                for (int key = 0; key < MAX_SORT_KEYS; key++) {
+                    int64_t value = key < keyCount ? slotSortValue(stack, record->slot, keys[key].field) : 0;
+                    record->key[key] = key < keyCount && keys[key].descending ? ~value : value;
+                }
+            }
+        }
+    }
+    
+    k = k < count ? k : count;
+    selectSortRecords(records, count, k);
+    qsort(records, k, sizeof(TaskSortRecord), compareSortRecords);
+    for (int i = 0; i < k; i++) {
+        indices[i] = indexForSlot(stack, records[i].slot);
+    }
+    free(records);
+    return k;
+}
+
+ 
+/* Prints the tasks selectTopTasks picks; returns their count or -1. */
+int displayTopTasks(const TaskStack* stack, const TaskSortKey* keys, int keyCount, const TaskFilter* filter, int k) {
+    int* indices = (int*)malloc(((size_t)(k > 0 ? k : 0) + 1) * sizeof(int));
+    int count = indices != NULL ? selectTopTasks(stack, keys, keyCount, filter, k, indices) : -1;
+    for (int i = 0; i < count; i++) {
+        displayTask(taskSlot(stack, slotForIndex(stack, indices[i])), indices[i]);
+    }
+    free(indices);
+    return count;
+}
+
+ 
+/* Lists the tasks due in [fromKey, toKey] whose status is in statusMask.
+   With a DueIndex attached this walks only the matching range, in due-date
+   order; otherwise it is a filtered scan in stack order. */
+static int displayTasksDueInRange(const TaskStack* stack, int fromKey, int toKey, unsigned statusMask) {
+    if (stack->dueIndex == NULL) {
+        TaskFilter filter;
+        initializeTaskFilter(&filter);
+        filter.fromDueKey = fromKey;
+        filter.toDueKey = toKey;
+        filter.statusMask = statusMask;
+        return displayFilteredTasks(stack, &filter);
+    }
+    
+    DueCursor cursor;
+    uint32_t id;
+    int matches = 0;
+    openDueCursor(&cursor, stack->dueIndex, fromKey, toKey);
+    while (nextDueEntry(&cursor, &id)) {
+        int slot = stack->idSlots[id];
+        const Task* task = taskSlot(stack, slot);
+        if (statusMask & (1u << task->status)) {
+            displayTask(task, indexForSlot(stack, slot));
+            matches++;
+        }
+    }
+    return matches;
+}
+
+ 
+int displayTasksDueBetween(const TaskStack* stack, int fromKey, int toKey) {
+    return displayTasksDueInRange(stack, fromKey, toKey, ALL_STATUSES);
+}
+
+ 
+int countTasksDueBetween(const TaskStack* stack, int fromKey, int toKey) {
+    if (stack->dueIndex == NULL) {
+        TaskFilter filter;
+        initializeTaskFilter(&filter);
+        filter.fromDueKey = fromKey;
+        filter.toDueKey = toKey;
+        return countMatchingTasks(stack, &filter);
+    }
+    
+    DueCursor cursor;
+    uint32_t id;
+    int matches = 0;
+    openDueCursor(&cursor, stack->dueIndex, fromKey, toKey);
+    while (nextDueEntry(&cursor, &id)) {
+        matches++;
+    }
+    return matches;
+}
+
+ 
+/* Unfinished tasks due before todayKey. */
+int displayOverdueTasks(const TaskStack* stack, int todayKey) {
+    return displayTasksDueInRange(stack, INT_MIN, todayKey - 1, ALL_STATUSES & ~(1u << COMPLETED));
+}
+
+ 
+/* The due-date key of the local calendar day `days` after `now`. */
+int dueKeyForDay(time_t now, int days) {
+    struct tm local;
+    localtime_r(&now, &local);
+    local.tm_mday += days;
+    local.tm_isdst = -1;
+    mktime(&local);
+    return DUE_KEY(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+ 
+/* Prints the number of tasks due in each month, earliest first, and returns
+   the number of months listed. Without a DueIndex the counts come from one
+   pass over the stack. */
+int displayDueCalendar(const TaskStack* stack) {
+    const DueIndex* index = stack->dueIndex;
+    DueIndex scratch;
+    
+    if (index == NULL) {
+        TaskCursor cursor;
+        const Task* task;
+        initializeDueIndex(&scratch);
+        openTaskCursor(&cursor, stack);
+        while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+            countDueMonth(&scratch, task->dueKey, 1);
+        }
+        index = &scratch;
+    }
+    
+    int months = index->monthCount;
+    for (int i = 0; i < months; i++) {
+        int year = index->months[i].monthKey / 100;
+        int month = index->months[i].monthKey % 100;
+        if (month >= 1 && month <= 12) {
+            printf("| %-9s %4d | %8d task(s) |\n", monthNames[month - 1], year, index->months[i].count);
+        } else {
+            printf("| %-14s | %8d task(s) |\n", "No due date", index->months[i].count);
+        }
+    }
+    if (index == &scratch) {
+        freeDueIndex(&scratch);
+    }
+    return months;
+}
+
+ 
+ 
+static int compareTokens(const void* a, const void* b) {
+    return strcmp((*(IndexEntry* const*)a)->token, (*(IndexEntry* const*)b)->token);
+}
+
+ 
+static void sortIndexTokens(KeywordIndex* index) {
+    if (!index->sortedDirty && index->sortedEntries != NULL) {
+        return;
+    }
+    
+    free(index->sortedEntries);
+    index->sortedEntries = (IndexEntry**)malloc((index->used + 1) * sizeof(IndexEntry*));
+    index->sortedCount = 0;
+    if (index->sortedEntries == NULL) {
+        return;
+    }
+    for (int i = 0; i < index->capacity; i++) {
+        if (index->entries[i].token != NULL) {
+            index->sortedEntries[index->sortedCount++] = &index->entries[i];
+        }
+    }
+    qsort(index->sortedEntries, index->sortedCount, sizeof(IndexEntry*), compareTokens);
+    index->sortedDirty = false;
+}
+
+ 
+static int compareIds(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+ 
+/* Intersects two sorted id lists, galloping through the longer one with
+   binary searches when the sizes are very different. */
+static int intersectIds(const uint32_t* a, int aCount, const uint32_t* b, int bCount, uint32_t* out) {
+    int count = 0;
+    if (aCount > bCount) {
+        const uint32_t* swapIds = a;
+        int swapCount = aCount;
+        a = b;
+        aCount = bCount;
+        b = swapIds;
+        bCount = swapCount;
+    }
+    
+    if ((int64_t)aCount * 16 < bCount) {
+        int low = 0;
+        for (int i = 0; i < aCount; i++) {
+            int high = bCount;
+            while (low < high) {
+                int mid = (low + high) / 2;
+                if (b[mid] < a[i]) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            if (low < bCount && b[low] == a[i]) {
+                out[count++] = a[i];
+            }
+        }
+        return count;
+    }
+    
+    int i = 0, j = 0;
+    while (i < aCount && j < bCount) {
+        if (a[i] < b[j]) {
+            i++;
+        } else if (a[i] > b[j]) {
+            j++;
+        } else {
+            out[count++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    return count;
+}
+
+ 
+static int unionIds(const uint32_t* a, int aCount, const uint32_t* b, int bCount, uint32_t* out) {
+    int i = 0, j = 0, count = 0;
+    while (i < aCount && j < bCount) {
+        if (a[i] < b[j]) {
+            out[count++] = a[i++];
+        } else if (a[i] > b[j]) {
+            out[count++] = b[j++];
+        } else {
+            out[count++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    while (i < aCount) {
+        out[count++] = a[i++];
+    }
+    while (j < bCount) {
+        out[count++] = b[j++];
+    }
+    return count;
+}
+
+ 
+/* Returns the ids for one query token. Exact tokens point straight at the
+   posting list; prefixes are merged into a new list the caller frees. */
+static const uint32_t* termIds(KeywordIndex* index, const char* token, bool prefix, int* count, uint32_t** owned) {
+    *owned = NULL;
+    *count = 0;
+    
+    if (!prefix) {
+        IndexEntry* entry = findIndexEntry(index, token, false);
+        if (entry == NULL) {
+            return NULL;
+        }
+        *count = entry->postings.count;
+        return entry->postings.ids;
+    }
+    
+    sortIndexTokens(index);
+    size_t length = strlen(token);
+    int low = 0, high = index->sortedCount;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (strcmp(index->sortedEntries[mid]->token, token) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    int total = 0;
+    for (int i = low; i < index->sortedCount && strncmp(index->sortedEntries[i]->token, token, length) == 0; i++) {
+        total += index->sortedEntries[i]->postings.count;
+    }
+    if (total == 0 || (*owned = (uint32_t*)malloc(total * sizeof(uint32_t))) == NULL) {
+        return NULL;
+    }
+    
+    int filled = 0;
+    for (int i = low; filled < total; i++) {
+        const PostingList* list = &index->sortedEntries[i]->postings;
+        memcpy(*owned + filled, list->ids, list->count * sizeof(uint32_t));
+        filled += list->count;
+    }
+    qsort(*owned, total, sizeof(uint32_t), compareIds);
+    
+    int unique = 0;
+    for (int i = 0; i < total; i++) {
+        if (unique == 0 || (*owned)[unique - 1] != (*owned)[i]) {
+            (*owned)[unique++] = (*owned)[i];
+        }
+    }
+    *count = unique;
+    return *owned;
+}
+
+ 
+static void mergeQueryGroup(uint32_t** result, int* resultCount, uint32_t** group, int* groupCount) {
+    if (*group == NULL) {
+        return;
+    }
+    uint32_t* merged = (uint32_t*)malloc((*resultCount + *groupCount + 1) * sizeof(uint32_t));
+    if (merged != NULL) {
+        *resultCount = unionIds(*result, *resultCount, *group, *groupCount, merged);
+        free(*result);
+        *result = merged;
+    }
+    free(*group);
+    *group = NULL;
+    *groupCount = 0;
+}
+
+ 
+/* Evaluates a keyword query: words are ANDed, "OR" or '|' separates
+   alternatives and a trailing '*' matches every token with that prefix.
+   Stores the sorted matching task ids in *results (to be freed by the
+   caller) and returns how many there are. */
+int queryKeywordIndex(KeywordIndex* index, const char* query, uint32_t** results) {
+    uint32_t* result = NULL;
+    int resultCount = 0;
+    uint32_t* group = NULL;
+    int groupCount = 0;
+    const char* p = query;
+    int64_t started = beginStat(STAT_SEARCH_INDEX);
+    
+    while (*p) {
+        if (isspace((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+        if (*p == '|') {
+            mergeQueryGroup(&result, &resultCount, &group, &groupCount);
+            p++;
+            continue;
+        }
+        
+        size_t length = strcspn(p, " \t\n|");
+        if (length == 2 && strncmp(p, "OR", 2) == 0) {
+            mergeQueryGroup(&result, &resultCount, &group, &groupCount);
+            p += length;
+            continue;
+        }
+        
+        char word[MAX_DESCRIPTION];
+        snprintf(word, sizeof(word), "%.*s", (int)length, p);
+        bool prefix = length > 0 && p[length - 1] == '*';
+        p += length;
+        
+        const char* text = word;
+        char token[MAX_TOKEN_LENGTH];
+        while (nextToken(&text, token) > 0) {
+            const char* rest = text;
+            char next[MAX_TOKEN_LENGTH];
+            bool lastToken = nextToken(&rest, next) == 0;
+            
+            int count;
+            uint32_t* owned;
+            const uint32_t* ids = termIds(index, token, prefix && lastToken, &count, &owned);
+            
+            if (group == NULL) {
+                group = (uint32_t*)malloc((count + 1) * sizeof(uint32_t));
+                if (group != NULL && count > 0) {
+                    memcpy(group, ids, count * sizeof(uint32_t));
+                }
+                groupCount = group != NULL ? count : 0;
+            } else {
+                groupCount = intersectIds(group, groupCount, ids, count, group);
+            }
+            free(owned);
+        }
+    }
+    mergeQueryGroup(&result, &resultCount, &group, &groupCount);
+    
+    *results = result;
+    endStat(STAT_SEARCH_INDEX, started, true);
+    return resultCount;
+}
+
+ 
+static int compareInts(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+ 
+/* Slots of the tasks matching a keyword query, in stack order. Returns
+   their count, or -1 when out of memory. */
+static int collectIndexedSlots(const TaskStack* stack, const char* query, int** slots) {
+    uint32_t* ids;
+    int count = queryKeywordIndex(stack->keywordIndex, query, &ids);
+    *slots = (int*)malloc((count + 1) * sizeof(int));
+    if (*slots == NULL) {
+        free(ids);
+        return -1;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        (*slots)[i] = stack->idSlots[ids[i]];
+    }
+    qsort(*slots, count, sizeof(int), compareInts);
+    free(ids);
+    return count;
+}
+
+ 
+int displayIndexedMatches(const TaskStack* stack, const char* query) {
+    int* slots;
+    int count = collectIndexedSlots(stack, query, &slots);
+    if (count < 0) {
+        return 0;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        displayTask(taskSlot(stack, slots[i]), indexForSlot(stack, slots[i]));
+    }
+    free(slots);
+    return count;
+}
+
+ 
+void searchTasks(const TaskStack* stack, const char* query, SearchMode mode) {
+    drawUIHeader();
+    printf("| Search Results for '%s':                                                |\n", query);
+    drawLine(80);
+    
+    printf("| %2s | %-30s | %-17s | %10s | %-11s |\n", 
+           "ID", "Description", "Due Date", "Importance", "Status");
+    drawLine(80);
+    
+    bool found;
+    if (mode == SEARCH_KEYWORDS && stack->keywordIndex != NULL) {
+        found = displayIndexedMatches(stack, query) > 0;
+    } else {
+        found = displayMatchingTasks(stack, query, mode == SEARCH_SUBSTRING_IGNORE_CASE) > 0;
+    }
+    
+    if (!found) {
+        printf("| No tasks matching '%s' found.                                            |\n", query);
+    }
+    
+    drawUIFooter();
+}
+
+ 
+/* Home the cursor, clear the screen and scrollback, then the banner. */
+static const char uiHeader[] =
+    "\033[H\033[2J\033[3J"
+    "+------------------------------------------------------------------------------+\n"
+    "|                       TASK MANAGEMENT SYSTEM (STACK-BASED)                    |\n"
+    "+------------------------------------------------------------------------------+\n";
+
+static const char uiDashes[] =
+    "--------------------------------------------------------------------------------"
+    "--------------------------------------------------------------------------------";
+
+void drawUIHeader() {
+    fputs(uiHeader, stdout);
+}
+
+void drawUIFooter() {
+    drawLine(80);
+    printf("| Press Enter to continue...                                                    |\n");
+    drawLine(80);
+    clearInputBuffer();
+}
+
+void drawLine(int width) {
+    int dashes = width - 2 < (int)sizeof(uiDashes) - 1 ? width - 2 : (int)sizeof(uiDashes) - 1;
+    printf("+%.*s+\n", dashes < 0 ? 0 : dashes, uiDashes);
+}
+
+ 
+void initializeTerminalFrame(TerminalFrame* frame, int fd) {
+    frame->fd = fd;
+    frame->data = NULL;
+    frame->length = 0;
+    frame->capacity = 0;
+    frame->failed = false;
+}
+
+ 
+void freeTerminalFrame(TerminalFrame* frame) {
+    free(frame->data);
+    initializeTerminalFrame(frame, frame->fd);
+}
+
+ 
+/* Makes room for `extra` more bytes plus a terminator, doubling as it goes. */
+static bool reserveFrameBytes(TerminalFrame* frame, size_t extra) {
+    if (frame->failed) {
+        return false;
+    }
+    if (frame->length + extra < frame->capacity) {
+        return true;
+    }
+    
+    size_t capacity = frame->capacity ? frame->capacity : 4096;
+    while (frame->length + extra >= capacity) {
+        capacity *= 2;
+    }
+    char* data = (char*)realloc(frame->data, capacity);
+    if (data == NULL) {
+        frame->failed = true;
+        return false;
+    }
+    frame->data = data;
+    frame->capacity = capacity;
+    return true;
+}
+
+ 
+bool appendFrameText(TerminalFrame* frame, const char* text, size_t length) {
+    if (!reserveFrameBytes(frame, length)) {
+        return false;
+    }
+    memcpy(frame->data + frame->length, text, length);
+    frame->length += length;
+    return true;
+}
+
+ 
+bool appendFrameFormat(TerminalFrame* frame, const char* format, ...) {
+    va_list arguments;
+    if (!reserveFrameBytes(frame, 256)) {
+        return false;
+    }
+    
+    va_start(arguments, format);
+    int length = vsnprintf(frame->data + frame->length, frame->capacity - frame->length, format, arguments);
+    va_end(arguments);
+    if (length < 0) {
+        return false;
+    }
+    if ((size_t)length >= frame->capacity - frame->length) {
+        if (!reserveFrameBytes(frame, (size_t)length)) {
+            return false;
+        }
+        va_start(arguments, format);
+        vsnprintf(frame->data + frame->length, (size_t)length + 1, format, arguments);
+        va_end(arguments);
+    }
+    frame->length += (size_t)length;
+    return true;
+}
+
+ 
+void appendFrameHeader(TerminalFrame* frame) {
+    appendFrameText(frame, uiHeader, sizeof(uiHeader) - 1);
+}
+
+ 
+void appendFrameLine(TerminalFrame* frame, int width) {
+    int dashes = width - 2 < (int)sizeof(uiDashes) - 1 ? width - 2 : (int)sizeof(uiDashes) - 1;
+    dashes = dashes < 0 ? 0 : dashes;
+    if (reserveFrameBytes(frame, (size_t)dashes + 3)) {
+        char* out = frame->data + frame->length;
+        out[0] = '+';
+        memcpy(out + 1, uiDashes, dashes);
+        out[dashes + 1] = '+';
+        out[dashes + 2] = '\n';
+        frame->length += (size_t)dashes + 3;
+    }
+}
+
+ 
+/* Left-justifies text in a field of at least `width` bytes. */
+static char* putFrameText(char* out, const char* text, size_t length, size_t width) {
+    memcpy(out, text, length);
+    if (length < width) {
+        memset(out + length, ' ', width - length);
+        length = width;
+    }
+    return out + length;
+}
+
+ 
+/* Right-justifies a decimal in a field of at least `width` bytes. */
+static char* putFrameNumber(char* out, int value, int width) {
+    char digits[12];
+    unsigned magnitude = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+    int length = 0;
+    do {
+        digits[sizeof(digits) - ++length] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+        digits[sizeof(digits) - ++length] = '-';
+    }
+    for (; width > length; width--) {
+        *out++ = ' ';
+    }
+    memcpy(out, digits + sizeof(digits) - length, length);
+    return out + length;
+}
+
+ 
+/* Lays out a TASK_ROW_FORMAT row without vsnprintf, whose setup costs
+   more than the row itself when a listing formats thousands of them. */
+void appendFrameTask(TerminalFrame* frame, const Task* task, int index) {
+    const char* status = statusNames[task->status];
+    if (!reserveFrameBytes(frame, task->descriptionLength + sizeof(task->dueLabel) + 80)) {
+        return;
+    }
+    
+    char* out = frame->data + frame->length;
+    out = putFrameText(out, "| ", 2, 2);
+    out = putFrameNumber(out, index + 1, 2);
+    out = putFrameText(out, " | ", 3, 3);
+    out = putFrameText(out, getTaskDescription(task), task->descriptionLength, 30);
+    out = putFrameText(out, " | ", 3, 3);
+    out = putFrameText(out, task->dueLabel, strlen(task->dueLabel), 17);
+    out = putFrameText(out, " | ", 3, 3);
+    out = putFrameNumber(out, task->importance, 10);
+    out = putFrameText(out, " | ", 3, 3);
+    out = putFrameText(out, status, strlen(status), 11);
+    out = putFrameText(out, " |\n", 3, 3);
+    frame->length = out - frame->data;
+}
+
+ 
+/* Writes the frame with one write and empties it for the next one. When
+   the frame goes to standard output, whatever stdio still holds goes first
+   so the two never interleave. */
+bool flushTerminalFrame(TerminalFrame* frame) {
+    bool written = !frame->failed;
+    if (frame->fd == STDOUT_FILENO) {
+        fflush(stdout);
+    }
+    if (frame->length > 0) {
+        written = writeAll(frame->fd, (const unsigned char*)frame->data, frame->length) && written;
+    }
+    frame->length = 0;
+    frame->failed = false;
+    return written;
+}
+
+ 
+static void appendFrameTableTop(TerminalFrame* frame) {
+    appendFrameLine(frame, 80);
+    appendFrameFormat(frame, "| %2s | %-30s | %-17s | %10s | %-11s |\n", 
+                      "ID", "Description", "Due Date", "Importance", "Status");
+    appendFrameLine(frame, 80);
+}
+
+ 
+static void appendFrameTableBottom(TerminalFrame* frame, int first, int shown, int size) {
+    char range[80];
+    appendFrameLine(frame, 80);
+    snprintf(range, sizeof(range), "Tasks %d-%d of %d", first + 1, first + shown, size);
+    appendFrameFormat(frame, "| %-76s |\n", range);
+}
+
+ 
+/* Appends the table of at most `rows` tasks starting at stack index `first`
+   and which of the stack's tasks they are. Only those rows are formatted,
+   and finding the first is O(log n), so a page of a huge stack costs the
+   same as a page of a small one. Returns the number of rows shown. */
+int renderTaskPage(TerminalFrame* frame, const TaskStack* stack, int first, int rows) {
+    int size = getStackSize(stack);
+    TaskCursor cursor;
+    const Task* task;
+    int shown = 0;
+    
+    if (size == 0) {
+        appendFrameText(frame, "| No tasks available.                                                         |\n", 80);
+        return 0;
+    }
+    first = first > size - 1 ? size - 1 : first;
+    first = first < 0 ? 0 : first;
+    
+    appendFrameTableTop(frame);
+    openTaskCursor(&cursor, stack);
+    seekTaskCursor(&cursor, first);
+    while (shown < rows && (task = nextTaskFromCursor(&cursor)) != NULL) {
+        appendFrameTask(frame, task, cursor.index);
+        shown++;
+    }
+    appendFrameTableBottom(frame, first, shown, size);
+    return shown;
+}
+
+ 
+/* renderTaskPage in the view's order, from rank `first`; the ID column
+   still shows each task's place in the stack. The view is refreshed
+   first. Returns the number of rows shown, or -1. */
+int renderSortedPage(TerminalFrame* frame, const TaskStack* stack, SortedView* view, int first, int rows) {
+    int shown = 0;
+    if (!refreshSortedView(stack, view)) {
+        return -1;
+    }
+    if (view->count == 0) {
+        appendFrameText(frame, "| No tasks available.                                                         |\n", 80);
+        return 0;
+    }
+    first = first > view->count - 1 ? view->count - 1 : first;
+    first = first < 0 ? 0 : first;
+    
+    appendFrameTableTop(frame);
+    for (; shown < rows && first + shown < view->count; shown++) {
+        int index;
+        const Task* task = getSortedTask(stack, view, first + shown, &index);
+        appendFrameTask(frame, task, index);
+    }
+    appendFrameTableBottom(frame, first, shown, view->count);
+    return shown;
+}
+
+ 
+/* Task rows that fit under the banner, the table borders and the prompt;
+   TASK_PAGE_ROWS when standard output is not a terminal. */
+int visibleTaskRows() {
+    struct winsize window;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &window) != 0 || window.ws_row == 0) {
+        return TASK_PAGE_ROWS;
+    }
+    int rows = (int)window.ws_row - 11;
+    return rows < 5 ? 5 : rows;
+}
+
+ 
+int displayTaskPage(const TaskStack* stack, int first, int rows) {
+    TerminalFrame frame;
+    initializeTerminalFrame(&frame, STDOUT_FILENO);
+    int shown = renderTaskPage(&frame, stack, first, rows);
+    flushTerminalFrame(&frame);
+    freeTerminalFrame(&frame);
+    return shown;
+}
+
+ 
+/* Pages through the stack, or through a sorted view of it, a screenful at
+   a time; each screen is one frame and one write. Enter shows the next
+   page and leaves after the last one, 'p' goes back a page, a task ID
+   jumps to the page holding it and 'q' leaves at once. */
+static void browseTaskPages(const TaskStack* stack, SortedView* view, const char* title) {
+    TerminalFrame frame;
+    char input[32];
+    int rows = visibleTaskRows();
+    int first = 0;
+    
+    initializeTerminalFrame(&frame, STDOUT_FILENO);
+    while (true) {
+        int size = getStackSize(stack);
+        appendFrameHeader(&frame);
+        appendFrameFormat(&frame, "| %-76.76s |\n", title);
+        if (view == NULL) {
+            renderTaskPage(&frame, stack, first, rows);
+        } else if (renderSortedPage(&frame, stack, view, first, rows) < 0) {
+            appendFrameFormat(&frame, "| Not enough memory to sort the tasks.\n");
+        }
+        appendFrameLine(&frame, 80);
+        appendFrameFormat(&frame, "| %s", first + rows < size ? "Enter: next page, p: previous, ID: go to task, q: back: "
+                                                              : "Enter: back, p: previous, ID: go to task: ");
+        flushTerminalFrame(&frame);
+    
+        if (fgets(input, sizeof(input), stdin) == NULL) {
+            break;
+        }
+        if (strchr(input, '\n') == NULL) {
+            clearInputBuffer();
+        }
+        int id = atoi(input);
+        if (input[0] == 'q') {
+            break;
+        } else if (id > 0 && size > 0) {
+            id = id > size ? size : id;
+            first = (view != NULL ? findSortedRank(stack, view, id - 1) : id - 1) / rows * rows;
+        } else if (input[0] == 'p') {
+            first = first >= rows ? first - rows : 0;
+        } else if (first + rows < size) {
+            first += rows;
+        } else {
+            break;
+        }
+    }
+    freeTerminalFrame(&frame);
+}
+
+ 
+void browseTasks(const TaskStack* stack, const char* title) {
+    browseTaskPages(stack, NULL, title);
+}
+
+ 
+void browseSortedView(const TaskStack* stack, SortedView* view, const char* title) {
+    browseTaskPages(stack, view, title);
+}
+ 
+/* Splits the next space-separated word off a batch command line. */
+static char* nextCommandWord(char** cursor) {
+    char* word = *cursor + strspn(*cursor, " \t");
+    size_t length = strcspn(word, " \t");
+    if (length == 0) {
+        *cursor = word;
+        return NULL;
+    }
+    *cursor = word + length + (word[length] != '\0');
+    word[length] = '\0';
+    return word;
+}
+
+ 
+static char* restOfCommand(char** cursor) {
+    char* rest = *cursor + strspn(*cursor, " \t");
+    size_t length = strlen(rest);
+    *cursor = rest + length;
+    while (length > 0 && (rest[length - 1] == ' ' || rest[length - 1] == '\t')) {
+        rest[--length] = '\0';
+    }
+    return length > 0 ? rest : NULL;
+}
+
+ 
+static bool parseCommandInt(const char* word, int low, int high, int* value) {
+    char* end;
+    if (word == NULL) {
+        return false;
+    }
+    long parsed = strtol(word, &end, 10);
+    if (end == word || *end != '\0' || parsed < low || parsed > high) {
+        return false;
+    }
+    *value = (int)parsed;
+    return true;
+}
+
+ 
+/* Dates are written YYYY-MM-DD in batch commands. */
+static bool parseCommandDate(const char* word, int* key) {
+    int year, month, day;
+    char extra;
+    if (word == NULL || sscanf(word, "%d-%d-%d%c", &year, &month, &day, &extra) != 3 ||
+        !isValidDate(year, month, day)) {
+        return false;
+    }
+    *key = DUE_KEY(year, month, day);
+    return true;
+}
+
+ 
+static bool parseCommandStatus(const char* word, TaskStatus* status) {
+    return word != NULL && parseStatusToken(word, strlen(word), status);
+}
+
+ 
+static bool parseCommandDescription(char** cursor, Task* task) {
+    char* description = restOfCommand(cursor);
+    return description != NULL && setTaskDescription(task, description);
+}
+
+ 
+/* DATE IMPORTANCE STATUS DESCRIPTION... */
+static bool parseCommandTask(char** cursor, Task* task) {
+    int key;
+    memset(task, 0, sizeof(*task));
+    if (!parseCommandDate(nextCommandWord(cursor), &key) ||
+        !parseCommandInt(nextCommandWord(cursor), 1, 10, &task->importance) ||
+        !parseCommandStatus(nextCommandWord(cursor), &task->status) ||
+        !parseCommandDescription(cursor, task)) {
+        return false;
+    }
+    setTaskDueDate(task, DUE_YEAR(key), DUE_MONTH(key), DUE_DAY(key));
+    task->createdAt = time(NULL);
+    return true;
+}
+
+ 
+/* FIELD VALUE pairs; "desc" takes the rest of the line, so it comes last. */
+static bool parseCommandEdit(char** cursor, Task* task) {
+    char* field;
+    int key;
+    bool changed = false;
+    
+    while ((field = nextCommandWord(cursor)) != NULL) {
+        bool ok = false;
+        if (strcmp(field, "due") == 0) {
+            ok = parseCommandDate(nextCommandWord(cursor), &key) &&
+                 setTaskDueDate(task, DUE_YEAR(key), DUE_MONTH(key), DUE_DAY(key));
+        } else if (strcmp(field, "importance") == 0) {
+            ok = parseCommandInt(nextCommandWord(cursor), 1, 10, &task->importance);
+        } else if (strcmp(field, "status") == 0) {
+            ok = parseCommandStatus(nextCommandWord(cursor), &task->status);
+        } else if (strcmp(field, "desc") == 0) {
+            ok = parseCommandDescription(cursor, task);
+        }
+        if (!ok) {
+            return false;
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+ 
+static void printBatchHelp() {
+    printf("add DATE IMPORTANCE STATUS DESCRIPTION    push a task (DATE is YYYY-MM-DD,\n"
+           "                                          STATUS pending|in-progress|completed or 0-2)\n"
+           "insert ID DATE IMPORTANCE STATUS DESCRIPTION\n"
+           "pop | peek | list | count | undo | redo | save\n"
+           "next | pop-next                           most important unfinished task\n"
+           "edit ID [due DATE] [importance N] [status S] [desc TEXT]\n"
+           "remove ID\n"
+           "search QUERY                              keyword search (AND, OR, word*)\n"
+           "grep [-i] TEXT                            substring search\n"
+           "sort KEYS                                 e.g. sort -importance date\n"
+           "sorted KEYS                               list in key order, leaving the stack as it is\n"
+           "top N [STATUS] [KEYS]                     first N in key order (default -importance date)\n"
+           "due-before DATE | due FROM TO             tasks by due date, earliest first\n"
+           "due-week | overdue | calendar             next 7 days, unfinished and late, tasks per month\n"
+           "filter MIN_IMPORTANCE [STATUS]\n"
+           "import PATH | export PATH                 CSV, or JSON Lines for .jsonl/.ndjson/.json\n"
+           "stats                                     calls and latency percentiles per operation\n");
+}
+
+ 
+/* Runs one batch command, editing `line` in place. Mutations print nothing;
+   queries print one table row per task, numbered by task ID as in the menu.
+   Returns false if the command is unknown, malformed or fails. */
+bool runBatchCommand(TaskStack* stack, char* line) {
+    char* cursor = line;
+    char* command = nextCommandWord(&cursor);
+    Task task;
+    int id, key;
+    
+    if (command == NULL || command[0] == '#') {
+        return true;
+    }
+    if (strcmp(command, "add") == 0) {
+        return parseCommandTask(&cursor, &task) && pushTask(stack, task);
+    }
+    if (strcmp(command, "insert") == 0) {
+        return parseCommandInt(nextCommandWord(&cursor), 1, INT_MAX, &id) &&
+               parseCommandTask(&cursor, &task) && insertTaskAtIndex(stack, id - 1, task);
+    }
+    if (strcmp(command, "pop") == 0) {
+        if (!popTask(stack, &task)) {
+            return false;
+        }
+        displayTask(&task, getStackSize(stack));
+        return true;
+    }
+    if (strcmp(command, "peek") == 0) {
+        if (!peekTask(stack, &task)) {
+            return false;
+        }
+        displayTask(&task, getStackSize(stack) - 1);
+        return true;
+    }
+    if (strcmp(command, "next") == 0 || strcmp(command, "pop-next") == 0) {
+        int index;
+        if (!peekPriorityTask(stack, &task, &index) ||
+            (command[3] == '-' && !removeTaskAtIndex(stack, index))) {
+            return false;
+        }
+        displayTask(&task, index);
+        return true;
+    }
+    if (strcmp(command, "edit") == 0) {
+        const Task* current;
+        if (!parseCommandInt(nextCommandWord(&cursor), 1, INT_MAX, &id) ||
+            (current = getTaskAtIndex(stack, id - 1)) == NULL) {
+            return false;
+        }
+        task = *current;
+        return parseCommandEdit(&cursor, &task) && editTaskAtIndex(stack, id - 1, task);
+    }
+    if (strcmp(command, "remove") == 0) {
+        return parseCommandInt(nextCommandWord(&cursor), 1, INT_MAX, &id) && removeTaskAtIndex(stack, id - 1);
+    }
+    if (strcmp(command, "list") == 0) {
+        TaskCursor tasks;
+        const Task* listed;
+        openTaskCursor(&tasks, stack);
+        while ((listed = nextTaskFromCursor(&tasks)) != NULL) {
+            displayTask(listed, tasks.index);
+        }
+        return true;
+    }
+    if (strcmp(command, "count") == 0) {
+        printf("%d\n", getStackSize(stack));
+        return true;
+    }
+    if (strcmp(command, "search") == 0) {
+        char* query = restOfCommand(&cursor);
+        if (query == NULL) {
+            return false;
+        }
+        if (stack->keywordIndex != NULL) {
+            displayIndexedMatches(stack, query);
+        } else {
+            displayMatchingTasks(stack, query, true);
+        }
+        return true;
+    }
+    if (strcmp(command, "grep") == 0) {
+        char* text = restOfCommand(&cursor);
+        bool ignoreCase = text != NULL && strncmp(text, "-i ", 3) == 0;
+        if (ignoreCase) {
+            text += 3 + strspn(text + 3, " \t");
+        }
+        if (text == NULL || *text == '\0') {
+            return false;
+        }
+        displayMatchingTasks(stack, text, ignoreCase);
+        return true;
+    }
+    if (strcmp(command, "sort") == 0) {
+        TaskSortKey keys[MAX_SORT_KEYS];
+        char* spec = restOfCommand(&cursor);
+        int keyCount = spec != NULL ? parseSortKeys(spec, keys) : -1;
+        return keyCount >= 0 && sortStack(stack, keys, keyCount);
+    }
+    if (strcmp(command, "sorted") == 0) {
+        TaskSortKey keys[MAX_SORT_KEYS];
+        SortedView view;
+        char* spec = restOfCommand(&cursor);
+        int keyCount = spec != NULL ? parseSortKeys(spec, keys) : -1;
+        if (keyCount < 0) {
+            return false;
+        }
+        initializeSortedView(&view, keys, keyCount);
+        int listed = displaySortedView(stack, &view);
+        freeSortedView(&view);
+        return listed >= 0;
+    }
+    if (strcmp(command, "top") == 0) {
+        TaskSortKey keys[MAX_SORT_KEYS] = { { SORT_BY_IMPORTANCE, true }, { SORT_BY_DUE_DATE, false } };
+        int keyCount = 2;
+        TaskFilter filter;
+        TaskStatus status;
+        int count;
+        initializeTaskFilter(&filter);
+        if (!parseCommandInt(nextCommandWord(&cursor), 1, INT_MAX, &count)) {
+            return false;
+        }
+        char* spec = restOfCommand(&cursor);
+        size_t length = spec != NULL ? strcspn(spec, " \t") : 0;
+        if (length > 0 && parseStatusToken(spec, length, &status)) {
+            filter.statusMask = 1u << status;
+            spec += length + strspn(spec + length, " \t");
+        }
+        if (spec != NULL && *spec != '\0' && (keyCount = parseSortKeys(spec, keys)) < 0) {
+            return false;
+        }
+        return displayTopTasks(stack, keys, keyCount, &filter, count) >= 0;
+    }
+    if (strcmp(command, "due-before") == 0) {
+        if (!parseCommandDate(nextCommandWord(&cursor), &key)) {
+            return false;
+        }
+        displayTasksDueBetween(stack, 0, key - 1);
+        return true;
+    }
+    if (strcmp(command, "due") == 0) {
+        int toKey;
+        if (!parseCommandDate(nextCommandWord(&cursor), &key) || !parseCommandDate(nextCommandWord(&cursor), &toKey)) {
+            return false;
+        }
+        displayTasksDueBetween(stack, key, toKey);
+        return true;
+    }
+    if (strcmp(command, "due-week") == 0) {
+        time_t now = time(NULL);
+        displayTasksDueBetween(stack, dueKeyForDay(now, 0), dueKeyForDay(now, 6));
+        return true;
+    }
+    if (strcmp(command, "overdue") == 0) {
+        displayOverdueTasks(stack, dueKeyForDay(time(NULL), 0));
+        return true;
+    }
+    if (strcmp(command, "calendar") == 0) {
+        displayDueCalendar(stack);
+        return true;
+    }
+    if (strcmp(command, "filter") == 0) {
+        TaskFilter filter;
+        TaskStatus status;
+        char* word;
+        initializeTaskFilter(&filter);
+        if (!parseCommandInt(nextCommandWord(&cursor), 0, INT_MAX, &filter.minImportance) ||
+            ((word = nextCommandWord(&cursor)) != NULL && !parseCommandStatus(word, &status))) {
+            return false;
+        }
+        if (filter.minImportance == 0) {
+            filter.minImportance = INT_MIN;
+        }
+        if (word != NULL) {
+            filter.statusMask = 1u << status;
+        }
+        displayFilteredTasks(stack, &filter);
+        return true;
+    }
+    if (strcmp(command, "undo") == 0) {
+        return stack->undo != NULL && undoLastOperation(stack, stack->undo);
+    }
+    if (strcmp(command, "redo") == 0) {
+        return stack->undo != NULL && redoLastOperation(stack, stack->undo);
+    }
+    if (strcmp(command, "save") == 0) {
+        return saveStackToFile(stack);
+    }
+    if (strcmp(command, "import") == 0) {
+        char* path = restOfCommand(&cursor);
+        int rejected = 0;
+        int imported = path != NULL ? importTasksFromFile(stack, path, taskFileFormatForPath(path), &rejected) : -1;
+        if (rejected > 0) {
+            fprintf(stderr, "%s: skipped %d invalid record(s)\n", path, rejected);
+        }
+        return imported >= 0;
+    }
+    if (strcmp(command, "export") == 0) {
+        char* path = restOfCommand(&cursor);
+        return path != NULL && exportTasksToFile(stack, path, taskFileFormatForPath(path)) >= 0;
+    }
+    if (strcmp(command, "stats") == 0) {
+        return displayStats(stack) >= 0;
+    }
+    if (strcmp(command, "help") == 0) {
+        printBatchHelp();
+        return true;
+    }
+    return false;
+}
+
+ 
+/* Runs a command script, one command per line; blank lines and lines
+   starting with '#' are skipped. A failing command is reported on stderr
+   with its line number and the script carries on. Returns the number of
+   commands that failed. */
+int runBatchFile(TaskStack* stack, FILE* input) {
+    char line[4 * MAX_DESCRIPTION];
+    char original[4 * MAX_DESCRIPTION];
+    int number = 0;
+    int failed = 0;
+    
+    while (fgets(line, sizeof(line), input) != NULL) {
+        number++;
+        size_t length = strcspn(line, "\r\n");
+        if (line[length] == '\0' && length == sizeof(line) - 1) {
+            fprintf(stderr, "line %d: command too long\n", number);
+            failed++;
+            int c;
+            while ((c = fgetc(input)) != '\n' && c != EOF);
+            continue;
+        }
+        line[length] = '\0';
+        memcpy(original, line, length + 1);
+        if (!runBatchCommand(stack, line)) {
+            fprintf(stderr, "line %d: cannot run '%s'\n", number, original);
+            failed++;
+        }
+        checkpointWriteAheadLog(stack);
+    }
+    return failed;
+}
+
+ 
+/* Listens on "unix:PATH", or over TCP on "[HOST:]PORT" with HOST defaulting
+   to 127.0.0.1; port 0 picks a free port, which ends up in server->port. */
+bool openTaskServer(TaskServer* server, const char* address) {
+    struct epoll_event event = { .events = EPOLLIN };
+    bool ok;
+    
+    memset(server, 0, sizeof(*server));
+    server->listener = server->epoll = server->wake = -1;
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un local = { .sun_family = AF_UNIX };
+        struct stat info;
+        ok = strlen(address + 5) > 0 && strlen(address + 5) < sizeof(local.sun_path);
+        if (ok) {
+            strcpy(local.sun_path, address + 5);
+            if (stat(local.sun_path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+                unlink(local.sun_path);
+            }
+            server->listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            ok = server->listener >= 0 &&
+                 bind(server->listener, (struct sockaddr*)&local, sizeof(local)) == 0;
+        }
+        if (ok) {
+            strcpy(server->unixPath, local.sun_path);
+        }
+    } else {
+        struct sockaddr_in inet = { .sin_family = AF_INET };
+        socklen_t length = sizeof(inet);
+        const char* colon = strrchr(address, ':');
+        const char* port = colon != NULL ? colon + 1 : address;
+        char host[64] = "127.0.0.1";
+        char* end;
+        int one = 1;
+        
+        if (colon != NULL && colon > address) {
+            snprintf(host, sizeof(host), "%.*s", (int)(colon - address), address);
+        }
+        long number = strtol(port, &end, 10);
+        ok = end != port && *end == '\0' && number >= 0 && number <= 65535 &&
+             inet_pton(AF_INET, host, &inet.sin_addr) == 1;
+        if (ok) {
+            inet.sin_port = htons((uint16_t)number);
+            server->listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            ok = server->listener >= 0 &&
+                 setsockopt(server->listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0 &&
+                 bind(server->listener, (struct sockaddr*)&inet, sizeof(inet)) == 0 &&
+                 getsockname(server->listener, (struct sockaddr*)&inet, &length) == 0;
+            server->port = ntohs(inet.sin_port);
+        }
+    }
+    
+    ok = ok && listen(server->listener, SOMAXCONN) == 0 &&
+         (server->epoll = epoll_create1(EPOLL_CLOEXEC)) >= 0 &&
+         (server->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) >= 0;
+    event.data.ptr = &server->listener;
+    ok = ok && epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->listener, &event) == 0;
+    event.data.ptr = &server->wake;
+    ok = ok && epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->wake, &event) == 0;
+    if (!ok) {
+        closeTaskServer(server);
+    }
+    return ok;
+}
+
+ 
+static bool reserveServerBytes(char** buffer, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    size_t grown = *capacity ? *capacity : SERVER_READ_SIZE;
+    while (grown < needed) {
+        grown *= 2;
+    }
+    char* resized = (char*)realloc(*buffer, grown);
+    if (resized == NULL) {
+        return false;
+    }
+    *buffer = resized;
+    *capacity = grown;
+    return true;
+}
+
+ 
+static bool appendServerText(ServerConnection* connection, const char* text, size_t length) {
+    if (!reserveServerBytes(&connection->output, &connection->outputCapacity, connection->outputLength + length)) {
+        return false;
+    }
+    memcpy(connection->output + connection->outputLength, text, length);
+    connection->outputLength += length;
+    return true;
+}
+
+ 
+/* A reply row: the task ID, then the task as in a CSV export. */
+static bool appendServerRow(ServerConnection* connection, const Task* task, int index) {
+    if (!reserveServerBytes(&connection->output, &connection->outputCapacity,
+                            connection->outputLength + EXPORT_ROW_LIMIT + 16)) {
+        return false;
+    }
+    char* start = connection->output + connection->outputLength;
+    char* out = appendDecimal(start, index + 1);
+    *out++ = ',';
+    out = appendCsvTask(out, task);
+    *out++ = '\n';
+    connection->outputLength += out - start;
+    return true;
+}
+
+ 
+/* Puts "OK <rows>" in front of the rows appended since `mark`, or replaces
+   them with "ERR <message>". Returns false if even that cannot be queued. */
+static bool finishServerReply(ServerConnection* connection, size_t mark, int rows, const char* error) {
+    char header[64];
+    int length = error != NULL ? snprintf(header, sizeof(header), "ERR %s\n", error)
+                               : snprintf(header, sizeof(header), "OK %d\n", rows);
+    if (error != NULL) {
+        connection->outputLength = mark;
+    }
+    if (!reserveServerBytes(&connection->output, &connection->outputCapacity, connection->outputLength + length)) {
+        connection->outputLength = mark;
+        return false;
+    }
+    memmove(connection->output + mark + length, connection->output + mark, connection->outputLength - mark);
+    memcpy(connection->output + mark, header, length);
+    connection->outputLength += length;
+    return true;
+}
+
+ 
+/* Appends a row per matching task in stack order, through the keyword
+   index when `keywords` is set and one is attached, otherwise by substring
+   scan. Returns the row count, or -1 when out of memory. */
+static int appendServerMatches(const TaskStack* stack, ServerConnection* connection, const char* query,
+                               bool keywords, bool ignoreCase) {
+    int rows = 0;
+    
+    if (keywords && stack->keywordIndex != NULL) {
+        int* slots;
+        int count = collectIndexedSlots(stack, query, &slots);
+        for (int i = 0; i < count && rows >= 0; i++) {
+            rows = appendServerRow(connection, taskSlot(stack, slots[i]), indexForSlot(stack, slots[i])) ? rows + 1 : -1;
+        }
+        free(count >= 0 ? slots : NULL);
+        return count < 0 ? -1 : rows;
+    }
+    
+    SubstringMatcher matcher;
+    TaskCursor cursor;
+    const Task* task;
+    prepareSubstringMatcher(&matcher, query, ignoreCase);
+    openTaskCursor(&cursor, stack);
+    while (rows >= 0 && (task = nextTaskFromCursor(&cursor)) != NULL) {
+        if (matchSubstring(&matcher, getTaskDescription(task), descriptionReadable(task))) {
+            rows = appendServerRow(connection, task, cursor.index) ? rows + 1 : -1;
+        }
+    }
+    return rows;
+}
+
+ 
+/* Appends a row per operation called so far: its name, calls, failed
+   calls, timed calls, and the mean, p50, p99, p99.9 and maximum of the
+   timed calls in nanoseconds. Returns the row count, or -1 when out of
+   memory. */
+static int appendServerStats(ServerConnection* connection) {
+    TaskStats* stats = (TaskStats*)malloc(sizeof(TaskStats));
+    char row[256];
+    int rows = 0;
+    
+    if (stats == NULL) {
+        return -1;
+    }
+    collectStats(stats);
+    for (int op = 0; op < STAT_OPERATIONS && rows >= 0; op++) {
+        if (stats->calls[op] == 0) {
+            continue;
+        }
+        int length = snprintf(row, sizeof(row), "%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n", statOperationNames[op],
+                              (unsigned long long)stats->calls[op], (unsigned long long)stats->failures[op],
+                              (unsigned long long)stats->timed[op],
+                              (unsigned long long)(stats->timed[op] > 0 ? stats->timedNanos[op] / stats->timed[op] : 0),
+                              (unsigned long long)statPercentile(stats, (StatOperation)op, 50),
+                              (unsigned long long)statPercentile(stats, (StatOperation)op, 99),
+                              (unsigned long long)statPercentile(stats, (StatOperation)op, 99.9),
+                              (unsigned long long)statPercentile(stats, (StatOperation)op, 100));
+        rows = appendServerText(connection, row, length) ? rows + 1 : -1;
+    }
+    free(stats);
+    return rows;
+}
+
+ 
+/* Runs one request, written like a batch command, and queues its reply:
+   "OK <n>" and n rows, or "ERR <message>". Returns false only when the
+   reply cannot be queued. */
+static bool serveRequest(TaskStack* stack, ServerConnection* connection, char* line) {
+    char* cursor = line;
+    char* command = nextCommandWord(&cursor);
+    size_t mark = connection->outputLength;
+    Task task;
+    int id;
+    int rows = 0;
+    bool ok;
+    
+    if (command == NULL) {
+        return finishServerReply(connection, mark, 0, "empty request");
+    }
+    if (strcmp(command, "add") == 0) {
+        ok = parseCommandTask(&cursor, &task) && pushTask(stack, task);
+    } else if (strcmp(command, "insert") == 0) {
+        ok = parseCommandInt(nextCommandWord(&cursor), 1, INT_MAX, &id) &&
+             parseCommandTask(&cursor, &task) && insertTaskAtIndex(stack, id - 1, task);
+    } else if (strcmp(command, "pop") == 0) {
+        ok = popTask(stack, &task) && appendServerRow(connection, &task, getStackSize(stack));
+        rows = 1;
+    } else if (strcmp(command, "peek") == 0) {
+        ok = peekTask(stack, &task) && appendServerRow(connection, &task, getStackSize(stack) - 1);
+        rows = 1;
+    } else if (strcmp(command, "next") == 0 || strcmp(command, "pop-next") == 0) {
+        int index;
+        ok = peekPriorityTask(stack, &task, &index) &&
+             (command[3] != '-' || removeTaskAtIndex(stack, index)) &&
+             appendServerRow(connection, &task, index);
+        rows = 1;
+    } else if (strcmp(command, "edit") == 0) {
+        const Task* current;
+        ok = parseCommandInt(nextCommandWord(&cursor), 1, INT_MAX, &id) &&
+             (current = getTaskAtIndex(stack, id - 1)) != NULL;
+        if (ok) {
+            task = *current;
+            ok = parseCommandEdit(&cursor, &task) && editTaskAtIndex(stack, id - 1, task);
+        }
+    } else if (strcmp(command, "remove") == 0) {
+        ok = parseCommandInt(nextCommandWord(&cursor), 1, INT_MAX, &id) && removeTaskAtIndex(stack, id - 1);
+    } else if (strcmp(command, "list") == 0) {
+        TaskCursor tasks;
+        const Task* listed;
+        openTaskCursor(&tasks, stack);
+        ok = true;
+        while (ok && (listed = nextTaskFromCursor(&tasks)) != NULL) {
+            ok = appendServerRow(connection, listed, tasks.index);
+            rows++;
+        }
+    } else if (strcmp(command, "count") == 0) {
+        char count[16];
+        char* end = appendDecimal(count, getStackSize(stack));
+        *end++ = '\n';
+        ok = appendServerText(connection, count, end - count);
+        rows = 1;
+    } else if (strcmp(command, "search") == 0 || strcmp(command, "grep") == 0) {
+        bool keywords = command[0] == 's';
+        char* query = restOfCommand(&cursor);
+        bool ignoreCase = keywords || (query != NULL && strncmp(query, "-i ", 3) == 0);
+        if (!keywords && ignoreCase) {
+            query += 3 + strspn(query + 3, " \t");
+        }
+        rows = query != NULL && *query != '\0' ? appendServerMatches(stack, connection, query, keywords, ignoreCase) : -1;
+        ok = rows >= 0;
+    } else if (strcmp(command, "sort") == 0) {
+        TaskSortKey keys[MAX_SORT_KEYS];
+        char* spec = restOfCommand(&cursor);
+        int keyCount = spec != NULL ? parseSortKeys(spec, keys) : -1;
+        ok = keyCount >= 0 && sortStack(stack, keys, keyCount);
+    } else if (strcmp(command, "undo") == 0) {
+        ok = stack->undo != NULL && undoLastOperation(stack, stack->undo);
+    } else if (strcmp(command, "redo") == 0) {
+        ok = stack->undo != NULL && redoLastOperation(stack, stack->undo);
+    } else if (strcmp(command, "save") == 0) {
+        ok = saveStackInBackground(stack);
+    } else if (strcmp(command, "stats") == 0) {
+        rows = appendServerStats(connection);
+        ok = rows >= 0;
+    } else {
+        return finishServerReply(connection, mark, 0, "unknown command");
+    }
+    return finishServerReply(connection, mark, rows, ok ? NULL : "failed");
+}
+
+ 
+/* Runs the complete request lines waiting in the input buffer, pausing
+   once SERVER_OUTPUT_LIMIT bytes of replies are queued. */
+static bool runServerRequests(TaskServer* server, ServerConnection* connection, TaskStack* stack) {
+    size_t start = 0;
+    char* newline;
+    
+    while (connection->outputLength - connection->outputSent < SERVER_OUTPUT_LIMIT &&
+           (newline = (char*)memchr(connection->input + start, '\n', connection->inputLength - start)) != NULL) {
+        char* line = connection->input + start;
+        size_t length = newline - line;
+        if (length > 0 && line[length - 1] == '\r') {
+            length--;
+        }
+        line[length] = '\0';
+        start = newline + 1 - connection->input;
+        server->requests++;
+        int64_t started = beginStat(STAT_REQUEST);
+        bool queued = serveRequest(stack, connection, line);
+        endStat(STAT_REQUEST, started, queued);
+        if (!queued) {
+            return false;
+        }
+    }
+    
+    connection->inputLength -= start;
+    memmove(connection->input, connection->input + start, connection->inputLength);
+    if (connection->inputLength > SERVER_REQUEST_LIMIT &&
+        memchr(connection->input, '\n', connection->inputLength) == NULL) {
+        connection->closing = true;
+        connection->inputLength = 0;
+        return finishServerReply(connection, connection->outputLength, 0, "request too long");
+    }
+    return true;
+}
+
+ 
+/* One read per wake-up keeps a busy client from starving the others; the
+   level-triggered epoll comes back for whatever is left. */
+static bool readServerConnection(TaskServer* server, ServerConnection* connection, TaskStack* stack) {
+    if (!reserveServerBytes(&connection->input, &connection->inputCapacity,
+                            connection->inputLength + SERVER_READ_SIZE)) {
+        return false;
+    }
+    ssize_t count = read(connection->fd, connection->input + connection->inputLength, SERVER_READ_SIZE);
+    if (count == 0) {
+        connection->closing = true;
+    } else if (count < 0) {
+        return errno == EAGAIN || errno == EINTR;
+    } else {
+        connection->inputLength += (size_t)count;
+    }
+    return runServerRequests(server, connection, stack);
+}
+
+ 
+/* Sends the queued replies, normally with one send. Whatever the socket
+   does not take waits for EPOLLOUT, and reading pauses until it has gone.
+   Returns false once the connection should be closed. */
+static bool flushServerConnection(TaskServer* server, ServerConnection* connection) {
+    while (connection->outputSent < connection->outputLength) {
+        ssize_t count = send(connection->fd, connection->output + connection->outputSent,
+                             connection->outputLength - connection->outputSent, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0 && errno == EAGAIN) {
+            break;
+        }
+        if (count < 0) {
+            return false;
+        }
+        connection->outputSent += (size_t)count;
+    }
+    
+    bool pending = connection->outputSent < connection->outputLength;
+    if (!pending) {
+        connection->outputLength = connection->outputSent = 0;
+    }
+    if (pending != connection->writing) {
+        struct epoll_event event = { .events = pending ? EPOLLOUT : EPOLLIN, .data.ptr = connection };
+        if (epoll_ctl(server->epoll, EPOLL_CTL_MOD, connection->fd, &event) != 0) {
+            return false;
+        }
+        connection->writing = pending;
+    }
+    return pending || !connection->closing;
+}
+
+ 
+static void closeServerConnection(TaskServer* server, ServerConnection* connection) {
+    epoll_ctl(server->epoll, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    server->connections[connection->slot] = server->connections[--server->connectionCount];
+    server->connections[connection->slot]->slot = connection->slot;
+    free(connection->input);
+    free(connection->output);
+    free(connection);
+}
+
+ 
+static void acceptServerConnections(TaskServer* server) {
+    int fd;
+    while ((fd = accept(server->listener, NULL, NULL)) >= 0) {
+        ServerConnection* connection = (ServerConnection*)calloc(1, sizeof(ServerConnection));
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = connection };
+        int one = 1;
         
-        int choice;
-        scanf("%d", &choice);
-        clearInputBuffer();
+        if (server->connectionCount == server->connectionCapacity) {
+            int capacity = server->connectionCapacity ? server->connectionCapacity * 2 : 16;
+            ServerConnection** grown = (ServerConnection**)realloc(server->connections,
+                                                                   capacity * sizeof(ServerConnection*));
+            if (grown != NULL) {
+                server->connections = grown;
+                server->connectionCapacity = capacity;
+            }
+        }
+        if (connection == NULL || server->connectionCount == server->connectionCapacity ||
+            epoll_ctl(server->epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            free(connection);
+            continue;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        connection->fd = fd;
+        connection->slot = server->connectionCount;
+        server->connections[server->connectionCount++] = connection;
+    }
+}
+
+ 
+/* Serves requests until stopTaskServer is called and returns how many were
+   run, or -1 if epoll fails. The stack belongs to this thread meanwhile. */
+int runTaskServer(TaskServer* server, TaskStack* stack) {
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    uint64_t served = server->requests;
+    
+    while (!atomic_load(&server->stopping)) {
+        int timeout = backgroundSave.running ? 50 : -1;
+        /* The stats file is rewritten on schedule even with no client. */
+        int statsDue = refreshStatsFile(stack, false);
+        if (statsDue >= 0 && (timeout < 0 || statsDue < timeout)) {
+            timeout = statsDue;
+        }
         
-        switch (choice) {
-            case 1:  
-                drawUIHeader();
-                printf("| Push New Task                                                             |\n");
-                drawLine(80);
-                
-                printf("| Enter Task Description: ");
-                scanf(" %99[^\n]", newTask.description);
-                clearInputBuffer();
-                
-                printf("| Enter Task Due Date (YYYY MM DD): ");
-                if (scanf("%d %d %d", &newTask.year, &newTask.month, &newTask.day) != 3 || 
-                    !isValidDate(newTask.year, newTask.month, newTask.day)) {
-                    printf("| Invalid date format. Please enter a valid date.\n");
-                    drawUIFooter();
-                    continue;
-                }
-                clearInputBuffer();
-                
-                printf("| Enter Task Importance (1-10): ");
-                scanf("%d", &newTask.importance);
-                clearInputBuffer();
-                
-                printf("| Task Status (0-Pending, 1-In Progress, 2-Completed): ");
-                int status;
-                scanf("%d", &status);
-                if (status >= PENDING && status <= COMPLETED) {
-                    newTask.status = (TaskStatus)status;
-                } else {
-                    newTask.status = PENDING;
-                }
-                clearInputBuffer();
-                
-                 
-                newTask.createdAt = time(NULL);
-                
-                if (pushTask(&taskStack, newTask)) {
-                    printf("| Task pushed successfully!\n");
-                } else {
-                    printf("| Task stack is full. Cannot push more tasks.\n");
-                }
-                
-                drawUIFooter();
-                break;
-                
-            case 2:  
-                drawUIHeader();
-                printf("| Pop Task                                                                  |\n");
-                drawLine(80);
-                
-                Task poppedTask;
-                if (popTask(&taskStack, &poppedTask)) {
-                    printf("| Popped Task: %s\n", poppedTask.description);
-                    pushToUndoStack(&undoStack, poppedTask);  
-                } else {
-                    printf("| Task stack is empty. Nothing to pop.\n");
-                }
-                
-                drawUIFooter();
-                break;
-                
-            case 3:  
-                drawUIHeader();
-                printf("| Current Tasks (%d/%d):                                                    |\n", 
-                       getStackSize(taskStack), MAX_TASKS);
-                
-                displayAllTasks(taskStack);
-                
-                drawUIFooter();
-                break;
-                
-            case 4:  
-                drawUIHeader();
-                printf("| Edit Task                                                                 |\n");
-                drawLine(80);
-                
-                if (isEmptyStack(&taskStack)) {
-                    printf("| Task stack is empty. Nothing to edit.\n");
-                    drawUIFooter();
-                    continue;
-                }
-                
-                displayAllTasks(taskStack);
-                
-                printf("| Enter Task ID to edit: ");
-                scanf("%d", &taskNumber);
-                clearInputBuffer();
-                
-                taskIndex = taskNumber - 1;
-                Task* taskToEdit = getTaskAtIndex(&taskStack, getStackSize(taskStack) - 1 - taskIndex);
-                
-                if (taskToEdit == NULL) {
-                    printf("| Invalid Task ID. Please try again.\n");
-                    drawUIFooter();
-                    continue;
-                }
-                
-                 
-                Task editedTask = *taskToEdit;
-                
-                printf("| Current description: %s\n", editedTask.description);
-                printf("| Enter new description (or press Enter to keep current): ");
-                char newDesc[MAX_DESCRIPTION];
-                if (fgets(newDesc, MAX_DESCRIPTION, stdin) != NULL && newDesc[0] != '\n') {
-                    newDesc[strcspn(newDesc, "\n")] = 0;  
-                    strcpy(editedTask.description, newDesc);
-                }
-                
-                printf("| Current date: %s %d, %d\n", 
-                       monthNames[editedTask.month - 1], editedTask.day, editedTask.year);
-                printf("| Enter new date (YYYY MM DD) or 0 to keep current: ");
-                int year, month, day;
-                if (scanf("%d", &year) == 1 && year != 0) {
-                    scanf("%d %d", &month, &day);
-                    if (isValidDate(year, month, day)) {
-                        editedTask.year = year;
-                        editedTask.month = month;
-                        editedTask.day = day;
-                    } else {
-                        printf("| Invalid date. Keeping current date.\n");
-                    }
-                }
-                clearInputBuffer();
-                
-                printf("| Current importance: %d\n", editedTask.importance);
-                printf("| Enter new importance (1-10) or 0 to keep current: ");
-                int importance;
-                if (scanf("%d", &importance) == 1 && importance > 0) {
-                    editedTask.importance = importance;
-                }
-                clearInputBuffer();
-                
-                printf("| Current status: %s\n", statusNames[editedTask.status]);
-                printf("| Enter new status (0-Pending, 1-In Progress, 2-Completed) or -1 to keep current: ");
-                if (scanf("%d", &status) == 1 && status >= 0) {
-                    if (status >= PENDING && status <= COMPLETED) {
-                        editedTask.status = (TaskStatus)status;
-                    }
-                }
-                clearInputBuffer();
-                
-                if (editTaskAtIndex(&taskStack, getStackSize(taskStack) - 1 - taskIndex, editedTask, &undoStack)) {
-                    printf("| Task updated successfully!\n");
-                } else {
-                    printf("| Error updating task.\n");
-                }
-                
-                drawUIFooter();
-                break;
-                
-            case 5:  
-                drawUIHeader();
-                printf("| Remove Specific Task                                                      |\n");
-                drawLine(80);
-                
-                if (isEmptyStack(&taskStack)) {
-                    printf("| Task stack is empty. Nothing to remove.\n");
-                    drawUIFooter();
+        /* Requests held back by SERVER_OUTPUT_LIMIT go once their replies
+           have been sent; the client may be waiting on them rather than
+           sending more. */
+        for (int c = server->connectionCount - 1; c >= 0; c--) {
+            ServerConnection* connection = server->connections[c];
+            if (connection->writing || connection->inputLength == 0 ||
+                memchr(connection->input, '\n', connection->inputLength) == NULL) {
+                continue;
+            }
+            timeout = 0;
+            if (!runServerRequests(server, connection, stack)) {
+                closeServerConnection(server, connection);
+            }
+        }
+        
+        int count = epoll_wait(server->epoll, events, SERVER_MAX_EVENTS, timeout);
+        if (count < 0 && errno != EINTR) {
+            return -1;
+        }
+        finishBackgroundSave(false);
+        
+        for (int i = 0; i < count; i++) {
+            void* source = events[i].data.ptr;
+            if (source == &server->listener) {
+                acceptServerConnections(server);
+                continue;
+            }
+            if (source == &server->wake) {
+                uint64_t wakes;
+                if (read(server->wake, &wakes, sizeof(wakes)) < 0) {
                     continue;
                 }
-                
-                displayAllTasks(taskStack);
-                
-                printf("| Enter Task ID to remove: ");
-                scanf("%d", &taskNumber);
-                clearInputBuffer();
-                
-                taskIndex = taskNumber - 1;
-                int actualIndex = getStackSize(taskStack) - 1 - taskIndex;
-                
-                if (removeTaskAtIndex(&taskStack, actualIndex, &undoStack)) {
-                    printf("| Task removed successfully!\n");
-                } else {
-                    printf("| Invalid Task ID or error removing task.\n");
-                }
-                
-                drawUIFooter();
-                break;
-                
-            case 6:  
-                drawUIHeader();
-                printf("| Search Tasks                                                              |\n");
-                drawLine(80);
-                
-                printf("| Enter search keyword: ");
-                scanf(" %99[^\n]", searchKeyword);
-                clearInputBuffer();
-                
-                searchTasks(taskStack, searchKeyword);
-                break;
-                
-            case 7:  
-                sortStackByDate(&taskStack);
-                drawUIHeader();
-                printf("| Tasks sorted by date.                                                     |\n");
-                displayAllTasks(taskStack);
-                drawUIFooter();
-                break;
-                
-            case 8:  
-                sortStackByImportance(&taskStack);
-                drawUIHeader();
-                printf("| Tasks sorted by importance.                                               |\n");
-                displayAllTasks(taskStack);
-                drawUIFooter();
-                break;
-                
-            case 9:  
-                drawUIHeader();
-                printf("| Undo Last Operation                                                       |\n");
-                drawLine(80);
-                
-                if (undoLastOperation(&taskStack, &undoStack)) {
-                    printf("| Last operation undone successfully!\n");
-                } else {
-                    printf("| Nothing to undo or error occurred.\n");
-                }
-                
-                drawUIFooter();
-                break;
-                
-            case 10:  
-                saveStackToFile(taskStack);
-                drawUIHeader();
-                printf("| Tasks saved successfully!                                                 |\n");
-                drawUIFooter();
-                break;
-                
-            case 11:  
-                drawUIHeader();
-                printf("| Saving tasks before exit...                                               |\n");
-                saveStackToFile(taskStack);
-                printf("| Thank you for using the Stack-Based Task Management System!               |\n");
-                drawUIFooter();
-                exit(0);
-                
-            default:
-                drawUIHeader();
-                printf("| Invalid choice. Please try again.                                           |\n");
-                drawUIFooter();
+                continue;
+            }
+            
+            ServerConnection* connection = (ServerConnection*)source;
+            bool keep;
+            if (events[i].events & EPOLLERR) {
+                keep = false;
+            } else if (events[i].events & EPOLLOUT) {
+                keep = flushServerConnection(server, connection);
+            } else {
+                keep = readServerConnection(server, connection, stack);
+            }
+            if (!keep) {
+                closeServerConnection(server, connection);
+            }
+        }
+        
+        /* Group commit: the changes made this round reach the disk with one
+           sync before any reply that reports them goes out. */
+        if (stack->wal != NULL) {
+            syncWriteAheadLog(stack->wal);
+            checkpointWriteAheadLog(stack);
+        }
+        for (int c = server->connectionCount - 1; c >= 0; c--) {
+            ServerConnection* connection = server->connections[c];
+            if (!connection->writing && (connection->outputLength > 0 || connection->closing) &&
+                !flushServerConnection(server, connection)) {
+                closeServerConnection(server, connection);
+            }
+        }
+        server->rounds++;
+    }
+    return (int)(server->requests - served);
+}
+
+ 
+/* Makes runTaskServer return; safe from a signal handler or another
+   thread. */
+void stopTaskServer(TaskServer* server) {
+    uint64_t one = 1;
+    atomic_store(&server->stopping, true);
+    if (write(server->wake, &one, sizeof(one)) < 0) {
+        return;
+    }
+}
+
+ 
+void closeTaskServer(TaskServer* server) {
+    while (server->connectionCount > 0) {
+        closeServerConnection(server, server->connections[server->connectionCount - 1]);
+    }
+    free(server->connections);
+    server->connections = NULL;
+    server->connectionCapacity = 0;
+    if (server->listener >= 0) {
+        close(server->listener);
+    }
+    if (server->epoll >= 0) {
+        close(server->epoll);
+    }
+    if (server->wake >= 0) {
+        close(server->wake);
+    }
+    if (server->unixPath[0] != '\0') {
+        unlink(server->unixPath);
+    }
+    server->listener = server->epoll = server->wake = -1;
+    server->unixPath[0] = '\0';
+}
+
+ 
+/* A directory of "" keeps the stacks in memory; any other is created if
+   missing. */
+bool initializeTaskNamespace(TaskNamespace* space, const char* directory) {
+    memset(space, 0, sizeof(*space));
+    if (directory == NULL) {
+        directory = "";
+    }
+    if (strlen(directory) >= sizeof(space->directory) ||
+        (directory[0] != '\0' && mkdir(directory, 0755) != 0 && errno != EEXIST)) {
+        return false;
+    }
+    strcpy(space->directory, directory);
+    for (int s = 0; s < NAMESPACE_SHARDS; s++) {
+        pthread_mutex_init(&space->shards[s].lock, NULL);
+    }
+    return true;
+}
+
+ 
+/* Names are 1 to MAX_STACK_NAME - 1 letters, digits, '-', '_' or '.', not
+   starting with '.', so that each one is a safe file name. */
+static bool isValidStackName(const char* name) {
+    size_t length = strlen(name);
+    if (length == 0 || length >= MAX_STACK_NAME || name[0] == '.') {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '-' && name[i] != '_' && name[i] != '.') {
+            return false;
         }
     }
+    return true;
+}
+
+ 
+static void closeNamedStack(NamedStack* named) {
+    if (named->wal != NULL) {
+        closeWriteAheadLog(named->wal);
+        free(named->wal);
+    }
+    named->stack.undo = NULL;
+    freeUndoStack(&named->undo);
+    resetStack(&named->stack);
+    freeKeywordIndex(&named->keywordIndex);
+    free(named);
+}
+
+ 
+/* A new stack, loaded from NAME.dat and NAME.wal when the namespace has a
+   directory, the same way main loads tasks.dat and tasks.wal. */
+static NamedStack* openNamedStack(const TaskNamespace* space, const char* name, uint32_t hash) {
+    NamedStack* named = (NamedStack*)calloc(1, sizeof(NamedStack));
+    if (named == NULL) {
+        return NULL;
+    }
+    strcpy(named->name, name);
+    named->hash = hash;
+    initializeStack(&named->stack);
+    initializeUndoStack(&named->undo, UNDO_BUDGET);
+    initializeKeywordIndex(&named->keywordIndex);
+    attachKeywordIndex(&named->stack, &named->keywordIndex);
     
-    return 0;
-}
\ No newline at end of file
+    if (space->directory[0] != '\0') {
+        char walPath[MAX_NAMESPACE_PATH];
+        snprintf(named->dataPath, sizeof(named->dataPath), "%s/%s.dat", space->directory, name);
+        snprintf(walPath, sizeof(walPath), "%s/%s.wal", space->directory, name);
+        named->stack.path = named->dataPath;
+        bool loaded = loadStackFromFile(&named->stack);
+        bool missing = !loaded && errno == ENOENT;
+        named->wal = (WriteAheadLog*)malloc(sizeof(WriteAheadLog));
+        if (named->wal != NULL && openWriteAheadLog(named->wal, walPath)) {
+            int recovered = loaded || missing ? replayWriteAheadLog(&named->stack, named->wal) :
+                            named->wal->fileSize > 0 ? -1 : 0;
+            if (recovered < 0) {
+                closeNamedStack(named);
+                return NULL;
+            }
+            attachWriteAheadLog(&named->stack, named->wal);
+        } else {
+            free(named->wal);
+            named->wal = NULL;
+        }
+    }
+    attachUndoStack(&named->stack, &named->undo);
+    return named;
+}
+
+ 
+static int findShardSlot(const NamespaceShard* shard, const char* name, uint32_t hash) {
+    int slot = hash & (shard->capacity - 1);
+    while (shard->stacks[slot] != NULL &&
+           (shard->stacks[slot]->hash != hash || strcmp(shard->stacks[slot]->name, name) != 0)) {
+        slot = (slot + 1) & (shard->capacity - 1);
+    }
+    return slot;
+}
+
+ 
+static bool growNamespaceShard(NamespaceShard* shard) {
+    unsigned capacity = shard->capacity ? (unsigned)shard->capacity * 2 : 16;
+    NamedStack** stacks = (NamedStack**)calloc(capacity, sizeof(NamedStack*));
+    if (stacks == NULL) {
+        return false;
+    }
+    NamedStack** old = shard->stacks;
+    int oldCapacity = shard->capacity;
+    shard->stacks = stacks;
+    shard->capacity = (int)capacity;
+    for (int i = 0; i < oldCapacity; i++) {
+        if (old[i] != NULL) {
+            stacks[findShardSlot(shard, old[i]->name, old[i]->hash)] = old[i];
+        }
+    }
+    free(old);
+    return true;
+}
+
+ 
+/* Finds the stack called `name`, creating it when `create` is set, and
+   returns it with its shard locked; every other stack in the shard waits
+   until unlockNamedStack, including while a new stack loads its files.
+   Returns NULL, with nothing locked, for an invalid or unknown name or a
+   stack whose log cannot be replayed over its snapshot. */
+NamedStack* lockNamedStack(TaskNamespace* space, const char* name, bool create) {
+    if (!isValidStackName(name)) {
+        return NULL;
+    }
+    uint32_t hash = hashText(name, strlen(name));
+    NamespaceShard* shard = &space->shards[hash >> NAMESPACE_SHARD_SHIFT];
+    NamedStack* named = NULL;
+    
+    pthread_mutex_lock(&shard->lock);
+    if (shard->capacity > 0) {
+        named = shard->stacks[findShardSlot(shard, name, hash)];
+    }
+    if (named == NULL && create && (shard->count * 2 < shard->capacity || growNamespaceShard(shard)) &&
+        (named = openNamedStack(space, name, hash)) != NULL) {
+        shard->stacks[findShardSlot(shard, name, hash)] = named;
+        shard->count++;
+    }
+    if (named == NULL) {
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return named;
+}
+
+ 
+void unlockNamedStack(TaskNamespace* space, NamedStack* named) {
+    checkpointWriteAheadLog(&named->stack);
+    pthread_mutex_unlock(&space->shards[named->hash >> NAMESPACE_SHARD_SHIFT].lock);
+}
+
+ 
+/* Removes the stack from the namespace and deletes its files. Entries
+   after it in the same probe run are put back, so lookups still find
+   them. */
+bool dropNamedStack(TaskNamespace* space, const char* name) {
+    NamedStack* named = lockNamedStack(space, name, false);
+    if (named == NULL) {
+        return false;
+    }
+    NamespaceShard* shard = &space->shards[named->hash >> NAMESPACE_SHARD_SHIFT];
+    int slot = findShardSlot(shard, named->name, named->hash);
+    
+    shard->stacks[slot] = NULL;
+    shard->count--;
+    for (slot = (slot + 1) & (shard->capacity - 1); shard->stacks[slot] != NULL;
+         slot = (slot + 1) & (shard->capacity - 1)) {
+        NamedStack* moved = shard->stacks[slot];
+        shard->stacks[slot] = NULL;
+        shard->stacks[findShardSlot(shard, moved->name, moved->hash)] = moved;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    
+    if (named->dataPath[0] != '\0') {
+        char walPath[MAX_NAMESPACE_PATH];
+        snprintf(walPath, sizeof(walPath), "%.*s.wal", (int)strlen(named->dataPath) - 4, named->dataPath);
+        remove(named->dataPath);
+        remove(walPath);
+    }
+    closeNamedStack(named);
+    return true;
+}
+
+ 
+int countNamedStacks(TaskNamespace* space) {
+    int count = 0;
+    for (int s = 0; s < NAMESPACE_SHARDS; s++) {
+        pthread_mutex_lock(&space->shards[s].lock);
+        count += space->shards[s].count;
+        pthread_mutex_unlock(&space->shards[s].lock);
+    }
+    return count;
+}
+
+ 
+/* Opens every stack that has a NAME.dat or NAME.wal in the directory, and
+   returns how many the namespace then holds. */
+int loadTaskNamespace(TaskNamespace* space) {
+    DIR* directory = space->directory[0] != '\0' ? opendir(space->directory) : NULL;
+    struct dirent* entry;
+    
+    while (directory != NULL && (entry = readdir(directory)) != NULL) {
+        char name[MAX_STACK_NAME];
+        size_t length = strlen(entry->d_name);
+        if (length <= 4 || length - 4 >= MAX_STACK_NAME ||
+            (strcmp(entry->d_name + length - 4, ".dat") != 0 && strcmp(entry->d_name + length - 4, ".wal") != 0)) {
+            continue;
+        }
+        snprintf(name, sizeof(name), "%.*s", (int)length - 4, entry->d_name);
+        NamedStack* named = lockNamedStack(space, name, true);
+        if (named != NULL) {
+            unlockNamedStack(space, named);
+        }
+    }
+    if (directory != NULL) {
+        closedir(directory);
+    }
+    return countNamedStacks(space);
+}
+
+ 
+/* Checkpoints every stack into its own file, one shard at a time. Returns
+   the number of stacks that could not be saved. */
+int saveTaskNamespace(TaskNamespace* space) {
+    int failed = 0;
+    for (int s = 0; s < NAMESPACE_SHARDS && space->directory[0] != '\0'; s++) {
+        NamespaceShard* shard = &space->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        for (int i = 0; i < shard->capacity; i++) {
+            if (shard->stacks[i] != NULL) {
+                failed += !saveStackToFile(&shard->stacks[i]->stack);
+            }
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return failed;
+}
+
+ 
+void freeTaskNamespace(TaskNamespace* space) {
+    for (int s = 0; s < NAMESPACE_SHARDS; s++) {
+        NamespaceShard* shard = &space->shards[s];
+        for (int i = 0; i < shard->capacity; i++) {
+            if (shard->stacks[i] != NULL) {
+                closeNamedStack(shard->stacks[i]);
+            }
+        }
+        free(shard->stacks);
+        shard->stacks = NULL;
+        shard->count = shard->capacity = 0;
+        pthread_mutex_destroy(&shard->lock);
+    }
+}
+
+ 
+/* One thread's share of a namespace search: every `step`th shard from
+   `first`, with the matches it found. */
+typedef struct {
+    TaskNamespace* space;
+    const char* query;
+    int first;
+    int step;
+    NamespaceMatch* matches;
+    int count;
+    int capacity;
+    bool failed;
+} NamespaceSearchJob;
+
+ 
+static void addNamespaceMatch(NamespaceSearchJob* job, const NamedStack* named, const TaskStack* stack, int slot) {
+    if (job->count == job->capacity) {
+        int capacity = job->capacity ? job->capacity * 2 : 64;
+        NamespaceMatch* grown = (NamespaceMatch*)realloc(job->matches, capacity * sizeof(NamespaceMatch));
+        if (grown == NULL) {
+            job->failed = true;
+            return;
+        }
+        job->matches = grown;
+        job->capacity = capacity;
+    }
+    NamespaceMatch* match = &job->matches[job->count++];
+    memcpy(match->stackName, named->name, MAX_STACK_NAME);
+    match->index = indexForSlot(stack, slot);
+    match->task = *taskSlot(stack, slot);
+    retainTaskDescription(&match->task);
+}
+
+ 
+static void* runNamespaceSearch(void* argument) {
+    NamespaceSearchJob* job = (NamespaceSearchJob*)argument;
+    for (int s = job->first; s < NAMESPACE_SHARDS && !job->failed; s += job->step) {
+        NamespaceShard* shard = &job->space->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        for (int i = 0; i < shard->capacity && !job->failed; i++) {
+            const NamedStack* named = shard->stacks[i];
+            int* slots = NULL;
+            int count = named != NULL ? collectIndexedSlots(&named->stack, job->query, &slots) : 0;
+            job->failed = count < 0;
+            for (int m = 0; m < count && !job->failed; m++) {
+                addNamespaceMatch(job, named, &named->stack, slots[m]);
+            }
+            free(slots);
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return NULL;
+}
+
+ 
+static int compareNamespaceMatches(const void* a, const void* b) {
+    const NamespaceMatch* x = (const NamespaceMatch*)a;
+    const NamespaceMatch* y = (const NamespaceMatch*)b;
+    int order = strcmp(x->stackName, y->stackName);
+    return order != 0 ? order : (x->index > y->index) - (x->index < y->index);
+}
+
+ 
+/* Releases the descriptions the matches hold and frees the array. */
+void freeNamespaceMatches(NamespaceMatch* matches, int count) {
+    for (int i = 0; i < count; i++) {
+        releaseTaskDescription(&matches[i].task);
+    }
+    free(matches);
+}
+
+ 
+/* Runs a keyword query against every stack, with the shards split over
+   up to one thread per core, each holding only the lock of the shard it
+   is searching. The matches come back ordered by stack name and then by
+   task ID. Returns their count, or -1 when out of memory; the caller
+   hands *matches to freeNamespaceMatches. */
+int searchTaskNamespace(TaskNamespace* space, const char* query, NamespaceMatch** matches) {
+    NamespaceSearchJob jobs[NAMESPACE_SHARDS];
+    pthread_t threads[NAMESPACE_SHARDS];
+    bool started[NAMESPACE_SHARDS] = { false };
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int threadCount = cores < 1 ? 1 : cores > NAMESPACE_SHARDS ? NAMESPACE_SHARDS : (int)cores;
+    int total = 0;
+    bool failed = false;
+    
+    for (int t = 0; t < threadCount; t++) {
+        jobs[t] = (NamespaceSearchJob){ .space = space, .query = query, .first = t, .step = threadCount };
+        started[t] = t > 0 && pthread_create(&threads[t], NULL, runNamespaceSearch, &jobs[t]) == 0;
+    }
+    for (int t = 0; t < threadCount; t++) {
+        if (!started[t]) {
+            runNamespaceSearch(&jobs[t]);
+        }
+    }
+    for (int t = 1; t < threadCount; t++) {
+        if (started[t]) {
+            pthread_join(threads[t], NULL);
+        }
+    }
+    
+    for (int t = 0; t < threadCount; t++) {
+        total += jobs[t].count;
+        failed = failed || jobs[t].failed;
+    }
+    *matches = failed ? NULL : (NamespaceMatch*)malloc((total + 1) * sizeof(NamespaceMatch));
+    total = *matches != NULL ? total : -1;
+    for (int t = 0, offset = 0; t < threadCount; t++) {
+        if (total > 0 && jobs[t].count > 0) {
+            memcpy(*matches + offset, jobs[t].matches, jobs[t].count * sizeof(NamespaceMatch));
+            offset += jobs[t].count;
+            free(jobs[t].matches);
+        } else {
+            freeNamespaceMatches(jobs[t].matches, jobs[t].count);
+        }
+    }
+    if (total > 1) {
+        qsort(*matches, total, sizeof(NamespaceMatch), compareNamespaceMatches);
+    }
+    return total;
+}
+
+ 
+/* Where refreshStatsFile writes, and how often. */
+typedef struct {
+    char path[MAX_NAMESPACE_PATH];
+    int64_t intervalNanos;
+    int64_t writtenAt;
+} StatsFile;
+
+static StatsFile statsFile;
+
+ 
+/* Formats a latency in at most six characters, such as "850ns" or
+   "12.3us". */
+static void formatNanos(char* out, size_t size, double nanos) {
+    const char* units[] = { "ns", "us", "ms", "s" };
+    int unit = 0;
+    while (unit < 3 && nanos >= 999.5) {
+        nanos /= 1000;
+        unit++;
+    }
+    snprintf(out, size, unit == 0 || nanos >= 99.95 ? "%.0f%s" : nanos >= 9.995 ? "%.1f%s" : "%.2f%s", nanos,
+             units[unit]);
+}
+
+ 
+static uint64_t poolBytes() {
+    pthread_mutex_lock(&stringPool.lock);
+    uint64_t bytes = stringPool.bytes;
+    pthread_mutex_unlock(&stringPool.lock);
+    return bytes;
+}
+
+ 
+/* Prints a row for every operation called so far, with its calls, failed
+   calls and the mean and percentiles of its timed calls, then the stack's
+   size and undo depth. Returns the number of rows, or -1 when out of
+   memory. */
+int displayStats(const TaskStack* stack) {
+    TaskStats* stats = (TaskStats*)malloc(sizeof(TaskStats));
+    char summary[128];
+    int rows = 0;
+    
+    if (stats == NULL) {
+        return -1;
+    }
+    collectStats(stats);
+    printf("| %-12s | %8s | %5s | %6s | %6s | %6s | %6s | %6s |\n", "Operation", "Calls", "Fails", "Mean", "p50",
+           "p99", "p99.9", "Max");
+    drawLine(80);
+    for (int op = 0; op < STAT_OPERATIONS; op++) {
+        char mean[16] = "-", p50[16] = "-", p99[16] = "-", p999[16] = "-", max[16] = "-";
+        if (stats->calls[op] == 0) {
+            continue;
+        }
+        if (stats->timed[op] > 0) {
+            formatNanos(mean, sizeof(mean), (double)stats->timedNanos[op] / stats->timed[op]);
+            formatNanos(p50, sizeof(p50), (double)statPercentile(stats, (StatOperation)op, 50));
+            formatNanos(p99, sizeof(p99), (double)statPercentile(stats, (StatOperation)op, 99));
+            formatNanos(p999, sizeof(p999), (double)statPercentile(stats, (StatOperation)op, 99.9));
+            formatNanos(max, sizeof(max), (double)statPercentile(stats, (StatOperation)op, 100));
+        }
+        printf("| %-12s | %8llu | %5llu | %6s | %6s | %6s | %6s | %6s |\n", statOperationNames[op],
+               (unsigned long long)stats->calls[op], (unsigned long long)stats->failures[op], mean, p50, p99, p999,
+               max);
+        rows++;
+    }
+    snprintf(summary, sizeof(summary), "%d task(s), %d undo and %d redo step(s), %.1f MB of text, %d thread(s)",
+             getStackSize(stack), stack->undo != NULL ? stack->undo->undoCount : 0,
+             stack->undo != NULL ? stack->undo->redoCount : 0, poolBytes() / 1e6, stats->threads);
+    drawLine(80);
+    printf("| %-76s |\n", summary);
+    free(stats);
+    return rows;
+}
+
+ 
+/* Writes the stats in the Prometheus text format to a temporary file that
+   is renamed over `path`, so a scraper never reads half of one. The
+   log-linear buckets are folded into decimal bounds, each counting under
+   the first bound that its whole range lies within. */
+bool writeStatsFile(const char* path, const TaskStack* stack) {
+    static const double bounds[] = { 1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1, 10 };
+    TaskStats* stats = (TaskStats*)malloc(sizeof(TaskStats));
+    char temporary[MAX_NAMESPACE_PATH + 8];
+    FILE* file = NULL;
+    
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    if (stats == NULL || (file = fopen(temporary, "w")) == NULL) {
+        free(stats);
+        return false;
+    }
+    collectStats(stats);
+    
+    fprintf(file, "# HELP task_operations_total Calls of each stack operation.\n"
+                  "# TYPE task_operations_total counter\n");
+    for (int op = 0; op < STAT_OPERATIONS; op++) {
+        fprintf(file, "task_operations_total{op=\"%s\"} %llu\n", statOperationNames[op],
+                (unsigned long long)stats->calls[op]);
+    }
+    fprintf(file, "# HELP task_operation_failures_total Calls of each stack operation that failed.\n"
+                  "# TYPE task_operation_failures_total counter\n");
+    for (int op = 0; op < STAT_OPERATIONS; op++) {
+        fprintf(file, "task_operation_failures_total{op=\"%s\"} %llu\n", statOperationNames[op],
+                (unsigned long long)stats->failures[op]);
+    }
+    fprintf(file, "# HELP task_operation_seconds Latency of the timed calls; push, pop, peek, edit, insert, remove "
+                  "and request are timed on one call in %d.\n"
+                  "# TYPE task_operation_seconds histogram\n", STAT_SAMPLE_EVERY);
+    for (int op = 0; op < STAT_OPERATIONS; op++) {
+        uint64_t cumulative = 0;
+        int bucket = 0;
+        for (int i = 0; i < (int)(sizeof(bounds) / sizeof(bounds[0])); i++) {
+            while (bucket < STAT_BUCKETS && bucketLimit(bucket) <= bounds[i] * 1e9) {
+                cumulative += stats->histogram[op][bucket++];
+            }
+            fprintf(file, "task_operation_seconds_bucket{op=\"%s\",le=\"%g\"} %llu\n", statOperationNames[op],
+                    bounds[i], (unsigned long long)cumulative);
+        }
+        fprintf(file, "task_operation_seconds_bucket{op=\"%s\",le=\"+Inf\"} %llu\n", statOperationNames[op],
+                (unsigned long long)stats->timed[op]);
+        fprintf(file, "task_operation_seconds_sum{op=\"%s\"} %.9f\n", statOperationNames[op],
+                stats->timedNanos[op] / 1e9);
+        fprintf(file, "task_operation_seconds_count{op=\"%s\"} %llu\n", statOperationNames[op],
+                (unsigned long long)stats->timed[op]);
+    }
+    
+    fprintf(file, "# HELP task_string_pool_bytes Bytes of the string pool holding text, free slots excluded.\n"
+                  "# TYPE task_string_pool_bytes gauge\n"
+                  "task_string_pool_bytes %llu\n"
+                  "# HELP task_stats_threads Live threads that have made a measured call.\n"
+                  "# TYPE task_stats_threads gauge\n"
+                  "task_stats_threads %d\n", (unsigned long long)poolBytes(), stats->threads);
+    if (stack != NULL) {
+        fprintf(file, "# HELP task_stack_size Tasks on the stack.\n"
+                      "# TYPE task_stack_size gauge\n"
+                      "task_stack_size %d\n"
+                      "# HELP task_undo_depth Steps that can be undone.\n"
+                      "# TYPE task_undo_depth gauge\n"
+                      "task_undo_depth %d\n"
+                      "# HELP task_redo_depth Steps that can be redone.\n"
+                      "# TYPE task_redo_depth gauge\n"
+                      "task_redo_depth %d\n", getStackSize(stack),
+                stack->undo != NULL ? stack->undo->undoCount : 0, stack->undo != NULL ? stack->undo->redoCount : 0);
+    }
+    
+    bool ok = !ferror(file);
+    ok = fclose(file) == 0 && ok && rename(temporary, path) == 0;
+    if (!ok) {
+        remove(temporary);
+    }
+    free(stats);
+    return ok;
+}
+
+ 
+/* Makes refreshStatsFile rewrite `path` every intervalMs milliseconds; a
+   NULL path stops it. The first refresh writes at once. */
+void setStatsFile(const char* path, int intervalMs) {
+    snprintf(statsFile.path, sizeof(statsFile.path), "%s", path != NULL ? path : "");
+    statsFile.intervalNanos = intervalMs * 1000000LL;
+    statsFile.writtenAt = monotonicNanos() - statsFile.intervalNanos;
+}
+
+ 
+/* Rewrites the stats file if its interval has passed since the last write,
+   or at once when `force` is set. Returns the milliseconds until the next
+   write is due, or -1 when there is no stats file. Call it from one
+   thread. */
+int refreshStatsFile(const TaskStack* stack, bool force) {
+    if (statsFile.path[0] == '\0') {
+        return -1;
+    }
+    int64_t now = monotonicNanos();
+    if (force || now - statsFile.writtenAt >= statsFile.intervalNanos) {
+        writeStatsFile(statsFile.path, stack);
+        statsFile.writtenAt = now;
+    }
+    return (int)((statsFile.writtenAt + statsFile.intervalNanos - now + 999999) / 1000000);
+}
@@ -0,0 +1,832 @@
+#ifndef TASK_MANAGEMENT_STACKS_H
+#define TASK_MANAGEMENT_STACKS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdarg.h>
+
+#define MAX_TASKS (INT_MAX - TASK_CHUNK_SIZE)
+#define UNDO_BUDGET (1 << 20)
+#define MAX_DESCRIPTION_LENGTH 1023
+#define MAX_DESCRIPTION (MAX_DESCRIPTION_LENGTH + 1)
+#define LEGACY_DESCRIPTION 100
+#define TASK_CHUNK_SHIFT 10
+#define TASK_CHUNK_SIZE (1 << TASK_CHUNK_SHIFT)
+#define TASK_CHUNK_MASK (TASK_CHUNK_SIZE - 1)
+#define TASK_CHUNK_WORDS (TASK_CHUNK_SIZE / 64)
+#define DUE_LABEL_SIZE 20
+#define MAX_TOKEN_LENGTH 32
+#define MAX_SORT_KEYS 3
+#define MAX_SORT_THREADS 64
+#define PARALLEL_SORT_THRESHOLD 65536
+#define STRING_POOL_PADDING 32
+#define STRING_BLOCK_SHIFT 20
+#define STRING_BLOCK_SIZE (1 << STRING_BLOCK_SHIFT)
+#define STRING_MAX_BLOCKS 4096
+#define STRING_HEADER_SIZE 8
+#define STRING_SLOT_CLASSES ((STRING_HEADER_SIZE + MAX_DESCRIPTION + 7) / 8 + 1)
+#define STRING_RECLAIM_BYTES (1 << 20)
+#define ALL_STATUSES 0x7u
+#define FILENAME "tasks.dat"
+#define SNAPSHOT_MAGIC "TASKSNAP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER_SIZE 64
+#define SNAPSHOT_RECORD_SIZE 32
+#define HEAP_ARITY 4
+#define CONCURRENT_BLOCK_SHIFT 12
+#define CONCURRENT_BLOCK_SIZE (1 << CONCURRENT_BLOCK_SHIFT)
+#define CONCURRENT_MAX_BLOCKS 4096
+#define MAX_EXECUTOR_WORKERS 64
+#define MAX_TASK_HANDLERS 16
+#define DUE_LEAF_SIZE 256
+#define IMPORT_FIELDS 5
+#define IMPORT_REQUIRED_FIELDS 4
+#define IMPORT_BATCH_SIZE TASK_CHUNK_SIZE
+#define EXPORT_BUFFER_SIZE (1 << 16)
+#define EXPORT_ROW_LIMIT (6 * MAX_DESCRIPTION + 256)
+#define WAL_FILENAME "tasks.wal"
+#define WAL_BUFFER_SIZE 65536
+#define WAL_RECORD_HEADER 17
+#define WAL_GROUP_RECORDS 64
+#define WAL_GROUP_WINDOW_MS 5
+#define WAL_CHECKPOINT_BYTES (16 << 20)
+#define WAL_CHECKPOINT_RETRY_MS 1000
+#define WAL_CHECKPOINT_RETRY_MAX_MS 60000
+#define SERVER_MAX_EVENTS 64
+#define SERVER_READ_SIZE 65536
+#define SERVER_REQUEST_LIMIT (4 * MAX_DESCRIPTION)
+#define SERVER_OUTPUT_LIMIT (1 << 22)
+#define NAMESPACE_DIRECTORY "stacks"
+#define NAMESPACE_SHARDS 16
+#define NAMESPACE_SHARD_SHIFT 28
+#define MAX_STACK_NAME 64
+#define MAX_NAMESPACE_PATH 512
+#define STAT_BUCKETS 320
+#define STAT_SAMPLE_EVERY 64
+#define STATS_FILENAME "tasks.prom"
+#define STATS_FILE_INTERVAL_MS 10000
+#define TASK_PAGE_ROWS 20
+#define FRAME_FLUSH_BYTES (1 << 16)
+#define SORTED_VIEW_REBUILD_RATIO 8
+#define TASK_ROW_FORMAT "| %2d | %-30s | %-17s | %10d | %-11s |\n"
+
+#define DUE_KEY(year, month, day) ((year) * 10000 + (month) * 100 + (day))
+#define DUE_YEAR(key) ((key) / 10000)
+#define DUE_MONTH(key) ((key) / 100 % 100)
+#define DUE_DAY(key) ((key) % 100)
+
+ 
+typedef enum {
+    PENDING = 0,
+    IN_PROGRESS = 1,
+    COMPLETED = 2
+} TaskStatus;
+
+ 
+/* The description is a handle into the string pool; read it with
+   getTaskDescription and set it with setTaskDescription. */
+typedef struct {
+    uint32_t description;
+    uint16_t descriptionLength;
+    int dueKey;
+    char dueLabel[DUE_LABEL_SIZE];
+    int importance;
+    TaskStatus status;
+    uint32_t id;
+    time_t createdAt;
+} Task;
+
+ 
+typedef enum {
+    SNAPSHOT_INVALID = 0,
+    SNAPSHOT_VERSIONED = 1,
+    SNAPSHOT_LEGACY_BASELINE = 2,
+    SNAPSHOT_LEGACY_RAW = 3
+} SnapshotFormat;
+
+ 
+typedef enum {
+    TASK_FILE_CSV = 0,
+    TASK_FILE_JSONL = 1
+} TaskFileFormat;
+
+ 
+/* A field of an import file, still in the mapped input. `escaped` marks
+   text that holds CSV doubled quotes or JSON escapes. */
+typedef struct {
+    const char* text;
+    size_t length;
+    bool escaped;
+} ImportField;
+
+ 
+/* A tasks.dat file mapped read-only. Versioned files hold a 64-byte header
+   (magic, version, sizes, CRC-32 and the task count), 32-byte little-endian
+   records and a section of NUL-terminated descriptions that the records
+   address by offset; tasks are decoded straight from the mapping. */
+typedef struct {
+    const unsigned char* map;
+    size_t mapSize;
+    SnapshotFormat format;
+    int count;
+    uint32_t crc;
+    uint64_t lsn;
+    const unsigned char* records;
+    const unsigned char* strings;
+    size_t stringsSize;
+} TaskSnapshot;
+
+ 
+typedef enum {
+    WAL_PUSH = 1,
+    WAL_POP = 2,
+    WAL_EDIT = 3,
+    WAL_REMOVE = 4,
+    WAL_SORT = 5,
+    WAL_INSERT = 6,
+    WAL_REORDER = 7,
+    WAL_PUSH_BATCH = 8
+} WalRecordType;
+
+ 
+typedef enum {
+    UNDO_PUSH = 1,
+    UNDO_POP = 2,
+    UNDO_REMOVE = 3,
+    UNDO_INSERT = 4,
+    UNDO_EDIT = 5,
+    UNDO_PERMUTE = 6
+} UndoKind;
+
+ 
+typedef enum {
+    EDIT_DESCRIPTION = 1,
+    EDIT_DUE_DATE = 2,
+    EDIT_IMPORTANCE = 4,
+    EDIT_STATUS = 8
+} EditField;
+
+ 
+/* Undo/redo journal. Each entry holds just enough to invert one operation
+   (the task for a push, pop, remove or insert, the changed fields of an
+   edit, the permutation of a sort) in a ring buffer of `capacity` bytes.
+   Positions only grow; entries [start, cursor) can be undone and
+   [cursor, end) redone. */
+typedef struct {
+    unsigned char* ring;
+    size_t capacity;
+    uint64_t start;
+    uint64_t cursor;
+    uint64_t end;
+    int undoCount;
+    int redoCount;
+} UndoStack;
+
+ 
+/* Append-only log of stack operations. Records collect in the buffer and
+   reach the disk in batches with a single fsync (group commit); saving
+   tasks.dat checkpoints the stack and empties the log. After a failed
+   write or sync the log is marked failed and takes no more records until
+   that checkpoint; operations still apply to the stack, so a caller that
+   needs them kept checks `failed` and saves. A log past checkpointBytes,
+   or a failed one, is marked checkpointDue for checkpointWriteAheadLog. */
+typedef struct {
+    int fd;
+    unsigned char buffer[WAL_BUFFER_SIZE];
+    size_t used;
+    int pendingRecords;
+    int64_t pendingSince;
+    off_t fileSize;
+    off_t syncedSize;
+    int groupRecords;
+    int64_t groupWindowNanos;
+    off_t checkpointBytes;
+    bool checkpointDue;
+    int64_t checkpointRetryAt;
+    int64_t checkpointRetryNanos;
+    uint64_t syncs;
+    bool failed;
+} WriteAheadLog;
+
+ 
+typedef struct {
+    uint32_t* ids;
+    int count;
+    int capacity;
+} PostingList;
+
+ 
+typedef struct {
+    char* token;
+    uint32_t hash;
+    PostingList postings;
+} IndexEntry;
+
+ 
+/* Inverted index from lowercase description tokens to sorted lists of task
+   ids. The sorted token table used for prefix queries is rebuilt lazily. */
+typedef struct {
+    IndexEntry* entries;
+    int capacity;
+    int used;
+    IndexEntry** sortedEntries;
+    int sortedCount;
+    bool sortedDirty;
+} KeywordIndex;
+
+ 
+typedef enum {
+    SEARCH_KEYWORDS = 0,
+    SEARCH_SUBSTRING = 1,
+    SEARCH_SUBSTRING_IGNORE_CASE = 2
+} SearchMode;
+
+ 
+typedef enum {
+    SCAN_SCALAR = 0,
+    SCAN_SSE2 = 1,
+    SCAN_AVX2 = 2
+} SubstringScanLevel;
+
+ 
+/* A needle prepared for the first/last-byte filter; with ignoreCase the
+   needle is lowercased and both cases of each filter byte are tested. */
+typedef struct {
+    char needle[MAX_DESCRIPTION];
+    size_t length;
+    bool ignoreCase;
+    char firstLower, firstUpper;
+    char lastLower, lastUpper;
+} SubstringMatcher;
+
+ 
+typedef struct {
+    Task tasks[TASK_CHUNK_SIZE];
+    uint64_t live[TASK_CHUNK_WORDS];
+    int liveCount;
+    atomic_int refs;
+    uint64_t generation;
+} TaskChunk;
+
+ 
+/* The chunk pointers and the Fenwick tree over their live counts, in one
+   block that open views share with the stack. refs counts the stack and
+   the views holding the table; a chunk's refs counts the tables holding
+   the chunk. */
+typedef struct {
+    atomic_int refs;
+    int count;
+    int* liveTree;
+    TaskChunk* chunks[];
+} ChunkTable;
+
+ 
+/* Column-wise copy of the hot Task fields, indexed by physical slot, for
+   filters that would otherwise drag every description through the cache.
+   Descriptions are packed NUL-terminated into one pool; an edit leaves the
+   old text behind as garbage until the pool is repacked. */
+typedef struct {
+    int32_t* importance;
+    uint8_t* status;
+    int32_t* dueKey;
+    int64_t* createdAt;
+    uint32_t* descriptionOffset;
+    int capacity;
+    char* pool;
+    size_t poolUsed;
+    size_t poolCapacity;
+    size_t poolGarbage;
+} TaskColumns;
+
+ 
+typedef struct {
+    int32_t importance;
+    int32_t dueKey;
+    int64_t createdAt;
+    uint32_t id;
+} HeapEntry;
+
+ 
+/* Indexed 4-ary heap of the unfinished tasks, most important first. Each
+   entry carries its own key, so sifting never touches the tasks, and
+   `positions` maps a task id to its entry (or -1). */
+typedef struct {
+    HeapEntry* entries;
+    int count;
+    int capacity;
+    int* positions;
+    uint32_t positionCapacity;
+} TaskHeap;
+
+ 
+typedef struct {
+    int32_t dueKey;
+    uint32_t id;
+} DueEntry;
+
+ 
+typedef struct {
+    int count;
+    DueEntry entries[DUE_LEAF_SIZE];
+} DueLeaf;
+
+ 
+typedef struct {
+    int32_t monthKey;
+    int count;
+} DueMonth;
+
+ 
+/* Ordered index on (due-date key, task id): a two-level B+-tree whose
+   sorted leaf blocks are found by binary search over `lows`, the first
+   entry of each leaf. `months` keeps the number of tasks due in each month,
+   in month order. */
+typedef struct {
+    DueLeaf** leaves;
+    DueEntry* lows;
+    int leafCount;
+    int leafCapacity;
+    int count;
+    DueMonth* months;
+    int monthCount;
+    int monthCapacity;
+} DueIndex;
+
+ 
+typedef struct {
+    const DueIndex* index;
+    int leaf;
+    int position;
+    int toKey;
+} DueCursor;
+
+ 
+typedef struct {
+    Task task;
+    _Atomic uint32_t next;
+} TaskNode;
+
+ 
+/* Lock-free (Treiber) stack of tasks for producer and worker threads. Nodes
+   come from a pool of fixed-size blocks and are addressed by 32-bit
+   references, so a list head and its ABA tag fit in one 64-bit word.
+   Popped nodes go to a free list and are never handed back to malloc. */
+typedef struct {
+    _Atomic uint64_t head;
+    _Atomic uint64_t freeNodes;
+    _Atomic uint32_t allocated;
+    atomic_int size;
+    _Atomic(TaskNode*) blocks[CONCURRENT_MAX_BLOCKS];
+    pthread_mutex_t growLock;
+} ConcurrentTaskStack;
+
+ 
+/* Runs one task; returning false leaves it PENDING. The task must be
+   treated as read-only, since its status belongs to the executor. */
+typedef bool (*TaskHandler)(const Task* task, void* context);
+
+ 
+typedef struct {
+    const char* keyword;
+    TaskHandler handler;
+    void* context;
+} TaskHandlerEntry;
+
+ 
+typedef struct {
+    uint64_t executed;
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t unhandled;
+    uint64_t uncommitted;
+    uint64_t steals;
+    uint64_t stealAttempts;
+    double seconds;
+} ExecutorStats;
+
+ 
+/* Pool of worker threads that runs PENDING tasks through handlers picked
+   by keyword, balancing the load by work stealing. `stats` covers the
+   last run; workerStats breaks it down per worker. */
+typedef struct {
+    TaskHandlerEntry handlers[MAX_TASK_HANDLERS];
+    int handlerCount;
+    int workerCount;
+    bool stealing;
+    ExecutorStats stats;
+    ExecutorStats workerStats[MAX_EXECUTOR_WORKERS];
+} TaskExecutor;
+
+ 
+/* Inclusive importance and due-date ranges plus a bit per accepted status;
+   initializeTaskFilter sets every bound wide open. */
+typedef struct {
+    int minImportance;
+    int maxImportance;
+    unsigned statusMask;
+    int fromDueKey;
+    int toDueKey;
+} TaskFilter;
+
+ 
+/* Tasks live in fixed-size chunks that are never moved once allocated.
+   Still, a pointer returned by getTaskAtIndex is only good until the next
+   change to the stack: removals and compaction move tasks, and after
+   openStackView (a background save opens one) the first change to a chunk
+   swaps in a private copy, leaving the pointer on the view's chunk, which
+   is freed with the view. Copy the task out before changing the stack.
+   Removing a task below the top only clears its live bit; slots are
+   indexed through a Fenwick tree over per-chunk live counts and the dead
+   ones are squeezed out by compactStack once they outnumber the live
+   tasks. chunks and liveTree point into table, which openStackView shares
+   copy-on-write; a chunk whose generation is the stack's has been copied
+   since the last view was opened and is written in place. path names the
+   stack's snapshot file when it is not tasks.dat. */
+typedef struct {
+    ChunkTable* table;
+    TaskChunk** chunks;
+    int* liveTree;
+    int chunkCount;
+    int chunkCapacity;
+    int top;   
+    int size;
+    int tombstones;
+    int* idSlots;
+    uint32_t nextId;
+    uint32_t idCapacity;
+    KeywordIndex* keywordIndex;
+    TaskColumns* columns;
+    TaskHeap* heap;
+    DueIndex* dueIndex;
+    struct SortedView* sortedViews;
+    WriteAheadLog* wal;
+    UndoStack* undo;
+    const char* path;
+    uint64_t lsn;
+    uint64_t generation;
+} TaskStack;
+
+ 
+typedef struct {
+    const TaskStack* stack;
+    int slot;
+    int index;
+} TaskCursor;
+
+ 
+typedef enum {
+    SORT_BY_IMPORTANCE = 0,
+    SORT_BY_DUE_DATE = 1,
+    SORT_BY_CREATED_AT = 2
+} TaskSortField;
+
+ 
+typedef struct {
+    TaskSortField field;
+    bool descending;
+} TaskSortKey;
+
+ 
+/* A task's sort keys, descending ones bit-inverted and unused ones zero,
+   and its id, which breaks ties in favour of the older task. */
+typedef struct {
+    int64_t key[MAX_SORT_KEYS];
+    uint32_t id;
+} SortedEntry;
+
+ 
+/* The stack's tasks in key order, kept beside the stack so a sorted
+   listing leaves the LIFO order alone. Attached views are told the id of
+   every task pushed, removed or re-keyed, and only note it in `changed`.
+   The next read drops the noted entries, sorts their replacements and
+   merges them in, in O(n + k log k) for k changes. A view that is never
+   read costs one check per change: past 1/SORTED_VIEW_REBUILD_RATIO of
+   its entries, or when task ids are renumbered, it is marked stale
+   instead, and the next read rebuilds it from scratch. `marks` flags the
+   ids already in `changed`. */
+typedef struct SortedView {
+    TaskSortKey keys[MAX_SORT_KEYS];
+    int keyCount;
+    SortedEntry* entries;
+    int count;
+    int capacity;
+    uint32_t* changed;
+    int changedCount;
+    int changedCapacity;
+    uint8_t* marks;
+    uint32_t markCapacity;
+    bool stale;
+    uint64_t merges;
+    uint64_t rebuilds;
+    struct SortedView* next;
+} SortedView;
+
+ 
+/* One client of the task server: bytes read but not yet run as requests,
+   and replies not yet written. While `writing`, the socket waits for
+   EPOLLOUT and no more requests are read. */
+typedef struct {
+    int fd;
+    int slot;
+    char* input;
+    size_t inputLength;
+    size_t inputCapacity;
+    char* output;
+    size_t outputLength;
+    size_t outputSent;
+    size_t outputCapacity;
+    bool writing;
+    bool closing;
+} ServerConnection;
+
+ 
+/* Serves one stack to many clients from a single thread with an epoll
+   loop. Each wake-up runs every complete request line that arrived, makes
+   the changes durable with one log sync, and then sends each client all
+   of its replies with one write. */
+typedef struct {
+    int listener;
+    int epoll;
+    int wake;
+    int port;
+    char unixPath[108];
+    ServerConnection** connections;
+    int connectionCount;
+    int connectionCapacity;
+    atomic_bool stopping;
+    uint64_t requests;
+    uint64_t rounds;
+} TaskServer;
+
+ 
+/* A stack in a TaskNamespace, with its own undo journal and keyword index.
+   In a namespace with a directory it also has its own NAME.dat and, when
+   the log could be opened, NAME.wal. */
+typedef struct {
+    char name[MAX_STACK_NAME];
+    uint32_t hash;
+    TaskStack stack;
+    UndoStack undo;
+    KeywordIndex keywordIndex;
+    WriteAheadLog* wal;
+    char dataPath[MAX_NAMESPACE_PATH];
+} NamedStack;
+
+ 
+/* One lock and an open-addressing table of the stacks whose name hashes
+   here; the alignment keeps neighbouring locks off each other's cache
+   line. */
+typedef struct {
+    _Alignas(64) pthread_mutex_t lock;
+    NamedStack** stacks;
+    int count;
+    int capacity;
+} NamespaceShard;
+
+ 
+/* Named stacks, hash-partitioned over NAMESPACE_SHARDS independently
+   locked shards, so threads working on stacks in different shards never
+   wait for each other. An empty directory keeps every stack in memory. */
+typedef struct {
+    NamespaceShard shards[NAMESPACE_SHARDS];
+    char directory[MAX_NAMESPACE_PATH - MAX_STACK_NAME - 8];
+} TaskNamespace;
+
+ 
+/* One hit of a namespace-wide search: the stack's name, the task's ID
+   there minus one, and a copy of the task. The copy holds its own
+   reference on the description, so both stay valid if the stack changes
+   or is dropped, until freeNamespaceMatches. */
+typedef struct {
+    char stackName[MAX_STACK_NAME];
+    int index;
+    Task task;
+} NamespaceMatch;
+
+ 
+/* Operations the stats count and time. Those before STAT_PUSH_BULK are
+   cheap and timed on one call in STAT_SAMPLE_EVERY; the rest are timed on
+   every call. */
+typedef enum {
+    STAT_PUSH,
+    STAT_POP,
+    STAT_PEEK,
+    STAT_EDIT,
+    STAT_INSERT,
+    STAT_REMOVE,
+    STAT_REQUEST,
+    STAT_PUSH_BULK,
+    STAT_SORT,
+    STAT_REORDER,
+    STAT_UNDO,
+    STAT_REDO,
+    STAT_SEARCH_INDEX,
+    STAT_SEARCH_SCAN,
+    STAT_SAVE,
+    STAT_LOAD,
+    STAT_IMPORT,
+    STAT_EXPORT,
+    STAT_WAL_SYNC,
+    STAT_OPERATIONS
+} StatOperation;
+
+ 
+/* Every thread's stats added up. Per operation: the calls, the calls that
+   failed, and the latencies of the timed calls in a log-linear histogram.
+   Bucket b < 16 holds b nanoseconds; above that each power of two is split
+   into 8 buckets, so a latency is known to within 12.5%. */
+typedef struct {
+    uint64_t calls[STAT_OPERATIONS];
+    uint64_t failures[STAT_OPERATIONS];
+    uint64_t timed[STAT_OPERATIONS];
+    uint64_t timedNanos[STAT_OPERATIONS];
+    uint64_t histogram[STAT_OPERATIONS][STAT_BUCKETS];
+    int threads;
+} TaskStats;
+
+ 
+/* A screen built in memory and written to fd with one write, so the
+   terminal never shows half of it. After an allocation fails, appends are
+   dropped and the flush reports the failure. */
+typedef struct {
+    int fd;
+    char* data;
+    size_t length;
+    size_t capacity;
+    bool failed;
+} TerminalFrame;
+
+ 
+extern const char* monthNames[];
+extern const char* statusNames[];
+extern const char* statusTokens[];
+extern const char* importFieldNames[IMPORT_FIELDS];
+extern const char* statOperationNames[STAT_OPERATIONS];
+
+ 
+void initializeStack(TaskStack* stack);
+void resetStack(TaskStack* stack);
+void compactStack(TaskStack* stack);
+void openStackView(TaskStack* stack, TaskStack* view);
+void closeStackView(TaskStack* view);
+void initializeUndoStack(UndoStack* journal, size_t budget);
+void freeUndoStack(UndoStack* journal);
+void clearUndoStack(UndoStack* journal);
+void attachUndoStack(TaskStack* stack, UndoStack* journal);
+bool pushTask(TaskStack* stack, Task task);
+bool pushTasks(TaskStack* stack, const Task* tasks, int count);
+bool popTask(TaskStack* stack, Task* task);
+bool peekTask(TaskStack* stack, Task* task);
+bool isEmptyStack(const TaskStack* stack);
+bool isFullStack(const TaskStack* stack);
+bool isValidDate(int year, int month, int day);
+bool setTaskDueDate(Task* task, int year, int month, int day);
+const char* getTaskDescription(const Task* task);
+bool setTaskDescription(Task* task, const char* text);
+void setStringInterning(bool enabled);
+int displayTasksDueBetween(const TaskStack* stack, int fromKey, int toKey);
+void initializeTaskFilter(TaskFilter* filter);
+bool taskMatchesFilter(const Task* task, const TaskFilter* filter);
+int countMatchingTasks(const TaskStack* stack, const TaskFilter* filter);
+int displayFilteredTasks(const TaskStack* stack, const TaskFilter* filter);
+void clearInputBuffer();
+bool saveStackToFile(const TaskStack* stack);
+bool saveStackInBackground(TaskStack* stack);
+bool finishBackgroundSave(bool wait);
+bool loadStackFromFile(TaskStack* stack);
+bool saveStackToPath(const TaskStack* stack, const char* path);
+bool loadStackFromPath(TaskStack* stack, const char* path);
+bool writeTaskSnapshot(const TaskStack* stack, const char* path);
+bool openTaskSnapshot(TaskSnapshot* snapshot, const char* path);
+void closeTaskSnapshot(TaskSnapshot* snapshot);
+bool verifyTaskSnapshot(const TaskSnapshot* snapshot);
+const char* getSnapshotDescription(const TaskSnapshot* snapshot, int index, size_t* length);
+bool readSnapshotTask(const TaskSnapshot* snapshot, int index, Task* task);
+TaskFileFormat taskFileFormatForPath(const char* path);
+int importTasksFromFile(TaskStack* stack, const char* path, TaskFileFormat format, int* rejected);
+int exportTasksToFile(const TaskStack* stack, const char* path, TaskFileFormat format);
+void initializeWriteAheadLog(WriteAheadLog* wal);
+bool openWriteAheadLog(WriteAheadLog* wal, const char* path);
+bool syncWriteAheadLog(WriteAheadLog* wal);
+void closeWriteAheadLog(WriteAheadLog* wal);
+bool checkpointWriteAheadLog(TaskStack* stack);
+void attachWriteAheadLog(TaskStack* stack, WriteAheadLog* wal);
+int replayWriteAheadLog(TaskStack* stack, WriteAheadLog* wal);
+void displayTask(const Task* task, int index);
+void displayAllTasks(const TaskStack* stack);
+int displayMatchingTasks(const TaskStack* stack, const char* keyword, bool ignoreCase);
+void prepareSubstringMatcher(SubstringMatcher* matcher, const char* needle, bool ignoreCase);
+bool matchSubstring(const SubstringMatcher* matcher, const char* text, size_t readable);
+SubstringScanLevel detectSubstringScanLevel();
+void setSubstringScanLevel(SubstringScanLevel level);
+void searchTasks(const TaskStack* stack, const char* query, SearchMode mode);
+void initializeKeywordIndex(KeywordIndex* index);
+void clearKeywordIndex(KeywordIndex* index);
+void freeKeywordIndex(KeywordIndex* index);
+void attachKeywordIndex(TaskStack* stack, KeywordIndex* index);
+int queryKeywordIndex(KeywordIndex* index, const char* query, uint32_t** results);
+int displayIndexedMatches(const TaskStack* stack, const char* query);
+void initializeTaskColumns(TaskColumns* columns);
+void freeTaskColumns(TaskColumns* columns);
+void attachTaskColumns(TaskStack* stack, TaskColumns* columns);
+void detachTaskColumns(TaskStack* stack);
+void initializeTaskHeap(TaskHeap* heap);
+void freeTaskHeap(TaskHeap* heap);
+void clearTaskHeap(TaskHeap* heap);
+void attachTaskHeap(TaskStack* stack, TaskHeap* heap);
+void detachTaskHeap(TaskStack* stack);
+bool peekPriorityTask(const TaskStack* stack, Task* task, int* index);
+bool popPriorityTask(TaskStack* stack, Task* task);
+void initializeDueIndex(DueIndex* index);
+void freeDueIndex(DueIndex* index);
+void clearDueIndex(DueIndex* index);
+void attachDueIndex(TaskStack* stack, DueIndex* index);
+void detachDueIndex(TaskStack* stack);
+int countTasksDueBetween(const TaskStack* stack, int fromKey, int toKey);
+int displayOverdueTasks(const TaskStack* stack, int todayKey);
+int displayDueCalendar(const TaskStack* stack);
+int dueKeyForDay(time_t now, int days);
+void drawUIHeader();
+void drawUIFooter();
+void drawLine(int width);
+void initializeTerminalFrame(TerminalFrame* frame, int fd);
+void freeTerminalFrame(TerminalFrame* frame);
+bool appendFrameText(TerminalFrame* frame, const char* text, size_t length);
+bool appendFrameFormat(TerminalFrame* frame, const char* format, ...) __attribute__((format(printf, 2, 3)));
+void appendFrameHeader(TerminalFrame* frame);
+void appendFrameLine(TerminalFrame* frame, int width);
+void appendFrameTask(TerminalFrame* frame, const Task* task, int index);
+bool flushTerminalFrame(TerminalFrame* frame);
+int renderTaskPage(TerminalFrame* frame, const TaskStack* stack, int first, int rows);
+int visibleTaskRows();
+int displayTaskPage(const TaskStack* stack, int first, int rows);
+void browseTasks(const TaskStack* stack, const char* title);
+void browseSortedView(const TaskStack* stack, SortedView* view, const char* title);
+int renderSortedPage(TerminalFrame* frame, const TaskStack* stack, SortedView* view, int first, int rows);
+Task* getTaskAtIndex(TaskStack* stack, int index);
+int getStackSize(const TaskStack* stack);
+void initializeConcurrentStack(ConcurrentTaskStack* stack);
+void freeConcurrentStack(ConcurrentTaskStack* stack);
+bool pushConcurrentTask(ConcurrentTaskStack* stack, Task task);
+bool popConcurrentTask(ConcurrentTaskStack* stack, Task* task);
+bool peekConcurrentTask(ConcurrentTaskStack* stack, Task* task);
+int getConcurrentStackSize(const ConcurrentTaskStack* stack);
+int drainConcurrentStack(ConcurrentTaskStack* source, TaskStack* stack);
+void initializeTaskExecutor(TaskExecutor* executor, int workerCount);
+bool registerTaskHandler(TaskExecutor* executor, const char* keyword, TaskHandler handler, void* context);
+int runTaskExecutor(TaskExecutor* executor, TaskStack* stack);
+void openTaskCursor(TaskCursor* cursor, const TaskStack* stack);
+const Task* nextTaskFromCursor(TaskCursor* cursor);
+void seekTaskCursor(TaskCursor* cursor, int index);
+bool removeTaskAtIndex(TaskStack* stack, int index);
+bool editTaskAtIndex(TaskStack* stack, int index, Task newTask);
+bool insertTaskAtIndex(TaskStack* stack, int index, Task task);
+bool reorderStack(TaskStack* stack, const int* order);
+bool sortStack(TaskStack* stack, const TaskSortKey* keys, int keyCount);
+void sortStackByDate(TaskStack* stack);
+void sortStackByImportance(TaskStack* stack);
+int parseSortKeys(const char* spec, TaskSortKey* keys);
+void initializeSortedView(SortedView* view, const TaskSortKey* keys, int keyCount);
+void freeSortedView(SortedView* view);
+void attachSortedView(TaskStack* stack, SortedView* view);
+void detachSortedView(TaskStack* stack, SortedView* view);
+bool refreshSortedView(const TaskStack* stack, SortedView* view);
+const Task* getSortedTask(const TaskStack* stack, const SortedView* view, int rank, int* index);
+int displaySortedView(const TaskStack* stack, SortedView* view);
+int selectTopTasks(const TaskStack* stack, const TaskSortKey* keys, int keyCount, const TaskFilter* filter, int k,
+                   int* indices);
+int displayTopTasks(const TaskStack* stack, const TaskSortKey* keys, int keyCount, const TaskFilter* filter, int k);
+bool undoLastOperation(TaskStack* stack, UndoStack* journal);
+bool redoLastOperation(TaskStack* stack, UndoStack* journal);
+bool runBatchCommand(TaskStack* stack, char* line);
+int runBatchFile(TaskStack* stack, FILE* input);
+bool openTaskServer(TaskServer* server, const char* address);
+int runTaskServer(TaskServer* server, TaskStack* stack);
+void stopTaskServer(TaskServer* server);
+void closeTaskServer(TaskServer* server);
+bool initializeTaskNamespace(TaskNamespace* space, const char* directory);
+void freeTaskNamespace(TaskNamespace* space);
+NamedStack* lockNamedStack(TaskNamespace* space, const char* name, bool create);
+void unlockNamedStack(TaskNamespace* space, NamedStack* named);
+bool dropNamedStack(TaskNamespace* space, const char* name);
+int countNamedStacks(TaskNamespace* space);
+int loadTaskNamespace(TaskNamespace* space);
+int saveTaskNamespace(TaskNamespace* space);
+int searchTaskNamespace(TaskNamespace* space, const char* query, NamespaceMatch** matches);
+void freeNamespaceMatches(NamespaceMatch* matches, int count);
+void setStatsEnabled(bool enabled);
+void collectStats(TaskStats* stats);
+uint64_t statPercentile(const TaskStats* stats, StatOperation operation, double percentile);
+int displayStats(const TaskStack* stack);
+bool writeStatsFile(const char* path, const TaskStack* stack);
+void setStatsFile(const char* path, int intervalMs);
+int refreshStatsFile(const TaskStack* stack, bool force);
+
+#endif
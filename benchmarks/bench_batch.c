@@ -0,0 +1,99 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* Adds, edits and removes in a 6:2:2 ratio, one command per line; half of
+   the removes take the top task. Nothing in the script prints. */
+static FILE* writeScript(int commands) {
+    const char* statuses[] = { "pending", "in-progress", "completed" };
+    FILE* script = tmpfile();
+    int size = 0;
+    unsigned seed = 12345;
+    
+    for (int i = 0; i < commands; i++) {
+        seed = seed * 1103515245 + 12345;
+        int kind = i % 10;
+        if (kind < 6 || size < 2) {
+            fprintf(script, "add %d-%02d-%02d %u %s Scripted task %d for the batch benchmark\n",
+                    2024 + (int)(seed >> 8) % 3, 1 + (int)(seed >> 12) % 12, 1 + (int)(seed >> 16) % 28,
+                    1 + (seed >> 20) % 10, statuses[(seed >> 4) % 3], i);
+            size++;
+        } else if (kind < 8) {
+            fprintf(script, "edit %u importance %u status %s\n", 1 + (seed >> 8) % size,
+                    1 + (seed >> 20) % 10, statuses[(seed >> 4) % 3]);
+        } else if (kind == 8) {
+            fprintf(script, "remove %u\n", 1 + (seed >> 8) % size);
+            size--;
+        } else {
+            fprintf(script, "remove %d\n", size);
+            size--;
+        }
+    }
+    return script;
+}
+
+ 
+static void runScript(const char* label, FILE* script, int commands, bool attached, bool logged) {
+    static WriteAheadLog wal;
+    TaskStack stack;
+    KeywordIndex index;
+    TaskColumns columns;
+    UndoStack journal;
+    
+    remove(WAL_FILENAME);
+    initializeStack(&stack);
+    if (attached) {
+        initializeKeywordIndex(&index);
+        attachKeywordIndex(&stack, &index);
+        initializeTaskColumns(&columns);
+        attachTaskColumns(&stack, &columns);
+        initializeUndoStack(&journal, UNDO_BUDGET);
+        attachUndoStack(&stack, &journal);
+    }
+    if (logged && openWriteAheadLog(&wal, WAL_FILENAME)) {
+        attachWriteAheadLog(&stack, &wal);
+    }
+    
+    rewind(script);
+    double start = nowSeconds();
+    int failed = runBatchFile(&stack, script);
+    if (logged) {
+        closeWriteAheadLog(&wal);
+    }
+    double elapsed = nowSeconds() - start;
+    
+    printf("%-36s %8.0f commands/s  %6.2f us/command  (%d tasks left, %d failed)\n", label,
+           commands / elapsed, elapsed * 1e6 / commands, getStackSize(&stack), failed);
+    
+    if (attached) {
+        stack.undo = NULL;
+        freeUndoStack(&journal);
+        freeKeywordIndex(&index);
+        freeTaskColumns(&columns);
+    }
+    resetStack(&stack);
+    remove(WAL_FILENAME);
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int commands = argc > 1 ? atoi(argv[1]) : 200000;
+    FILE* script = writeScript(commands);
+    
+    /* What every interactive screen used to pay before drawing anything. */
+    int forks = 20;
+    double start = nowSeconds();
+    for (int i = 0; i < forks; i++) {
+        if (system("clear > /dev/null 2>&1 || cls > /dev/null 2>&1") == -1) {
+            break;
+        }
+    }
+    printf("%-36s %8.2f ms per screen\n", "menu screen clear via system()", (nowSeconds() - start) * 1e3 / forks);
+    
+    runScript("batch, bare stack", script, commands, false, false);
+    runScript("batch, index + columns + undo", script, commands, true, false);
+    runScript("batch, all of the above + WAL", script, commands, true, true);
+    
+    fclose(script);
+    return 0;
+}
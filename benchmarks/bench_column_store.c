@@ -0,0 +1,122 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+static int countWithScanner(const TaskStack* stack, const char* needle) {
+    const TaskColumns* columns = stack->columns;
+    TaskCursor cursor;
+    const Task* task;
+    SubstringMatcher matcher;
+    int matches = 0;
+    
+    prepareSubstringMatcher(&matcher, needle, true);
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        if (columns != NULL) {
+            size_t offset = columns->descriptionOffset[cursor.slot];
+            matches += matchSubstring(&matcher, columns->pool + offset, columns->poolUsed + STRING_POOL_PADDING - offset);
+        } else {
+            matches += matchSubstring(&matcher, getTaskDescription(task), descriptionReadable(task));
+        }
+    }
+    return matches;
+}
+
+ 
+/* Best of five runs, so one cold pass does not decide the result. */
+static double timeFilter(const TaskStack* stack, const TaskFilter* filter, int* matches) {
+    double best = 1e9;
+    for (int run = 0; run < 5; run++) {
+        double start = nowSeconds();
+        *matches = countMatchingTasks(stack, filter);
+        double elapsed = nowSeconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    const char* words[] = { "Deploy", "review", "quarterly", "invoice", "backup", "refactor", "release",
+                            "documentation", "meeting", "customer", "migration", "database", "sprint" };
+    const char* names[] = { "in progress, importance >= 8", "importance >= 8", "due in 2025",
+                            "pending, due before 2024-03-01" };
+    TaskFilter filters[4];
+    TaskStack stack;
+    TaskColumns columns;
+    Task task;
+    unsigned seed = 12345;
+    
+    for (int f = 0; f < 4; f++) {
+        initializeTaskFilter(&filters[f]);
+    }
+    filters[0].minImportance = 8;
+    filters[0].statusMask = 1u << IN_PROGRESS;
+    filters[1].minImportance = 8;
+    filters[2].fromDueKey = DUE_KEY(2025, 1, 1);
+    filters[2].toDueKey = DUE_KEY(2025, 12, 31);
+    filters[3].statusMask = 1u << PENDING;
+    filters[3].toDueKey = DUE_KEY(2024, 2, 29);
+    
+    memset(&task, 0, sizeof(task));
+    initializeStack(&stack);
+    for (int i = 0; i < count; i++) {
+        char description[MAX_DESCRIPTION];
+        int length = 0;
+        seed = seed * 1103515245 + 12345;
+        task.importance = 1 + (seed >> 8) % 10;
+        task.status = (TaskStatus)((seed >> 16) % 3);
+        task.createdAt = (time_t)i;
+        setTaskDueDate(&task, 2022 + (seed >> 4) % 5, 1 + (seed >> 12) % 12, 1 + (seed >> 20) % 28);
+        for (int w = 0; w < 2 + i % 6; w++) {
+            seed = seed * 1103515245 + 12345;
+            length += snprintf(description + length, MAX_DESCRIPTION - length, "%s%s",
+                               w ? " " : "", words[(seed >> 8) % 13]);
+        }
+        setTaskDescription(&task, description);
+        pushTask(&stack, task);
+    }
+    
+    double start = nowSeconds();
+    initializeTaskColumns(&columns);
+    attachTaskColumns(&stack, &columns);
+    double buildTime = nowSeconds() - start;
+    detachTaskColumns(&stack);
+    
+    printf("%d tasks: %zu-byte rows vs %zu bytes of columns per task + %.1f MB description pool (built in %.2f ms)\n",
+           count, sizeof(Task), sizeof(int32_t) * 2 + sizeof(uint8_t) + sizeof(int64_t) + sizeof(uint32_t),
+           columns.poolUsed / 1e6, buildTime * 1e3);
+    
+    for (int f = 0; f < 4; f++) {
+        int rowMatches, columnMatches;
+        double rowTime = timeFilter(&stack, &filters[f], &rowMatches);
+        stack.columns = &columns;
+        double columnTime = timeFilter(&stack, &filters[f], &columnMatches);
+        detachTaskColumns(&stack);
+        
+        printf("%-32s AoS %8.2f ms | SoA %8.2f ms | %6.2fx (%d matches)%s\n", names[f],
+               rowTime * 1e3, columnTime * 1e3, rowTime / columnTime, rowMatches,
+               rowMatches == columnMatches ? "" : " MISMATCH");
+    }
+    
+    const char* needles[] = { "database migration", "zzz-not-present" };
+    for (int n = 0; n < 2; n++) {
+        detachTaskColumns(&stack);
+        start = nowSeconds();
+        int rowMatches = countWithScanner(&stack, needles[n]);
+        double rowTime = nowSeconds() - start;
+        stack.columns = &columns;
+        start = nowSeconds();
+        int columnMatches = countWithScanner(&stack, needles[n]);
+        double columnTime = nowSeconds() - start;
+        printf("substring '%-20s' AoS %8.2f ms | pool %8.2f ms | %6.2fx (%d matches)%s\n", needles[n],
+               rowTime * 1e3, columnTime * 1e3, rowTime / columnTime, rowMatches,
+               rowMatches == columnMatches ? "" : " MISMATCH");
+    }
+    
+    detachTaskColumns(&stack);
+    freeTaskColumns(&columns);
+    resetStack(&stack);
+    return 0;
+}
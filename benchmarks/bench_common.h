@@ -0,0 +1,34 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+/* Helpers shared by the microbenchmarks; include it after the library
+   source. */
+
+ 
+static inline double nowSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+ 
+/* A task whose due date, importance, status and creation time all follow
+   from seed, described by the printf-style format. */
+__attribute__((format(printf, 2, 3)))
+static inline Task makeTask(unsigned seed, const char* format, ...) {
+    Task task;
+    char description[MAX_DESCRIPTION];
+    va_list args;
+    memset(&task, 0, sizeof(task));
+    va_start(args, format);
+    vsnprintf(description, sizeof(description), format, args);
+    va_end(args);
+    setTaskDescription(&task, description);
+    setTaskDueDate(&task, 2024 + seed % 3, 1 + seed % 12, 1 + seed % 28);
+    task.importance = 1 + seed % 10;
+    task.status = (TaskStatus)(seed % 3);
+    task.createdAt = (time_t)seed;
+    return task;
+}
+
+#endif
@@ -0,0 +1,183 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* The baseline: the regular stack behind one mutex. */
+typedef struct {
+    pthread_mutex_t lock;
+    TaskStack stack;
+} LockedTaskStack;
+
+ 
+typedef struct {
+    ConcurrentTaskStack* lockFree;
+    LockedTaskStack* locked;
+    int first;
+    int count;
+    bool producer;
+    atomic_int* producersLeft;
+    _Atomic unsigned char* seen;
+    int duplicates;
+    int taken;
+} Worker;
+
+ 
+static bool pushWorkerTask(Worker* worker, Task task) {
+    if (worker->lockFree != NULL) {
+        return pushConcurrentTask(worker->lockFree, task);
+    }
+    pthread_mutex_lock(&worker->locked->lock);
+    bool pushed = pushTask(&worker->locked->stack, task);
+    pthread_mutex_unlock(&worker->locked->lock);
+    return pushed;
+}
+
+ 
+static bool popWorkerTask(Worker* worker, Task* task) {
+    if (worker->lockFree != NULL) {
+        return popConcurrentTask(worker->lockFree, task);
+    }
+    pthread_mutex_lock(&worker->locked->lock);
+    bool popped = popTask(&worker->locked->stack, task);
+    pthread_mutex_unlock(&worker->locked->lock);
+    return popped;
+}
+
+ 
+/* Throughput: every thread alternates a push and a pop on the shared top. */
+static void* runPairs(void* argument) {
+    Worker* worker = (Worker*)argument;
+    Task task;
+    memset(&task, 0, sizeof(task));
+    for (int i = 0; i < worker->count; i++) {
+        task.importance = i;
+        pushWorkerTask(worker, task);
+        popWorkerTask(worker, &task);
+    }
+    return NULL;
+}
+
+ 
+/* Stress: producers push tasks tagged first..first+count-1 in createdAt;
+   consumers pop until the producers are done and the stack is empty, and
+   mark every tag they see. */
+static void* runStress(void* argument) {
+    Worker* worker = (Worker*)argument;
+    Task task;
+    memset(&task, 0, sizeof(task));
+    
+    if (worker->producer) {
+        for (int i = 0; i < worker->count; i++) {
+            task.createdAt = worker->first + i;
+            while (!pushWorkerTask(worker, task)) {
+            }
+        }
+        atomic_fetch_sub(worker->producersLeft, 1);
+        return NULL;
+    }
+    for (;;) {
+        /* Read before popping: if the producers had finished and the pop
+           still finds nothing, nothing more can arrive. */
+        bool finished = atomic_load(worker->producersLeft) == 0;
+        if (popWorkerTask(worker, &task)) {
+            worker->duplicates += atomic_exchange(&worker->seen[task.createdAt], 1);
+            worker->taken++;
+        } else if (finished) {
+            return NULL;
+        }
+    }
+}
+
+ 
+static double runThreads(void* (*body)(void*), Worker* workers, int threads) {
+    pthread_t ids[64];
+    double start = nowSeconds();
+    for (int t = 0; t < threads; t++) {
+        pthread_create(&ids[t], NULL, body, &workers[t]);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+    }
+    return nowSeconds() - start;
+}
+
+ 
+static void stressTest(bool lockFree, int threads, int tasks) {
+    static ConcurrentTaskStack concurrent;
+    static LockedTaskStack locked;
+    Worker workers[64];
+    _Atomic unsigned char* seen = (_Atomic unsigned char*)calloc(tasks, 1);
+    int producers = threads / 2;
+    atomic_int producersLeft = producers;
+    int duplicates = 0;
+    int taken = 0;
+    
+    initializeConcurrentStack(&concurrent);
+    initializeStack(&locked.stack);
+    pthread_mutex_init(&locked.lock, NULL);
+    for (int t = 0; t < threads; t++) {
+        Worker* worker = &workers[t];
+        memset(worker, 0, sizeof(*worker));
+        worker->lockFree = lockFree ? &concurrent : NULL;
+        worker->locked = &locked;
+        worker->producer = t < producers;
+        worker->first = t * (tasks / producers);
+        worker->count = t + 1 == producers ? tasks - worker->first : tasks / producers;
+        worker->producersLeft = &producersLeft;
+        worker->seen = seen;
+    }
+    runThreads(runStress, workers, threads);
+    
+    for (int t = 0; t < threads; t++) {
+        duplicates += workers[t].duplicates;
+        taken += workers[t].taken;
+    }
+    int missing = 0;
+    for (int i = 0; i < tasks; i++) {
+        missing += atomic_load(&seen[i]) == 0;
+    }
+    printf("stress %-10s %2d producers, %2d consumers, %d tasks: %s (%d taken, %d duplicated, %d missing)\n",
+           lockFree ? "lock-free" : "mutex", producers, threads - producers, tasks,
+           duplicates == 0 && missing == 0 && taken == tasks ? "ok" : "MISMATCH", taken, duplicates, missing);
+    
+    freeConcurrentStack(&concurrent);
+    resetStack(&locked.stack);
+    pthread_mutex_destroy(&locked.lock);
+    free(seen);
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int pairs = argc > 1 ? atoi(argv[1]) : 2000000;
+    static ConcurrentTaskStack concurrent;
+    static LockedTaskStack locked;
+    Worker workers[64];
+    
+    printf("%ld CPU(s) online\n", sysconf(_SC_NPROCESSORS_ONLN));
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        double elapsed[2];
+        for (int variant = 0; variant < 2; variant++) {
+            initializeConcurrentStack(&concurrent);
+            initializeStack(&locked.stack);
+            pthread_mutex_init(&locked.lock, NULL);
+            for (int t = 0; t < threads; t++) {
+                memset(&workers[t], 0, sizeof(Worker));
+                workers[t].lockFree = variant == 0 ? &concurrent : NULL;
+                workers[t].locked = &locked;
+                workers[t].count = pairs / threads;
+            }
+            elapsed[variant] = runThreads(runPairs, workers, threads);
+            freeConcurrentStack(&concurrent);
+            resetStack(&locked.stack);
+            pthread_mutex_destroy(&locked.lock);
+        }
+        double operations = 2.0 * (pairs / threads) * threads;
+        printf("%2d thread(s): lock-free %7.2f Mops/s | mutex %7.2f Mops/s\n", threads,
+               operations / elapsed[0] / 1e6, operations / elapsed[1] / 1e6);
+    }
+    
+    stressTest(true, 8, 1000000);
+    stressTest(false, 8, 1000000);
+    stressTest(true, 64, 1000000);
+    return 0;
+}
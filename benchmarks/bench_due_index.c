@@ -0,0 +1,98 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* Best of five runs of a one-week range count starting at each of `weeks`
+   consecutive Mondays' worth of keys. */
+static double timeRanges(const TaskStack* stack, int weeks, int* matches) {
+    double best = 1e9;
+    for (int run = 0; run < 5; run++) {
+        double start = nowSeconds();
+        *matches = 0;
+        for (int w = 0; w < weeks; w++) {
+            int fromKey = DUE_KEY(2025, 1 + w % 12, 1 + w % 3 * 7);
+            *matches += countTasksDueBetween(stack, fromKey, fromKey + 6);
+        }
+        double elapsed = (nowSeconds() - start) / weeks;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 2000000;
+    int weeks = 36;
+    TaskStack stack;
+    TaskColumns columns;
+    DueIndex index;
+    Task task;
+    unsigned seed = 12345;
+    
+    memset(&task, 0, sizeof(task));
+    setTaskDescription(&task, "Due index benchmark task");
+    initializeStack(&stack);
+    double start = nowSeconds();
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        task.importance = 1 + (seed >> 8) % 10;
+        task.status = (TaskStatus)((seed >> 16) % 3);
+        setTaskDueDate(&task, 2022 + (seed >> 4) % 5, 1 + (seed >> 12) % 12, 1 + (seed >> 20) % 28);
+        pushTask(&stack, task);
+    }
+    double bare = nowSeconds() - start;
+    
+    start = nowSeconds();
+    initializeDueIndex(&index);
+    attachDueIndex(&stack, &index);
+    double build = nowSeconds() - start;
+    printf("%d tasks: index built in %.1f ms, %d leaves, %d months\n", count, build * 1e3,
+           index.leafCount, index.monthCount);
+    
+    start = nowSeconds();
+    for (int i = 0; i < count / 10; i++) {
+        seed = seed * 1103515245 + 12345;
+        setTaskDueDate(&task, 2022 + (seed >> 4) % 5, 1 + (seed >> 12) % 12, 1 + (seed >> 20) % 28);
+        pushTask(&stack, task);
+    }
+    double indexed = nowSeconds() - start;
+    printf("%-32s %8.1f ns/push bare | %8.1f ns/push with due index\n", "push",
+           bare * 1e9 / count, indexed * 1e9 / (count / 10));
+    
+    int indexMatches, rowMatches, columnMatches;
+    double indexTime = timeRanges(&stack, weeks, &indexMatches);
+    detachDueIndex(&stack);
+    double rowTime = timeRanges(&stack, weeks, &rowMatches);
+    initializeTaskColumns(&columns);
+    attachTaskColumns(&stack, &columns);
+    double columnTime = timeRanges(&stack, weeks, &columnMatches);
+    detachTaskColumns(&stack);
+    printf("%-32s %8.3f ms index | %8.2f ms row scan | %8.2f ms column scan (%d per week)%s\n",
+           "tasks due in one week", indexTime * 1e3, rowTime * 1e3, columnTime * 1e3, indexMatches / weeks,
+           indexMatches == rowMatches && rowMatches == columnMatches ? "" : " MISMATCH");
+    
+    /* The calendar is printed; send it to /dev/null while timing it. */
+    int terminal = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    fflush(stdout);
+    dup2(devNull, STDOUT_FILENO);
+    stack.dueIndex = &index;
+    start = nowSeconds();
+    displayDueCalendar(&stack);
+    fflush(stdout);
+    double calendarIndex = nowSeconds() - start;
+    detachDueIndex(&stack);
+    start = nowSeconds();
+    displayDueCalendar(&stack);
+    fflush(stdout);
+    double calendarScan = nowSeconds() - start;
+    dup2(terminal, STDOUT_FILENO);
+    close(devNull);
+    close(terminal);
+    printf("%-32s %8.3f ms index | %8.2f ms scan\n", "tasks per month", calendarIndex * 1e3, calendarScan * 1e3);
+    
+    freeTaskColumns(&columns);
+    freeDueIndex(&index);
+    resetStack(&stack);
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* Synthetic work: `context` points at the number of hash rounds to spin. */
+static bool spinHandler(const Task* task, void* context) {
+    uint32_t hash = (uint32_t)task->id;
+    for (int i = *(const int*)context; i > 0; i--) {
+        hash = hash * 2654435761u + (uint32_t)i;
+    }
+    __asm__ volatile("" : : "r"(hash));
+    return true;
+}
+
+ 
+/* Fails every tenth task, by id. */
+static bool flakyHandler(const Task* task, void* context) {
+    (void)context;
+    return task->id % 10 != 0;
+}
+
+ 
+/* `heavyShare` percent of the tasks, all at the top of the stack, are
+   labelled "heavy"; the rest are "light". */
+static void fillStack(TaskStack* stack, int count, int heavyShare) {
+    Task task;
+    char description[MAX_DESCRIPTION];
+    memset(&task, 0, sizeof(task));
+    setTaskDueDate(&task, 2025, 6, 1);
+    initializeStack(stack);
+    for (int i = 0; i < count; i++) {
+        snprintf(description, MAX_DESCRIPTION, "%s task %d",
+                 i >= count - count * heavyShare / 100 ? "heavy" : "light", i);
+        setTaskDescription(&task, description);
+        task.importance = 1 + i % 10;
+        pushTask(stack, task);
+    }
+}
+
+ 
+static int countStatus(const TaskStack* stack, TaskStatus status) {
+    TaskCursor cursor;
+    const Task* task;
+    int matches = 0;
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        matches += task->status == status;
+    }
+    return matches;
+}
+
+ 
+static void runWorkload(const char* label, int count, int heavyShare, int workers, bool stealing) {
+    static int lightRounds = 200;
+    static int heavyRounds = 20000;
+    TaskStack stack;
+    TaskExecutor executor;
+    
+    fillStack(&stack, count, heavyShare);
+    initializeTaskExecutor(&executor, workers);
+    executor.stealing = stealing;
+    registerTaskHandler(&executor, "heavy", spinHandler, &heavyRounds);
+    registerTaskHandler(&executor, NULL, spinHandler, &lightRounds);
+    
+    int completed = runTaskExecutor(&executor, &stack);
+    const ExecutorStats* stats = &executor.stats;
+    uint64_t busiest = 0;
+    for (int w = 0; w < executor.workerCount; w++) {
+        busiest = executor.workerStats[w].executed > busiest ? executor.workerStats[w].executed : busiest;
+    }
+    printf("%-8s %2d worker(s), stealing %-3s %9.0f tasks/s  %7llu steals (%5.2f%% of tasks, %5.2f%% of attempts)"
+           "  busiest worker %5.1f%%%s\n", label, workers, stealing ? "on" : "off",
+           stats->executed / stats->seconds, (unsigned long long)stats->steals,
+           100.0 * stats->steals / (stats->executed ? stats->executed : 1),
+           100.0 * stats->steals / (stats->stealAttempts ? stats->stealAttempts : 1),
+           100.0 * busiest / (stats->executed ? stats->executed : 1),
+           completed == count && countStatus(&stack, COMPLETED) == count ? "" : " MISMATCH");
+    resetStack(&stack);
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 200000;
+    TaskStack stack;
+    TaskExecutor executor;
+    
+    printf("%ld CPU(s) online, %d tasks\n", sysconf(_SC_NPROCESSORS_ONLN), count);
+    for (int workers = 1; workers <= 8; workers *= 2) {
+        runWorkload("uniform", count, 0, workers, true);
+    }
+    for (int workers = 2; workers <= 8; workers *= 2) {
+        runWorkload("skewed", count, 5, workers, false);
+        runWorkload("skewed", count, 5, workers, true);
+    }
+    
+    /* Failed tasks stay PENDING and the run goes through the edit path, so
+       the log and undo journal see ordinary edits. */
+    fillStack(&stack, count, 0);
+    initializeTaskExecutor(&executor, 4);
+    registerTaskHandler(&executor, "task", flakyHandler, NULL);
+    double start = nowSeconds();
+    int completed = runTaskExecutor(&executor, &stack);
+    double total = nowSeconds() - start;
+    uint64_t failed = executor.stats.failed;
+    double handlers = executor.stats.seconds;
+    executor.handlers[0].handler = spinHandler;
+    executor.handlers[0].context = &(int){ 10 };
+    int retried = runTaskExecutor(&executor, &stack);
+    printf("flaky    4 worker(s): %d completed, %llu failed, retry completed %d: %s  (%.1f ms in handlers, %.1f ms with the edits)\n",
+           completed, (unsigned long long)failed, retried,
+           completed + retried == count && countStatus(&stack, PENDING) == 0 ? "ok" : "MISMATCH",
+           handlers * 1e3, total * 1e3);
+    resetStack(&stack);
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* Three to seven words picked by seed. */
+static void describeTask(char* description, unsigned seed) {
+    const char* words[] = { "Deploy", "review", "quarterly", "invoice", "backup", "refactor", "release",
+                            "documentation", "meeting", "customer", "migration", "database", "sprint" };
+    int length = 0;
+    for (int w = 0; w < 3 + (int)(seed % 5); w++) {
+        length += snprintf(description + length, MAX_DESCRIPTION - length, "%s%s", w ? " " : "",
+                           words[(seed >> (w * 3)) % 13]);
+    }
+}
+
+ 
+static double fileMegabytes(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0 ? info.st_size / 1e6 : 0.0;
+}
+
+ 
+/* The loader one would write without the pipeline: stdio lines, sscanf and
+   one pushTask per record. Handles unquoted CSV only. */
+static int naiveCsvImport(TaskStack* stack, const char* path) {
+    char line[512];
+    FILE* file = fopen(path, "r");
+    int count = 0;
+    if (file == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        Task task;
+        char description[MAX_DESCRIPTION];
+        char status[16];
+        int year, month, day;
+        long long createdAt;
+        memset(&task, 0, sizeof(task));
+        if (sscanf(line, "%1023[^,],%d-%d-%d,%d,%15[^,],%lld", description, &year, &month, &day,
+                   &task.importance, status, &createdAt) != 7 || !setTaskDueDate(&task, year, month, day) ||
+            !setTaskDescription(&task, description)) {
+            continue;
+        }
+        task.status = strcmp(status, "pending") == 0 ? PENDING : strcmp(status, "completed") == 0 ? COMPLETED : IN_PROGRESS;
+        task.createdAt = (time_t)createdAt;
+        count += pushTask(stack, task);
+    }
+    fclose(file);
+    return count;
+}
+
+ 
+static void report(const char* label, const char* path, int tasks, double seconds) {
+    printf("%-36s %8.1f MB/s  %7.2f M tasks/s  (%d tasks, %.1f MB, %.0f ms)\n", label,
+           fileMegabytes(path) / seconds, tasks / seconds / 1e6, tasks, fileMegabytes(path), seconds * 1e3);
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 2000000;
+    const char* paths[] = { "bench_tasks.csv", "bench_tasks.jsonl" };
+    const char* names[] = { "CSV", "JSONL" };
+    TaskStack stack;
+    char description[MAX_DESCRIPTION];
+    int rejected;
+    
+    initializeStack(&stack);
+    for (int i = 0; i < count; i++) {
+        unsigned seed = (unsigned)i * 2654435761u;
+        describeTask(description, seed);
+        pushTask(&stack, makeTask(seed, "%s", description));
+    }
+    
+    for (int f = 0; f < 2; f++) {
+        char label[64];
+        double start = nowSeconds();
+        int exported = exportTasksToFile(&stack, paths[f], (TaskFileFormat)f);
+        snprintf(label, sizeof(label), "export %s", names[f]);
+        report(label, paths[f], exported, nowSeconds() - start);
+    }
+    resetStack(&stack);
+    
+    for (int f = 0; f < 2; f++) {
+        char label[64];
+        initializeStack(&stack);
+        double start = nowSeconds();
+        int imported = importTasksFromFile(&stack, paths[f], (TaskFileFormat)f, &rejected);
+        snprintf(label, sizeof(label), "import %s", names[f]);
+        report(label, paths[f], imported, nowSeconds() - start);
+        resetStack(&stack);
+    }
+    
+    KeywordIndex index;
+    TaskColumns columns;
+    initializeStack(&stack);
+    initializeKeywordIndex(&index);
+    attachKeywordIndex(&stack, &index);
+    initializeTaskColumns(&columns);
+    attachTaskColumns(&stack, &columns);
+    double start = nowSeconds();
+    int imported = importTasksFromFile(&stack, paths[0], TASK_FILE_CSV, &rejected);
+    report("import CSV, index + columns attached", paths[0], imported, nowSeconds() - start);
+    resetStack(&stack);
+    freeKeywordIndex(&index);
+    freeTaskColumns(&columns);
+    
+    initializeStack(&stack);
+    start = nowSeconds();
+    imported = naiveCsvImport(&stack, paths[0]);
+    report("fgets + sscanf + pushTask per row", paths[0], imported, nowSeconds() - start);
+    resetStack(&stack);
+    
+    remove(paths[0]);
+    remove(paths[1]);
+    return 0;
+}
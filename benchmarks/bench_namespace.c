@@ -0,0 +1,199 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* The baseline: every team's tasks on the one stack behind one mutex, with
+   the same keyword index and undo journal a named stack has. */
+typedef struct {
+    pthread_mutex_t lock;
+    TaskStack stack;
+    KeywordIndex keywordIndex;
+    UndoStack undo;
+} LockedTaskStack;
+
+ 
+typedef struct {
+    TaskNamespace* space;
+    LockedTaskStack* locked;
+    int thread;
+    int ops;
+    int done;
+} Worker;
+
+ 
+/* Half pushes, a quarter pops and a quarter edits of the top task, on one
+   of four stacks owned by this thread. */
+static bool runOperation(TaskStack* stack, unsigned roll, Task* task) {
+    if (roll % 4 < 2) {
+        return pushTask(stack, *task);
+    }
+    if (roll % 4 == 2) {
+        return popTask(stack, task) || pushTask(stack, *task);
+    }
+    const Task* top = getTaskAtIndex(stack, getStackSize(stack) - 1);
+    if (top == NULL) {
+        return pushTask(stack, *task);
+    }
+    Task edited = *top;
+    edited.importance = 1 + roll % 10;
+    return editTaskAtIndex(stack, getStackSize(stack) - 1, edited);
+}
+
+ 
+static void* runWorker(void* argument) {
+    Worker* worker = (Worker*)argument;
+    unsigned seed = 777u * (worker->thread + 1);
+    Task task = makeTask(seed, "Ticket %u about the billing export", seed % 4096);
+    char name[MAX_STACK_NAME];
+    
+    for (int i = 0; i < worker->ops; i++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned roll = seed >> 8;
+        if (worker->locked != NULL) {
+            pthread_mutex_lock(&worker->locked->lock);
+            worker->done += runOperation(&worker->locked->stack, roll, &task);
+            pthread_mutex_unlock(&worker->locked->lock);
+            continue;
+        }
+        snprintf(name, sizeof(name), "team-%d-%u", worker->thread, roll % 4);
+        NamedStack* named = lockNamedStack(worker->space, name, true);
+        worker->done += runOperation(&named->stack, roll, &task);
+        unlockNamedStack(worker->space, named);
+    }
+    return NULL;
+}
+
+ 
+static double runThreads(TaskNamespace* space, LockedTaskStack* locked, int threads, int ops, int* done) {
+    pthread_t handles[64];
+    Worker workers[64];
+    
+    double start = nowSeconds();
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (Worker){ .space = space, .locked = locked, .thread = t, .ops = ops };
+        pthread_create(&handles[t], NULL, runWorker, &workers[t]);
+    }
+    *done = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(handles[t], NULL);
+        *done += workers[t].done;
+    }
+    return nowSeconds() - start;
+}
+
+ 
+/* searchTaskNamespace's work, every shard on the calling thread. */
+static int searchSerially(TaskNamespace* space, const char* query) {
+    NamespaceSearchJob job = { .space = space, .query = query, .first = 0, .step = 1 };
+    runNamespaceSearch(&job);
+    if (job.count > 1) {
+        qsort(job.matches, job.count, sizeof(NamespaceMatch), compareNamespaceMatches);
+    }
+    freeNamespaceMatches(job.matches, job.count);
+    return job.failed ? -1 : job.count;
+}
+
+ 
+static void fillNamespace(TaskNamespace* space, int stacks, int tasksPerStack) {
+    char name[MAX_STACK_NAME];
+    for (int s = 0; s < stacks; s++) {
+        snprintf(name, sizeof(name), "project-%03d", s);
+        NamedStack* named = lockNamedStack(space, name, true);
+        for (int i = 0; i < tasksPerStack; i++) {
+            unsigned seed = (unsigned)(s * tasksPerStack + i) * 2654435761u;
+            pushTask(&named->stack, makeTask(seed, "Ticket %u about the billing export", seed % 4096));
+        }
+        unlockNamedStack(space, named);
+    }
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int ops = argc > 1 ? atoi(argv[1]) : 200000;
+    int stacks = argc > 2 ? atoi(argv[2]) : 256;
+    int tasksPerStack = argc > 3 ? atoi(argv[3]) : 2000;
+    int threadCounts[] = { 1, 2, 4, 8 };
+    TaskNamespace space;
+    LockedTaskStack locked;
+    int done;
+    
+    printf("%d ops per thread, %ld core(s)\n", ops, sysconf(_SC_NPROCESSORS_ONLN));
+    for (int i = 0; i < 4; i++) {
+        int threads = threadCounts[i];
+        initializeTaskNamespace(&space, "");
+        double sharded = runThreads(&space, NULL, threads, ops, &done);
+        bool complete = done == threads * ops && countNamedStacks(&space) == threads * 4;
+        freeTaskNamespace(&space);
+    
+        pthread_mutex_init(&locked.lock, NULL);
+        initializeStack(&locked.stack);
+        initializeKeywordIndex(&locked.keywordIndex);
+        attachKeywordIndex(&locked.stack, &locked.keywordIndex);
+        initializeUndoStack(&locked.undo, UNDO_BUDGET);
+        attachUndoStack(&locked.stack, &locked.undo);
+        double single = runThreads(NULL, &locked, threads, ops, &done);
+        complete = complete && done == threads * ops;
+        locked.stack.undo = NULL;
+        freeUndoStack(&locked.undo);
+        resetStack(&locked.stack);
+        freeKeywordIndex(&locked.keywordIndex);
+        pthread_mutex_destroy(&locked.lock);
+        printf("%d thread(s): sharded namespace %7.2f Mops/s | one stack, one mutex %7.2f Mops/s%s\n", threads,
+               threads * ops / sharded / 1e6, threads * ops / single / 1e6, complete ? "" : " MISMATCH");
+    }
+    
+    initializeTaskNamespace(&space, "");
+    fillNamespace(&space, stacks, tasksPerStack);
+    const char* queries[] = { "ticket billing", "ticket 17", "nothing-matches-this" };
+    for (int q = 0; q < 3; q++) {
+        NamespaceMatch* matches;
+        double start = nowSeconds();
+        int count = searchTaskNamespace(&space, queries[q], &matches);
+        double fanOut = nowSeconds() - start;
+        start = nowSeconds();
+        int serial = searchSerially(&space, queries[q]);
+        double oneThread = nowSeconds() - start;
+    
+        bool ordered = true;
+        for (int i = 1; i < count && ordered; i++) {
+            ordered = compareNamespaceMatches(&matches[i - 1], &matches[i]) < 0;
+        }
+        printf("search %-22s %d stacks: fan-out %8.2f ms | serial %8.2f ms (%d matches)%s\n", queries[q], stacks,
+               fanOut * 1e3, oneThread * 1e3, count, count == serial && ordered ? "" : " MISMATCH");
+        if (count >= 0) {
+            freeNamespaceMatches(matches, count);
+        }
+    }
+    freeTaskNamespace(&space);
+    
+    /* Every stack saved to its own file comes back with the same tasks. */
+    char directory[64];
+    snprintf(directory, sizeof(directory), "/tmp/bench_namespace.%d", (int)getpid());
+    initializeTaskNamespace(&space, directory);
+    fillNamespace(&space, 64, 500);
+    double start = nowSeconds();
+    int failed = saveTaskNamespace(&space);
+    double save = nowSeconds() - start;
+    freeTaskNamespace(&space);
+    
+    initializeTaskNamespace(&space, directory);
+    start = nowSeconds();
+    int loaded = loadTaskNamespace(&space);
+    double load = nowSeconds() - start;
+    bool intact = failed == 0 && loaded == 64;
+    for (int s = 0; s < 64 && intact; s++) {
+        char name[MAX_STACK_NAME];
+        snprintf(name, sizeof(name), "project-%03d", s);
+        NamedStack* named = lockNamedStack(&space, name, false);
+        intact = named != NULL && getStackSize(&named->stack) == 500;
+        if (named != NULL) {
+            unlockNamedStack(&space, named);
+        }
+        intact = intact && dropNamedStack(&space, name);
+    }
+    printf("64 stacks of 500 tasks: save %.2f ms, load %.2f ms, %d left after dropping%s\n", save * 1e3, load * 1e3,
+           countNamedStacks(&space), intact && countNamedStacks(&space) == 0 ? "" : " MISMATCH");
+    freeTaskNamespace(&space);
+    rmdir(directory);
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+static Task randomTask(unsigned* seed, int i) {
+    Task task;
+    char description[MAX_DESCRIPTION];
+    memset(&task, 0, sizeof(task));
+    *seed = *seed * 1103515245 + 12345;
+    task.importance = 1 + (*seed >> 8) % 10;
+    task.status = (TaskStatus)((*seed >> 16) % 3);
+    task.createdAt = (time_t)i;
+    setTaskDueDate(&task, 2024 + (*seed >> 4) % 3, 1 + (*seed >> 12) % 12, 1 + (*seed >> 20) % 28);
+    snprintf(description, MAX_DESCRIPTION, "Priority benchmark task %d", i);
+    setTaskDescription(&task, description);
+    return task;
+}
+
+ 
+static double fillStack(TaskStack* stack, TaskHeap* heap, int count) {
+    unsigned seed = 12345;
+    initializeStack(stack);
+    if (heap != NULL) {
+        initializeTaskHeap(heap);
+        attachTaskHeap(stack, heap);
+    }
+    double start = nowSeconds();
+    for (int i = 0; i < count; i++) {
+        pushTask(stack, randomTask(&seed, i));
+    }
+    return nowSeconds() - start;
+}
+
+ 
+/* What "next most important task" costs without the heap: one pass over
+   every task, in the same order the heap uses. */
+static int scanForPriorityTask(const TaskStack* stack) {
+    TaskCursor cursor;
+    const Task* task;
+    const Task* best = NULL;
+    int bestIndex = -1;
+    
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        if (task->status == COMPLETED) {
+            continue;
+        }
+        if (best == NULL || task->importance > best->importance ||
+            (task->importance == best->importance &&
+             (task->dueKey < best->dueKey ||
+              (task->dueKey == best->dueKey && task->createdAt < best->createdAt)))) {
+            best = task;
+            bestIndex = cursor.index;
+        }
+    }
+    return bestIndex;
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int pops = argc > 2 ? atoi(argv[2]) : 2000;
+    TaskStack stack;
+    TaskHeap heap;
+    Task task;
+    
+    double bare = fillStack(&stack, NULL, count);
+    double start = nowSeconds();
+    initializeTaskHeap(&heap);
+    attachTaskHeap(&stack, &heap);
+    double build = nowSeconds() - start;
+    printf("%d tasks, %d unfinished: heap built in %.2f ms\n", count, heap.count, build * 1e3);
+    detachTaskHeap(&stack);
+    freeTaskHeap(&heap);
+    resetStack(&stack);
+    
+    double kept = fillStack(&stack, &heap, count);
+    printf("%-36s %8.1f ns/push bare | %8.1f ns/push with heap\n", "push",
+           bare * 1e9 / count, kept * 1e9 / count);
+    
+    start = nowSeconds();
+    int checksum = 0;
+    for (int i = 0; i < pops; i++) {
+        int index;
+        peekPriorityTask(&stack, &task, &index);
+        checksum += index;
+    }
+    double peek = nowSeconds() - start;
+    
+    start = nowSeconds();
+    for (int i = 0; i < pops; i++) {
+        checksum -= scanForPriorityTask(&stack);
+    }
+    double scan = nowSeconds() - start;
+    printf("%-36s %8.3f us heap | %8.1f us scan%s\n", "peek most important", peek * 1e6 / pops,
+           scan * 1e6 / pops, checksum == 0 ? "" : " MISMATCH");
+    
+    start = nowSeconds();
+    for (int i = 0; i < pops; i++) {
+        popPriorityTask(&stack, &task);
+    }
+    double popHeap = nowSeconds() - start;
+    detachTaskHeap(&stack);
+    
+    start = nowSeconds();
+    for (int i = 0; i < pops; i++) {
+        removeTaskAtIndex(&stack, scanForPriorityTask(&stack));
+    }
+    double popScan = nowSeconds() - start;
+    printf("%-36s %8.3f us heap | %8.1f us scan  (%.0fx)\n", "pop most important", popHeap * 1e6 / pops,
+           popScan * 1e6 / pops, popScan / popHeap);
+    
+    freeTaskHeap(&heap);
+    resetStack(&stack);
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+static size_t legacyBytesCopied;
+
+ 
+/* The pre-cursor read paths: every call took the stack by value, popped the
+   copy into a malloc'd buffer and then walked that buffer backwards. */
+static int legacyGetStackSize(TaskStack stack) {
+    legacyBytesCopied += sizeof(TaskStack);
+    return stack.top + 1;
+}
+
+ 
+static void legacyDisplayTask(Task task, int index) {
+    legacyBytesCopied += sizeof(Task);
+    displayTask(&task, index);
+}
+
+ 
+/* The old code popped every task off a by-value copy of the stack. The
+   copy now shares its chunks with the original, so it is read from the
+   top down instead, which moves the same bytes. */
+static Task* legacyCopyOut(TaskStack stack, int size) {
+    legacyBytesCopied += sizeof(TaskStack);
+    Task* tasks = (Task*)malloc(size * sizeof(Task));
+    TaskStack copyStack = stack;
+    legacyBytesCopied += sizeof(TaskStack);
+    
+    for (int i = 0; i < size; i++) {
+        tasks[i] = *getTaskAtIndex(&copyStack, size - 1 - i);
+    }
+    legacyBytesCopied += 2 * (size_t)size * sizeof(Task);
+    return tasks;
+}
+
+ 
+static void legacyDisplayAllTasks(TaskStack stack) {
+    int size = legacyGetStackSize(stack);
+    Task* tasks = legacyCopyOut(stack, size);
+    
+    for (int i = size - 1; i >= 0; i--) {
+        legacyDisplayTask(tasks[i], size - 1 - i);
+    }
+    free(tasks);
+}
+
+ 
+static int legacySearchTasks(TaskStack stack, const char* keyword) {
+    int size = legacyGetStackSize(stack);
+    Task* tasks = legacyCopyOut(stack, size);
+    int matches = 0;
+    
+    for (int i = size - 1; i >= 0; i--) {
+        if (strstr(getTaskDescription(&tasks[i]), keyword) != NULL) {
+            legacyDisplayTask(tasks[i], size - 1 - i);
+            matches++;
+        }
+    }
+    free(tasks);
+    return matches;
+}
+
+ 
+static void legacySaveStackToFile(TaskStack stack) {
+    legacyBytesCopied += sizeof(TaskStack);
+    saveStackToFile(&stack);
+}
+
+ 
+static void fillStack(TaskStack* stack, int count) {
+    const char* words[] = { "deploy", "review", "meeting", "invoice", "backup", "refactor", "release", "docs" };
+    Task task;
+    char description[MAX_DESCRIPTION];
+    memset(&task, 0, sizeof(task));
+    
+    for (int i = 0; i < count; i++) {
+        snprintf(description, MAX_DESCRIPTION, "%s %s #%d", words[i % 8], words[(i / 8) % 8], i);
+        setTaskDescription(&task, description);
+        setTaskDueDate(&task, 2024 + i % 3, i % 12 + 1, i % 28 + 1);
+        task.importance = i % 10 + 1;
+        task.status = (TaskStatus)(i % 3);
+        task.createdAt = 1700000000 + i;
+        pushTask(stack, task);
+    }
+}
+
+ 
+#define ROUNDS 20
+
+static volatile int sink;
+
+ 
+static void report(const char* name, double legacyTime, size_t legacyBytes, double newTime) {
+    fprintf(stderr, "%-16s | legacy %10.3f ms %12zu bytes copied | cursor %10.3f ms %4d bytes copied | %6.2fx\n",
+            name, legacyTime * 1e3 / ROUNDS, legacyBytes / ROUNDS, newTime * 1e3 / ROUNDS, 0,
+            legacyTime / newTime);
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 10000;
+    char directory[] = "/tmp/task_bench_XXXXXX";
+    
+    if (mkdtemp(directory) == NULL || chdir(directory) != 0) {
+        perror("mkdtemp");
+        return 1;
+    }
+    
+    TaskStack stack;
+    initializeStack(&stack);
+    fillStack(&stack, count);
+    
+     
+    fflush(stdout);
+    int devNull = open("/dev/null", O_WRONLY);
+    dup2(devNull, STDOUT_FILENO);
+    
+    fprintf(stderr, "Read paths at %d tasks, %d rounds each (per-call figures)\n", count, ROUNDS);
+    
+    double start, legacyTime, newTime;
+    
+    legacyBytesCopied = 0;
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        legacyDisplayAllTasks(stack);
+    }
+    legacyTime = nowSeconds() - start;
+    fflush(stdout);
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        displayAllTasks(&stack);
+    }
+    newTime = nowSeconds() - start;
+    fflush(stdout);
+    report("displayAllTasks", legacyTime, legacyBytesCopied, newTime);
+    
+    legacyBytesCopied = 0;
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        sink = legacySearchTasks(stack, "invoice backup");
+    }
+    legacyTime = nowSeconds() - start;
+    fflush(stdout);
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        sink = displayMatchingTasks(&stack, "invoice backup", false);
+    }
+    newTime = nowSeconds() - start;
+    fflush(stdout);
+    report("searchTasks", legacyTime, legacyBytesCopied, newTime);
+    
+    legacyBytesCopied = 0;
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        legacySaveStackToFile(stack);
+    }
+    legacyTime = nowSeconds() - start;
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        saveStackToFile(&stack);
+    }
+    newTime = nowSeconds() - start;
+    report("saveStackToFile", legacyTime, legacyBytesCopied, newTime);
+    
+    legacyBytesCopied = 0;
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        sink = legacyGetStackSize(stack);
+    }
+    legacyTime = nowSeconds() - start;
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        sink = getStackSize(&stack);
+    }
+    newTime = nowSeconds() - start;
+    report("getStackSize", legacyTime, legacyBytesCopied, newTime);
+    
+    remove(FILENAME);
+    rmdir(directory);
+    resetStack(&stack);
+    return 0;
+}
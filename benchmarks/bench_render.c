@@ -0,0 +1,129 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* The renderer before frames: a stdio call per border character and one
+   per row, every row formatted whatever the terminal can show. */
+static void legacyDrawLine(FILE* out, int width) {
+    fprintf(out, "+");
+    for (int i = 0; i < width - 2; i++) {
+        fprintf(out, "-");
+    }
+    fprintf(out, "+\n");
+}
+
+ 
+static void legacyDisplayAllTasks(FILE* out, const TaskStack* stack) {
+    TaskCursor cursor;
+    const Task* task;
+    legacyDrawLine(out, 80);
+    fprintf(out, "| %2s | %-30s | %-17s | %10s | %-11s |\n", 
+            "ID", "Description", "Due Date", "Importance", "Status");
+    legacyDrawLine(out, 80);
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        fprintf(out, TASK_ROW_FORMAT, cursor.index + 1, getTaskDescription(task), task->dueLabel,
+                task->importance, statusNames[task->status]);
+    }
+    legacyDrawLine(out, 80);
+}
+
+ 
+static const char* skipLines(const char* text, int lines) {
+    while (lines-- > 0 && (text = strchr(text, '\n')) != NULL) {
+        text++;
+    }
+    return text;
+}
+
+ 
+/* The page's rows must be the very bytes the full listing has for them. */
+static bool samePageRows(const char* legacy, TerminalFrame* frame, int first, int rows) {
+    const char* page = skipLines(frame->data, 3);
+    const char* pageEnd = skipLines(frame->data, 3 + rows);
+    const char* expected = skipLines(legacy, 3 + first);
+    return page != NULL && pageEnd != NULL && expected != NULL &&
+           strncmp(page, expected, pageEnd - page) == 0;
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    TaskStack stack;
+    Task task;
+    TerminalFrame frame;
+    char description[MAX_DESCRIPTION];
+    char* legacy = NULL;
+    size_t legacyLength = 0;
+    
+    initializeStack(&stack);
+    memset(&task, 0, sizeof(task));
+    for (int i = 0; i < count; i++) {
+        snprintf(description, sizeof(description), "Call supplier %d", i % 9973);
+        setTaskDescription(&task, description);
+        setTaskDueDate(&task, 2025, 1 + i % 12, 1 + i % 28);
+        task.importance = 1 + i % 10;
+        task.status = (TaskStatus)(i % 3);
+        pushTask(&stack, task);
+    }
+    
+    FILE* memory = open_memstream(&legacy, &legacyLength);
+    legacyDisplayAllTasks(memory, &stack);
+    fclose(memory);
+    initializeTerminalFrame(&frame, -1);
+    renderTaskPage(&frame, &stack, 0, count);
+    bool whole = frame.length > legacyLength && memcmp(frame.data, legacy, legacyLength) == 0;
+    
+    /* A terminal line-buffers stdout, so the legacy renderer writes a line at a time. */
+    fflush(stdout);
+    int devNull = open("/dev/null", O_WRONLY);
+    int terminal = dup(STDOUT_FILENO);
+    dup2(devNull, STDOUT_FILENO);
+    setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+    
+    double start = nowSeconds();
+    for (int r = 0; r < rounds; r++) {
+        legacyDisplayAllTasks(stdout, &stack);
+    }
+    double legacyTime = (nowSeconds() - start) / rounds;
+    start = nowSeconds();
+    for (int r = 0; r < rounds; r++) {
+        displayAllTasks(&stack);
+    }
+    double frameTime = (nowSeconds() - start) / rounds;
+    
+    int firsts[] = { 0, count / 2, count - TASK_PAGE_ROWS };
+    double pageTimes[3];
+    bool pages = true;
+    for (int p = 0; p < 3; p++) {
+        int first = firsts[p] < 0 ? 0 : firsts[p];
+        start = nowSeconds();
+        for (int r = 0; r < rounds * 100; r++) {
+            displayTaskPage(&stack, first, TASK_PAGE_ROWS);
+        }
+        pageTimes[p] = (nowSeconds() - start) / (rounds * 100);
+        frame.length = 0;
+        int shown = renderTaskPage(&frame, &stack, first, TASK_PAGE_ROWS);
+        frame.data[frame.length] = '\0';
+        pages = pages && shown == (count - first < TASK_PAGE_ROWS ? count - first : TASK_PAGE_ROWS) &&
+                samePageRows(legacy, &frame, first, shown);
+    }
+    
+    fflush(stdout);
+    dup2(terminal, STDOUT_FILENO);
+    setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+    printf("%d tasks, %zu bytes listed\n", count, legacyLength);
+    printf("%-28s %10.3f ms legacy | %10.3f ms frame  (%.1fx)%s\n", "whole list", legacyTime * 1e3,
+           frameTime * 1e3, legacyTime / frameTime, whole ? "" : " MISMATCH");
+    printf("%-28s %10.3f ms legacy | %10.3f / %.3f / %.3f ms first / middle / last page  (%.0fx)%s\n",
+           "one screen", legacyTime * 1e3, pageTimes[0] * 1e3, pageTimes[1] * 1e3, pageTimes[2] * 1e3,
+           legacyTime / pageTimes[2], pages ? "" : " MISMATCH");
+    
+    freeTerminalFrame(&frame);
+    free(legacy);
+    resetStack(&stack);
+    close(devNull);
+    close(terminal);
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+#include <fcntl.h>
+
+ 
+/* Builds descriptions from a 2000-word vocabulary with a skewed word
+   distribution, so some tokens are common and most are rare. */
+static void makeDescription(Task* task, unsigned* seed) {
+    char description[MAX_DESCRIPTION];
+    static const char* syllables[] = { "ka", "lo", "mi", "ne", "ru", "sa", "ti", "vo", "xe", "zu" };
+    int length = 0;
+    int words = 3 + *seed % 5;
+    
+    for (int w = 0; w < words && length < MAX_DESCRIPTION - 12; w++) {
+        *seed = *seed * 1103515245 + 12345;
+        unsigned r = (*seed >> 8) % 1000000;
+        unsigned word = (r * (unsigned long long)r / 1000000) * 2000 / 1000000;
+        length += snprintf(description + length, MAX_DESCRIPTION - length, "%s%s%s%s ",
+                           syllables[word % 10], syllables[word / 10 % 10], syllables[word / 100 % 10],
+                           word >= 1000 ? "n" : "");
+    }
+    description[length > 0 ? length - 1 : 0] = '\0';
+    setTaskDescription(task, description);
+}
+
+ 
+static double timeQuery(TaskStack* stack, const char* query, SearchMode mode, int rounds, int* matches) {
+    double start = nowSeconds();
+    for (int r = 0; r < rounds; r++) {
+        if (mode == SEARCH_KEYWORDS) {
+            *matches = displayIndexedMatches(stack, query);
+        } else {
+            *matches = displayMatchingTasks(stack, query, false);
+        }
+    }
+    fflush(stdout);
+    return (nowSeconds() - start) / rounds;
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    TaskStack stack;
+    KeywordIndex index;
+    Task task;
+    unsigned seed = 7;
+    
+    memset(&task, 0, sizeof(task));
+    setTaskDueDate(&task, 2025, 4, 10);
+    initializeStack(&stack);
+    initializeKeywordIndex(&index);
+    
+    double start = nowSeconds();
+    for (int i = 0; i < count; i++) {
+        makeDescription(&task, &seed);
+        pushTask(&stack, task);
+    }
+    double plainPush = nowSeconds() - start;
+    
+    start = nowSeconds();
+    attachKeywordIndex(&stack, &index);
+    double buildTime = nowSeconds() - start;
+    
+    resetStack(&stack);
+    seed = 7;
+    start = nowSeconds();
+    for (int i = 0; i < count; i++) {
+        makeDescription(&task, &seed);
+        pushTask(&stack, task);
+    }
+    double indexedPush = nowSeconds() - start;
+    
+    printf("%d tasks, %d distinct tokens\n", count, index.used);
+    printf("push without index %.1f ns, with index %.1f ns; bulk index build %.1f ms\n\n",
+           plainPush * 1e9 / count, indexedPush * 1e9 / count, buildTime * 1e3);
+    
+     
+    fflush(stdout);
+    int savedStdout = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    
+    struct {
+        const char* label;
+        const char* query;
+        const char* substring;
+    } cases[] = {
+        { "common term", "kakaka", "kakaka" },
+        { "rare term", "zuzuzun", "zuzuzun" },
+        { "AND", "kakaka lokaka", NULL },
+        { "OR", "zuzuzun OR xexexen", NULL },
+        { "prefix", "zuzu*", NULL },
+    };
+    
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int indexedMatches = 0, scanMatches = 0;
+        fflush(stdout);
+        dup2(devNull, STDOUT_FILENO);
+        double indexed = timeQuery(&stack, cases[i].query, SEARCH_KEYWORDS, 50, &indexedMatches);
+        double scanned = cases[i].substring ? timeQuery(&stack, cases[i].substring, SEARCH_SUBSTRING, 10, &scanMatches) : 0;
+        dup2(savedStdout, STDOUT_FILENO);
+        
+        if (cases[i].substring) {
+            printf("%-12s %-22s index %9.1f us (%6d hits) | substring scan %9.1f us (%6d hits)\n",
+                   cases[i].label, cases[i].query, indexed * 1e6, indexedMatches, scanned * 1e6, scanMatches);
+        } else {
+            printf("%-12s %-22s index %9.1f us (%6d hits)\n",
+                   cases[i].label, cases[i].query, indexed * 1e6, indexedMatches);
+        }
+    }
+    
+     
+    uint32_t* ids;
+    start = nowSeconds();
+    int hits = 0;
+    for (int r = 0; r < 1000; r++) {
+        hits = queryKeywordIndex(&index, "zuzuzun", &ids);
+        free(ids);
+    }
+    printf("\nrare term id lookup only: %.2f us (%d hits)\n", (nowSeconds() - start) * 1e3, hits);
+    
+    resetStack(&stack);
+    freeKeywordIndex(&index);
+    return 0;
+}
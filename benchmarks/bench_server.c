@@ -0,0 +1,297 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* One client connection: sends `requests` requests, `depth` at a time, and
+   times each from the send of its window to the arrival of its reply. */
+typedef struct {
+    const char* address;
+    int requests;
+    int depth;
+    unsigned seed;
+    double* latencies;
+    int replies;
+    int errors;
+    int added;
+    int popped;
+    bool broken;
+} Client;
+
+ 
+typedef struct {
+    TaskServer* server;
+    TaskStack* stack;
+} ServerThread;
+
+ 
+static int connectToServer(const char* address) {
+    int fd;
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un local = { .sun_family = AF_UNIX };
+        snprintf(local.sun_path, sizeof(local.sun_path), "%s", address + 5);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr*)&local, sizeof(local)) == 0) {
+            return fd;
+        }
+    } else {
+        struct sockaddr_in inet = { .sin_family = AF_INET };
+        const char* colon = strrchr(address, ':');
+        char host[64] = "127.0.0.1";
+        int one = 1;
+        if (colon != NULL && colon > address) {
+            snprintf(host, sizeof(host), "%.*s", (int)(colon - address), address);
+        }
+        inet.sin_port = htons((uint16_t)atoi(colon != NULL ? colon + 1 : address));
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd >= 0 && inet_pton(AF_INET, host, &inet.sin_addr) == 1 &&
+            connect(fd, (struct sockaddr*)&inet, sizeof(inet)) == 0) {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    return -1;
+}
+
+ 
+/* 30% add, 10% pop, 20% peek, 20% count, 10% keyword search for a rare
+   word, 10% edit of a random low ID. Returns 'a' or 'p' for the requests
+   that change the size, so the replies can be tallied. */
+static char writeRequest(char* out, unsigned* seed, int* length) {
+    *seed = *seed * 1103515245 + 12345;
+    unsigned roll = (*seed >> 8) % 100;
+    unsigned value = *seed >> 12;
+    if (roll < 30) {
+        *length = sprintf(out, "add 2025-%02u-%02u %u pending Follow up with customer %u\n", 1 + value % 12,
+                          1 + value % 28, 1 + value % 10, value % 5000);
+        return 'a';
+    }
+    if (roll < 40) {
+        *length = sprintf(out, "pop\n");
+        return 'p';
+    }
+    if (roll < 60) {
+        *length = sprintf(out, "peek\n");
+    } else if (roll < 80) {
+        *length = sprintf(out, "count\n");
+    } else if (roll < 90) {
+        *length = sprintf(out, "search customer%u\n", value % 5000);
+    } else {
+        *length = sprintf(out, "edit %u importance %u\n", 1 + value % 1000, 1 + value % 10);
+    }
+    return 0;
+}
+
+ 
+static void* runClient(void* argument) {
+    Client* client = (Client*)argument;
+    char* requests = (char*)malloc((size_t)client->depth * 128);
+    char* kinds = (char*)malloc(client->depth);
+    size_t capacity = 1 << 20;
+    char* input = (char*)malloc(capacity);
+    size_t used = 0;
+    int fd = connectToServer(client->address);
+    
+    client->broken = fd < 0;
+    for (int sent = 0; sent < client->requests && !client->broken; ) {
+        int window = client->requests - sent < client->depth ? client->requests - sent : client->depth;
+        size_t length = 0;
+        for (int i = 0; i < window; i++) {
+            int written;
+            kinds[i] = writeRequest(requests + length, &client->seed, &written);
+            length += (size_t)written;
+        }
+        double start = nowSeconds();
+        for (size_t off = 0; off < length && !client->broken; ) {
+            ssize_t count = send(fd, requests + off, length - off, MSG_NOSIGNAL);
+            client->broken = count <= 0;
+            off += count > 0 ? (size_t)count : 0;
+        }
+    
+        /* Each reply is a header line and as many rows as it announces. */
+        int answered = 0;
+        int rowsLeft = -1;
+        size_t consumed = 0;
+        while (answered < window && !client->broken) {
+            char* newline = (char*)memchr(input + consumed, '\n', used - consumed);
+            if (newline == NULL) {
+                memmove(input, input + consumed, used - consumed);
+                used -= consumed;
+                consumed = 0;
+                ssize_t count = read(fd, input + used, capacity - used);
+                client->broken = count <= 0;
+                used += count > 0 ? (size_t)count : 0;
+                continue;
+            }
+            char* line = input + consumed;
+            consumed = newline + 1 - input;
+            if (rowsLeft > 0) {
+                rowsLeft--;
+            } else if (strncmp(line, "OK ", 3) == 0) {
+                rowsLeft = atoi(line + 3);
+                client->added += kinds[answered] == 'a';
+                client->popped += kinds[answered] == 'p';
+            } else {
+                rowsLeft = 0;
+                client->errors++;
+            }
+            if (rowsLeft == 0) {
+                client->latencies[sent + answered] = nowSeconds() - start;
+                answered++;
+                rowsLeft = -1;
+            }
+        }
+        memmove(input, input + consumed, used - consumed);
+        used -= consumed;
+        client->replies += answered;
+        sent += window;
+    }
+    
+    if (fd >= 0) {
+        close(fd);
+    }
+    free(requests);
+    free(kinds);
+    free(input);
+    return NULL;
+}
+
+ 
+static void* runServerThread(void* argument) {
+    ServerThread* thread = (ServerThread*)argument;
+    runTaskServer(thread->server, thread->stack);
+    return NULL;
+}
+
+ 
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+ 
+/* Runs `connections` clients of `requests` requests each, `depth` deep,
+   and prints throughput and latency percentiles. Returns the net change
+   in the number of tasks the replies report, or INT_MIN on a failure. */
+static int runLoad(const char* label, const char* address, int connections, int depth, int requests) {
+    Client clients[64];
+    pthread_t threads[64];
+    int total = connections * requests;
+    double* latencies = (double*)malloc(total * sizeof(double));
+    int replies = 0, errors = 0, change = 0;
+    bool broken = false;
+    
+    double start = nowSeconds();
+    for (int c = 0; c < connections; c++) {
+        clients[c] = (Client){ .address = address, .requests = requests, .depth = depth,
+                               .seed = 1000u + c, .latencies = latencies + c * requests };
+        pthread_create(&threads[c], NULL, runClient, &clients[c]);
+    }
+    for (int c = 0; c < connections; c++) {
+        pthread_join(threads[c], NULL);
+        replies += clients[c].replies;
+        errors += clients[c].errors;
+        change += clients[c].added - clients[c].popped;
+        broken = broken || clients[c].broken;
+    }
+    double elapsed = nowSeconds() - start;
+    
+    qsort(latencies, replies, sizeof(double), compareDoubles);
+    printf("%-6s %d connection(s), depth %2d %10.0f req/s | p50 %8.1f us  p99 %8.1f us  p99.9 %8.1f us | %d ERR%s\n",
+           label, connections, depth, replies / elapsed, latencies[replies / 2] * 1e6,
+           latencies[(int)(replies * 0.99)] * 1e6, latencies[(int)(replies * 0.999)] * 1e6, errors,
+           replies == total && !broken ? "" : " MISMATCH");
+    free(latencies);
+    return replies == total && !broken ? change : INT_MIN;
+}
+
+ 
+/* Without an address the server runs on a thread of this process, over a
+   unix socket and then TCP, on a stack with the usual attachments; the
+   replies are then checked against the final task count. */
+int main(int argc, char* argv[]) {
+    int requests = argc > 1 ? atoi(argv[1]) : 50000;
+    const char* address = argc > 2 ? argv[2] : NULL;
+    int depths[] = { 1, 32 };
+    int connections[] = { 1, 2, 4, 8 };
+    
+    if (address != NULL) {
+        for (int d = 0; d < 2; d++) {
+            for (int c = 0; c < 4; c++) {
+                runLoad("remote", address, connections[c], depths[d], requests);
+            }
+        }
+        return 0;
+    }
+    
+    TaskStack stack;
+    KeywordIndex keywordIndex;
+    TaskColumns columns;
+    TaskHeap heap;
+    UndoStack undo;
+    Task task;
+    char description[MAX_DESCRIPTION];
+    char unixAddress[64];
+    
+    initializeStack(&stack);
+    initializeKeywordIndex(&keywordIndex);
+    attachKeywordIndex(&stack, &keywordIndex);
+    initializeTaskColumns(&columns);
+    attachTaskColumns(&stack, &columns);
+    initializeTaskHeap(&heap);
+    attachTaskHeap(&stack, &heap);
+    initializeUndoStack(&undo, UNDO_BUDGET);
+    attachUndoStack(&stack, &undo);
+    memset(&task, 0, sizeof(task));
+    for (int i = 0; i < 10000; i++) {
+        snprintf(description, sizeof(description), "Follow up with customer %d", i % 5000);
+        setTaskDescription(&task, description);
+        setTaskDueDate(&task, 2025, 1 + i % 12, 1 + i % 28);
+        task.importance = 1 + i % 10;
+        pushTask(&stack, task);
+    }
+    
+    snprintf(unixAddress, sizeof(unixAddress), "unix:/tmp/bench_server.%d.sock", (int)getpid());
+    const char* addresses[] = { unixAddress, "127.0.0.1:0" };
+    const char* labels[] = { "unix", "tcp" };
+    for (int a = 0; a < 2; a++) {
+        TaskServer server;
+        ServerThread thread = { &server, &stack };
+        pthread_t serverThread;
+        char tcpAddress[32];
+        int expected = getStackSize(&stack);
+        bool consistent = true;
+    
+        if (!openTaskServer(&server, addresses[a])) {
+            printf("cannot listen on %s\n", addresses[a]);
+            continue;
+        }
+        snprintf(tcpAddress, sizeof(tcpAddress), "127.0.0.1:%d", server.port);
+        pthread_create(&serverThread, NULL, runServerThread, &thread);
+        for (int d = 0; d < 2; d++) {
+            for (int c = 0; c < 4; c++) {
+                int change = runLoad(labels[a], a == 0 ? addresses[a] : tcpAddress, connections[c], depths[d],
+                                     requests);
+                consistent = consistent && change != INT_MIN;
+                expected += change != INT_MIN ? change : 0;
+            }
+        }
+        stopTaskServer(&server);
+        pthread_join(serverThread, NULL);
+        printf("%-6s %llu requests in %llu rounds, %d tasks left%s\n", labels[a],
+               (unsigned long long)server.requests, (unsigned long long)server.rounds, getStackSize(&stack),
+               consistent && expected == getStackSize(&stack) ? "" : " MISMATCH");
+        closeTaskServer(&server);
+    }
+    
+    stack.undo = NULL;
+    freeUndoStack(&undo);
+    resetStack(&stack);
+    freeKeywordIndex(&keywordIndex);
+    freeTaskColumns(&columns);
+    freeTaskHeap(&heap);
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+static long fileSize(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0 ? (long)info.st_size : -1;
+}
+
+ 
+/* The raw format the program used to write: a count, then the Task structs
+   with their descriptions inline. */
+static void writeRawFile(const TaskStack* stack, const char* path) {
+    FILE* file = fopen(path, "wb");
+    int count = getStackSize(stack);
+    TaskCursor cursor;
+    const Task* task;
+    RawTask raw;
+    
+    memset(&raw, 0, sizeof(raw));
+    fwrite(&count, sizeof(int), 1, file);
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        snprintf(raw.description, LEGACY_DESCRIPTION, "%s", getTaskDescription(task));
+        raw.dueKey = task->dueKey;
+        memcpy(raw.dueLabel, task->dueLabel, DUE_LABEL_SIZE);
+        raw.importance = task->importance;
+        raw.status = task->status;
+        raw.id = task->id;
+        raw.createdAt = task->createdAt;
+        fwrite(&raw, sizeof(RawTask), 1, file);
+    }
+    fclose(file);
+}
+
+ 
+static void runSize(int count) {
+    const char* words[] = { "Deploy", "review", "quarterly", "invoice", "backup", "refactor", "release",
+                            "documentation", "meeting", "customer", "migration", "database", "sprint" };
+    TaskStack stack;
+    TaskSnapshot snapshot;
+    Task task;
+    unsigned seed = 2024;
+    
+    memset(&task, 0, sizeof(task));
+    initializeStack(&stack);
+    for (int i = 0; i < count; i++) {
+        char description[MAX_DESCRIPTION];
+        int length = 0;
+        seed = seed * 1103515245 + 12345;
+        task.importance = 1 + (seed >> 8) % 10;
+        task.status = (TaskStatus)((seed >> 16) % 3);
+        task.createdAt = (time_t)i;
+        setTaskDueDate(&task, 2022 + (seed >> 4) % 5, 1 + (seed >> 12) % 12, 1 + (seed >> 20) % 28);
+        for (int w = 0; w < 2 + i % 6; w++) {
+            seed = seed * 1103515245 + 12345;
+            length += snprintf(description + length, MAX_DESCRIPTION - length, "%s%s",
+                               w ? " " : "", words[(seed >> 8) % 13]);
+        }
+        setTaskDescription(&task, description);
+        pushTask(&stack, task);
+    }
+    
+    double start = nowSeconds();
+    writeRawFile(&stack, FILENAME);
+    double rawSave = nowSeconds() - start;
+    long rawSize = fileSize(FILENAME);
+    
+    start = nowSeconds();
+    loadStackFromFile(&stack);
+    double rawLoad = nowSeconds() - start;
+    
+    start = nowSeconds();
+    saveStackToFile(&stack);
+    double save = nowSeconds() - start;
+    long size = fileSize(FILENAME);
+    
+    start = nowSeconds();
+    openTaskSnapshot(&snapshot, FILENAME);
+    double open = nowSeconds() - start;
+    
+    start = nowSeconds();
+    size_t touched = 0;
+    for (int i = 0; i < 1000; i++) {
+        size_t length;
+        seed = seed * 1103515245 + 12345;
+        const char* text = getSnapshotDescription(&snapshot, (int)(seed % (unsigned)count), &length);
+        touched += text != NULL ? length : 0;
+    }
+    double reads = nowSeconds() - start;
+    
+    start = nowSeconds();
+    bool valid = verifyTaskSnapshot(&snapshot);
+    double verify = nowSeconds() - start;
+    closeTaskSnapshot(&snapshot);
+    
+    start = nowSeconds();
+    bool loaded = loadStackFromFile(&stack);
+    double load = nowSeconds() - start;
+    
+    printf("%8d tasks | raw: %6.1f MB, save %8.2f ms, load %8.2f ms"
+           " | snapshot: %6.1f MB, save %8.2f ms, open %6.3f ms, 1000 in-place reads %6.3f ms,"
+           " crc %7.2f ms, load %8.2f ms%s\n",
+           count, rawSize / 1e6, rawSave * 1e3, rawLoad * 1e3,
+           size / 1e6, save * 1e3, open * 1e3, reads * 1e3, verify * 1e3, load * 1e3,
+           valid && loaded && getStackSize(&stack) == count && touched > 0 ? "" : " FAILED");
+    
+    resetStack(&stack);
+    remove(FILENAME);
+}
+
+ 
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            runSize(atoi(argv[i]));
+        }
+        return 0;
+    }
+    
+    runSize(1000);
+    runSize(100000);
+    runSize(1000000);
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* The original O(n^2) implementations, kept here only for comparison. */
+static void legacySortStackByDate(TaskStack* stack) {
+    int size = getStackSize(stack);
+    Task* tasks = (Task*)malloc(size * sizeof(Task));
+    
+    for (int i = 0; i < size; i++) {
+        popTask(stack, &tasks[i]);
+    }
+    for (int i = 0; i < size - 1; i++) {
+        for (int j = 0; j < size - i - 1; j++) {
+            if (tasks[j].dueKey > tasks[j + 1].dueKey) {
+                Task temp = tasks[j];
+                tasks[j] = tasks[j + 1];
+                tasks[j + 1] = temp;
+            }
+        }
+    }
+    for (int i = size - 1; i >= 0; i--) {
+        pushTask(stack, tasks[i]);
+    }
+    free(tasks);
+}
+
+ 
+static void legacySortStackByImportance(TaskStack* stack) {
+    int size = getStackSize(stack);
+    Task* tasks = (Task*)malloc(size * sizeof(Task));
+    
+    for (int i = 0; i < size; i++) {
+        popTask(stack, &tasks[i]);
+    }
+    for (int i = 0; i < size - 1; i++) {
+        for (int j = 0; j < size - i - 1; j++) {
+            if (tasks[j].importance < tasks[j + 1].importance) {
+                Task temp = tasks[j];
+                tasks[j] = tasks[j + 1];
+                tasks[j + 1] = temp;
+            }
+        }
+    }
+    for (int i = size - 1; i >= 0; i--) {
+        pushTask(stack, tasks[i]);
+    }
+    free(tasks);
+}
+
+ 
+static void fillStack(TaskStack* stack, int count, unsigned seed) {
+    Task task;
+    memset(&task, 0, sizeof(task));
+    setTaskDescription(&task, "Benchmark task");
+    
+    resetStack(stack);
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        task.importance = (seed >> 16) % 10 + 1;
+        setTaskDueDate(&task, 2020 + (seed >> 8) % 8, (seed >> 4) % 12 + 1, (seed >> 12) % 28 + 1);
+        task.createdAt = 1700000000 + (seed >> 3) % 1000000;
+        pushTask(stack, task);
+    }
+}
+
+ 
+static double timeSort(TaskStack* stack, int count, void (*sort)(TaskStack*)) {
+    fillStack(stack, count, 42);
+    double start = nowSeconds();
+    sort(stack);
+    return nowSeconds() - start;
+}
+
+ 
+static void sortByAllKeys(TaskStack* stack) {
+    TaskSortKey keys[] = {
+        { SORT_BY_IMPORTANCE, true },
+        { SORT_BY_DUE_DATE, false },
+        { SORT_BY_CREATED_AT, false }
+    };
+    sortStack(stack, keys, 3);
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int counts[] = { 1000, 10000, 100000, 1000000 };
+    int legacyLimit = argc > 1 ? atoi(argv[1]) : 10000;
+    TaskStack stack;
+    initializeStack(&stack);
+    
+    printf("Sort engine vs bubble sort (sort threads at 1e6 tasks: %d)\n", sortThreadCount(1000000));
+    printf("%10s | %14s %14s | %14s %14s | %14s\n", "tasks",
+           "legacy date", "engine date", "legacy import.", "engine import.", "engine 3-key");
+    
+    for (int i = 0; i < 4; i++) {
+        int count = counts[i];
+        char legacyDate[32] = "skipped";
+        char legacyImportance[32] = "skipped";
+        
+        if (count <= legacyLimit) {
+            snprintf(legacyDate, sizeof(legacyDate), "%.3f ms", timeSort(&stack, count, legacySortStackByDate) * 1e3);
+            snprintf(legacyImportance, sizeof(legacyImportance), "%.3f ms", timeSort(&stack, count, legacySortStackByImportance) * 1e3);
+        }
+        double engineDate = timeSort(&stack, count, sortStackByDate);
+        double engineImportance = timeSort(&stack, count, sortStackByImportance);
+        double engineAll = timeSort(&stack, count, sortByAllKeys);
+        
+        printf("%10d | %14s %11.3f ms | %14s %11.3f ms | %11.3f ms\n", count,
+               legacyDate, engineDate * 1e3, legacyImportance, engineImportance * 1e3, engineAll * 1e3);
+    }
+    
+    resetStack(&stack);
+    return 0;
+}
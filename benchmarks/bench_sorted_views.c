@@ -0,0 +1,130 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* A third each of pushes, pops and importance edits, the same on both stacks. */
+static void mutate(TaskStack* stack, unsigned* seed, int changes) {
+    for (int i = 0; i < changes; i++) {
+        *seed = *seed * 1103515245 + 12345;
+        unsigned roll = *seed >> 8;
+        Task task;
+        if (roll % 3 == 0) {
+            pushTask(stack, makeTask(roll, "Renew contract %u", roll % 5000));
+        } else if (roll % 3 == 1) {
+            popTask(stack, &task);
+        } else {
+            int index = (int)(roll / 3 % (unsigned)getStackSize(stack));
+            task = *getTaskAtIndex(stack, index);
+            task.importance = 1 + roll % 10;
+            editTaskAtIndex(stack, index, task);
+        }
+    }
+}
+
+ 
+/* The view must hold what a view built from nothing holds. */
+static bool sameAsRebuilt(TaskStack* stack, SortedView* view, const TaskSortKey* keys, int keyCount) {
+    SortedView fresh;
+    initializeSortedView(&fresh, keys, keyCount);
+    bool same = refreshSortedView(stack, &fresh) && fresh.count == view->count;
+    for (int i = 0; same && i < view->count; i++) {
+        same = compareSortedEntries(&fresh.entries[i], &view->entries[i]) == 0;
+    }
+    freeSortedView(&fresh);
+    return same;
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 200000;
+    TaskSortKey keys[] = { { SORT_BY_IMPORTANCE, true }, { SORT_BY_DUE_DATE, false } };
+    TaskSortKey dateKey = { SORT_BY_DUE_DATE, false };
+    TaskStack sorted, viewed;
+    SortedView importanceView, dateView;
+    unsigned seed = 7;
+    
+    initializeStack(&sorted);
+    initializeStack(&viewed);
+    for (int i = 0; i < count; i++) {
+        unsigned roll = (unsigned)i * 2654435761u;
+        Task task = makeTask(roll, "Renew contract %u", roll % 5000);
+        pushTask(&sorted, task);
+        pushTask(&viewed, task);
+    }
+    initializeSortedView(&importanceView, keys, 2);
+    attachSortedView(&viewed, &importanceView);
+    initializeSortedView(&dateView, &dateKey, 1);
+    attachSortedView(&viewed, &dateView);
+    
+    /* Reading a sorted listing after some changes: re-sorting the stack
+       against refreshing the view. The first refresh builds it. */
+    printf("%d tasks, %zu-byte view entries\n", count, sizeof(SortedEntry));
+    int changeCounts[] = { 0, 1, 64, 4096, count / 4 };
+    for (int c = 0; c < 5; c++) {
+        unsigned sortedSeed = seed;
+        mutate(&sorted, &sortedSeed, changeCounts[c]);
+        mutate(&viewed, &seed, changeCounts[c]);
+        double start = nowSeconds();
+        sortStack(&sorted, keys, 2);
+        double sortTime = nowSeconds() - start;
+        uint64_t merges = importanceView.merges;
+        start = nowSeconds();
+        refreshSortedView(&viewed, &importanceView);
+        double viewTime = nowSeconds() - start;
+        bool same = sameAsRebuilt(&viewed, &importanceView, keys, 2) && importanceView.count == getStackSize(&sorted);
+        printf("%6d change(s): sortStack %9.3f ms | view %s %9.3f ms  (%.1fx)%s\n", changeCounts[c], sortTime * 1e3,
+               importanceView.merges > merges ? "merge  " : "rebuild", viewTime * 1e3, sortTime / viewTime,
+               same ? "" : " MISMATCH");
+    }
+    
+    /* What two attached views add to each change, and one refresh of both
+       after all of them; few enough changes that they are merged. */
+    int ops = count / SORTED_VIEW_REBUILD_RATIO / 2;
+    refreshSortedView(&viewed, &importanceView);
+    refreshSortedView(&viewed, &dateView);
+    double start = nowSeconds();
+    mutate(&viewed, &seed, ops);
+    double attached = nowSeconds() - start;
+    start = nowSeconds();
+    refreshSortedView(&viewed, &importanceView);
+    refreshSortedView(&viewed, &dateView);
+    double refresh = nowSeconds() - start;
+    bool same = sameAsRebuilt(&viewed, &importanceView, keys, 2) && sameAsRebuilt(&viewed, &dateView, &dateKey, 1) &&
+                importanceView.rebuilds == 2 && dateView.rebuilds == 1;
+    detachSortedView(&viewed, &importanceView);
+    detachSortedView(&viewed, &dateView);
+    start = nowSeconds();
+    mutate(&viewed, &seed, ops);
+    double bare = nowSeconds() - start;
+    printf("%d changes: %.0f ns/change with two views attached, %.0f ns/change with none; both merged in %.3f ms%s\n",
+           ops, attached / ops * 1e9, bare / ops * 1e9, refresh * 1e3, same ? "" : " MISMATCH");
+    
+    /* The 10 most important pending tasks: partial selection against a full
+       sort of the same records, and the prefix of the full order. */
+    TaskFilter pending;
+    initializeTaskFilter(&pending);
+    pending.statusMask = 1u << PENDING;
+    int size = getStackSize(&viewed);
+    int* all = (int*)malloc(size * sizeof(int));
+    int* top = (int*)malloc(size * sizeof(int));
+    int ks[] = { 10, 1000 };
+    start = nowSeconds();
+    int matching = selectTopTasks(&viewed, keys, 2, &pending, size, all);
+    double full = nowSeconds() - start;
+    for (int i = 0; i < 2; i++) {
+        start = nowSeconds();
+        int selected = selectTopTasks(&viewed, keys, 2, &pending, ks[i], top);
+        double partial = nowSeconds() - start;
+        same = selected == (ks[i] < matching ? ks[i] : matching) && memcmp(top, all, selected * sizeof(int)) == 0;
+        printf("top %4d of %d pending: selection %8.3f ms | full sort %8.3f ms  (%.1fx)%s\n", ks[i], matching,
+               partial * 1e3, full * 1e3, full / partial, same ? "" : " MISMATCH");
+    }
+    
+    free(all);
+    free(top);
+    freeSortedView(&importanceView);
+    freeSortedView(&dateView);
+    resetStack(&sorted);
+    resetStack(&viewed);
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+static void benchPushPop(int count) {
+    TaskStack stack;
+    Task task;
+    memset(&task, 0, sizeof(task));
+    setTaskDescription(&task, "Benchmark task");
+    setTaskDueDate(&task, 2025, 4, 10);
+    task.importance = 5;
+    
+    initializeStack(&stack);
+    
+    double start = nowSeconds();
+    for (int i = 0; i < count; i++) {
+        task.importance = i % 10 + 1;
+        if (!pushTask(&stack, task)) {
+            printf("push failed at %d\n", i);
+            exit(1);
+        }
+    }
+    double pushTime = nowSeconds() - start;
+    
+     
+    Task* first = getTaskAtIndex(&stack, 0);
+    
+    long checksum = 0;
+    start = nowSeconds();
+    while (popTask(&stack, &task)) {
+        checksum += task.importance;
+    }
+    double popTime = nowSeconds() - start;
+    
+     
+    start = nowSeconds();
+    for (int i = 0; i < count; i++) {
+        pushTask(&stack, task);
+    }
+    double repushTime = nowSeconds() - start;
+    
+    if (getTaskAtIndex(&stack, 0) != first) {
+        printf("chunk storage moved after regrowth\n");
+        exit(1);
+    }
+    
+    start = nowSeconds();
+    resetStack(&stack);
+    double resetTime = nowSeconds() - start;
+    
+    printf("%10d | push %8.2f Mops/s %6.1f ns | pop %8.2f Mops/s %6.1f ns | re-push %8.2f Mops/s | reset %8.3f ms | checksum %ld\n",
+           count,
+           count / pushTime / 1e6, pushTime * 1e9 / count,
+           count / popTime / 1e6, popTime * 1e9 / count,
+           count / repushTime / 1e6,
+           resetTime * 1e3,
+           checksum);
+}
+
+ 
+static void benchRemoveEdit(int count) {
+    TaskStack stack;
+    UndoStack journal;
+    Task task;
+    memset(&task, 0, sizeof(task));
+    setTaskDescription(&task, "Benchmark task");
+    setTaskDueDate(&task, 2025, 4, 10);
+    
+    initializeStack(&stack);
+    for (int i = 0; i < count; i++) {
+        task.importance = i % 10 + 1;
+        pushTask(&stack, task);
+    }
+    
+    int operations = count / 2;
+    unsigned seed = 12345;
+    
+    double start = nowSeconds();
+    for (int i = 0; i < operations; i++) {
+        seed = seed * 1103515245 + 12345;
+        task.importance = i % 10 + 1;
+        editTaskAtIndex(&stack, (int)(seed >> 8) % getStackSize(&stack), task);
+    }
+    double editTime = nowSeconds() - start;
+    
+    /* The same edits again with the undo journal recording field deltas. */
+    initializeUndoStack(&journal, UNDO_BUDGET);
+    attachUndoStack(&stack, &journal);
+    start = nowSeconds();
+    for (int i = 0; i < operations; i++) {
+        seed = seed * 1103515245 + 12345;
+        task.importance = i % 10 + 1;
+        editTaskAtIndex(&stack, (int)(seed >> 8) % getStackSize(&stack), task);
+    }
+    double journalTime = nowSeconds() - start;
+    int undone = 0;
+    start = nowSeconds();
+    while (undoLastOperation(&stack, &journal)) {
+        undone++;
+    }
+    double undoTime = nowSeconds() - start;
+    stack.undo = NULL;
+    freeUndoStack(&journal);
+    
+    start = nowSeconds();
+    for (int i = 0; i < operations; i++) {
+        seed = seed * 1103515245 + 12345;
+        removeTaskAtIndex(&stack, (int)(seed >> 8) % getStackSize(&stack));
+    }
+    double removeTime = nowSeconds() - start;
+    
+    printf("%10d | edit %8.2f Mops/s %6.1f ns | remove %8.2f Mops/s %6.1f ns (random index, %d each)\n",
+           count,
+           operations / editTime / 1e6, editTime * 1e9 / operations,
+           operations / removeTime / 1e6, removeTime * 1e9 / operations,
+           operations);
+    printf("%10s | edit with undo journal %6.1f ns | undo %6.1f ns (%d entries kept in %d KB)\n",
+           "", journalTime * 1e9 / operations, undone ? undoTime * 1e9 / undone : 0.0,
+           undone, UNDO_BUDGET >> 10);
+    resetStack(&stack);
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int defaultCounts[] = { 1000, 100000, 10000000 };
+    
+    printf("TaskStack push/pop throughput (sizeof(Task) = %zu, chunk = %d tasks)\n",
+           sizeof(Task), TASK_CHUNK_SIZE);
+    
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            benchPushPop(atoi(argv[i]));
+        }
+        for (int i = 1; i < argc; i++) {
+            benchRemoveEdit(atoi(argv[i]));
+        }
+    } else {
+        for (int i = 0; i < 3; i++) {
+            benchPushPop(defaultCounts[i]);
+        }
+        for (int i = 0; i < 2; i++) {
+            benchRemoveEdit(defaultCounts[i]);
+        }
+    }
+    return 0;
+}
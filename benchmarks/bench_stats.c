@@ -0,0 +1,208 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+typedef struct {
+    int ops;
+    double seconds;
+} StatsWorker;
+
+ 
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+ 
+/* The mix the stack sees from the menu and the server: 40% push, 30% pop,
+   20% peek and 10% edit of the top task, 9 calls in 10 succeeding. */
+static void runMix(TaskStack* stack, int ops, unsigned seed) {
+    Task task = makeTask(seed, "Follow up with customer %u about the invoice", seed % 5000);
+    for (int i = 0; i < ops; i++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned roll = (seed >> 8) % 10;
+        if (roll < 4) {
+            pushTask(stack, task);
+        } else if (roll < 7) {
+            popTask(stack, &task);
+        } else if (roll < 9) {
+            peekTask(stack, &task);
+        } else {
+            task.importance = 1 + (seed >> 4) % 10;
+            editTaskAtIndex(stack, getStackSize(stack) - 1, task);
+        }
+    }
+}
+
+ 
+/* Runs the mix on one stack of `base` tasks in chunks of 20000 ops, two
+   at a time, one with the stats on and one with them off, in alternating
+   order. The overhead is the median of the pairs' ratios, which a noisy
+   neighbour moves far less than a ratio of two long runs. */
+static double measureOverhead(bool attached, int base, int ops, double* on, double* off) {
+    int chunk = 20000;
+    int pairs = ops / (2 * chunk) > 0 ? ops / (2 * chunk) : 1;
+    double* ratios = (double*)malloc(pairs * sizeof(double));
+    TaskStack stack;
+    KeywordIndex keywordIndex;
+    UndoStack undo;
+    
+    initializeStack(&stack);
+    if (attached) {
+        initializeKeywordIndex(&keywordIndex);
+        attachKeywordIndex(&stack, &keywordIndex);
+        initializeUndoStack(&undo, UNDO_BUDGET);
+        attachUndoStack(&stack, &undo);
+    }
+    for (int i = 0; i < base; i++) {
+        unsigned seed = (unsigned)i * 2654435761u;
+        pushTask(&stack, makeTask(seed, "Follow up with customer %u about the invoice", seed % 5000));
+    }
+    
+    *on = *off = 0;
+    for (int p = 0; p < pairs; p++) {
+        double elapsed[2];
+        for (int half = 0; half < 2; half++) {
+            bool enabled = (p + half) % 2 == 0;
+            setStatsEnabled(enabled);
+            double start = nowSeconds();
+            runMix(&stack, chunk, 4242u + p);
+            elapsed[enabled] = nowSeconds() - start;
+        }
+        *on += elapsed[1];
+        *off += elapsed[0];
+        ratios[p] = elapsed[1] / elapsed[0];
+    }
+    setStatsEnabled(true);
+    qsort(ratios, pairs, sizeof(double), compareDoubles);
+    double median = ratios[pairs / 2];
+    *on /= (double)pairs * chunk;
+    *off /= (double)pairs * chunk;
+    
+    free(ratios);
+    if (attached) {
+        stack.undo = NULL;
+        freeUndoStack(&undo);
+    }
+    resetStack(&stack);
+    if (attached) {
+        freeKeywordIndex(&keywordIndex);
+    }
+    return (median - 1) * 100;
+}
+
+ 
+static void* runStatsWorker(void* argument) {
+    StatsWorker* worker = (StatsWorker*)argument;
+    TaskStack stack;
+    Task task = makeTask(7, "Follow up with customer %u about the invoice", 7);
+    initializeStack(&stack);
+    double start = nowSeconds();
+    for (int i = 0; i < worker->ops; i++) {
+        pushTask(&stack, task);
+    }
+    for (int i = 0; i < worker->ops; i++) {
+        popTask(&stack, &task);
+    }
+    worker->seconds = nowSeconds() - start;
+    resetStack(&stack);
+    return NULL;
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int ops = argc > 1 ? atoi(argv[1]) : 2000000;
+    int base = argc > 2 ? atoi(argv[2]) : 100000;
+    TaskStats* before = (TaskStats*)malloc(sizeof(TaskStats));
+    TaskStats* after = (TaskStats*)malloc(sizeof(TaskStats));
+    double on, off;
+    
+    printf("%d mixed ops on %d tasks, 1 call in %d of the cheap ones timed\n", ops, base, STAT_SAMPLE_EVERY);
+    /* A bare stack is the worst case, a call there being only a few times
+       the cost of counting it; the budget applies to the stack the menu and
+       the server run, with an index and an undo journal attached. */
+    for (int attached = 0; attached < 2; attached++) {
+        double overhead = measureOverhead(attached, base, ops, &on, &off);
+        printf("%-28s stats on %6.1f ns/op | off %6.1f ns/op | overhead %+5.1f%%%s\n",
+               attached ? "with keyword index and undo" : "bare stack", on * 1e9, off * 1e9, overhead,
+               !attached || overhead < 5 ? "" : " MISMATCH");
+    }
+    
+    /* Slow operations are timed on every call: sorting and searching 1M
+       tasks, with and without the stats. */
+    TaskStack stack;
+    KeywordIndex keywordIndex;
+    initializeStack(&stack);
+    initializeKeywordIndex(&keywordIndex);
+    attachKeywordIndex(&stack, &keywordIndex);
+    for (int i = 0; i < 1000000; i++) {
+        unsigned seed = (unsigned)i * 2654435761u;
+        pushTask(&stack, makeTask(seed, "Follow up with customer %u about the invoice", seed % 5000));
+    }
+    for (int enabled = 1; enabled >= 0; enabled--) {
+        setStatsEnabled(enabled);
+        double start = nowSeconds();
+        sortStackByImportance(&stack);
+        sortStackByDate(&stack);
+        double sorting = nowSeconds() - start;
+        start = nowSeconds();
+        for (int q = 0; q < 1000; q++) {
+            uint32_t* ids;
+            char query[32];
+            snprintf(query, sizeof(query), "customer %d", q);
+            queryKeywordIndex(&keywordIndex, query, &ids);
+            free(ids);
+        }
+        printf("stats %-3s 2 sorts of 1M tasks %8.2f ms | 1000 keyword queries %8.2f ms\n", enabled ? "on" : "off",
+               sorting * 1e3, (nowSeconds() - start) * 1e3);
+    }
+    setStatsEnabled(true);
+    resetStack(&stack);
+    freeKeywordIndex(&keywordIndex);
+    
+    /* Counts from several threads add up exactly, a thread started after
+       another has exited takes over its block, and the percentiles come
+       out in order. */
+    StatsWorker workers[4];
+    pthread_t threads[4];
+    collectStats(before);
+    for (int t = 0; t < 4; t++) {
+        workers[t] = (StatsWorker){ .ops = ops / 4 };
+        pthread_create(&threads[t], NULL, runStatsWorker, &workers[t]);
+        if (t == 1) {
+            pthread_join(threads[0], NULL);
+        }
+    }
+    for (int t = 1; t < 4; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    collectStats(after);
+    
+    uint64_t pushes = after->calls[STAT_PUSH] - before->calls[STAT_PUSH];
+    uint64_t pops = after->calls[STAT_POP] - before->calls[STAT_POP];
+    uint64_t timed = after->timed[STAT_PUSH] - before->timed[STAT_PUSH];
+    uint64_t p50 = statPercentile(after, STAT_PUSH, 50);
+    uint64_t p99 = statPercentile(after, STAT_PUSH, 99);
+    uint64_t max = statPercentile(after, STAT_PUSH, 100);
+    int blocks = 0;
+    for (const ThreadStats* block = statsBlocks; block != NULL; block = block->next) {
+        blocks++;
+    }
+    bool exact = pushes == (uint64_t)(4 * (ops / 4)) && pops == pushes && after->threads == before->threads &&
+                 timed > 0 && p50 <= p99 && p99 <= max && blocks <= 4;
+    printf("4 threads: %llu pushes, %llu pops counted, %llu timed; push p50 %llu ns, p99 %llu ns, max %llu ns; "
+           "%d of %d stats block(s) in use%s\n", (unsigned long long)pushes, (unsigned long long)pops,
+           (unsigned long long)timed, (unsigned long long)p50, (unsigned long long)p99, (unsigned long long)max,
+           after->threads, blocks, exact ? "" : " MISMATCH");
+    
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/bench_stats.%d.prom", (int)getpid());
+    double start = nowSeconds();
+    bool written = writeStatsFile(path, NULL);
+    printf("Prometheus file written in %.2f ms%s\n", (nowSeconds() - start) * 1e3, written ? "" : " MISMATCH");
+    remove(path);
+    free(before);
+    free(after);
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* Descriptions drawn from a vocabulary of the given size; distinct == count
+   makes every description unique. */
+static void makeDescription(char* description, unsigned seed, int distinct) {
+    snprintf(description, MAX_DESCRIPTION, "Follow up with customer %u about the quarterly invoice",
+             seed % (unsigned)distinct);
+}
+
+ 
+static int compareRawTasks(const void* a, const void* b) {
+    const RawTask* x = (const RawTask*)a;
+    const RawTask* y = (const RawTask*)b;
+    if (x->importance != y->importance) {
+        return y->importance - x->importance;
+    }
+    return x->dueKey < y->dueKey ? -1 : x->dueKey > y->dueKey;
+}
+
+ 
+static int compareTasks(const void* a, const void* b) {
+    const Task* x = (const Task*)a;
+    const Task* y = (const Task*)b;
+    if (x->importance != y->importance) {
+        return y->importance - x->importance;
+    }
+    return x->dueKey < y->dueKey ? -1 : x->dueKey > y->dueKey;
+}
+
+ 
+/* Bytes per task for a stack of count tasks: the records plus whatever the
+   pool grew by while they were pushed. */
+static void measureMemory(int count, int distinct, bool interning) {
+    TaskStack stack;
+    Task task;
+    char description[MAX_DESCRIPTION];
+    unsigned seed = 4242;
+    
+    setStringInterning(interning);
+    uint64_t before = stringPool.bytes;
+    memset(&task, 0, sizeof(task));
+    initializeStack(&stack);
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        makeDescription(description, distinct == count ? (unsigned)i : seed >> 8, distinct);
+        setTaskDescription(&task, description);
+        task.importance = 1 + i % 10;
+        pushTask(&stack, task);
+    }
+    double pooled = (double)(stringPool.bytes - before) / count;
+    
+    bool intact = true;
+    for (int i = 0; i < count && intact; i += count / 1000 + 1) {
+        const Task* stored = getTaskAtIndex(&stack, i);
+        intact = strncmp(getTaskDescription(stored), "Follow up with customer ", 24) == 0 &&
+                 strlen(getTaskDescription(stored)) == stored->descriptionLength;
+    }
+    printf("%8d distinct, interning %-3s | %6.1f B/task (%zu record + %6.1f pool) vs %zu inline%s\n", distinct,
+           interning ? "on" : "off", sizeof(Task) + pooled, sizeof(Task), pooled, sizeof(RawTask),
+           intact ? "" : " MISMATCH");
+    resetStack(&stack);
+    setStringInterning(true);
+}
+
+ 
+/* Streams count unique descriptions through a stack that keeps the newest
+   depth of them. Removed text is reclaimed and its slots reused, so the
+   pool grows with depth rather than with count. */
+static void measureChurn(int count, int depth) {
+    TaskStack stack;
+    Task task;
+    char description[MAX_DESCRIPTION];
+    char expected[MAX_DESCRIPTION];
+    bool intact = true;
+    
+    uint64_t before = stringPool.bytes;
+    uint32_t blocks = stringPool.blockCount;
+    memset(&task, 0, sizeof(task));
+    initializeStack(&stack);
+    double start = nowSeconds();
+    for (int i = 0; i < count; i++) {
+        makeDescription(description, (unsigned)i, count);
+        setTaskDescription(&task, description);
+        pushTask(&stack, task);
+        if (i >= depth) {
+            makeDescription(expected, (unsigned)(i - depth), count);
+            intact = intact && strcmp(getTaskDescription(getTaskAtIndex(&stack, 0)), expected) == 0;
+            removeTaskAtIndex(&stack, 0);
+        }
+    }
+    double elapsed = nowSeconds() - start;
+    printf("churn %d unique through %d live | %6.1f ns/op, pool %+.1f MB, %u new block(s), %.1f MB free%s\n", count,
+           depth, elapsed * 1e9 / count, ((double)stringPool.bytes - (double)before) / 1e6,
+           stringPool.blockCount - blocks, stringPool.freeBytes / 1e6, intact ? "" : " MISMATCH");
+    resetStack(&stack);
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    char description[MAX_DESCRIPTION];
+    unsigned seed = 99;
+    
+    printf("%d tasks, sizeof(Task) %zu, inline layout %zu\n", count, sizeof(Task), sizeof(RawTask));
+    measureMemory(count, 1000, true);
+    measureMemory(count, 1000, false);
+    measureMemory(count, count, true);
+    measureChurn(count * 4, 10000);
+    
+    Task* tasks = (Task*)malloc(count * sizeof(Task));
+    Task* taskCopies = (Task*)malloc(count * sizeof(Task));
+    RawTask* raws = (RawTask*)malloc(count * sizeof(RawTask));
+    RawTask* rawCopies = (RawTask*)malloc(count * sizeof(RawTask));
+    memset(tasks, 0, count * sizeof(Task));
+    memset(raws, 0, count * sizeof(RawTask));
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        makeDescription(description, seed >> 8, 1000);
+        setTaskDescription(&tasks[i], description);
+        snprintf(raws[i].description, LEGACY_DESCRIPTION, "%s", description);
+        tasks[i].importance = raws[i].importance = 1 + (seed >> 4) % 10;
+        tasks[i].dueKey = raws[i].dueKey = (int)((seed >> 12) % 100000);
+    }
+    
+    /* Copying and sorting move whole records, so both scale with their size. */
+    double start = nowSeconds();
+    memcpy(taskCopies, tasks, count * sizeof(Task));
+    double taskCopy = nowSeconds() - start;
+    start = nowSeconds();
+    memcpy(rawCopies, raws, count * sizeof(RawTask));
+    double rawCopy = nowSeconds() - start;
+    printf("%-28s %8.2f ms handles | %8.2f ms inline  (%.2fx)\n", "copy every task", taskCopy * 1e3,
+           rawCopy * 1e3, rawCopy / taskCopy);
+    
+    start = nowSeconds();
+    qsort(taskCopies, count, sizeof(Task), compareTasks);
+    double taskSort = nowSeconds() - start;
+    start = nowSeconds();
+    qsort(rawCopies, count, sizeof(RawTask), compareRawTasks);
+    double rawSort = nowSeconds() - start;
+    
+    bool sameOrder = true;
+    for (int i = 0; i < count && sameOrder; i++) {
+        sameOrder = taskCopies[i].importance == rawCopies[i].importance &&
+                    taskCopies[i].dueKey == rawCopies[i].dueKey;
+    }
+    printf("%-28s %8.2f ms handles | %8.2f ms inline  (%.2fx)%s\n", "qsort by importance, due", taskSort * 1e3,
+           rawSort * 1e3, rawSort / taskSort, sameOrder ? "" : " MISMATCH");
+    
+    TaskStack stack;
+    initializeStack(&stack);
+    for (int i = 0; i < count; i++) {
+        pushTask(&stack, tasks[i]);
+    }
+    start = nowSeconds();
+    sortStackByImportance(&stack);
+    printf("%-28s %8.2f ms\n", "sortStackByImportance", (nowSeconds() - start) * 1e3);
+    printf("pool: %u block(s), %.1f MB of text, %u interned strings\n", stringPool.blockCount,
+           stringPool.bytes / 1e6, stringPool.internCount);
+    
+    resetStack(&stack);
+    free(tasks);
+    free(taskCopies);
+    free(raws);
+    free(rawCopies);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#define _GNU_SOURCE
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+static int countWithLibc(const TaskStack* stack, const char* needle, bool ignoreCase) {
+    TaskCursor cursor;
+    const Task* task;
+    int matches = 0;
+    
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        const char* description = getTaskDescription(task);
+        const char* hit = ignoreCase ? strcasestr(description, needle) : strstr(description, needle);
+        matches += hit != NULL;
+    }
+    return matches;
+}
+
+ 
+static int countWithScanner(const TaskStack* stack, const char* needle, bool ignoreCase) {
+    TaskCursor cursor;
+    const Task* task;
+    SubstringMatcher matcher;
+    int matches = 0;
+    
+    prepareSubstringMatcher(&matcher, needle, ignoreCase);
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        matches += matchSubstring(&matcher, getTaskDescription(task), descriptionReadable(task));
+    }
+    return matches;
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    const char* words[] = { "Deploy", "review", "quarterly", "invoice", "backup", "refactor", "release",
+                            "documentation", "meeting", "customer", "migration", "database", "sprint" };
+    const char* needles[] = { "database migration", "Invoice", "zzz-not-present" };
+    const char* levelNames[] = { "scalar", "sse2", "avx2" };
+    TaskStack stack;
+    Task task;
+    unsigned seed = 99;
+    
+    memset(&task, 0, sizeof(task));
+    setTaskDueDate(&task, 2025, 4, 10);
+    initializeStack(&stack);
+    for (int i = 0; i < count; i++) {
+        char description[MAX_DESCRIPTION];
+        int length = 0;
+        int wordCount = 2 + i % 6;
+        for (int w = 0; w < wordCount; w++) {
+            seed = seed * 1103515245 + 12345;
+            length += snprintf(description + length, MAX_DESCRIPTION - length, "%s%s",
+                               w ? " " : "", words[(seed >> 8) % 13]);
+        }
+        setTaskDescription(&task, description);
+        pushTask(&stack, task);
+    }
+    
+    printf("%d tasks, best scanner: %s\n", count, levelNames[detectSubstringScanLevel()]);
+    
+    for (int ignoreCase = 0; ignoreCase <= 1; ignoreCase++) {
+        for (int n = 0; n < 3; n++) {
+            double start = nowSeconds();
+            int expected = countWithLibc(&stack, needles[n], ignoreCase);
+            double libcTime = nowSeconds() - start;
+            
+            printf("%-20s %-11s %-10s %8.2f ms (%d hits)", needles[n], ignoreCase ? "ignorecase" : "exact",
+                   ignoreCase ? "strcasestr" : "strstr", libcTime * 1e3, expected);
+            
+            for (int level = SCAN_SCALAR; level <= (int)detectSubstringScanLevel(); level++) {
+                setSubstringScanLevel((SubstringScanLevel)level);
+                start = nowSeconds();
+                int matches = countWithScanner(&stack, needles[n], ignoreCase);
+                double scanTime = nowSeconds() - start;
+                printf(" | %s %7.2f ms %5.2fx%s", levelNames[level], scanTime * 1e3, libcTime / scanTime,
+                       matches == expected ? "" : " MISMATCH");
+            }
+            printf("\n");
+        }
+    }
+    
+    resetStack(&stack);
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+/* A reader scanning the stack while a writer edits it: either through a
+   view, or through the stack itself behind one mutex. */
+typedef struct {
+    TaskStack* stack;
+    pthread_mutex_t* lock;
+    atomic_bool* stop;
+    int scans;
+    bool changed;
+} Reader;
+
+ 
+static uint64_t digestTasks(const TaskStack* stack) {
+    TaskCursor cursor;
+    const Task* task;
+    uint64_t hash = 1469598103934665603ULL;
+    
+    openTaskCursor(&cursor, stack);
+    while ((task = nextTaskFromCursor(&cursor)) != NULL) {
+        hash = (hash ^ (uint64_t)task->importance ^ ((uint64_t)task->dueKey << 8)) * 1099511628211ULL;
+        hash = (hash ^ (unsigned char)getTaskDescription(task)[0]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+ 
+static void* runReader(void* argument) {
+    Reader* reader = (Reader*)argument;
+    while (!atomic_load(reader->stop)) {
+        if (reader->lock != NULL) {
+            pthread_mutex_lock(reader->lock);
+            digestTasks(reader->stack);
+            pthread_mutex_unlock(reader->lock);
+        } else {
+            TaskStack view;
+            openStackView(reader->stack, &view);
+            uint64_t first = digestTasks(&view);
+            reader->changed |= digestTasks(&view) != first;
+            closeStackView(&view);
+        }
+        reader->scans++;
+    }
+    return NULL;
+}
+
+ 
+static void fillStack(TaskStack* stack, int count) {
+    Task task;
+    char description[MAX_DESCRIPTION];
+    unsigned seed = 12345;
+    memset(&task, 0, sizeof(task));
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        task.importance = 1 + (seed >> 8) % 10;
+        task.createdAt = (time_t)i;
+        setTaskDueDate(&task, 2024 + (seed >> 4) % 3, 1 + (seed >> 12) % 12, 1 + (seed >> 20) % 28);
+        snprintf(description, MAX_DESCRIPTION, "Task %d for the view benchmark", i);
+        setTaskDescription(&task, description);
+        pushTask(stack, task);
+    }
+}
+
+ 
+/* Edits random tasks for the given time and returns edits per second;
+   the slowest single edit goes to worst. */
+static double runWriter(TaskStack* stack, pthread_mutex_t* lock, double seconds, double* worst) {
+    unsigned seed = 777;
+    int edits = 0;
+    double start = nowSeconds();
+    double now = start;
+    *worst = 0;
+    
+    while (now - start < seconds) {
+        seed = seed * 1103515245 + 12345;
+        int index = (int)(seed >> 4) % getStackSize(stack);
+        double before = nowSeconds();
+        if (lock != NULL) {
+            pthread_mutex_lock(lock);
+        }
+        Task task = *getTaskAtIndex(stack, index);
+        task.importance = 1 + (seed >> 8) % 10;
+        editTaskAtIndex(stack, index, task);
+        if (lock != NULL) {
+            pthread_mutex_unlock(lock);
+        }
+        now = nowSeconds();
+        *worst = now - before > *worst ? now - before : *worst;
+        edits++;
+    }
+    return edits / (now - start);
+}
+
+ 
+static void runContention(TaskStack* stack, const char* label, bool reading, bool locked) {
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    atomic_bool stop = false;
+    Reader reader = { stack, locked ? &lock : NULL, &stop, 0, false };
+    pthread_t thread;
+    double worst;
+    
+    if (reading) {
+        pthread_create(&thread, NULL, runReader, &reader);
+    }
+    double rate = runWriter(stack, locked ? &lock : NULL, 1.0, &worst);
+    atomic_store(&stop, true);
+    if (reading) {
+        pthread_join(thread, NULL);
+    }
+    printf("%-36s %10.0f edits/s  worst edit %8.3f ms  %4d full scans%s\n", label, rate, worst * 1e3,
+           reader.scans, reader.changed ? " MISMATCH" : "");
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    TaskStack stack;
+    TaskStack view;
+    double worst;
+    
+    initializeStack(&stack);
+    fillStack(&stack, count);
+    printf("%d tasks\n", count);
+    
+    /* What a consistent read used to cost: a copy of every chunk. */
+    double start = nowSeconds();
+    TaskChunk** copies = (TaskChunk**)malloc(stack.chunkCount * sizeof(TaskChunk*));
+    for (int c = 0; c < stack.chunkCount; c++) {
+        copies[c] = (TaskChunk*)malloc(sizeof(TaskChunk));
+        memcpy(copies[c], stack.chunks[c], sizeof(TaskChunk));
+    }
+    double copyTime = nowSeconds() - start;
+    for (int c = 0; c < stack.chunkCount; c++) {
+        free(copies[c]);
+    }
+    free(copies);
+    
+    int opens = 100000;
+    start = nowSeconds();
+    for (int i = 0; i < opens; i++) {
+        openStackView(&stack, &view);
+        closeStackView(&view);
+    }
+    double openTime = (nowSeconds() - start) / opens;
+    printf("%-36s %10.2f ms\n", "copy of every chunk", copyTime * 1e3);
+    printf("%-36s %10.3f us\n", "openStackView + closeStackView", openTime * 1e6);
+    
+    /* The first write to each chunk after a view opens pays for its copy. */
+    openStackView(&stack, &view);
+    uint64_t before = digestTasks(&view);
+    double fresh = runWriter(&stack, NULL, 0.5, &worst);
+    bool intact = digestTasks(&view) == before;
+    closeStackView(&view);
+    double settled = runWriter(&stack, NULL, 0.5, &worst);
+    printf("%-36s %10.0f edits/s vs %.0f with no view open%s\n", "edits right after a view opens", fresh,
+           settled, intact ? "" : " MISMATCH");
+    
+    runContention(&stack, "edits, no reader", false, false);
+    runContention(&stack, "edits, reader holding a mutex", true, true);
+    runContention(&stack, "edits, reader on a view", true, false);
+    
+    start = nowSeconds();
+    saveStackToFile(&stack);
+    double saveTime = nowSeconds() - start;
+    
+    openStackView(&stack, &view);
+    before = digestTasks(&view);
+    start = nowSeconds();
+    saveStackInBackground(&stack);
+    double startTime = nowSeconds() - start;
+    int edits = 0;
+    worst = 0;
+    while (backgroundSave.running && !atomic_load(&backgroundSave.done)) {
+        double slowest;
+        runWriter(&stack, NULL, 0.001, &slowest);
+        worst = slowest > worst ? slowest : worst;
+        edits++;
+    }
+    double saveWall = nowSeconds() - start;
+    finishBackgroundSave(true);
+    
+    TaskStack loaded;
+    initializeStack(&loaded);
+    bool saved = loadStackFromFile(&loaded) && digestTasks(&loaded) == before;
+    printf("%-36s %10.2f ms with every edit waiting\n", "saveStackToFile", saveTime * 1e3);
+    printf("%-36s %10.3f ms to start, %.2f ms to finish, worst edit meanwhile %.3f ms%s\n",
+           "saveStackInBackground", startTime * 1e3, saveWall * 1e3, worst * 1e3, saved ? "" : " MISMATCH");
+    
+    closeStackView(&view);
+    resetStack(&loaded);
+    resetStack(&stack);
+    remove(FILENAME);
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "../TaskManagement_Stacks.c"
+#include "bench_common.h"
+
+ 
+static void fillStack(TaskStack* stack, int count) {
+    for (int i = 0; i < count; i++) {
+        pushTask(stack, makeTask((unsigned)i, "Logged task %u for the durability benchmark", (unsigned)i));
+    }
+}
+
+ 
+/* Mixed mutations: pushes, edits and pops in a 2:1:1 ratio. */
+static void mutate(TaskStack* stack, int i) {
+    unsigned seed = (unsigned)i * 2654435761u;
+    Task task = makeTask(seed, "Logged task %u for the durability benchmark", seed);
+    if (i % 4 < 2) {
+        pushTask(stack, task);
+    } else if (i % 4 == 2) {
+        editTaskAtIndex(stack, i % getStackSize(stack), task);
+    } else {
+        popTask(stack, &task);
+    }
+}
+
+ 
+static void runLogged(const char* label, int baseSize, int operations, int groupRecords) {
+    static WriteAheadLog wal;
+    TaskStack stack;
+    
+    remove(FILENAME);
+    remove(WAL_FILENAME);
+    initializeStack(&stack);
+    fillStack(&stack, baseSize);
+    saveStackToFile(&stack);
+    
+    openWriteAheadLog(&wal, WAL_FILENAME);
+    wal.groupRecords = groupRecords;
+    attachWriteAheadLog(&stack, &wal);
+    
+    double start = nowSeconds();
+    for (int i = 0; i < operations; i++) {
+        mutate(&stack, i);
+    }
+    syncWriteAheadLog(&wal);
+    double elapsed = nowSeconds() - start;
+    
+    printf("%-28s %8.2f us/op  (%d ops, %llu fsyncs, %lld log bytes)\n", label, elapsed * 1e6 / operations,
+           operations, (unsigned long long)wal.syncs, (long long)wal.fileSize);
+    
+    closeWriteAheadLog(&wal);
+    resetStack(&stack);
+}
+
+ 
+int main(int argc, char* argv[]) {
+    int baseSize = argc > 1 ? atoi(argv[1]) : 100000;
+    int operations = argc > 2 ? atoi(argv[2]) : 20000;
+    static WriteAheadLog wal;
+    TaskStack stack;
+    
+    printf("stack of %d tasks\n", baseSize);
+    
+    initializeStack(&stack);
+    fillStack(&stack, baseSize);
+    int rewrites = operations / 100 > 0 ? operations / 100 : 1;
+    double start = nowSeconds();
+    for (int i = 0; i < rewrites; i++) {
+        mutate(&stack, i);
+        saveStackToFile(&stack);
+    }
+    double elapsed = nowSeconds() - start;
+    printf("%-28s %8.2f us/op  (%d ops)\n", "full save after each op", elapsed * 1e6 / rewrites, rewrites);
+    resetStack(&stack);
+    
+    runLogged("log, fsync every op", baseSize, rewrites * 10, 1);
+    runLogged("log, group commit of 64", baseSize, operations, 64);
+    runLogged("log, group commit of 1024", baseSize, operations, 1024);
+    
+    /* Recovery: a snapshot plus five times as many logged operations. */
+    remove(FILENAME);
+    remove(WAL_FILENAME);
+    initializeStack(&stack);
+    fillStack(&stack, baseSize);
+    saveStackToFile(&stack);
+    openWriteAheadLog(&wal, WAL_FILENAME);
+    wal.groupRecords = 1024;
+    wal.checkpointBytes = (off_t)1 << 40;
+    attachWriteAheadLog(&stack, &wal);
+    for (int i = 0; i < operations * 5; i++) {
+        mutate(&stack, i);
+    }
+    closeWriteAheadLog(&wal);
+    resetStack(&stack);
+    
+    start = nowSeconds();
+    initializeStack(&stack);
+    loadStackFromFile(&stack);
+    double loadTime = nowSeconds() - start;
+    openWriteAheadLog(&wal, WAL_FILENAME);
+    start = nowSeconds();
+    int replayed = replayWriteAheadLog(&stack, &wal);
+    double replayTime = nowSeconds() - start;
+    printf("recovery: load %.2f ms, replay %d ops in %.2f ms (%.2f us/op)\n",
+           loadTime * 1e3, replayed, replayTime * 1e3, replayTime * 1e6 / (replayed ? replayed : 1));
+    
+    closeWriteAheadLog(&wal);
+    resetStack(&stack);
+    remove(FILENAME);
+    remove(WAL_FILENAME);
+    return 0;
+}
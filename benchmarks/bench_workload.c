@@ -0,0 +1,595 @@
+#include "../TaskManagement_Stacks.h"
+#include <string.h>
+#include <math.h>
+#include <sys/resource.h>
+
+#define OP_KINDS 6
+#define MAX_WORD_LENGTH 16
+
+ 
+typedef enum {
+    OP_PUSH = 0,
+    OP_POP = 1,
+    OP_EDIT = 2,
+    OP_REMOVE = 3,
+    OP_SEARCH = 4,
+    OP_SORT = 5
+} OpKind;
+
+ 
+const char* opNames[OP_KINDS] = { "push", "pop", "edit", "remove", "search", "sort" };
+
+ 
+const char* syllables[] = {
+    "ka", "lo", "mi", "ne", "ru", "sa", "ti", "vo", "xe", "zu",
+    "ba", "de", "fi", "go", "hu", "ja", "pe", "qi", "wo", "yu"
+};
+
+ 
+const char* sortSpecs[] = { "-importance date", "date", "created", "-importance date created" };
+
+ 
+/* Zipfian ranks in [0, n) by the method of Gray et al. (also used by YCSB):
+   O(1) per draw once zeta(n) is known, and zeta is kept up to date term by
+   term as n changes, so the stack can grow and shrink under it. theta 0 is
+   uniform. */
+typedef struct {
+    double theta;
+    double zeta2;
+    double zetan;
+    long n;
+} ZipfGenerator;
+
+ 
+/* Latencies of one operation kind, in nanoseconds, plus how much the
+   process's peak RSS grew during those operations. */
+typedef struct {
+    uint64_t* samples;
+    long count;
+    long failed;
+    uint64_t totalNanos;
+    long rssGrowthKb;
+} OpStats;
+
+ 
+typedef struct {
+    long tasks;
+    long ops;
+    double weights[OP_KINDS];
+    double theta;
+    int minLength;
+    int maxLength;
+    long vocabulary;
+    unsigned seed;
+    bool csv;
+    bool keywordIndex;
+    bool columns;
+    bool heap;
+    bool dueIndex;
+    bool undo;
+    bool wal;
+} WorkloadConfig;
+
+ 
+static uint64_t nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+ 
+static long peakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+ 
+/* xorshift64*: the benchmark's only source of randomness, so runs with the
+   same seed replay the same operations. */
+static uint64_t nextRandom(uint64_t* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+ 
+static double nextUnit(uint64_t* state) {
+    return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+ 
+static void resizeZipf(ZipfGenerator* zipf, long n) {
+    while (zipf->n < n) {
+        zipf->n++;
+        zipf->zetan += 1.0 / pow((double)zipf->n, zipf->theta);
+    }
+    while (zipf->n > n) {
+        zipf->zetan -= 1.0 / pow((double)zipf->n, zipf->theta);
+        zipf->n--;
+    }
+}
+
+ 
+static void initializeZipf(ZipfGenerator* zipf, double theta, long n) {
+    zipf->theta = theta;
+    zipf->zeta2 = 1.0 + pow(0.5, theta);
+    zipf->zetan = 0;
+    zipf->n = 0;
+    resizeZipf(zipf, n);
+}
+
+ 
+static long nextZipf(ZipfGenerator* zipf, uint64_t* state) {
+    double u = nextUnit(state);
+    if (zipf->n <= 1) {
+        return 0;
+    }
+    if (zipf->theta == 0) {
+        return (long)(u * zipf->n);
+    }
+    
+    double uz = u * zipf->zetan;
+    if (uz < 1.0) {
+        return 0;
+    }
+    if (uz < zipf->zeta2) {
+        return 1;
+    }
+    double alpha = 1.0 / (1.0 - zipf->theta);
+    double eta = (1.0 - pow(2.0 / zipf->n, 1.0 - zipf->theta)) / (1.0 - zipf->zeta2 / zipf->zetan);
+    long rank = (long)(zipf->n * pow(eta * u - eta + 1.0, alpha));
+    return rank < zipf->n ? rank : zipf->n - 1;
+}
+
+ 
+/* Word number i of the vocabulary, spelled in base-20 syllables so every
+   number gets a distinct word. */
+static int spellWord(long i, char* word) {
+    int length = 0;
+    for (long n = i + 20; n > 0 && length + 2 < MAX_WORD_LENGTH; n /= 20) {
+        memcpy(word + length, syllables[n % 20], 2);
+        length += 2;
+    }
+    word[length] = '\0';
+    return length;
+}
+
+ 
+/* A description of Zipf-distributed words whose length is uniform in
+   [minLength, maxLength]. */
+static void makeDescription(const WorkloadConfig* config, ZipfGenerator* words, uint64_t* state,
+                            char* description) {
+    int target = config->minLength + (int)(nextRandom(state) % (uint64_t)(config->maxLength - config->minLength + 1));
+    int length = 0;
+    char word[MAX_WORD_LENGTH];
+    
+    while (length < target) {
+        int wordLength = spellWord(nextZipf(words, state), word);
+        if (length > 0) {
+            description[length++] = ' ';
+        }
+        int room = target - length;
+        memcpy(description + length, word, wordLength < room ? wordLength : room);
+        length += wordLength < room ? wordLength : room;
+    }
+    description[length] = '\0';
+}
+
+ 
+/* Fills in every field but the description, which goes to the buffer so
+   the caller decides whether storing it is timed. */
+static void makeTask(const WorkloadConfig* config, ZipfGenerator* words, uint64_t* state, Task* task,
+                     char* description) {
+    uint64_t r = nextRandom(state);
+    
+    memset(task, 0, sizeof(*task));
+    makeDescription(config, words, state, description);
+    setTaskDueDate(task, 2024 + (int)(r % 3), 1 + (int)(r >> 8) % 12, 1 + (int)(r >> 16) % 28);
+    task->importance = 1 + (int)(r >> 24) % 10;
+    task->status = (TaskStatus)((r >> 32) % 3);
+    task->createdAt = (time_t)(r >> 40);
+}
+
+ 
+static bool parseMix(const char* spec, double* weights) {
+    char copy[256];
+    snprintf(copy, sizeof(copy), "%s", spec);
+    memset(weights, 0, OP_KINDS * sizeof(double));
+    
+    for (char* item = strtok(copy, ","); item != NULL; item = strtok(NULL, ",")) {
+        char* equals = strchr(item, '=');
+        int kind = 0;
+        if (equals == NULL) {
+            return false;
+        }
+        *equals = '\0';
+        while (kind < OP_KINDS && strcmp(item, opNames[kind]) != 0) {
+            kind++;
+        }
+        if (kind == OP_KINDS || (weights[kind] = atof(equals + 1)) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ 
+static bool parseAttachments(const char* list, WorkloadConfig* config) {
+    char copy[256];
+    snprintf(copy, sizeof(copy), "%s", list);
+    config->keywordIndex = config->columns = config->heap = config->dueIndex = config->undo = config->wal = false;
+    
+    for (char* item = strtok(copy, ","); item != NULL; item = strtok(NULL, ",")) {
+        if (strcmp(item, "index") == 0) {
+            config->keywordIndex = true;
+        } else if (strcmp(item, "columns") == 0) {
+            config->columns = true;
+        } else if (strcmp(item, "heap") == 0) {
+            config->heap = true;
+        } else if (strcmp(item, "due") == 0) {
+            config->dueIndex = true;
+        } else if (strcmp(item, "undo") == 0) {
+            config->undo = true;
+        } else if (strcmp(item, "wal") == 0) {
+            config->wal = true;
+        } else if (strcmp(item, "none") != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ 
+static void printUsage(const char* program) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --tasks N         tasks on the stack before the run (default 100000)\n"
+            "  --ops N           operations to run (default 200000)\n"
+            "  --mix SPEC        relative weights, e.g. push=30,pop=10,edit=25,remove=10,search=24.9,sort=0.1\n"
+            "  --zipf THETA      skew of task and word choice, 0 <= THETA < 1 (default 0.99, 0 = uniform)\n"
+            "  --desc MIN-MAX    description length range in bytes (default 16-128)\n"
+            "  --vocabulary N    distinct words in descriptions (default 10000)\n"
+            "  --attach LIST     index,columns,heap,due,undo,wal or none (default all but wal)\n"
+            "  --seed N          random seed (default 1)\n"
+            "  --csv             print one CSV row per operation kind\n",
+            program);
+}
+
+ 
+static bool parseArguments(int argc, char* argv[], WorkloadConfig* config) {
+    config->tasks = 100000;
+    config->ops = 200000;
+    config->theta = 0.99;
+    config->minLength = 16;
+    config->maxLength = 128;
+    config->vocabulary = 10000;
+    config->seed = 1;
+    config->csv = false;
+    parseMix("push=30,pop=10,edit=25,remove=10,search=24.9,sort=0.1", config->weights);
+    parseAttachments("index,columns,heap,due,undo", config);
+    
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--csv") == 0) {
+            config->csv = true;
+            continue;
+        }
+        if (value == NULL) {
+            return false;
+        }
+        if (strcmp(argv[i], "--tasks") == 0) {
+            config->tasks = atol(value);
+        } else if (strcmp(argv[i], "--ops") == 0) {
+            config->ops = atol(value);
+        } else if (strcmp(argv[i], "--mix") == 0) {
+            if (!parseMix(value, config->weights)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "--zipf") == 0) {
+            config->theta = atof(value);
+        } else if (strcmp(argv[i], "--desc") == 0) {
+            if (sscanf(value, "%d-%d", &config->minLength, &config->maxLength) != 2) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "--vocabulary") == 0) {
+            config->vocabulary = atol(value);
+        } else if (strcmp(argv[i], "--attach") == 0) {
+            if (!parseAttachments(value, config)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            config->seed = (unsigned)atol(value);
+        } else {
+            return false;
+        }
+        i++;
+    }
+    
+    double total = 0;
+    for (int kind = 0; kind < OP_KINDS; kind++) {
+        total += config->weights[kind];
+    }
+    return config->tasks >= 0 && config->ops > 0 && total > 0 && config->theta >= 0 && config->theta < 1 &&
+           config->minLength >= 1 && config->minLength <= config->maxLength &&
+           config->maxLength < MAX_DESCRIPTION && config->vocabulary > 0;
+}
+
+ 
+static int compareNanos(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+ 
+static double percentileMicros(const OpStats* stats, double fraction) {
+    long rank = (long)ceil(fraction * stats->count) - 1;
+    return stats->samples[rank < 0 ? 0 : rank] / 1e3;
+}
+
+ 
+static void reportStats(const WorkloadConfig* config, const char* name, OpStats* stats) {
+    if (stats->count == 0) {
+        return;
+    }
+    qsort(stats->samples, stats->count, sizeof(uint64_t), compareNanos);
+    double rate = stats->count * 1e9 / (stats->totalNanos ? stats->totalNanos : 1);
+    double mean = stats->totalNanos / 1e3 / stats->count;
+    
+    if (config->csv) {
+        printf("%s,%ld,%ld,%.0f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f\n", name, stats->count, stats->failed, rate,
+               mean, percentileMicros(stats, 0.50), percentileMicros(stats, 0.90), percentileMicros(stats, 0.99),
+               percentileMicros(stats, 0.999), stats->samples[stats->count - 1] / 1e3,
+               stats->rssGrowthKb / 1024.0);
+    } else {
+        printf("%-8s %9ld %7ld %11.0f %9.2f %9.2f %9.2f %9.2f %9.2f %10.2f %8.1f\n", name, stats->count,
+               stats->failed, rate, mean, percentileMicros(stats, 0.50), percentileMicros(stats, 0.90),
+               percentileMicros(stats, 0.99), percentileMicros(stats, 0.999), stats->samples[stats->count - 1] / 1e3,
+               stats->rssGrowthKb / 1024.0);
+    }
+}
+
+ 
+int main(int argc, char* argv[]) {
+    WorkloadConfig config;
+    TaskStack stack;
+    KeywordIndex keywordIndex;
+    TaskColumns columns;
+    TaskHeap heap;
+    DueIndex dueIndex;
+    UndoStack undo;
+    WriteAheadLog wal;
+    ZipfGenerator tasks, words;
+    OpStats stats[OP_KINDS];
+    OpStats all;
+    Task task;
+    char description[MAX_DESCRIPTION];
+    char word[MAX_WORD_LENGTH];
+    long hits = 0;
+    
+    if (!parseArguments(argc, argv, &config)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    uint64_t state = 0x9E3779B97F4A7C15ULL ^ config.seed;
+    initializeZipf(&words, config.theta, config.vocabulary);
+    initializeZipf(&tasks, config.theta, 0);
+    
+    /* The whole schedule is drawn up front and the sample arrays are
+       touched now, so the RSS growth measured during the run belongs to
+       the stack and not to the benchmark's own bookkeeping. */
+    unsigned char* schedule = (unsigned char*)malloc(config.ops);
+    double total = 0;
+    memset(stats, 0, sizeof(stats));
+    for (int kind = 0; kind < OP_KINDS; kind++) {
+        total += config.weights[kind];
+    }
+    for (long i = 0; i < config.ops; i++) {
+        double pick = nextUnit(&state) * total;
+        int kind = 0;
+        while (kind < OP_KINDS - 1 && (pick -= config.weights[kind]) >= 0) {
+            kind++;
+        }
+        while (config.weights[kind] == 0) {
+            kind--;
+        }
+        schedule[i] = (unsigned char)kind;
+        stats[kind].count++;
+    }
+    all.samples = (uint64_t*)malloc(config.ops * sizeof(uint64_t));
+    for (int kind = 0; kind < OP_KINDS; kind++) {
+        stats[kind].samples = (uint64_t*)malloc((stats[kind].count + 1) * sizeof(uint64_t));
+        memset(stats[kind].samples, 0, (stats[kind].count + 1) * sizeof(uint64_t));
+        stats[kind].count = 0;
+    }
+    memset(all.samples, 0, config.ops * sizeof(uint64_t));
+    all.count = all.failed = 0;
+    all.totalNanos = 0;
+    all.rssGrowthKb = 0;
+    
+    uint64_t setupStart = nowNanos();
+    initializeStack(&stack);
+    for (long i = 0; i < config.tasks; i++) {
+        makeTask(&config, &words, &state, &task, description);
+        setTaskDescription(&task, description);
+        pushTask(&stack, task);
+    }
+    if (config.keywordIndex) {
+        initializeKeywordIndex(&keywordIndex);
+        attachKeywordIndex(&stack, &keywordIndex);
+    }
+    if (config.columns) {
+        initializeTaskColumns(&columns);
+        attachTaskColumns(&stack, &columns);
+    }
+    if (config.heap) {
+        initializeTaskHeap(&heap);
+        attachTaskHeap(&stack, &heap);
+    }
+    if (config.dueIndex) {
+        initializeDueIndex(&dueIndex);
+        attachDueIndex(&stack, &dueIndex);
+    }
+    if (config.wal) {
+        remove("bench_workload.wal");
+        initializeWriteAheadLog(&wal);
+        config.wal = openWriteAheadLog(&wal, "bench_workload.wal");
+        if (config.wal) {
+            attachWriteAheadLog(&stack, &wal);
+        }
+    }
+    if (config.undo) {
+        initializeUndoStack(&undo, UNDO_BUDGET);
+        attachUndoStack(&stack, &undo);
+    }
+    double setupSeconds = (nowNanos() - setupStart) / 1e9;
+    long setupRss = peakRssKb();
+    long expectedSize = config.tasks;
+    
+    if (!config.csv) {
+        printf("%ld tasks, %ld ops, zipf %.2f, descriptions %d-%d bytes from %ld words, seed %u\n", config.tasks,
+               config.ops, config.theta, config.minLength, config.maxLength, config.vocabulary, config.seed);
+        printf("attached:%s%s%s%s%s%s; setup %.2f s, peak RSS %.1f MB\n", config.keywordIndex ? " index" : "",
+               config.columns ? " columns" : "", config.heap ? " heap" : "", config.dueIndex ? " due" : "",
+               config.undo ? " undo" : "", config.wal ? " wal" : "", setupSeconds, setupRss / 1024.0);
+        printf("%-8s %9s %7s %11s %9s %9s %9s %9s %9s %10s %8s\n", "op", "count", "failed", "ops/s", "mean us",
+               "p50 us", "p90 us", "p99 us", "p99.9 us", "max us", "RSS MB");
+    } else {
+        printf("op,count,failed,ops_per_sec,mean_us,p50_us,p90_us,p99_us,p999_us,max_us,rss_growth_mb\n");
+    }
+    
+    uint64_t runStart = nowNanos();
+    long rss = setupRss;
+    for (long i = 0; i < config.ops; i++) {
+        OpKind kind = (OpKind)schedule[i];
+        int size = getStackSize(&stack);
+        bool ok = true;
+        uint64_t start, elapsed;
+    
+        resizeZipf(&tasks, size);
+        int index = size - 1 - (int)nextZipf(&tasks, &state);
+        uint64_t r = nextRandom(&state);
+    
+        switch (kind) {
+            case OP_PUSH:
+                makeTask(&config, &words, &state, &task, description);
+                start = nowNanos();
+                ok = setTaskDescription(&task, description) && pushTask(&stack, task);
+                elapsed = nowNanos() - start;
+                expectedSize += ok;
+                break;
+            case OP_POP:
+                start = nowNanos();
+                ok = popTask(&stack, &task);
+                elapsed = nowNanos() - start;
+                expectedSize -= ok;
+                break;
+            case OP_EDIT:
+                makeDescription(&config, &words, &state, description);
+                start = nowNanos();
+                if (size > 0) {
+                    task = *getTaskAtIndex(&stack, index);
+                    task.importance = 1 + (int)(r % 10);
+                    task.status = (TaskStatus)((r >> 8) % 3);
+                    ok = ((r >> 16) % 2 == 0 || setTaskDescription(&task, description)) &&
+                         editTaskAtIndex(&stack, index, task);
+                } else {
+                    ok = false;
+                }
+                elapsed = nowNanos() - start;
+                break;
+            case OP_REMOVE:
+                start = nowNanos();
+                ok = removeTaskAtIndex(&stack, index);
+                elapsed = nowNanos() - start;
+                expectedSize -= ok;
+                break;
+            case OP_SEARCH:
+                spellWord(nextZipf(&words, &state), word);
+                start = nowNanos();
+                if (config.keywordIndex) {
+                    uint32_t* ids = NULL;
+                    int matches = queryKeywordIndex(&keywordIndex, word, &ids);
+                    hits += matches > 0 ? matches : 0;
+                    free(ids);
+                } else {
+                    SubstringMatcher matcher;
+                    TaskCursor cursor;
+                    const Task* found;
+                    int matches = 0;
+                    prepareSubstringMatcher(&matcher, word, false);
+                    openTaskCursor(&cursor, &stack);
+                    while ((found = nextTaskFromCursor(&cursor)) != NULL) {
+                        matches += matchSubstring(&matcher, getTaskDescription(found), found->descriptionLength + 1);
+                    }
+                    hits += matches;
+                }
+                elapsed = nowNanos() - start;
+                break;
+            case OP_SORT:
+            default: {
+                TaskSortKey keys[MAX_SORT_KEYS];
+                int keyCount = parseSortKeys(sortSpecs[r % 4], keys);
+                start = nowNanos();
+                sortStack(&stack, keys, keyCount);
+                elapsed = nowNanos() - start;
+                break;
+            }
+        }
+    
+        OpStats* stat = &stats[kind];
+        long now = peakRssKb();
+        stat->rssGrowthKb += now - rss;
+        rss = now;
+        stat->samples[stat->count++] = elapsed;
+        stat->totalNanos += elapsed;
+        stat->failed += !ok;
+        all.samples[all.count++] = elapsed;
+        all.totalNanos += elapsed;
+        all.failed += !ok;
+        all.rssGrowthKb = rss - setupRss;
+    }
+    double runSeconds = (nowNanos() - runStart) / 1e9;
+    
+    for (int kind = 0; kind < OP_KINDS; kind++) {
+        reportStats(&config, opNames[kind], &stats[kind]);
+    }
+    reportStats(&config, "all", &all);
+    bool sizeMatches = getStackSize(&stack) == expectedSize;
+    if (!config.csv) {
+        printf("run %.2f s wall, %d tasks left, %ld search hits, peak RSS %.1f MB%s\n", runSeconds,
+               getStackSize(&stack), hits, rss / 1024.0, sizeMatches ? "" : " MISMATCH");
+    } else if (!sizeMatches) {
+        fprintf(stderr, "MISMATCH: %d tasks left, expected %ld\n", getStackSize(&stack), expectedSize);
+    }
+    
+    if (config.wal) {
+        closeWriteAheadLog(&wal);
+        remove("bench_workload.wal");
+    }
+    if (config.undo) {
+        stack.undo = NULL;
+        freeUndoStack(&undo);
+    }
+    resetStack(&stack);
+    if (config.keywordIndex) {
+        freeKeywordIndex(&keywordIndex);
+    }
+    if (config.columns) {
+        freeTaskColumns(&columns);
+    }
+    if (config.heap) {
+        freeTaskHeap(&heap);
+    }
+    if (config.dueIndex) {
+        freeDueIndex(&dueIndex);
+    }
+    for (int kind = 0; kind < OP_KINDS; kind++) {
+        free(stats[kind].samples);
+    }
+    free(all.samples);
+    free(schedule);
+    return sizeMatches ? 0 : 1;
+}